@@ -0,0 +1,156 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisColorSpaceConversionBenchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_group_layer.h"
+
+namespace {
+
+const int imageSize = 2048;
+
+KisPaintDeviceSP createTestDevice(const KoColorSpace *cs, int seedOffset)
+{
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    QVector<quint8> bytes(imageSize * imageSize * cs->pixelSize());
+    quint8 *ptr = bytes.data();
+    quint32 seed = 1234 + seedOffset;
+
+    for (int y = 0; y < imageSize; y++) {
+        for (int x = 0; x < imageSize; x++) {
+            seed = seed * 1103515245 + 12345;
+            const quint8 grain = (seed >> 16) & 0x7;
+
+            ptr[0] = quint8((x + seedOffset * 13) / 8) + grain;
+            ptr[1] = quint8((y + seedOffset * 7) / 8) + grain;
+            ptr[2] = quint8((x + y) / 16);
+            ptr[3] = 255;
+            ptr += 4;
+        }
+    }
+
+    dev->writeBytes(bytes.data(), QRect(0, 0, imageSize, imageSize));
+    return dev;
+}
+
+void addColorModelRows()
+{
+    QTest::addColumn<QString>("modelId");
+    QTest::addColumn<QString>("depthId");
+    QTest::addColumn<int>("numLayers");
+
+    const QVector<QPair<KoID, KoID>> colorSpaces = {
+        {RGBAColorModelID, Integer16BitsColorDepthID},
+        {RGBAColorModelID, Float32BitsColorDepthID},
+        {CMYKAColorModelID, Integer16BitsColorDepthID},
+        {LABAColorModelID, Integer16BitsColorDepthID},
+        {GrayAColorModelID, Integer8BitsColorDepthID}
+    };
+
+    const QVector<int> layerCounts({1, 8});
+
+    Q_FOREACH (const auto &cs, colorSpaces) {
+        Q_FOREACH (int numLayers, layerCounts) {
+            QTest::newRow(QString("%1-%2-layers-%3")
+                          .arg(cs.first.id()).arg(cs.second.id()).arg(numLayers).toLatin1())
+                << cs.first.id() << cs.second.id() << numLayers;
+        }
+    }
+}
+
+void reportThroughput(qint64 elapsed, int numLayers)
+{
+    const qreal megapixels = qreal(imageSize) * imageSize * numLayers / 1e6;
+    qDebug() << "Time:" << elapsed << "ms"
+             << "Throughput:" << (elapsed > 0 ? megapixels * 1000.0 / elapsed : 0.0) << "MPx/s";
+}
+
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertDevice_data()
+{
+    addColorModelRows();
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertDevice()
+{
+    QFETCH(QString, modelId);
+    QFETCH(QString, depthId);
+    QFETCH(int, numLayers);
+
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *dstCs = KoColorSpaceRegistry::instance()->colorSpace(modelId, depthId, 0);
+    QVERIFY(dstCs);
+
+    QVector<KisPaintDeviceSP> devices;
+    for (int i = 0; i < numLayers; i++) {
+        devices << createTestDevice(srcCs, i);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // no jobs interface, so the conversion is done sequentially
+    QBENCHMARK_ONCE {
+        Q_FOREACH (KisPaintDeviceSP dev, devices) {
+            dev->convertTo(dstCs);
+        }
+    }
+
+    reportThroughput(timer.elapsed(), numLayers);
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertImage_data()
+{
+    addColorModelRows();
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertImage()
+{
+    QFETCH(QString, modelId);
+    QFETCH(QString, depthId);
+    QFETCH(int, numLayers);
+
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *dstCs = KoColorSpaceRegistry::instance()->colorSpace(modelId, depthId, 0);
+    QVERIFY(dstCs);
+
+    KisImageSP image = new KisImage(0, imageSize, imageSize, srcCs, "conversion benchmark");
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8, createTestDevice(srcCs, i));
+        image->addNode(layer, image->root());
+    }
+
+    image->initialRefreshGraph();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the layers are converted in parallel in tile patches
+    QBENCHMARK_ONCE {
+        image->convertImageColorSpace(dstCs,
+                                      KoColorConversionTransformation::internalRenderingIntent(),
+                                      KoColorConversionTransformation::internalConversionFlags());
+        image->waitForDone();
+    }
+
+    reportThroughput(timer.elapsed(), numLayers);
+
+    QCOMPARE(*image->colorSpace(), *dstCs);
+}
+
+QTEST_MAIN(KisColorSpaceConversionBenchmark)
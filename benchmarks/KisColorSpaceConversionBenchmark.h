@@ -0,0 +1,24 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISCOLORSPACECONVERSIONBENCHMARK_H
+#define KISCOLORSPACECONVERSIONBENCHMARK_H
+
+#include <QtTest>
+
+class KisColorSpaceConversionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkConvertDevice_data();
+    void benchmarkConvertDevice();
+
+    void benchmarkConvertImage_data();
+    void benchmarkConvertImage();
+};
+
+#endif // KISCOLORSPACECONVERSIONBENCHMARK_H
@@ -0,0 +1,157 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisKraSaveLoadBenchmark.h"
+
+#include <QTest>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <KoColorSpaceRegistry.h>
+
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_group_layer.h"
+
+namespace {
+
+const int imageSize = 2048;
+
+/**
+ * Generates a layer content which is neither trivially compressible
+ * nor pure noise: a gradient with some grain, offset per layer
+ */
+KisImageSP createTestImage(int numLayers)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "save/load benchmark");
+
+    QVector<quint8> bytes(imageSize * imageSize * cs->pixelSize());
+
+    for (int i = 0; i < numLayers; i++) {
+        quint8 *ptr = bytes.data();
+        quint32 seed = 1234 + i;
+
+        for (int y = 0; y < imageSize; y++) {
+            for (int x = 0; x < imageSize; x++) {
+                seed = seed * 1103515245 + 12345;
+                const quint8 grain = (seed >> 16) & 0x7;
+
+                ptr[0] = quint8((x + i * 13) / 8) + grain;
+                ptr[1] = quint8((y + i * 7) / 8) + grain;
+                ptr[2] = quint8((x + y) / 16);
+                ptr[3] = 255;
+                ptr += 4;
+            }
+        }
+
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8, cs);
+        layer->paintDevice()->writeBytes(bytes.data(), image->bounds());
+        image->addNode(layer, image->root());
+    }
+
+    image->initialRefreshGraph();
+
+    return image;
+}
+
+void addLayersAndThreadsRows()
+{
+    QTest::addColumn<int>("numLayers");
+    QTest::addColumn<int>("numThreads");
+
+    const QVector<int> layerCounts({1, 8, 32});
+    QVector<int> threadCounts({1, 4, 16});
+    threadCounts.append(QThread::idealThreadCount());
+
+    Q_FOREACH (int numLayers, layerCounts) {
+        Q_FOREACH (int numThreads, threadCounts) {
+            QTest::newRow(QString("layers-%1-threads-%2").arg(numLayers).arg(numThreads).toLatin1())
+                << numLayers << numThreads;
+        }
+    }
+}
+
+}
+
+void KisKraSaveLoadBenchmark::initTestCase()
+{
+    m_originalThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+}
+
+void KisKraSaveLoadBenchmark::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(m_originalThreadCount);
+}
+
+void KisKraSaveLoadBenchmark::benchmarkSave_data()
+{
+    addLayersAndThreadsRows();
+}
+
+void KisKraSaveLoadBenchmark::benchmarkSave()
+{
+    QFETCH(int, numLayers);
+    QFETCH(int, numThreads);
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(createTestImage(numLayers));
+
+    QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+    const QString fileName = QString("save_benchmark_%1.kra").arg(numLayers);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        const bool result = doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType());
+        QVERIFY(result);
+    }
+
+    qDebug() << "Layers:" << numLayers << "Threads:" << numThreads << "Time:" << timer.elapsed();
+
+    QFile::remove(fileName);
+}
+
+void KisKraSaveLoadBenchmark::benchmarkLoad_data()
+{
+    addLayersAndThreadsRows();
+}
+
+void KisKraSaveLoadBenchmark::benchmarkLoad()
+{
+    QFETCH(int, numLayers);
+    QFETCH(int, numThreads);
+
+    const QString fileName = QString("load_benchmark_%1.kra").arg(numLayers);
+
+    {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        doc->setCurrentImage(createTestImage(numLayers));
+        QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        QVERIFY(doc->loadNativeFormat(fileName));
+        QCOMPARE(doc->image()->root()->childCount(), quint32(numLayers));
+    }
+
+    qDebug() << "Layers:" << numLayers << "Threads:" << numThreads << "Time:" << timer.elapsed();
+
+    QFile::remove(fileName);
+}
+
+QTEST_MAIN(KisKraSaveLoadBenchmark)
@@ -0,0 +1,30 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISKRASAVELOADBENCHMARK_H
+#define KISKRASAVELOADBENCHMARK_H
+
+#include <QtTest>
+
+class KisKraSaveLoadBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkSave_data();
+    void benchmarkSave();
+
+    void benchmarkLoad_data();
+    void benchmarkLoad();
+
+private:
+    int m_originalThreadCount = 0;
+};
+
+#endif // KISKRASAVELOADBENCHMARK_H
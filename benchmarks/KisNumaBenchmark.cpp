@@ -0,0 +1,273 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisNumaBenchmark.h"
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QTest>
+#include <QThread>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoCompositeOpRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_painter.h"
+#include "kis_datamanager.h"
+#include "KisNumaTopology.h"
+#include "KisWorkStealingThreadPool.h"
+
+/**
+ * The benchmarks bind the threads to the nodes with sched_setaffinity()
+ * (see KisNumaTopology::bindCurrentThreadToNode()), so the tile data is
+ * first written on one node and then composited on the same or on another
+ * node.
+ *
+ * On a NUMA system the real nodes are used. On a single-node system the
+ * CPUs are split into two simulated nodes. The memory is the same for
+ * all the CPUs there, so the rows show only the overhead of the binding
+ * and of the scheduling.
+ */
+
+namespace {
+
+const QRect imageRect(0, 0, 4096, 4096);
+const int numCycles = 10;
+const int patchSize = 256;
+
+struct NodeThread : public QThread
+{
+    NodeThread(const KisNumaTopology *topology, int node, std::function<void()> func)
+        : m_topology(topology), m_node(node), m_func(func)
+    {
+    }
+
+    void run() override {
+        m_topology->bindCurrentThreadToNode(m_node);
+        m_func();
+    }
+
+    const KisNumaTopology *m_topology;
+    int m_node;
+    std::function<void()> m_func;
+};
+
+/**
+ * Runs \p func in a thread bound to \p node
+ */
+void runOnNode(const KisNumaTopology *topology, int node, std::function<void()> func)
+{
+    NodeThread thread(topology, node, func);
+    thread.start();
+    thread.wait();
+}
+
+/**
+ * Returns the topology of the system if it has several nodes,
+ * otherwise the simulated one
+ */
+const KisNumaTopology* benchmarkTopology(QScopedPointer<KisNumaTopology> &simulated)
+{
+    KisNumaTopology *system = KisNumaTopology::instance();
+    if (system->numNodes() > 1) return system;
+
+    const int numCpus = QThread::idealThreadCount();
+    if (numCpus < 2) return 0;
+
+    QVector<QVector<int>> nodeCpus(2);
+    for (int cpu = 0; cpu < numCpus; cpu++) {
+        nodeCpus[cpu < numCpus / 2 ? 0 : 1].append(cpu);
+    }
+
+    simulated.reset(new KisNumaTopology(nodeCpus));
+    return simulated.data();
+}
+
+void fillDevice(KisPaintDeviceSP dev, const QRect &rc, const QColor &color)
+{
+    dev->fill(rc, KoColor(color, dev->colorSpace()));
+}
+
+void compositePatches(KisPaintDeviceSP src, KisPaintDeviceSP dst, const QRect &rc)
+{
+    KisPainter gc(dst);
+    gc.setCompositeOp(COMPOSITE_OVER);
+
+    for (int y = rc.top(); y <= rc.bottom(); y += patchSize) {
+        for (int x = rc.left(); x <= rc.right(); x += patchSize) {
+            const QRect patch = QRect(x, y, patchSize, patchSize) & rc;
+            gc.bitBlt(patch.topLeft(), src, patch);
+        }
+    }
+}
+
+struct CompositionRunnable : public QRunnable
+{
+    CompositionRunnable(KisPaintDeviceSP src, KisPaintDeviceSP dst, const QRect &rc)
+        : m_src(src), m_dst(dst), m_rc(rc)
+    {
+    }
+
+    void run() override {
+        KisPainter gc(m_dst);
+        gc.setCompositeOp(COMPOSITE_OVER);
+        gc.bitBlt(m_rc.topLeft(), m_src, m_rc);
+    }
+
+    KisPaintDeviceSP m_src;
+    KisPaintDeviceSP m_dst;
+    QRect m_rc;
+};
+
+void reportResult(qint64 nsecs)
+{
+    const qreal megapixels = qreal(imageRect.width()) * imageRect.height() * numCycles / 1000000.0;
+    const qreal time = nsecs / 1000000.0;
+
+    qDebug() << QTest::currentDataTag()
+             << "Time:" << time << "ms"
+             << "MPx/s:" << megapixels / time * 1000.0;
+}
+
+}
+
+void KisNumaBenchmark::benchmarkComposition_data()
+{
+    QTest::addColumn<int>("workNode");
+
+    QTest::newRow("local") << 0;
+    QTest::newRow("remote") << 1;
+}
+
+/**
+ * Fills the devices on node 0 and composites them with the threads
+ * bound to node 0 (local) or node 1 (remote)
+ */
+void KisNumaBenchmark::benchmarkComposition()
+{
+    QFETCH(int, workNode);
+
+    QScopedPointer<KisNumaTopology> simulated;
+    const KisNumaTopology *topology = benchmarkTopology(simulated);
+    if (!topology) {
+        QSKIP("At least two CPUs are needed for simulating two nodes");
+    }
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP src = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+
+    runOnNode(topology, 0, [&] () {
+        fillDevice(src, imageRect, QColor(200, 100, 50, 128));
+        fillDevice(dst, imageRect, Qt::white);
+    });
+
+    const int numThreads = topology->nodeCpus(workNode).size();
+    const int stripeHeight = imageRect.height() / numThreads;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        QVector<NodeThread*> threads;
+
+        for (int i = 0; i < numThreads; i++) {
+            const QRect stripe(imageRect.x(), imageRect.y() + i * stripeHeight,
+                               imageRect.width(),
+                               i < numThreads - 1 ? stripeHeight : imageRect.height() - i * stripeHeight);
+
+            threads << new NodeThread(topology, workNode, [src, dst, stripe] () {
+                for (int cycle = 0; cycle < numCycles; cycle++) {
+                    compositePatches(src, dst, stripe);
+                }
+            });
+        }
+
+        Q_FOREACH (NodeThread *thread, threads) {
+            thread->start();
+        }
+
+        Q_FOREACH (NodeThread *thread, threads) {
+            thread->wait();
+        }
+
+        qDeleteAll(threads);
+    }
+
+    reportResult(timer.nsecsElapsed());
+}
+
+void KisNumaBenchmark::benchmarkSchedulingHint_data()
+{
+    QTest::addColumn<bool>("useHint");
+
+    QTest::newRow("no-hint") << false;
+    QTest::newRow("hint") << true;
+}
+
+/**
+ * Fills the left half of the devices on node 0 and the right half on
+ * node 1, then composites them in patches with the pool the updater
+ * context uses, with and without the node hint the context passes
+ */
+void KisNumaBenchmark::benchmarkSchedulingHint()
+{
+    QFETCH(bool, useHint);
+
+    QScopedPointer<KisNumaTopology> simulated;
+    const KisNumaTopology *topology = benchmarkTopology(simulated);
+    if (!topology) {
+        QSKIP("At least two CPUs are needed for simulating two nodes");
+    }
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP src = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+
+    const QRect leftHalf(imageRect.x(), imageRect.y(), imageRect.width() / 2, imageRect.height());
+    const QRect rightHalf = imageRect.adjusted(imageRect.width() / 2, 0, 0, 0);
+
+    runOnNode(topology, 0, [&] () {
+        fillDevice(src, leftHalf, QColor(200, 100, 50, 128));
+        fillDevice(dst, leftHalf, Qt::white);
+    });
+
+    runOnNode(topology, 1, [&] () {
+        fillDevice(src, rightHalf, QColor(50, 100, 200, 128));
+        fillDevice(dst, rightHalf, Qt::white);
+    });
+
+    KisWorkStealingThreadPool pool;
+    pool.setNumaTopology(topology);
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        for (int cycle = 0; cycle < numCycles; cycle++) {
+            for (int y = imageRect.top(); y <= imageRect.bottom(); y += patchSize) {
+                for (int x = imageRect.left(); x <= imageRect.right(); x += patchSize) {
+                    const QRect patch(x, y, patchSize, patchSize);
+
+                    const int node = useHint ? dst->dataManager()->dominantNumaNode(patch) : -1;
+                    pool.start(new CompositionRunnable(src, dst, patch), node);
+                }
+            }
+
+            pool.waitForDone();
+        }
+    }
+
+    reportResult(timer.nsecsElapsed());
+}
+
+QTEST_MAIN(KisNumaBenchmark)
@@ -0,0 +1,23 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISNUMABENCHMARK_H
+#define KISNUMABENCHMARK_H
+
+#include <QtTest>
+
+class KisNumaBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkComposition_data();
+    void benchmarkComposition();
+    void benchmarkSchedulingHint_data();
+    void benchmarkSchedulingHint();
+};
+
+#endif // KISNUMABENCHMARK_H
@@ -0,0 +1,120 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisOpenGLUpdateInfoBuilderBenchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_paint_device.h"
+#include "kis_update_info.h"
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
+#include "opengl/kis_texture_tile_info_pool.h"
+#include "opengl/kis_texture_tile_update_info.h"
+
+namespace {
+
+// the size of a 4K display
+const QRect updateRect(0, 0, 3840, 2160);
+
+const int textureSize = 256;
+const int textureBorder = 8;
+const int numUpdates = 10;
+
+const KoColorSpace* colorSpaceById(const QString &id)
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    if (id == "rgb8") {
+        return registry->rgb8();
+    } else if (id == "rgb16") {
+        return registry->rgb16();
+    } else if (id == "rgbaf32-linear") {
+        return registry->colorSpace(RGBAColorModelID.id(), Float32BitsColorDepthID.id(), registry->p2020G10Profile());
+    } else if (id == "rgbaf16-pq") {
+        return registry->colorSpace(RGBAColorModelID.id(), Float16BitsColorDepthID.id(), registry->p2020PQProfile());
+    }
+
+    return 0;
+}
+
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkBuildUpdateInfo_data()
+{
+    QTest::addColumn<QString>("srcColorSpace");
+    QTest::addColumn<QString>("dstColorSpace");
+    QTest::addColumn<bool>("parallel");
+
+    QTest::newRow("rgb8-rgb8-serial") << "rgb8" << "rgb8" << false;
+    QTest::newRow("rgb8-rgb8-parallel") << "rgb8" << "rgb8" << true;
+    QTest::newRow("rgb16-rgb8-serial") << "rgb16" << "rgb8" << false;
+    QTest::newRow("rgb16-rgb8-parallel") << "rgb16" << "rgb8" << true;
+    QTest::newRow("hdr-serial") << "rgbaf32-linear" << "rgbaf16-pq" << false;
+    QTest::newRow("hdr-parallel") << "rgbaf32-linear" << "rgbaf16-pq" << true;
+}
+
+/**
+ * Measures the CPU-side preparation of the canvas textures for an update
+ * of the whole 4K canvas: fetching of the projection data and conversion
+ * into the display color space. No GPU is needed, the tiles are not
+ * uploaded anywhere.
+ */
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkBuildUpdateInfo()
+{
+    QFETCH(QString, srcColorSpace);
+    QFETCH(QString, dstColorSpace);
+    QFETCH(bool, parallel);
+
+    const KoColorSpace *srcCS = colorSpaceById(srcColorSpace);
+    const KoColorSpace *dstCS = colorSpaceById(dstColorSpace);
+    QVERIFY(srcCS);
+    QVERIFY(dstCS);
+
+    KisPaintDeviceSP projection = new KisPaintDevice(srcCS);
+    projection->fill(updateRect, KoColor(QColor(200, 100, 50, 220), srcCS));
+
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisTextureTileInfoPoolSP pool = poolRegistry.getPool(textureSize, textureSize);
+
+    KisOpenGLUpdateInfoBuilder builder;
+    builder.setTextureInfoPool(pool);
+    builder.setConversionOptions(
+        ConversionOptions(dstCS,
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags()));
+    builder.setTextureBorder(textureBorder);
+    builder.setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder, textureSize - 2 * textureBorder));
+    builder.setParallelProcessingEnabled(parallel);
+
+    int numTiles = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < numUpdates; i++) {
+            KisOpenGLUpdateInfoSP info =
+                builder.buildUpdateInfo(updateRect, projection, updateRect, 0, true);
+            numTiles = info->tileList.size();
+        }
+    }
+
+    const qreal megapixels = updateRect.width() * updateRect.height() / 1000000.0;
+    const qreal updateTime = timer.nsecsElapsed() / 1000000.0 / numUpdates;
+
+    qDebug() << QTest::currentDataTag()
+             << "Tiles:" << numTiles
+             << "Update time:" << updateTime << "ms"
+             << "Time/MPx:" << updateTime / megapixels << "ms";
+}
+
+QTEST_MAIN(KisOpenGLUpdateInfoBuilderBenchmark)
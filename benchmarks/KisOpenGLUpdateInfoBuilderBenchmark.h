@@ -0,0 +1,21 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISOPENGLUPDATEINFOBUILDERBENCHMARK_H
+#define KISOPENGLUPDATEINFOBUILDERBENCHMARK_H
+
+#include <QtTest>
+
+class KisOpenGLUpdateInfoBuilderBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkBuildUpdateInfo_data();
+    void benchmarkBuildUpdateInfo();
+};
+
+#endif // KISOPENGLUPDATEINFOBUILDERBENCHMARK_H
@@ -0,0 +1,250 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisUpdateSchedulerBenchmark.h"
+
+#include <algorithm>
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_group_layer.h"
+#include "kis_image_config.h"
+#include "kis_update_time_monitor.h"
+#include "KisRunnableBasedStrokeStrategy.h"
+#include "KisRunnableStrokeJobData.h"
+
+namespace {
+
+const int imageSize = 4096;
+const int numLayers = 16;
+const int numWaves = 64;
+const int patchSize = 64;
+
+struct BenchmarkStrokeStrategy : public KisRunnableBasedStrokeStrategy
+{
+    BenchmarkStrokeStrategy()
+        : KisRunnableBasedStrokeStrategy(QLatin1String("scheduler-benchmark-stroke"))
+    {
+        enableJob(JOB_DOSTROKE);
+    }
+};
+
+QRect patchRect(int index)
+{
+    const int patchesPerRow = imageSize / patchSize;
+    const int patch = (index * 7919) % (patchesPerRow * patchesPerRow);
+
+    return QRect((patch % patchesPerRow) * patchSize,
+                 (patch / patchesPerRow) * patchSize,
+                 patchSize, patchSize);
+}
+
+qreal percentile(QVector<qint64> values, qreal fraction)
+{
+    if (values.isEmpty()) return 0.0;
+
+    std::sort(values.begin(), values.end());
+    const int index = qBound(0, int(fraction * values.size()), values.size() - 1);
+    return values[index] / 1000.0;
+}
+
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkStrokeJobs_data()
+{
+    QTest::addColumn<int>("numThreads");
+    QTest::addColumn<bool>("withUpdates");
+
+    Q_FOREACH (int numThreads, QVector<int>({4, 16, 64})) {
+        QTest::newRow(QString("threads-%1-strokes").arg(numThreads).toLatin1()) << numThreads << false;
+        QTest::newRow(QString("threads-%1-mixed").arg(numThreads).toLatin1()) << numThreads << true;
+    }
+}
+
+/**
+ * Feeds the scheduler with the waves of concurrent stroke jobs, one job
+ * per thread in every wave. In the mixed mode every wave is accompanied
+ * with the same number of merge jobs, which compete for the threads with
+ * the strokes.
+ *
+ * Reports:
+ *   - utilization: the time spent in the stroke jobs divided by the total
+ *     time of all the threads
+ *   - latency: the time between adding a job to the image and the moment
+ *     it was started by a worker thread
+ */
+void KisUpdateSchedulerBenchmark::benchmarkStrokeJobs()
+{
+    QFETCH(int, numThreads);
+    QFETCH(bool, withUpdates);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "scheduler benchmark");
+
+    QVector<KisPaintLayerSP> layers;
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(image->bounds(), KoColor(QColor(16 * i, 255 - 16 * i, 128, 200), cs));
+        image->addNode(layer, image->root());
+        layers << layer;
+    }
+
+    image->initialRefreshGraph();
+    image->setWorkingThreadsLimit(numThreads);
+
+    const int numJobs = numWaves * numThreads;
+    QVector<qint64> latencies(numJobs);
+    QVector<qint64> busyTimes(numJobs);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        for (int wave = 0; wave < numWaves; wave++) {
+            if (withUpdates) {
+                for (int i = 0; i < numThreads; i++) {
+                    const int index = wave * numThreads + i;
+                    layers[index % numLayers]->setDirty(patchRect(index + numJobs));
+                }
+            }
+
+            KisStrokeId id = image->startStroke(new BenchmarkStrokeStrategy());
+
+            for (int i = 0; i < numThreads; i++) {
+                const int index = wave * numThreads + i;
+                const qint64 enqueueTime = timer.nsecsElapsed();
+                KisPaintDeviceSP device = layers[index % numLayers]->paintDevice();
+
+                image->addJob(id,
+                    new KisRunnableStrokeJobData(
+                        [&timer, &latencies, &busyTimes, index, enqueueTime, device, cs] () {
+                            const qint64 startTime = timer.nsecsElapsed();
+                            latencies[index] = startTime - enqueueTime;
+
+                            device->fill(patchRect(index), KoColor(QColor(index % 256, 0, 0, 255), cs));
+
+                            busyTimes[index] = timer.nsecsElapsed() - startTime;
+                        },
+                        KisStrokeJobData::CONCURRENT));
+            }
+
+            image->endStroke(id);
+            image->waitForDone();
+        }
+    }
+
+    const qint64 wallTime = timer.nsecsElapsed();
+
+    qint64 totalBusyTime = 0;
+    Q_FOREACH (qint64 value, busyTimes) {
+        totalBusyTime += value;
+    }
+
+    qint64 totalLatency = 0;
+    Q_FOREACH (qint64 value, latencies) {
+        totalLatency += value;
+    }
+
+    qDebug() << "Threads:" << numThreads
+             << "Time:" << wallTime / 1000000 << "ms"
+             << "Utilization:" << 100.0 * totalBusyTime / (qreal(wallTime) * numThreads) << "%";
+    qDebug() << "Latency (us):"
+             << "mean" << totalLatency / 1000.0 / numJobs
+             << "p50" << percentile(latencies, 0.5)
+             << "p99" << percentile(latencies, 0.99);
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkFullRefresh_data()
+{
+    QTest::addColumn<int>("numRefreshLayers");
+    QTest::addColumn<int>("fixedPatchSize");
+
+    Q_FOREACH (int numRefreshLayers, QVector<int>({4, 32})) {
+        Q_FOREACH (int fixedPatchSize, QVector<int>({256, 512, 1024})) {
+            QTest::newRow(QString("layers-%1-fixed-%2").arg(numRefreshLayers).arg(fixedPatchSize).toLatin1())
+                << numRefreshLayers << fixedPatchSize;
+        }
+
+        QTest::newRow(QString("layers-%1-adaptive").arg(numRefreshLayers).toLatin1())
+            << numRefreshLayers << 0;
+    }
+}
+
+/**
+ * Compares full refreshes of the image with the fixed update patch
+ * sizes and with the size adapted to the measured merge time. The
+ * cost of merging of a pixel grows with the number of layers, so the
+ * adapted size is expected to differ for the two layer counts.
+ *
+ * Reports the time of a refresh and the merge statistics collected
+ * by KisUpdateTimeMonitor.
+ */
+void KisUpdateSchedulerBenchmark::benchmarkFullRefresh()
+{
+    QFETCH(int, numRefreshLayers);
+    QFETCH(int, fixedPatchSize);
+
+    const int refreshImageSize = 2048;
+    const int numRefreshes = 8;
+
+    KisImageConfig config(false);
+    const bool oldAdaptive = config.adaptiveUpdatePatchSize();
+    const int oldPatchWidth = config.updatePatchWidth();
+    const int oldPatchHeight = config.updatePatchHeight();
+
+    config.setAdaptiveUpdatePatchSize(!fixedPatchSize);
+    config.setUpdatePatchWidth(fixedPatchSize ? fixedPatchSize : 512);
+    config.setUpdatePatchHeight(fixedPatchSize ? fixedPatchSize : 512);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, refreshImageSize, refreshImageSize, cs, "full refresh benchmark");
+
+    for (int i = 0; i < numRefreshLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(image->bounds(), KoColor(QColor(8 * i, 255 - 8 * i, 128, 200), cs));
+        image->addNode(layer, image->root());
+    }
+
+    // the first refresh lets the adaptive mode measure the merge time
+    image->initialRefreshGraph();
+
+    KisUpdateTimeMonitor::instance()->resetMergeJobsStatistics();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < numRefreshes; i++) {
+            image->refreshGraphAsync();
+            image->waitForDone();
+        }
+    }
+
+    const qint64 wallTime = timer.nsecsElapsed();
+    const KisUpdateTimeMonitor::MergeJobsStatistics stats =
+        KisUpdateTimeMonitor::instance()->mergeJobsStatistics();
+
+    qDebug() << "Layers:" << numRefreshLayers
+             << "Patch:" << (fixedPatchSize ? QString::number(fixedPatchSize) : QString("adaptive"))
+             << "Refresh time:" << wallTime / 1000000.0 / numRefreshes << "ms";
+    qDebug() << "Merge jobs:" << stats.numJobs
+             << "Time/job:" << stats.averageJobTime() << "ms"
+             << "Time/px:" << stats.nsecsPerPixel() << "ns"
+             << "Last adapted patch:" << stats.patchSize;
+
+    config.setAdaptiveUpdatePatchSize(oldAdaptive);
+    config.setUpdatePatchWidth(oldPatchWidth);
+    config.setUpdatePatchHeight(oldPatchHeight);
+}
+
+QTEST_MAIN(KisUpdateSchedulerBenchmark)
@@ -0,0 +1,24 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISUPDATESCHEDULERBENCHMARK_H
+#define KISUPDATESCHEDULERBENCHMARK_H
+
+#include <QtTest>
+
+class KisUpdateSchedulerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkStrokeJobs_data();
+    void benchmarkStrokeJobs();
+
+    void benchmarkFullRefresh_data();
+    void benchmarkFullRefresh();
+};
+
+#endif // KISUPDATESCHEDULERBENCHMARK_H
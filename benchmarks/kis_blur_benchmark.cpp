@@ -36,6 +36,10 @@
 
 #include "kis_selection.h"
 #include <kis_iterator_ng.h>
+#include <kis_gaussian_kernel.h>
+#include <kis_convolution_kernel.h>
+#include <kis_convolution_painter.h>
+#include "testing_timed_default_bounds.h"
 
 void KisBlurBenchmark::initTestCase()
 {
@@ -87,6 +91,77 @@ void KisBlurBenchmark::benchmarkFilter()
     }
 }
 
+void KisBlurBenchmark::benchmarkGaussian_data()
+{
+    QTest::addColumn<qreal>("radius");
+    QTest::addColumn<int>("method");
+
+    const QVector<qreal> radii = {5, 20, 50, 100, 200, 400};
+
+    for (qreal radius : radii) {
+        QTest::newRow(QString("exact-%1").arg(radius).toLatin1())
+            << radius << int(KisGaussianKernel::BLUR_EXACT);
+        QTest::newRow(QString("fast-%1").arg(radius).toLatin1())
+            << radius << int(KisGaussianKernel::BLUR_FAST);
+    }
+}
+
+void KisBlurBenchmark::benchmarkGaussian()
+{
+    QFETCH(qreal, radius);
+    QFETCH(int, method);
+
+    const QRect rect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+
+    KisPaintDeviceSP device = new KisPaintDevice(*m_device);
+    device->setDefaultBounds(new TestUtil::TestingTimedDefaultBounds(rect));
+
+    QBENCHMARK_ONCE {
+        KisGaussianKernel::applyGaussian(device, rect, radius, radius,
+                                         QBitArray(), 0, false, BORDER_REPEAT,
+                                         KisGaussianKernel::BlurMethod(method));
+    }
+}
+
+void KisBlurBenchmark::benchmarkFFTConvolution_data()
+{
+    QTest::addColumn<qreal>("radius");
+    QTest::addColumn<bool>("useTiling");
+
+    const QVector<qreal> radii = {10, 50, 200};
 
+    for (qreal radius : radii) {
+        QTest::newRow(QString("whole-%1").arg(radius).toLatin1()) << radius << false;
+        QTest::newRow(QString("tiled-%1").arg(radius).toLatin1()) << radius << true;
+    }
+}
+
+void KisBlurBenchmark::benchmarkFFTConvolution()
+{
+    QFETCH(qreal, radius);
+    QFETCH(bool, useTiling);
+
+    if (!KisConvolutionPainter::supportsFFTW()) {
+        QSKIP("FFTW is not available");
+    }
+
+    const QRect rect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+
+    KisPaintDeviceSP device = new KisPaintDevice(*m_device);
+    device->setDefaultBounds(new TestUtil::TestingTimedDefaultBounds(rect));
+
+    KisConvolutionKernelSP kernel = KisGaussianKernel::createUniform2DKernel(radius, radius);
+
+    KisConvolutionPainter::resetFFTPeakMemoryUsage();
+
+    QBENCHMARK_ONCE {
+        KisConvolutionPainter painter(device, KisConvolutionPainter::FFTW);
+        painter.setFFTTilingEnabled(useTiling);
+        painter.applyMatrix(kernel, device, rect.topLeft(), rect.topLeft(), rect.size(), BORDER_REPEAT);
+    }
+
+    qDebug() << "FFT buffers peak memory:"
+             << KisConvolutionPainter::fftPeakMemoryUsage() / (1024 * 1024) << "MiB";
+}
 
 QTEST_MAIN(KisBlurBenchmark)
@@ -39,6 +39,12 @@ private Q_SLOTS:
     void cleanupTestCase();
     
     void benchmarkFilter();
+
+    void benchmarkGaussian_data();
+    void benchmarkGaussian();
+
+    void benchmarkFFTConvolution_data();
+    void benchmarkFFTConvolution();
     
 };
 
@@ -43,10 +43,14 @@
 #include <KoColorSpace.h>
 #include <KoCompositeOp.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
 
 #include <KoColorSpaceTraits.h>
 #include <KoCompositeOpAlphaDarken.h>
 #include <KoCompositeOpOver.h>
+#include <KoCompositeOpCopy2.h>
+#include <KoCompositeOpGeneric.h>
+#include <KoCompositeOpRegistry.h>
 #include <KoOptimizedCompositeOpFactory.h>
 #include <KoAlphaDarkenParamsWrapper.h>
 
@@ -66,7 +70,8 @@
 enum AlphaRange {
     ALPHA_ZERO,
     ALPHA_UNIT,
-    ALPHA_RANDOM
+    ALPHA_RANDOM,
+    ALPHA_MIXED
 };
 
 
@@ -83,6 +88,16 @@ inline channel_type generateAlphaValue(AlphaRange range, RandomGenerator &rnd) {
     case ALPHA_RANDOM:
         value = rnd();
         break;
+    case ALPHA_MIXED:
+        // a lot of zero and unit values to hit the special
+        // cases in the ops, mixed with the random ones
+        value = rnd();
+        if (value < rnd.unit() / 4) {
+            value = 0;
+        } else if (value > rnd.unit() / 4 * 3) {
+            value = rnd.unit();
+        }
+        break;
     }
 
     return value;
@@ -126,6 +141,27 @@ struct RandomGenerator<quint8>
     boost::mt11213b m_rnd;
 };
 
+template <>
+struct RandomGenerator<quint16>
+{
+    RandomGenerator(int seed)
+        : m_smallint(0,65535),
+          m_rnd(seed)
+    {
+    }
+
+    quint16 operator() () {
+        return m_smallint(m_rnd);
+    }
+
+    quint16 unit() {
+        return KoColorSpaceMathsTraits<quint16>::unitValue;
+    }
+
+    boost::uniform_smallint<int> m_smallint;
+    boost::mt11213b m_rnd;
+};
+
 template <>
 struct RandomGenerator<float>
 {
@@ -254,6 +290,8 @@ QVector<Tile> generateTiles(int size,
 
         if (pixelSize == 4) {
             generateDataLine<quint8>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
+        } else if (pixelSize == 8) {
+            generateDataLine<quint16>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else if (pixelSize == 16) {
             generateDataLine<float>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else {
@@ -280,6 +318,14 @@ inline bool fuzzyCompare(channel_type a, channel_type b, channel_type prec) {
     return qAbs(a - b) <= prec;
 }
 
+/**
+ * Float values are not clamped by some of the blending modes, so
+ * the values above unit are compared relatively
+ */
+inline bool fuzzyCompare(float a, float b, float prec) {
+    return qAbs(a - b) <= prec * qMax(1.0f, qAbs(b));
+}
+
 template <typename channel_type>
 inline bool comparePixels(channel_type *p1, channel_type *p2, channel_type prec) {
     return (p1[3] == p2[3] && p1[3] == 0) ||
@@ -321,7 +367,7 @@ bool compareTwoOpsPixels(QVector<Tile> &tiles, channel_type prec) {
     return true;
 }
 
-bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2)
+bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2, float floatPrecision = 2e-7)
 {
     Q_ASSERT(op1->colorSpace()->pixelSize() == op2->colorSpace()->pixelSize());
     const quint32 pixelSize = op1->colorSpace()->pixelSize();
@@ -329,8 +375,8 @@ bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp
     QVector<Tile> tiles = generateTiles(2, alignment, alignment, ALPHA_RANDOM, ALPHA_RANDOM, op1->colorSpace()->pixelSize());
 
     KoCompositeOp::ParameterInfo params;
-    params.dstRowStride  = 4 * rowStride;
-    params.srcRowStride  = 4 * rowStride;
+    params.dstRowStride  = pixelSize * rowStride;
+    params.srcRowStride  = pixelSize * rowStride;
     params.maskRowStride = rowStride;
     params.rows          = processRect.height();
     params.cols          = processRect.width();
@@ -353,8 +399,11 @@ bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp
     if (pixelSize == 4) {
         compareResult = compareTwoOpsPixels<quint8>(tiles, 10);
     }
+    else if (pixelSize == 8) {
+        compareResult = compareTwoOpsPixels<quint16>(tiles, 257);
+    }
     else if (pixelSize == 16) {
-        compareResult = compareTwoOpsPixels<float>(tiles, 2e-7);
+        compareResult = compareTwoOpsPixels<float>(tiles, floatPrecision);
     }
     else {
         qFatal("Pixel size %i is not implemented", pixelSize);
@@ -384,12 +433,14 @@ QString getTestName(bool haveMask,
     testName +=
         srcAlphaRange == ALPHA_RANDOM ? "SrcRand " :
         srcAlphaRange == ALPHA_ZERO   ? "SrcZero " :
-        srcAlphaRange == ALPHA_UNIT   ? "SrcUnit " : "###";
+        srcAlphaRange == ALPHA_UNIT   ? "SrcUnit " :
+        srcAlphaRange == ALPHA_MIXED  ? "SrcMixd " : "###";
 
     testName +=
         dstAlphaRange == ALPHA_RANDOM ? "DstRand" :
         dstAlphaRange == ALPHA_ZERO   ? "DstZero" :
-        dstAlphaRange == ALPHA_UNIT   ? "DstUnit" : "###";
+        dstAlphaRange == ALPHA_UNIT   ? "DstUnit" :
+        dstAlphaRange == ALPHA_MIXED  ? "DstMixd" : "###";
 
     return testName;
 }
@@ -408,11 +459,12 @@ void benchmarkCompositeOp(const KoCompositeOp *op,
     QVector<Tile> tiles =
         generateTiles(numTiles, srcAlignmentShift, dstAlignmentShift, srcAlphaRange, dstAlphaRange, op->colorSpace()->pixelSize());
 
-    const int tileOffset = 4 * (processRect.y() * rowStride + processRect.x());
+    const quint32 pixelSize = op->colorSpace()->pixelSize();
+    const int tileOffset = pixelSize * (processRect.y() * rowStride + processRect.x());
 
     KoCompositeOp::ParameterInfo params;
-    params.dstRowStride  = 4 * rowStride;
-    params.srcRowStride  = 4 * rowStride;
+    params.dstRowStride  = pixelSize * rowStride;
+    params.srcRowStride  = pixelSize * rowStride;
     params.maskRowStride = rowStride;
     params.rows          = processRect.height();
     params.cols          = processRect.width();
@@ -709,6 +761,198 @@ void KisCompositionBenchmark::compareRgbF32OverOps()
     delete opAct;
 }
 
+void createRgb16Ops(const QString &id, KoCompositeOp **optimizedOp, KoCompositeOp **legacyOp)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+
+    if (id == "over") {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createOverOp64(cs);
+        *legacyOp = new KoCompositeOpOver<KoBgrU16Traits>(cs);
+    } else if (id == "alphadarken-hard") {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(cs);
+        *legacyOp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>(cs);
+    } else if (id == "alphadarken-creamy") {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(cs);
+        *legacyOp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>(cs);
+    } else {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createCopyOp64(cs);
+        *legacyOp = new KoCompositeOpCopy2<KoBgrU16Traits>(cs);
+    }
+}
+
+const QStringList rgb16OpIds({"over", "alphadarken-hard", "alphadarken-creamy", "copy"});
+
+template <class Traits>
+KoCompositeOp* createLegacyGenericSCOp(const KoColorSpace *cs, const QString &id)
+{
+    typedef typename Traits::channels_type T;
+
+    if (id == COMPOSITE_MULT) {
+        return new KoCompositeOpGenericSC<Traits, &cfMultiply<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_SCREEN) {
+        return new KoCompositeOpGenericSC<Traits, &cfScreen<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_OVERLAY) {
+        return new KoCompositeOpGenericSC<Traits, &cfOverlay<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_HARD_LIGHT) {
+        return new KoCompositeOpGenericSC<Traits, &cfHardLight<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_ADD) {
+        return new KoCompositeOpGenericSC<Traits, &cfAddition<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_SUBTRACT) {
+        return new KoCompositeOpGenericSC<Traits, &cfSubtract<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_LINEAR_BURN) {
+        return new KoCompositeOpGenericSC<Traits, &cfLinearBurn<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_DODGE) {
+        return new KoCompositeOpGenericSC<Traits, &cfColorDodge<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_DARKEN) {
+        return new KoCompositeOpGenericSC<Traits, &cfDarkenOnly<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_LIGHTEN) {
+        return new KoCompositeOpGenericSC<Traits, &cfLightenOnly<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_DIFF) {
+        return new KoCompositeOpGenericSC<Traits, &cfDifference<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    } else if (id == COMPOSITE_EXCLUSION) {
+        return new KoCompositeOpGenericSC<Traits, &cfExclusion<T> >(cs, id, id, KoCompositeOp::categoryMisc());
+    }
+
+    return 0;
+}
+
+KoOptimizedCompositeOpFactory::GenericSCMode genericSCMode(const QString &id)
+{
+    if (id == COMPOSITE_MULT) {
+        return KoOptimizedCompositeOpFactory::GenericSCMultiply;
+    } else if (id == COMPOSITE_SCREEN) {
+        return KoOptimizedCompositeOpFactory::GenericSCScreen;
+    } else if (id == COMPOSITE_OVERLAY) {
+        return KoOptimizedCompositeOpFactory::GenericSCOverlay;
+    } else if (id == COMPOSITE_HARD_LIGHT) {
+        return KoOptimizedCompositeOpFactory::GenericSCHardLight;
+    } else if (id == COMPOSITE_ADD) {
+        return KoOptimizedCompositeOpFactory::GenericSCAddition;
+    } else if (id == COMPOSITE_SUBTRACT) {
+        return KoOptimizedCompositeOpFactory::GenericSCSubtract;
+    } else if (id == COMPOSITE_LINEAR_BURN) {
+        return KoOptimizedCompositeOpFactory::GenericSCLinearBurn;
+    } else if (id == COMPOSITE_DODGE) {
+        return KoOptimizedCompositeOpFactory::GenericSCColorDodge;
+    } else if (id == COMPOSITE_DARKEN) {
+        return KoOptimizedCompositeOpFactory::GenericSCDarken;
+    } else if (id == COMPOSITE_LIGHTEN) {
+        return KoOptimizedCompositeOpFactory::GenericSCLighten;
+    } else if (id == COMPOSITE_DIFF) {
+        return KoOptimizedCompositeOpFactory::GenericSCDifference;
+    } else if (id == COMPOSITE_EXCLUSION) {
+        return KoOptimizedCompositeOpFactory::GenericSCExclusion;
+    }
+
+    return KoOptimizedCompositeOpFactory::GenericSCNone;
+}
+
+void createGenericSCOps(const QString &depth, const QString &id,
+                        KoCompositeOp **optimizedOp, KoCompositeOp **legacyOp)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", depth, "");
+    const KoOptimizedCompositeOpFactory::GenericSCMode mode = genericSCMode(id);
+
+    if (depth == Integer8BitsColorDepthID.id()) {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createGenericSCOp32(cs, mode, id, id, KoCompositeOp::categoryMisc());
+        *legacyOp = createLegacyGenericSCOp<KoBgrU8Traits>(cs, id);
+    } else if (depth == Integer16BitsColorDepthID.id()) {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createGenericSCOp64(cs, mode, id, id, KoCompositeOp::categoryMisc());
+        *legacyOp = createLegacyGenericSCOp<KoBgrU16Traits>(cs, id);
+    } else {
+        *optimizedOp = KoOptimizedCompositeOpFactory::createGenericSCOp128(cs, mode, id, id, KoCompositeOp::categoryMisc());
+        *legacyOp = createLegacyGenericSCOp<KoRgbF32Traits>(cs, id);
+    }
+}
+
+void addGenericSCOpsRows(bool addImplementation)
+{
+    QTest::addColumn<QString>("depth");
+    QTest::addColumn<QString>("id");
+    if (addImplementation) {
+        QTest::addColumn<bool>("optimized");
+    }
+
+    const QStringList ids({COMPOSITE_MULT, COMPOSITE_SCREEN, COMPOSITE_OVERLAY,
+                           COMPOSITE_HARD_LIGHT, COMPOSITE_ADD, COMPOSITE_SUBTRACT,
+                           COMPOSITE_LINEAR_BURN, COMPOSITE_DODGE, COMPOSITE_DARKEN,
+                           COMPOSITE_LIGHTEN, COMPOSITE_DIFF, COMPOSITE_EXCLUSION});
+
+    const QStringList depths({Integer8BitsColorDepthID.id(),
+                              Integer16BitsColorDepthID.id(),
+                              Float32BitsColorDepthID.id()});
+
+    Q_FOREACH (const QString &depth, depths) {
+        Q_FOREACH (const QString &id, ids) {
+            const QString name = QString("%1-%2").arg(depth).arg(id);
+
+            if (addImplementation) {
+                QTest::newRow(qPrintable(name + "-legacy")) << depth << id << false;
+                QTest::newRow(qPrintable(name + "-optimized")) << depth << id << true;
+            } else {
+                QTest::newRow(qPrintable(name)) << depth << id;
+            }
+        }
+    }
+}
+
+void KisCompositionBenchmark::compareGenericSCOps_data()
+{
+    addGenericSCOpsRows(false);
+}
+
+void KisCompositionBenchmark::compareGenericSCOps()
+{
+    QFETCH(QString, depth);
+    QFETCH(QString, id);
+
+    KoCompositeOp *opAct = 0;
+    KoCompositeOp *opExp = 0;
+    createGenericSCOps(depth, id, &opAct, &opExp);
+
+    if (!opAct) {
+        delete opExp;
+        QSKIP("The op has no vectorized implementation");
+    }
+
+    QVERIFY(compareTwoOps(true, opAct, opExp, 1e-5));
+    QVERIFY(compareTwoOps(false, opAct, opExp, 1e-5));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::testGenericSCCompositeOps_data()
+{
+    addGenericSCOpsRows(true);
+}
+
+void KisCompositionBenchmark::testGenericSCCompositeOps()
+{
+    QFETCH(QString, depth);
+    QFETCH(QString, id);
+    QFETCH(bool, optimized);
+
+    KoCompositeOp *optimizedOp = 0;
+    KoCompositeOp *legacyOp = 0;
+    createGenericSCOps(depth, id, &optimizedOp, &legacyOp);
+
+    KoCompositeOp *op = optimized ? optimizedOp : legacyOp;
+
+    if (op) {
+        qDebug() << "Testing Composite Op:" << depth << op->id() << "(" << (optimized ? "Optimized" : "Legacy") << ")";
+        benchmarkCompositeOp(op, true, 0.5, 0.3, 0, 0, ALPHA_RANDOM, ALPHA_RANDOM);
+        benchmarkCompositeOp(op, false, 1.0, 1.0, 0, 0, ALPHA_RANDOM, ALPHA_RANDOM);
+    }
+
+    delete optimizedOp;
+    delete legacyOp;
+
+    if (!op) {
+        QSKIP("The op has no vectorized implementation");
+    }
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenLegacy()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -773,6 +1017,33 @@ void KisCompositionBenchmark::testRgbF32CompositeOverOptimized()
     delete op;
 }
 
+void KisCompositionBenchmark::testRgb16CompositeOps_data()
+{
+    QTest::addColumn<QString>("id");
+    QTest::addColumn<bool>("optimized");
+
+    Q_FOREACH (const QString &id, rgb16OpIds) {
+        QTest::newRow(qPrintable(id + "-legacy")) << id << false;
+        QTest::newRow(qPrintable(id + "-optimized")) << id << true;
+    }
+}
+
+void KisCompositionBenchmark::testRgb16CompositeOps()
+{
+    QFETCH(QString, id);
+    QFETCH(bool, optimized);
+
+    KoCompositeOp *optimizedOp = 0;
+    KoCompositeOp *legacyOp = 0;
+    createRgb16Ops(id, &optimizedOp, &legacyOp);
+
+    benchmarkCompositeOp(optimized ? optimizedOp : legacyOp,
+                         QString("RGB16 ") + (optimized ? "Optimized" : "Legacy"));
+
+    delete optimizedOp;
+    delete legacyOp;
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenReal_Aligned()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -46,6 +46,9 @@ private Q_SLOTS:
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
 
+    void compareGenericSCOps_data();
+    void compareGenericSCOps();
+
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
 
@@ -58,6 +61,12 @@ private Q_SLOTS:
     void testRgbF32CompositeOverLegacy();
     void testRgbF32CompositeOverOptimized();
 
+    void testRgb16CompositeOps_data();
+    void testRgb16CompositeOps();
+
+    void testGenericSCCompositeOps_data();
+    void testGenericSCCompositeOps();
+
     void testRgb8CompositeAlphaDarkenReal_Aligned();
     void testRgb8CompositeOverReal_Aligned();
 
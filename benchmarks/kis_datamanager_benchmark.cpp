@@ -20,6 +20,12 @@
 #include "kis_benchmark_values.h"
 
 #include <QTest>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <kis_datamanager.h>
 
 // RGBA
@@ -198,5 +204,157 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+namespace {
+
+// the number of passes every thread makes over the tiles of the device
+const int LOOKUP_PASSES = 50;
+
+void addThreadsRows()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QList<int> threads = {1, 4, QThread::idealThreadCount(), 32};
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    Q_FOREACH (int numThreads, threads) {
+        QTest::newRow(QString("%1 threads").arg(numThreads).toLatin1()) << numThreads;
+    }
+}
+
+/**
+ * Fetches all the tiles of \p rect from \p dm in every one of \p numThreads
+ * threads, the way the iterators of the threads composing the same device
+ * do it, and reports the throughput of the hash table lookups
+ */
+void runConcurrentLookups(KisDataManager &dm, const QRect &rect, int numThreads,
+                          std::function<void()> writerFunc = std::function<void()>())
+{
+    const int firstCol = rect.x() / KisTileData::WIDTH;
+    const int firstRow = rect.y() / KisTileData::HEIGHT;
+    const int numCols = rect.width() / KisTileData::WIDTH;
+    const int numRows = rect.height() / KisTileData::HEIGHT;
+
+    auto readerFunc = [&] () {
+        for (int pass = 0; pass < LOOKUP_PASSES; pass++) {
+            for (int row = firstRow; row < firstRow + numRows; row++) {
+                for (int col = firstCol; col < firstCol + numCols; col++) {
+                    KisTileSP tile = dm.getTile(col, row, false);
+                    Q_UNUSED(tile);
+                }
+            }
+        }
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads + (writerFunc ? 1 : 0));
+
+    std::atomic<bool> readersDone(false);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        QFuture<void> writer;
+        if (writerFunc) {
+            writer = QtConcurrent::run(&pool, [&] () {
+                while (!readersDone) {
+                    writerFunc();
+                }
+            });
+        }
+
+        QList<QFuture<void>> readers;
+        for (int i = 0; i < numThreads; i++) {
+            readers << QtConcurrent::run(&pool, readerFunc);
+        }
+
+        Q_FOREACH (QFuture<void> reader, readers) {
+            reader.waitForFinished();
+        }
+
+        readersDone = true;
+        writer.waitForFinished();
+    }
+
+    const qreal elapsed = timer.nsecsElapsed() / 1000000.0;
+    const qreal numLookups = qreal(numThreads) * LOOKUP_PASSES * numCols * numRows;
+
+    qDebug() << QTest::currentDataTag()
+             << "Time:" << elapsed << "ms"
+             << "Lookups/ms per thread:" << numLookups / numThreads / elapsed;
+}
+
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentTileLookup_data()
+{
+    addThreadsRows();
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentTileLookup()
+{
+    QFETCH(int, numThreads);
+
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    const QRect rect(0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    dm.clear(rect.x(), rect.y(), rect.width(), rect.height(), 128);
+
+    runConcurrentLookups(dm, rect, numThreads);
+
+    delete[] p;
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentDefaultTileLookup_data()
+{
+    addThreadsRows();
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentDefaultTileLookup()
+{
+    QFETCH(int, numThreads);
+
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    // no tiles exist, so every lookup creates a wrapper of the default tile data
+    const QRect rect(0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    runConcurrentLookups(dm, rect, numThreads);
+
+    delete[] p;
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentLookupWithWriter_data()
+{
+    addThreadsRows();
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentLookupWithWriter()
+{
+    QFETCH(int, numThreads);
+
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    const QRect rect(0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    dm.clear(rect.x(), rect.y(), rect.width(), rect.height(), 128);
+
+    // a writer keeps adding and removing the tiles next to the ones being read
+    const QRect writerRect(TEST_IMAGE_WIDTH, 0, 8 * KisTileData::WIDTH, TEST_IMAGE_HEIGHT);
+    auto writerFunc = [&] () {
+        dm.clear(writerRect.x(), writerRect.y(), writerRect.width(), writerRect.height(), 200);
+        dm.clear(writerRect.x(), writerRect.y(), writerRect.width(), writerRect.height(), p);
+        dm.purge(writerRect);
+    };
+
+    runConcurrentLookups(dm, rect, numThreads, writerFunc);
+
+    delete[] p;
+}
 
 QTEST_MAIN(KisDatamanagerBenchmark)
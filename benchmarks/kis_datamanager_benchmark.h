@@ -36,6 +36,13 @@ private Q_SLOTS:
     void benchmarkExtent();
     void benchmarkClear();
     void benchmarkMemCpy();
+
+    void benchmarkConcurrentTileLookup_data();
+    void benchmarkConcurrentTileLookup();
+    void benchmarkConcurrentDefaultTileLookup_data();
+    void benchmarkConcurrentDefaultTileLookup();
+    void benchmarkConcurrentLookupWithWriter_data();
+    void benchmarkConcurrentLookupWithWriter();
 };
 
 #endif
@@ -37,6 +37,8 @@
 #include <brushengine/kis_paintop_preset.h>
 
 #include "tiles3/kis_tile_data_store.h"
+#include "tiles3/kis_tile_data.h"
+#include "tiles3/swap/kis_swapped_data_store.h"
 #include "kis_surrogate_undo_adapter.h"
 #include "kis_image_config.h"
 #define LOAD_PRESET_OR_RETURN(preset, fileName)                         \
@@ -228,4 +230,73 @@ void KisLowMemoryBenchmark::memory2000History100Pool500HugeBrush()
                       2000, 600, 500, 0);
 }
 
+void KisLowMemoryBenchmark::benchmarkSwapBackends_data()
+{
+    QTest::addColumn<bool>("useMappedSwapFile");
+
+    QTest::newRow("window") << false;
+    QTest::newRow("mapped") << true;
+}
+
+/**
+ * Emulates panning over a huge swapped-out canvas: the viewport
+ * moves from left to right, the tiles that become visible are
+ * swapped in and the ones that leave the viewport are swapped out.
+ */
+void KisLowMemoryBenchmark::benchmarkSwapBackends()
+{
+    QFETCH(bool, useMappedSwapFile);
+
+    const int gridSize = 64;
+    const int viewportColumns = 16;
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+
+    KisImageConfig config(false);
+    const bool oldUseMappedSwapFile = config.useMappedSwapFile();
+    config.setUseMappedSwapFile(useMappedSwapFile);
+
+    KisSwappedDataStore store;
+
+    QVector<KisTileData*> tiles;
+
+    for (int col = 0; col < gridSize; col++) {
+        for (int row = 0; row < gridSize; row++) {
+            KisTileData *td = new KisTileData(pixelSize, defaultPixel, KisTileDataStore::instance(), false);
+
+            quint8 *ptr = td->data();
+            const int numBytes = pixelSize * KisTileData::WIDTH * KisTileData::HEIGHT;
+            for (int i = 0; i < numBytes; i++) {
+                ptr[i] = quint8((i * 7 + (i >> 5)) ^ (col * gridSize + row));
+            }
+
+            store.trySwapOutTileData(td);
+            tiles.append(td);
+        }
+    }
+
+    QBENCHMARK_ONCE {
+        for (int col = 0; col < gridSize; col++) {
+            for (int row = 0; row < gridSize; row++) {
+                store.swapInTileData(tiles[col * gridSize + row]);
+            }
+
+            if (col >= viewportColumns) {
+                for (int row = 0; row < gridSize; row++) {
+                    store.trySwapOutTileData(tiles[(col - viewportColumns) * gridSize + row]);
+                }
+            }
+        }
+    }
+
+    Q_FOREACH (KisTileData *td, tiles) {
+        if (!td->data()) {
+            store.forgetTileData(td);
+        }
+        delete td;
+    }
+
+    config.setUseMappedSwapFile(oldUseMappedSwapFile);
+}
+
 QTEST_MAIN(KisLowMemoryBenchmark)
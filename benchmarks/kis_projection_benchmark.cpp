@@ -21,9 +21,12 @@
 #include "kis_benchmark_values.h"
 
 #include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
 
 #include <kis_group_layer.h>
+#include <kis_paint_layer.h>
 #include <kis_paint_device.h>
+#include <KisPartialProjectionsCache.h>
 #include <KisDocument.h>
 #include <kis_image.h>
 #include <KisPart.h>
@@ -58,5 +61,75 @@ void KisProjectionBenchmark::benchmarkLoading()
     }
 }
 
+void KisProjectionBenchmark::benchmarkPaintingOnActiveLayer_data()
+{
+    QTest::addColumn<int>("numLayers");
+    QTest::addColumn<bool>("cacheBelow");
+    QTest::addColumn<bool>("cacheAbove");
+
+    Q_FOREACH (int numLayers, QVector<int>({50, 200})) {
+        QTest::newRow(QString("%1-layers-no-cache").arg(numLayers).toLatin1()) << numLayers << false << false;
+        QTest::newRow(QString("%1-layers-below").arg(numLayers).toLatin1()) << numLayers << true << false;
+        QTest::newRow(QString("%1-layers-below-above").arg(numLayers).toLatin1()) << numLayers << true << true;
+    }
+}
+
+/**
+ * Paints a stroke of dabs on a layer lying in a big group of layers: three
+ * quarters of the layers are below the active one and the rest are above.
+ * The stroke area is painted once before the measurement to fill the
+ * partial projections cache. With the cache enabled the time should not
+ * depend on the number of layers.
+ */
+void KisProjectionBenchmark::benchmarkPaintingOnActiveLayer()
+{
+    QFETCH(int, numLayers);
+    QFETCH(bool, cacheBelow);
+    QFETCH(bool, cacheAbove);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 2048, 2048, cs, "projection benchmark");
+
+    KisGroupLayerSP group = new KisGroupLayer(image, "group", OPACITY_OPAQUE_U8);
+    image->addNode(group, image->root());
+
+    KisPaintLayerSP activeLayer;
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(image->bounds(), KoColor(QColor(i % 256, 255 - i % 256, 128, 64), cs));
+        image->addNode(layer, group);
+
+        if (i == numLayers * 3 / 4) {
+            activeLayer = layer;
+        }
+    }
+
+    image->initialRefreshGraph();
+
+    const bool oldCacheBelow = KisPartialProjectionsCache::belowCachingEnabled();
+    const bool oldCacheAbove = KisPartialProjectionsCache::aboveCachingEnabled();
+    KisPartialProjectionsCache::setCachingEnabled(cacheBelow, cacheAbove);
+
+    const int numDabs = 64;
+
+    auto paintStroke = [&] () {
+        for (int i = 0; i < numDabs; i++) {
+            const QRect dabRect(512 + 16 * i, 512 + 8 * i, 64, 64);
+            activeLayer->paintDevice()->fill(dabRect, KoColor(QColor(255, 4 * i, 0, 128), cs));
+            activeLayer->setDirty(dabRect);
+        }
+        image->waitForDone();
+    };
+
+    paintStroke();
+
+    QBENCHMARK {
+        paintStroke();
+    }
+
+    KisPartialProjectionsCache::setCachingEnabled(oldCacheBelow, oldCacheAbove);
+}
+
 
 QTEST_MAIN(KisProjectionBenchmark)
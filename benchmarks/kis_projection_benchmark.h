@@ -32,6 +32,9 @@ private Q_SLOTS:
 
     void benchmarkProjection();
     void benchmarkLoading();
+
+    void benchmarkPaintingOnActiveLayer_data();
+    void benchmarkPaintingOnActiveLayer();
 };
 
 #endif
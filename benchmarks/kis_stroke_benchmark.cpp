@@ -202,6 +202,30 @@ void KisStrokeBenchmark::sprayTextureRL()
 }
 
 
+void KisStrokeBenchmark::spray300pxWuParticles()
+{
+    QString presetFileName = "spray_300px_wu_particles.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::spray300pxWuParticlesRL()
+{
+    QString presetFileName = "spray_300px_wu_particles.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::particle500particles()
+{
+    QString presetFileName = "particle_500particles.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::particle500particlesRL()
+{
+    QString presetFileName = "particle_500particles.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
 void KisStrokeBenchmark::spray30px21particles()
 {
     QString presetFileName = "spray_30px21rasterParticles.kpp";
@@ -308,6 +332,19 @@ void KisStrokeBenchmark::hairy30InkDepletionRL()
     benchmarkRandomLines(presetFileName);
 }
 
+void KisStrokeBenchmark::hairy200pxDense()
+{
+    // tens of thousands of bristles with ink depletion
+    QString presetFileName = "hairybrush_200px_dense.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::hairy200pxDenseRL()
+{
+    QString presetFileName = "hairybrush_200px_dense.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
 
 void KisStrokeBenchmark::softbrushOpacity()
 {
@@ -354,9 +391,33 @@ void KisStrokeBenchmark::colorsmudge()
 void KisStrokeBenchmark::colorsmudgeRL()
 {
     QString presetFileName = "colorsmudge.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudge200pxSmearing()
+{
+    QString presetFileName = "colorsmudge_200px_smearing.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudge200pxSmearingRL()
+{
+    QString presetFileName = "colorsmudge_200px_smearing.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudge200pxDulling()
+{
+    QString presetFileName = "colorsmudge_200px_dulling.kpp";
     benchmarkStroke(presetFileName);
 }
 
+void KisStrokeBenchmark::colorsmudge200pxDullingRL()
+{
+    QString presetFileName = "colorsmudge_200px_dulling.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
 
 void KisStrokeBenchmark::roundMarker()
 {
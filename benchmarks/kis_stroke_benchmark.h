@@ -102,6 +102,9 @@ private Q_SLOTS:
     void hairy30InkDepletion();
     void hairy30InkDepletionRL();
 
+    void hairy200pxDense();
+    void hairy200pxDenseRL();
+
     // Spray brush benchmark1
     void spray30px21particles();
     void spray30px21particlesRL();
@@ -115,6 +118,13 @@ private Q_SLOTS:
     void sprayTexture();
     void sprayTextureRL();
 
+    // Spray and Particle brushes with tens of thousands of particles per dab
+    void spray300pxWuParticles();
+    void spray300pxWuParticlesRL();
+
+    void particle500particles();
+    void particle500particlesRL();
+
     void dynabrush();
     void dynabrushRL();
 
@@ -127,6 +137,13 @@ private Q_SLOTS:
     void colorsmudge();
     void colorsmudgeRL();
 
+    // Color smudge with big dabs, rendered in stripes
+    void colorsmudge200pxSmearing();
+    void colorsmudge200pxSmearingRL();
+
+    void colorsmudge200pxDulling();
+    void colorsmudge200pxDullingRL();
+
     void roundMarker();
     void roundMarkerRandomLines();
     void roundMarkerRectangle();
@@ -157,5 +157,58 @@ void KisThumbnailBenchmark::benchmarkCreateThumbnailHiQcreateThumbOversample4x()
     image.save("createThumbnailHiQcreateThumbOversample4x.png");
 }
 
+/**
+ * Paints a small dab on a copy of the device before every thumbnail,
+ * like the overview docker does while the user paints
+ */
+static void benchmarkThumbnailAfterDab(KisPaintDeviceSP srcDevice, bool useMipmap, const QString &fileName)
+{
+    KisPaintDeviceSP dev = new KisPaintDevice(*srcDevice);
+    dev->setMipmapEnabled(useMipmap);
+
+    KoColor color(Qt::red, dev->colorSpace());
+    QImage image = dev->createThumbnail(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, QRect(), OVERSAMPLE);
+
+    int i = 0;
+
+    QBENCHMARK{
+        const QRect dabRect((i * 97) % (IMAGE_WIDTH - 50), (i * 61) % (IMAGE_HEIGHT - 50), 50, 50);
+        dev->fill(dabRect, color);
+        dev->setDirty(dabRect);
+
+        image = dev->createThumbnail(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, QRect(), OVERSAMPLE,
+                                     KoColorConversionTransformation::internalRenderingIntent(),
+                                     KoColorConversionTransformation::internalConversionFlags());
+        i++;
+    }
+
+    image.save(fileName);
+}
+
+void KisThumbnailBenchmark::benchmarkCreateThumbnailAfterDab()
+{
+    benchmarkThumbnailAfterDab(m_dev, false, "createThumbnailAfterDab.png");
+}
+
+void KisThumbnailBenchmark::benchmarkCreateThumbnailMipmapAfterDab()
+{
+    benchmarkThumbnailAfterDab(m_dev, true, "createThumbnailMipmapAfterDab.png");
+}
+
+void KisThumbnailBenchmark::benchmarkCreateThumbnailMipmapFirstBuild()
+{
+    QImage image;
+
+    QBENCHMARK{
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_dev);
+        dev->setMipmapEnabled(true);
+
+        image = dev->createThumbnail(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, QRect(), OVERSAMPLE,
+                                     KoColorConversionTransformation::internalRenderingIntent(),
+                                     KoColorConversionTransformation::internalConversionFlags());
+    }
+
+    image.save("createThumbnailMipmapFirstBuild.png");
+}
 
 QTEST_MAIN(KisThumbnailBenchmark)
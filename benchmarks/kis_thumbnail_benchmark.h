@@ -49,6 +49,10 @@ private Q_SLOTS:
     void benchmarkCreateThumbnailHiQcreateThumbOversample3x();
     void benchmarkCreateThumbnailHiQcreateThumbOversample4x();
 
+    void benchmarkCreateThumbnailAfterDab();
+    void benchmarkCreateThumbnailMipmapAfterDab();
+    void benchmarkCreateThumbnailMipmapFirstBuild();
+
 };
 
 
@@ -0,0 +1,7 @@
+/* config-compression.h.  Generated by cmake from config-compression.h.cmake */
+
+/* Define if you have the LZ4 compression library */
+#cmakedefine HAVE_LZ4 1
+
+/* Define if you have the Zstandard compression library */
+#cmakedefine HAVE_ZSTD 1
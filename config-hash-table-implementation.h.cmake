@@ -1,3 +1,6 @@
 /* config-hash-table-implementation.h.  Generated by cmake from config-hash-table-implementation.h.cmake */
 
+/* Tile hash tables with lock-free lookups and QSBR reclamation of the tiles
+   (kis_tile_hash_table2.h). If not set, the tables guard every lookup with
+   a read-write lock (kis_tile_hash_table.h). */
 #cmakedefine USE_LOCK_FREE_HASH_TABLE 1
@@ -14,6 +14,7 @@
 #include <QVector>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
 #include <kis_lockless_stack.h>
 
 #define CALL_MEMBER(obj, pmf) ((obj).*(pmf))
@@ -39,24 +40,56 @@ private:
         }
     };
 
-    QAtomicInt m_rawPointerUsers;
+    /**
+     * The readers are counted in several slots, each one living in its own
+     * cache line, so that the threads reading the map concurrently would not
+     * fight for the same counter. A thread always uses the same slot, which
+     * is selected by the hash of its id.
+     *
+     * The reclamation is safe when every slot has been seen empty after the
+     * action has been enqueued: a reader which is not seen has either finished
+     * before its slot was checked or started after the object had already been
+     * unlinked from the map.
+     */
+    static const int NumReaderSlots = 16;
+
+    struct ReaderSlot {
+        QAtomicInt users;
+        char padding[64 - sizeof(QAtomicInt)];
+    };
+
+    ReaderSlot m_rawPointerUsers[NumReaderSlots];
     KisLocklessStack<Action> m_pendingActions;
     KisLocklessStack<Action> m_migrationReclaimActions;
 
+    static inline int currentReaderSlot()
+    {
+        const quint64 id = quint64(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+        return int((id * 0x9E3779B97F4A7C15ULL) >> 60) & (NumReaderSlots - 1);
+    }
+
+    bool hasRawPointerUsers() const
+    {
+        for (int i = 0; i < NumReaderSlots; i++) {
+            if (m_rawPointerUsers[i].users.loadAcquire()) return true;
+        }
+        return false;
+    }
+
     void releasePoolSafely(KisLocklessStack<Action> *pool, bool force = false) {
         KisLocklessStack<Action> tmp;
         tmp.mergeFrom(*pool);
         if (tmp.isEmpty()) return;
 
         if (force || tmp.size() > 4096) {
-            while (m_rawPointerUsers.loadAcquire());
+            while (hasRawPointerUsers());
 
             Action action;
             while (tmp.pop(action)) {
                 action();
             }
         } else {
-            if (!m_rawPointerUsers.loadAcquire()) {
+            if (!hasRawPointerUsers()) {
                 Action action;
                 while (tmp.pop(action)) {
                     action();
@@ -107,16 +140,16 @@ public:
 
     void lockRawPointerAccess()
     {
-        m_rawPointerUsers.ref();
+        m_rawPointerUsers[currentReaderSlot()].users.ref();
     }
 
     void unlockRawPointerAccess()
     {
-        m_rawPointerUsers.deref();
+        m_rawPointerUsers[currentReaderSlot()].users.deref();
     }
 
     bool sanityRawPointerAccessLocked() const {
-        return m_rawPointerUsers.loadAcquire();
+        return m_rawPointerUsers[currentReaderSlot()].users.loadAcquire();
     }
 };
 
@@ -0,0 +1,426 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisFastGaussianBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QBitArray>
+#include <QRect>
+#include <QVector>
+
+#include <KoChannelInfo.h>
+#include <KoColorSpace.h>
+#include <KoUpdater.h>
+
+#include "kis_assert.h"
+#include "kis_convolution_worker.h"
+#include "kis_default_bounds.h"
+#include "kis_gaussian_kernel.h"
+#include "kis_math_toolbox.h"
+#include "kis_paint_device.h"
+
+
+namespace {
+
+/**
+ * The number of rows transposed and filtered together in the
+ * horizontal pass. 16 floats make a cache line.
+ */
+const int laneBlockSize = 16;
+
+inline const float* lineAt(const float *data, int index, int length, int numLanes)
+{
+    return data + size_t(qBound(0, index, length - 1)) * numLanes;
+}
+
+void boxPass(const float *src, float *dst, int length, int numLanes,
+             const KisFastGaussianBlur::BoxParameters &params,
+             float *acc)
+{
+    const int radius = params.radius;
+    const float scale = params.scale;
+    const float edgeWeight = params.edgeWeight;
+
+    std::fill(acc, acc + numLanes, 0.0f);
+
+    for (int i = -radius; i <= radius; i++) {
+        const float *line = lineAt(src, i, length, numLanes);
+        for (int l = 0; l < numLanes; l++) {
+            acc[l] += line[l];
+        }
+    }
+
+    /**
+     * acc keeps the sum of the samples [i - radius, i + radius]
+     */
+    for (int i = 0; i < length; i++) {
+        const float *outerLeft = lineAt(src, i - radius - 1, length, numLanes);
+        const float *innerLeft = lineAt(src, i - radius, length, numLanes);
+        const float *outerRight = lineAt(src, i + radius + 1, length, numLanes);
+        float *out = dst + size_t(i) * numLanes;
+
+        for (int l = 0; l < numLanes; l++) {
+            out[l] = scale * (acc[l] + edgeWeight * (outerLeft[l] + outerRight[l]));
+            acc[l] += outerRight[l] - innerLeft[l];
+        }
+    }
+}
+
+struct ChannelsInfo
+{
+    ChannelsInfo(const QList<KoChannelInfo*> &_channels)
+        : channels(_channels)
+    {
+        KisMathToolbox mathToolbox;
+
+        for (int i = 0; i < channels.size(); i++) {
+            minClamp.append(mathToolbox.minChannelValue(channels[i]));
+            maxClamp.append(mathToolbox.maxChannelValue(channels[i]));
+
+            if (channels[i]->channelType() == KoChannelInfo::ALPHA) {
+                alphaCachePos = i;
+                alphaRealPos = channels[i]->pos();
+            }
+        }
+
+        toDoubleFuncPtr.resize(channels.size());
+        fromDoubleFuncPtr.resize(channels.size());
+        fromDoubleCheckNullFuncPtr.resize(channels.size());
+
+        bool result = mathToolbox.getToDoubleChannelPtr(channels, toDoubleFuncPtr);
+        result &= mathToolbox.getFromDoubleChannelPtr(channels, fromDoubleFuncPtr);
+        result &= mathToolbox.getFromDoubleCheckNullChannelPtr(channels, fromDoubleCheckNullFuncPtr);
+
+        KIS_ASSERT(result);
+    }
+
+    inline int numChannels() const {
+        return channels.size();
+    }
+
+    inline qreal clamp(int channel, qreal value) const {
+        // !(value >= min) also catches NaN
+        return value > maxClamp[channel] ? maxClamp[channel] :
+            !(value >= minClamp[channel]) ? minClamp[channel] : value;
+    }
+
+    QList<KoChannelInfo*> channels;
+
+    QVector<qreal> minClamp;
+    QVector<qreal> maxClamp;
+
+    QVector<PtrToDouble> toDoubleFuncPtr;
+    QVector<PtrFromDouble> fromDoubleFuncPtr;
+    QVector<PtrFromDoubleCheckNull> fromDoubleCheckNullFuncPtr;
+
+    int alphaCachePos = -1;
+    int alphaRealPos = -1;
+};
+
+template <class IteratorFactory>
+class BlurWorker
+{
+public:
+    BlurWorker(KisPaintDeviceSP device, const ChannelsInfo &info, KoUpdater *progress)
+        : m_device(device),
+          m_info(info),
+          m_progress(progress)
+    {
+    }
+
+    void execute(const QRect &rect, qreal xRadius, qreal yRadius, const QRect &dataRect)
+    {
+        const int xMargin = xRadius > 0.0 ? KisGaussianKernel::kernelSizeFromRadius(xRadius) / 2 : 0;
+        const int yMargin = yRadius > 0.0 ? KisGaussianKernel::kernelSizeFromRadius(yRadius) / 2 : 0;
+        const QRect cacheRect = rect.adjusted(-xMargin, -yMargin, xMargin, yMargin);
+
+        const int numSteps = m_info.numChannels() * ((xRadius > 0.0) + (yRadius > 0.0));
+        const float progressPerStep = numSteps ? 80.0 / numSteps : 0.0;
+
+        setProgress(0);
+
+        QVector<QVector<float>> planes(m_info.numChannels());
+        fillPlanes(cacheRect, dataRect, planes);
+
+        addToProgress(10);
+        if (isInterrupted()) return;
+
+        if (xRadius > 0.0) {
+            const KisFastGaussianBlur::BoxParameters params =
+                KisFastGaussianBlur::boxParameters(KisGaussianKernel::sigmaFromRadius(xRadius));
+
+            for (QVector<float> &plane : planes) {
+                plane = blurRows(plane, cacheRect.width(), cacheRect.height(), xMargin, rect.width(), params);
+
+                addToProgress(progressPerStep);
+                if (isInterrupted()) return;
+            }
+        }
+
+        if (yRadius > 0.0) {
+            const KisFastGaussianBlur::BoxParameters params =
+                KisFastGaussianBlur::boxParameters(KisGaussianKernel::sigmaFromRadius(yRadius));
+
+            QVector<float> result(rect.width() * cacheRect.height());
+
+            for (QVector<float> &plane : planes) {
+                KisFastGaussianBlur::blurLines(plane.data(), result.data(),
+                                               cacheRect.height(), rect.width(), params);
+                std::swap(plane, result);
+
+                addToProgress(progressPerStep);
+                if (isInterrupted()) return;
+            }
+        }
+
+        writePlanes(rect, yMargin, dataRect, planes);
+
+        setProgress(100);
+    }
+
+private:
+    void fillPlanes(const QRect &rect, const QRect &dataRect, QVector<QVector<float>> &planes)
+    {
+        const int numChannels = m_info.numChannels();
+
+        for (QVector<float> &plane : planes) {
+            plane.resize(rect.width() * rect.height());
+        }
+
+        typename IteratorFactory::HLineConstIterator it =
+            IteratorFactory::createHLineConstIterator(m_device, rect.x(), rect.y(), rect.width(), dataRect);
+
+        int index = 0;
+
+        for (int y = 0; y < rect.height(); y++) {
+            for (int x = 0; x < rect.width(); x++, index++) {
+                const quint8 *data = it->oldRawData();
+
+                // the color channels are blurred premultiplied
+                const float alpha = m_info.alphaCachePos >= 0 ?
+                    m_info.toDoubleFuncPtr[m_info.alphaCachePos](data, m_info.alphaRealPos) : 1.0;
+
+                for (int k = 0; k < numChannels; k++) {
+                    planes[k][index] = k != m_info.alphaCachePos ?
+                        m_info.toDoubleFuncPtr[k](data, m_info.channels[k]->pos()) * alpha :
+                        alpha;
+                }
+
+                it->nextPixel();
+            }
+
+            it->nextRow();
+        }
+    }
+
+    /**
+     * Blurs the rows of a plane of size width x height and returns
+     * the columns [offset, offset + resultWidth) of the result
+     */
+    QVector<float> blurRows(const QVector<float> &plane, int width, int height,
+                            int offset, int resultWidth,
+                            const KisFastGaussianBlur::BoxParameters &params)
+    {
+        QVector<float> result(resultWidth * height);
+
+        QVector<float> block(width * laneBlockSize);
+        QVector<float> blurredBlock(width * laneBlockSize);
+
+        for (int y0 = 0; y0 < height; y0 += laneBlockSize) {
+            const int numLanes = qMin(laneBlockSize, height - y0);
+
+            for (int l = 0; l < numLanes; l++) {
+                const float *src = plane.constData() + size_t(y0 + l) * width;
+                float *dst = block.data() + l;
+
+                for (int x = 0; x < width; x++) {
+                    dst[x * numLanes] = src[x];
+                }
+            }
+
+            KisFastGaussianBlur::blurLines(block.data(), blurredBlock.data(), width, numLanes, params);
+
+            for (int l = 0; l < numLanes; l++) {
+                const float *src = blurredBlock.constData() + offset * numLanes + l;
+                float *dst = result.data() + size_t(y0 + l) * resultWidth;
+
+                for (int x = 0; x < resultWidth; x++) {
+                    dst[x] = src[x * numLanes];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void writePlanes(const QRect &rect, int yMargin, const QRect &dataRect, const QVector<QVector<float>> &planes)
+    {
+        const int numChannels = m_info.numChannels();
+        const int alphaPos = m_info.alphaCachePos;
+
+        typename IteratorFactory::HLineIterator it =
+            IteratorFactory::createHLineIterator(m_device, rect.x(), rect.y(), rect.width(), dataRect);
+
+        int index = yMargin * rect.width();
+
+        for (int y = 0; y < rect.height(); y++) {
+            for (int x = 0; x < rect.width(); x++, index++) {
+                quint8 *dstPtr = it->rawData();
+
+                if (alphaPos >= 0) {
+                    bool alphaIsNullInDstSpace = false;
+
+                    const qreal alpha = m_info.clamp(alphaPos, planes[alphaPos][index]);
+                    m_info.fromDoubleCheckNullFuncPtr[alphaPos](dstPtr, m_info.alphaRealPos,
+                                                                alpha, &alphaIsNullInDstSpace);
+
+                    if (!alphaIsNullInDstSpace &&
+                        alpha > std::numeric_limits<qreal>::epsilon()) {
+
+                        const qreal alphaInv = 1.0 / alpha;
+
+                        for (int k = 0; k < numChannels; k++) {
+                            if (k == alphaPos) continue;
+                            m_info.fromDoubleFuncPtr[k](dstPtr, m_info.channels[k]->pos(),
+                                                        m_info.clamp(k, planes[k][index] * alphaInv));
+                        }
+                    } else {
+                        for (int k = 0; k < numChannels; k++) {
+                            if (k == alphaPos) continue;
+                            m_info.fromDoubleFuncPtr[k](dstPtr, m_info.channels[k]->pos(), 0.0);
+                        }
+                    }
+                } else {
+                    for (int k = 0; k < numChannels; k++) {
+                        m_info.fromDoubleFuncPtr[k](dstPtr, m_info.channels[k]->pos(),
+                                                    m_info.clamp(k, planes[k][index]));
+                    }
+                }
+
+                it->nextPixel();
+            }
+
+            it->nextRow();
+        }
+    }
+
+    void setProgress(float value)
+    {
+        m_currentProgress = value;
+
+        if (m_progress) {
+            m_progress->setProgress(int(m_currentProgress));
+        }
+    }
+
+    void addToProgress(float amount)
+    {
+        setProgress(m_currentProgress + amount);
+    }
+
+    bool isInterrupted() const
+    {
+        return m_progress && m_progress->interrupted();
+    }
+
+private:
+    KisPaintDeviceSP m_device;
+    const ChannelsInfo &m_info;
+    KoUpdater *m_progress;
+    float m_currentProgress = 0.0;
+};
+
+}
+
+KisFastGaussianBlur::BoxParameters KisFastGaussianBlur::boxParameters(qreal sigma)
+{
+    BoxParameters params;
+
+    const qreal variance = qMax(0.0, sigma * sigma / numPasses);
+
+    /**
+     * The variance of a box of 2r + 1 pixels is r(r + 1) / 3, so we take
+     * the biggest box with the variance not exceeding the requested one
+     * and distribute the rest of the variance to its outer pixels.
+     */
+    params.radius = std::floor(0.5 * std::sqrt(12.0 * variance + 1.0) - 0.5);
+
+    const int r = params.radius;
+    params.edgeWeight =
+        (2 * r + 1) * (r * (r + 1) - 3.0 * variance) /
+        (6.0 * (variance - (r + 1) * (r + 1)));
+    params.scale = 1.0 / (2 * r + 1 + 2 * params.edgeWeight);
+
+    return params;
+}
+
+void KisFastGaussianBlur::blurLines(float *src, float *dst, int length, int numLanes, const BoxParameters &params)
+{
+    static_assert(numPasses % 2 == 1, "the result of the last pass should land in dst");
+
+    if (length <= 0 || numLanes <= 0) return;
+
+    QVector<float> acc(numLanes);
+
+    for (int i = 0; i < numPasses; i++) {
+        if (i % 2 == 0) {
+            boxPass(src, dst, length, numLanes, params, acc.data());
+        } else {
+            boxPass(dst, src, length, numLanes, params, acc.data());
+        }
+    }
+}
+
+void KisFastGaussianBlur::apply(KisPaintDeviceSP device,
+                                const QRect &rect,
+                                qreal xRadius, qreal yRadius,
+                                const QBitArray &channelFlags,
+                                KoUpdater *progressUpdater,
+                                KisConvolutionBorderOp borderOp)
+{
+    if (rect.isEmpty() || (xRadius <= 0.0 && yRadius <= 0.0)) return;
+
+    const QList<KoChannelInfo*> allChannels = device->colorSpace()->channels();
+    QList<KoChannelInfo*> channels;
+
+    for (int i = 0; i < allChannels.size(); i++) {
+        if (channelFlags.isEmpty() || channelFlags.testBit(i)) {
+            channels.append(allChannels[i]);
+        }
+    }
+
+    if (channels.isEmpty()) return;
+
+    const ChannelsInfo info(channels);
+
+    /**
+     * The same border handling as in KisConvolutionPainter::applyMatrix(),
+     * so that the fast blur could replace the exact one transparently
+     */
+    if (device->defaultBounds()->wrapAroundMode()) {
+        borderOp = BORDER_IGNORE;
+    }
+
+    if (borderOp == BORDER_REPEAT) {
+        const QRect boundsRect = device->defaultBounds()->bounds();
+        QRect dataRect = rect | boundsRect;
+
+        KIS_SAFE_ASSERT_RECOVER(boundsRect != KisDefaultBounds().bounds()) {
+            dataRect = rect | device->exactBounds();
+        }
+
+        if (dataRect.isValid()) {
+            BlurWorker<RepeatIteratorFactory> worker(device, info, progressUpdater);
+            worker.execute(rect, xRadius, yRadius, dataRect);
+        }
+    } else {
+        BlurWorker<StandardIteratorFactory> worker(device, info, progressUpdater);
+        worker.execute(rect, xRadius, yRadius, QRect());
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_FAST_GAUSSIAN_BLUR_H
+#define __KIS_FAST_GAUSSIAN_BLUR_H
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+#include "kis_convolution_painter.h"
+
+class QBitArray;
+class QRect;
+
+/**
+ * Approximates the Gaussian blur with a cascade of three box filters,
+ * so the cost per pixel doesn't depend on the radius. Every box is an
+ * "extended box" (Gwosdek et al., "Theoretical Foundations of Gaussian
+ * Convolution by Extended Box Filtering"), that is a box with fractional
+ * weights of its two outer pixels, which makes the variance of the
+ * cascade equal to the variance of the Gaussian for any sigma.
+ *
+ * The sigma is taken from KisGaussianKernel::sigmaFromRadius(), and the
+ * support of the cascade is never wider than the one of the exact kernel,
+ * so the needed and changed rects of the filters stay the same.
+ *
+ * The data is processed in float planes, one per channel. The lines
+ * are filtered in bundles of contiguous "lanes": the columns of a plane
+ * for the vertical pass and blocks of transposed rows for the horizontal
+ * one, so the inner loops are plain element-wise operations the compiler
+ * vectorizes.
+ */
+class KRITAIMAGE_EXPORT KisFastGaussianBlur
+{
+public:
+    static const int numPasses = 3;
+
+    struct BoxParameters {
+        /**
+         * The number of pixels with weight 1.0 on each side of the center
+         */
+        int radius = 0;
+
+        /**
+         * The weight of the two pixels right outside the radius
+         */
+        float edgeWeight = 0.0;
+
+        /**
+         * Normalization factor, 1 / (2 * radius + 1 + 2 * edgeWeight)
+         */
+        float scale = 1.0;
+    };
+
+    /**
+     * Calculates a box, numPasses passes of which have variance sigma^2
+     */
+    static BoxParameters boxParameters(qreal sigma);
+
+    /**
+     * Blurs \p numLanes independent lines of \p length samples. Sample i of
+     * lane l is stored at src[i * numLanes + l]. The lines are extended with
+     * their edge samples. The result is written into \p dst, \p src is used
+     * as a temporary buffer and its content is undefined afterwards.
+     */
+    static void blurLines(float *src, float *dst, int length, int numLanes, const BoxParameters &params);
+
+    /**
+     * Blurs \p rect of \p device in-place, reading the pixels around the
+     * rect the same way KisConvolutionPainter does. A zero radius disables
+     * blurring in that direction.
+     */
+    static void apply(KisPaintDeviceSP device,
+                      const QRect &rect,
+                      qreal xRadius, qreal yRadius,
+                      const QBitArray &channelFlags,
+                      KoUpdater *progressUpdater,
+                      KisConvolutionBorderOp borderOp = BORDER_REPEAT);
+};
+
+#endif /* __KIS_FAST_GAUSSIAN_BLUR_H */
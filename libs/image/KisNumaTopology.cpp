@@ -0,0 +1,319 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisNumaTopology.h"
+
+#include <cstdlib>
+
+#include <QDir>
+#include <QFile>
+#include <QGlobalStatic>
+#include <QMap>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "kis_debug.h"
+#include "kis_image_config.h"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+#ifdef Q_OS_LINUX
+
+/**
+ * The constants of the memory policy API of the kernel. They are
+ * defined in numaif.h, which is a part of libnuma, so we don't
+ * depend on it and call the syscalls directly.
+ */
+const int MemoryPolicyPreferred = 1;
+const unsigned long MemoryPolicyFlagNode = 1 << 0;
+const unsigned long MemoryPolicyFlagAddress = 1 << 1;
+
+const int maxNodeId = 1023;
+typedef unsigned long NodeMask[(maxNodeId + 1) / (8 * sizeof(unsigned long))];
+
+const QString sysfsNodesPath("/sys/devices/system/node");
+
+#endif
+
+}
+
+struct KisNumaTopology::Private
+{
+    QVector<QVector<int>> nodeCpus;
+
+    /**
+     * The ids of the nodes used by the kernel, they are not
+     * necessarily dense
+     */
+    QVector<int> nodeIds;
+
+    QVector<int> cpuToNode;
+    bool isNumaAware = false;
+
+    void initCpuMap();
+    void detect();
+};
+
+void KisNumaTopology::Private::initCpuMap()
+{
+    cpuToNode.clear();
+
+    for (int node = 0; node < nodeCpus.size(); node++) {
+        Q_FOREACH (int cpu, nodeCpus[node]) {
+            while (cpuToNode.size() <= cpu) {
+                cpuToNode.append(-1);
+            }
+            cpuToNode[cpu] = node;
+        }
+    }
+
+    isNumaAware = nodeCpus.size() > 1;
+}
+
+void KisNumaTopology::Private::detect()
+{
+#ifdef Q_OS_LINUX
+    const QStringList entries =
+        QDir(sysfsNodesPath).entryList(QStringList() << "node*", QDir::Dirs);
+
+    const QRegularExpression nodeRegExp("^node(\\d+)$");
+
+    QMap<int, QVector<int>> cpusById;
+
+    Q_FOREACH (const QString &entry, entries) {
+        QRegularExpressionMatch match = nodeRegExp.match(entry);
+        if (!match.hasMatch()) continue;
+
+        const int id = match.captured(1).toInt();
+        if (id > maxNodeId) continue;
+
+        QFile file(sysfsNodesPath + "/" + entry + "/cpulist");
+        if (!file.open(QIODevice::ReadOnly)) continue;
+
+        const QVector<int> cpus = parseCpuList(QString::fromLatin1(file.readAll()));
+
+        // memory-only nodes cannot run any jobs
+        if (cpus.isEmpty()) continue;
+
+        cpusById.insert(id, cpus);
+    }
+
+    for (auto it = cpusById.constBegin(); it != cpusById.constEnd(); ++it) {
+        nodeIds.append(it.key());
+        nodeCpus.append(it.value());
+    }
+#endif
+
+    if (nodeCpus.isEmpty()) {
+        QVector<int> cpus;
+        for (int i = 0; i < QThread::idealThreadCount(); i++) {
+            cpus.append(i);
+        }
+
+        nodeIds = {0};
+        nodeCpus = {cpus};
+    }
+
+    initCpuMap();
+}
+
+
+KisNumaTopology::KisNumaTopology()
+    : m_d(new Private)
+{
+    m_d->detect();
+}
+
+KisNumaTopology::KisNumaTopology(const QVector<QVector<int>> &nodeCpus)
+    : m_d(new Private)
+{
+    m_d->nodeCpus = nodeCpus;
+
+    /**
+     * The simulated nodes are mapped to the real ones, so that the
+     * memory placement would still work on the real NUMA systems
+     */
+    KisNumaTopology *system = instance();
+
+    for (int i = 0; i < nodeCpus.size(); i++) {
+        m_d->nodeIds.append(system->m_d->nodeIds[i % system->m_d->nodeIds.size()]);
+    }
+
+    m_d->initCpuMap();
+}
+
+KisNumaTopology::~KisNumaTopology()
+{
+}
+
+Q_GLOBAL_STATIC(KisNumaTopology, s_instance)
+
+KisNumaTopology* KisNumaTopology::instance()
+{
+    KisNumaTopology *topology = s_instance;
+
+    static bool configApplied = [topology] () {
+        if (topology->m_d->isNumaAware) {
+            topology->m_d->isNumaAware = KisImageConfig(true).numaAwareness();
+        }
+        return true;
+    }();
+    Q_UNUSED(configApplied);
+
+    return topology;
+}
+
+bool KisNumaTopology::isNumaAware() const
+{
+    return m_d->isNumaAware;
+}
+
+int KisNumaTopology::numNodes() const
+{
+    return m_d->nodeCpus.size();
+}
+
+QVector<int> KisNumaTopology::nodeCpus(int node) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(node >= 0 && node < m_d->nodeCpus.size(), QVector<int>());
+    return m_d->nodeCpus[node];
+}
+
+int KisNumaTopology::currentNode() const
+{
+#ifdef Q_OS_LINUX
+    if (m_d->nodeCpus.size() > 1) {
+        const int cpu = sched_getcpu();
+        if (cpu >= 0 && cpu < m_d->cpuToNode.size() && m_d->cpuToNode[cpu] >= 0) {
+            return m_d->cpuToNode[cpu];
+        }
+    }
+#endif
+
+    return 0;
+}
+
+bool KisNumaTopology::bindCurrentThreadToNode(int node) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(node >= 0 && node < m_d->nodeCpus.size(), false);
+
+#ifdef Q_OS_LINUX
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    Q_FOREACH (int cpu, m_d->nodeCpus[node]) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    return !sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+#else
+    return false;
+#endif
+}
+
+void KisNumaTopology::unbindCurrentThread() const
+{
+#ifdef Q_OS_LINUX
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    for (int cpu = 0; cpu < m_d->cpuToNode.size() && cpu < CPU_SETSIZE; cpu++) {
+        if (m_d->cpuToNode[cpu] >= 0) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+#endif
+}
+
+void* KisNumaTopology::allocateOnNode(size_t size, int node) const
+{
+#ifdef Q_OS_LINUX
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return 0;
+
+    if (node >= 0 && node < m_d->nodeIds.size()) {
+        NodeMask mask = {0};
+        const int id = m_d->nodeIds[node];
+        mask[id / (8 * sizeof(unsigned long))] |= 1UL << (id % (8 * sizeof(unsigned long)));
+
+        /**
+         * The pages are not touched yet, so setting the policy is enough
+         * for placing them. If the kernel doesn't support NUMA, the pages
+         * are placed on the node of the first thread touching them.
+         */
+        syscall(SYS_mbind, ptr, size, MemoryPolicyPreferred, mask, sizeof(mask) * 8 + 1, 0);
+    }
+
+    return ptr;
+#else
+    Q_UNUSED(node);
+    return malloc(size);
+#endif
+}
+
+void KisNumaTopology::freeOnNode(void *ptr, size_t size) const
+{
+#ifdef Q_OS_LINUX
+    munmap(ptr, size);
+#else
+    Q_UNUSED(size);
+    free(ptr);
+#endif
+}
+
+int KisNumaTopology::nodeOfMemory(const void *ptr) const
+{
+#ifdef Q_OS_LINUX
+    int id = -1;
+    if (syscall(SYS_get_mempolicy, &id, 0, 0, ptr, MemoryPolicyFlagNode | MemoryPolicyFlagAddress)) {
+        return -1;
+    }
+
+    return m_d->nodeIds.indexOf(id);
+#else
+    Q_UNUSED(ptr);
+    return m_d->nodeCpus.size() == 1 ? 0 : -1;
+#endif
+}
+
+QVector<int> KisNumaTopology::parseCpuList(const QString &list)
+{
+    QVector<int> cpus;
+
+    Q_FOREACH (const QString &item, list.trimmed().split(',', QString::SkipEmptyParts)) {
+        const QStringList range = item.split('-');
+
+        bool firstOk = false;
+        bool lastOk = false;
+        const int first = range[0].toInt(&firstOk);
+        const int last = range.size() == 2 ? range[1].toInt(&lastOk) : first;
+
+        if (!firstOk || (range.size() == 2 && !lastOk) || range.size() > 2 || last < first) {
+            warnKrita << "WARNING: KisNumaTopology: failed to parse CPU list" << list;
+            return QVector<int>();
+        }
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.append(cpu);
+        }
+    }
+
+    return cpus;
+}
@@ -0,0 +1,106 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_NUMA_TOPOLOGY_H
+#define __KIS_NUMA_TOPOLOGY_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include "kritaimage_export.h"
+
+class QString;
+
+/**
+ * The NUMA nodes of the system and the CPUs belonging to them.
+ *
+ * On a multi-socket machine every socket has its own memory, and
+ * accessing the memory of another socket is considerably slower. The
+ * tile data store uses the topology to place the tile data on the node
+ * of the thread that writes it, and the updater context uses it to run
+ * the merge jobs on the node owning the data of their rects.
+ *
+ * The nodes are numbered densely, from 0 to numNodes() - 1. The topology
+ * is detected only on Linux, on the other systems there is always a
+ * single node.
+ */
+class KRITAIMAGE_EXPORT KisNumaTopology
+{
+public:
+    /**
+     * Detects the topology of the system
+     */
+    KisNumaTopology();
+
+    /**
+     * Creates a topology consisting of the nodes with the given CPUs.
+     * It is used for simulating NUMA systems in tests and benchmarks,
+     * the memory is still allocated according to the real topology.
+     */
+    KisNumaTopology(const QVector<QVector<int>> &nodeCpus);
+
+    ~KisNumaTopology();
+
+    /**
+     * The topology of the system. Its NUMA awareness is read from
+     * KisImageConfig on the first call and never changes afterwards,
+     * since the tile data memory cannot be switched between the
+     * allocation policies on the fly.
+     */
+    static KisNumaTopology* instance();
+
+    /**
+     * Returns true if there is more than one node and the NUMA-aware
+     * allocation and scheduling are enabled
+     */
+    bool isNumaAware() const;
+
+    int numNodes() const;
+    QVector<int> nodeCpus(int node) const;
+
+    /**
+     * Returns the node of the CPU the calling thread is running on.
+     * The thread may be migrated right after the call unless it has
+     * been bound to a node.
+     */
+    int currentNode() const;
+
+    /**
+     * Restricts the calling thread to the CPUs of \p node.
+     * Returns false if the system doesn't support that.
+     */
+    bool bindCurrentThreadToNode(int node) const;
+
+    /**
+     * Allows the calling thread to run on the CPUs of all the nodes
+     */
+    void unbindCurrentThread() const;
+
+    /**
+     * Allocates a page-aligned block of \p size bytes, whose pages
+     * are placed on \p node when they are touched for the first time.
+     * The block should be freed with freeOnNode().
+     */
+    void* allocateOnNode(size_t size, int node) const;
+    void freeOnNode(void *ptr, size_t size) const;
+
+    /**
+     * Returns the node the page containing \p ptr resides on, or
+     * -1 if it cannot be found out
+     */
+    int nodeOfMemory(const void *ptr) const;
+
+    /**
+     * Parses the list of CPUs in the format of sysfs, e.g. "0-3,8,10-11"
+     */
+    static QVector<int> parseCpuList(const QString &list);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_NUMA_TOPOLOGY_H */
@@ -0,0 +1,186 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisPaintDeviceMipmap.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
+#include "kis_default_bounds_base.h"
+#include "kis_lod_transform.h"
+#include "KisRegion.h"
+
+
+namespace {
+
+inline QRect nextLevelRect(const QRect &rc)
+{
+    return KisLodTransform::scaledRect(KisLodTransform::alignedRect(rc, 1), 1);
+}
+
+}
+
+struct KisPaintDeviceMipmap::Private
+{
+    KisPaintDevice *device;
+
+    QMutex lock;
+
+    /**
+     * levels[i] keeps level i + 1
+     */
+    QVector<KisPaintDeviceSP> levels;
+
+    /**
+     * The state of the original device the levels have been built from.
+     * The data manager records the tiles changed since the previous
+     * request while it is tracked by the mipmap.
+     */
+    KisDataManagerSP dataManager;
+    const KoColorSpace *colorSpace = 0;
+    KoColor defaultPixel;
+    QPoint offset;
+
+    bool stateMatches() const;
+    void resetData();
+    QVector<QRect> fetchChangedRects(bool *allChanged);
+    void updateLevels(const QVector<QRect> &originalRects);
+    void appendLevel();
+};
+
+bool KisPaintDeviceMipmap::Private::stateMatches() const
+{
+    return dataManager == device->dataManager() &&
+        *colorSpace == *device->colorSpace() &&
+        defaultPixel == device->defaultPixel() &&
+        offset == QPoint(device->x(), device->y());
+}
+
+void KisPaintDeviceMipmap::Private::resetData()
+{
+    levels.clear();
+
+    if (dataManager) {
+        dataManager->setDirtyTilesTrackingEnabled(false);
+        dataManager = 0;
+    }
+
+    colorSpace = 0;
+}
+
+QVector<QRect> KisPaintDeviceMipmap::Private::fetchChangedRects(bool *allChanged)
+{
+    QVector<QRect> rects = dataManager->takeDirtyTiles(allChanged);
+    if (*allChanged) return QVector<QRect>();
+
+    // the tiles never intersect, so they can be merged into bigger rects
+    return KisRegion(std::move(rects)).translated(offset.x(), offset.y()).rects();
+}
+
+void KisPaintDeviceMipmap::Private::updateLevels(const QVector<QRect> &originalRects)
+{
+    QVector<QRect> rects = originalRects;
+    KisPaintDevice *src = device;
+
+    for (int i = 0; i < levels.size() && !rects.isEmpty(); i++) {
+        KisPaintDeviceSP dst = levels[i];
+
+        /**
+         * The aligned rects of the neighbouring tiles may overlap by a
+         * pixel on the lower levels. It is cheaper to regenerate these
+         * pixels twice than to merge the rects.
+         */
+        for (QRect &rc : rects) {
+            src->generateLodCloneDevice(dst, rc, 1);
+            rc = nextLevelRect(rc);
+        }
+
+        src = dst.data();
+    }
+}
+
+void KisPaintDeviceMipmap::Private::appendLevel()
+{
+    KisPaintDevice *src = levels.isEmpty() ? device : levels.last().data();
+
+    KisPaintDeviceSP dst = new KisPaintDevice(colorSpace);
+    dst->setDefaultPixel(defaultPixel);
+    dst->moveTo(offset);
+
+    src->generateLodCloneDevice(dst, src->extent(), 1);
+
+    levels.append(dst);
+}
+
+
+KisPaintDeviceMipmap::KisPaintDeviceMipmap(KisPaintDevice *device)
+    : m_d(new Private)
+{
+    m_d->device = device;
+}
+
+KisPaintDeviceMipmap::~KisPaintDeviceMipmap()
+{
+    m_d->resetData();
+}
+
+KisPaintDeviceSP KisPaintDeviceMipmap::level(int level)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(level >= 1 && level <= maxLevel, 0);
+
+    /**
+     * The level of detail planes of the device have their own data,
+     * which is not tracked by the mipmap
+     */
+    if (m_d->device->defaultBounds()->currentLevelOfDetail()) {
+        return 0;
+    }
+
+    QMutexLocker l(&m_d->lock);
+
+    if (m_d->colorSpace && !m_d->stateMatches()) {
+        m_d->resetData();
+    }
+
+    if (!m_d->colorSpace) {
+        m_d->dataManager = m_d->device->dataManager();
+        m_d->dataManager->setDirtyTilesTrackingEnabled(true);
+        m_d->colorSpace = m_d->device->colorSpace();
+        m_d->defaultPixel = m_d->device->defaultPixel();
+        m_d->offset = QPoint(m_d->device->x(), m_d->device->y());
+    }
+
+    /**
+     * The dirty tiles are taken before reading the data, so the
+     * changes happening during the update will be caught next time
+     */
+    bool allChanged = false;
+    const QVector<QRect> changedRects = m_d->fetchChangedRects(&allChanged);
+
+    if (allChanged) {
+        m_d->levels.clear();
+    } else {
+        m_d->updateLevels(changedRects);
+    }
+
+    while (m_d->levels.size() < level) {
+        m_d->appendLevel();
+    }
+
+    return new KisPaintDevice(*m_d->levels[level - 1]);
+}
+
+void KisPaintDeviceMipmap::reset()
+{
+    QMutexLocker l(&m_d->lock);
+    m_d->resetData();
+}
@@ -0,0 +1,65 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_PAINT_DEVICE_MIPMAP_H
+#define __KIS_PAINT_DEVICE_MIPMAP_H
+
+#include <QScopedPointer>
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+/**
+ * A chain of downscaled copies of a paint device. Level k is the
+ * device downscaled by 2^k with a box filter. The levels use the
+ * coordinate system of the level of detail planes, that is the
+ * pixel (x, y) of level k covers the pixels [x * 2^k, (x + 1) * 2^k)
+ * of the original device, and every level has the same offset as
+ * the original device.
+ *
+ * Level k is generated from level k - 1, and the levels are built
+ * lazily, when they are requested for the first time. Afterwards they
+ * are kept in sync incrementally: the data manager of the device
+ * records the tiles written, added or removed since the previous
+ * request (see KisTiledDataManager::takeDirtyTiles()), and only their
+ * areas are regenerated in all the levels. The changes that are not
+ * recorded per tile, like undo, make the levels be rebuilt from
+ * scratch. Therefore the users that sample the device at a low
+ * resolution (thumbnails, overview) pay only for the changes, not for
+ * the size of the device.
+ *
+ * The mipmap is owned by the device (see KisPaintDevice::setMipmapEnabled())
+ * and all the methods are thread-safe.
+ */
+class KRITAIMAGE_EXPORT KisPaintDeviceMipmap
+{
+public:
+    static const int maxLevel = 8;
+
+public:
+    KisPaintDeviceMipmap(KisPaintDevice *device);
+    ~KisPaintDeviceMipmap();
+
+    /**
+     * Brings the levels up to date with the original device and returns
+     * a copy of level \p level, where 1 <= level <= maxLevel. The copy
+     * shares the tiles with the level in copy-on-write manner, so it is
+     * cheap and is not affected by the further updates of the mipmap.
+     */
+    KisPaintDeviceSP level(int level);
+
+    /**
+     * Drops all the levels. They will be regenerated from scratch on
+     * the next request.
+     */
+    void reset();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PAINT_DEVICE_MIPMAP_H */
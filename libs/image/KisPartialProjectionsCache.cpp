@@ -0,0 +1,459 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisPartialProjectionsCache.h"
+
+#include <atomic>
+
+#include <QBitArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegion>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoCompositeOpRegistry.h>
+
+#include "kis_layer.h"
+#include "kis_node.h"
+#include "kis_painter.h"
+#include "kis_paint_device.h"
+#include "kis_projection_leaf.h"
+#include "kis_abstract_projection_plane.h"
+
+
+namespace {
+
+/**
+ * Painting with small dabs makes the valid region very fragmented.
+ * Operations on such a region become too expensive, so the region
+ * is just dropped when it gets too complicated.
+ */
+const int maxValidRegionRects = 1024;
+
+struct LevelNode {
+    KisNode *node;
+
+    /**
+     * A layer can be temporarily hidden from rendering without
+     * any update, so its visibility is a part of the signature
+     */
+    bool visible;
+
+    bool operator==(const LevelNode &rhs) const {
+        return node == rhs.node && visible == rhs.visible;
+    }
+};
+
+/**
+ * The state of the content of a sibling. The layers can be changed
+ * without an update of the image passing through the merger (e.g.
+ * while the updates are disabled), so the cache checks the state of
+ * every sibling on every update.
+ */
+struct LevelNodeState {
+    int projectionSequenceNumber;
+    quint8 opacity;
+    QString compositeOpId;
+    QBitArray channelFlags;
+
+    bool operator==(const LevelNodeState &rhs) const {
+        return projectionSequenceNumber == rhs.projectionSequenceNumber &&
+            opacity == rhs.opacity &&
+            compositeOpId == rhs.compositeOpId &&
+            channelFlags == rhs.channelFlags;
+    }
+};
+
+}
+
+struct KisPartialProjectionsCache::Private
+{
+    static std::atomic<bool> belowEnabled;
+    static std::atomic<bool> aboveEnabled;
+
+    mutable QMutex lock;
+
+    /**
+     * The signature of the group the cached data belongs to
+     */
+    QVector<LevelNode> levelNodes;
+    QVector<LevelNodeState> levelNodeStates;
+    int graphSequenceNumber = -1;
+
+    /**
+     * The properties of the group's original at the moment of
+     * creation of the cache
+     */
+    const KoColorSpace *colorSpace = 0;
+    KoColor defaultPixel;
+    QPoint offset;
+
+    KisNode *splitNode = 0;
+
+    KisNode *candidateNode = 0;
+    int candidateHits = 0;
+
+    KisPaintDeviceSP belowDevice;
+    QRegion belowValidRegion;
+
+    KisPaintDeviceSP aboveDevice;
+    QRegion aboveValidRegion;
+
+    void resetData();
+    void switchSplit(KisNode *node, KisPaintDeviceSP projection);
+    bool projectionMatches(KisPaintDeviceSP projection) const;
+
+    static bool isFilthy(const JobItem &item);
+    static bool isChanged(const JobItem &item);
+    static bool canBeMergedWithOver(const JobItem &item);
+    static LevelNodeState nodeState(const JobItem &item);
+    static void invalidate(QRegion &validRegion, const QRect &rect);
+    static void fillProjection(KisPaintDeviceSP device, const QRegion &region,
+                               const QVector<JobItem> &items, int begin, int end);
+};
+
+std::atomic<bool> KisPartialProjectionsCache::Private::belowEnabled(false);
+std::atomic<bool> KisPartialProjectionsCache::Private::aboveEnabled(false);
+
+void KisPartialProjectionsCache::Private::resetData()
+{
+    splitNode = 0;
+    belowDevice = 0;
+    aboveDevice = 0;
+    belowValidRegion = QRegion();
+    aboveValidRegion = QRegion();
+}
+
+void KisPartialProjectionsCache::Private::switchSplit(KisNode *node, KisPaintDeviceSP projection)
+{
+    resetData();
+
+    splitNode = node;
+    candidateNode = 0;
+    candidateHits = 0;
+
+    colorSpace = projection->colorSpace();
+    defaultPixel = projection->defaultPixel();
+    offset = QPoint(projection->x(), projection->y());
+}
+
+bool KisPartialProjectionsCache::Private::projectionMatches(KisPaintDeviceSP projection) const
+{
+    return *colorSpace == *projection->colorSpace() &&
+        defaultPixel == projection->defaultPixel() &&
+        offset == QPoint(projection->x(), projection->y());
+}
+
+bool KisPartialProjectionsCache::Private::isFilthy(const JobItem &item)
+{
+    return item.m_position & (KisBaseRectsWalker::N_FILTHY |
+                              KisBaseRectsWalker::N_FILTHY_PROJECTION |
+                              KisBaseRectsWalker::N_EXTRA);
+}
+
+bool KisPartialProjectionsCache::Private::isChanged(const JobItem &item)
+{
+    if (isFilthy(item)) return true;
+
+    return item.m_position & KisBaseRectsWalker::N_ABOVE_FILTHY &&
+        item.m_leaf->dependsOnLowerNodes();
+}
+
+bool KisPartialProjectionsCache::Private::canBeMergedWithOver(const JobItem &item)
+{
+    const KisProjectionLeafSP &leaf = item.m_leaf;
+    if (!leaf->visible()) return true;
+
+    KisLayer *layer = qobject_cast<KisLayer*>(leaf->node().data());
+    if (!layer || leaf->dependsOnLowerNodes() || layer->layerStyle()) return false;
+    if (layer->compositeOpId() != COMPOSITE_OVER) return false;
+
+    const QBitArray channelFlags = leaf->channelFlags();
+    return channelFlags.isEmpty() || channelFlags.count(true) == channelFlags.size();
+}
+
+LevelNodeState KisPartialProjectionsCache::Private::nodeState(const JobItem &item)
+{
+    const KisProjectionLeafSP &leaf = item.m_leaf;
+    KisPaintDeviceSP projection = leaf->projection();
+    KisLayer *layer = qobject_cast<KisLayer*>(leaf->node().data());
+
+    return {projection ? projection->sequenceNumber() : -1,
+            leaf->opacity(),
+            layer ? layer->compositeOpId() : QString(),
+            leaf->channelFlags()};
+}
+
+void KisPartialProjectionsCache::Private::invalidate(QRegion &validRegion, const QRect &rect)
+{
+    if (validRegion.intersects(rect)) {
+        validRegion -= rect;
+    }
+}
+
+void KisPartialProjectionsCache::Private::fillProjection(KisPaintDeviceSP device, const QRegion &region,
+                                                         const QVector<JobItem> &items, int begin, int end)
+{
+    for (auto rc = region.begin(); rc != region.end(); ++rc) {
+        device->clear(*rc);
+
+        for (int i = begin; i < end; i++) {
+            const KisProjectionLeafSP &leaf = items[i].m_leaf;
+            if (!leaf->visible()) continue;
+
+            KisPainter gc(device);
+            leaf->projectionPlane()->apply(&gc, *rc);
+        }
+    }
+}
+
+
+KisPartialProjectionsCache::KisPartialProjectionsCache()
+    : m_d(new Private)
+{
+}
+
+KisPartialProjectionsCache::~KisPartialProjectionsCache()
+{
+}
+
+KisPartialProjectionsCache::Plan
+KisPartialProjectionsCache::prepareUpdate(const QVector<JobItem> &items, KisPaintDeviceSP projection, bool canUseCache)
+{
+    Plan plan;
+    if (items.isEmpty()) return plan;
+
+    QRect rect;
+    QVector<LevelNode> nodes;
+    QVector<LevelNodeState> states;
+    nodes.reserve(items.size());
+    states.reserve(items.size());
+
+    int firstChanged = -1;
+    int lastChanged = -1;
+    int numFilthy = 0;
+
+    for (int i = 0; i < items.size(); i++) {
+        const JobItem &item = items[i];
+
+        rect |= item.m_applyRect;
+        nodes.append({item.m_leaf->node().data(), item.m_leaf->visible()});
+        states.append(Private::nodeState(item));
+
+        if (Private::isChanged(item)) {
+            if (firstChanged < 0) {
+                firstChanged = i;
+            }
+            lastChanged = i;
+        }
+
+        if (Private::isFilthy(item)) {
+            numFilthy++;
+        }
+    }
+
+    const int graphSequenceNumber = items.first().m_leaf->node()->graphSequenceNumber();
+
+    QMutexLocker l(&m_d->lock);
+
+    if (nodes != m_d->levelNodes || graphSequenceNumber != m_d->graphSequenceNumber) {
+        m_d->resetData();
+        m_d->levelNodes = nodes;
+        m_d->levelNodeStates = states;
+        m_d->graphSequenceNumber = graphSequenceNumber;
+        m_d->candidateNode = 0;
+        m_d->candidateHits = 0;
+    }
+
+    int splitIndex = -1;
+
+    if (m_d->splitNode) {
+        for (int i = 0; i < nodes.size(); i++) {
+            if (nodes[i].node == m_d->splitNode) {
+                splitIndex = i;
+                break;
+            }
+        }
+
+        KIS_SAFE_ASSERT_RECOVER(splitIndex >= 0) {
+            m_d->resetData();
+        }
+
+        if (splitIndex >= 0) {
+            if (firstChanged >= 0 && firstChanged < splitIndex) {
+                Private::invalidate(m_d->belowValidRegion, rect);
+            }
+
+            if (lastChanged > splitIndex) {
+                Private::invalidate(m_d->aboveValidRegion, rect);
+            }
+
+            /**
+             * A sibling changed outside of the updates coming through the
+             * merger may have been changed anywhere, so the whole part of
+             * the cache it belongs to is dropped
+             */
+            for (int i = 0; i < nodes.size(); i++) {
+                if (i == splitIndex || states[i] == m_d->levelNodeStates[i]) continue;
+
+                if (i < splitIndex) {
+                    m_d->belowValidRegion = QRegion();
+                } else {
+                    m_d->aboveValidRegion = QRegion();
+                }
+            }
+        }
+    }
+
+    m_d->levelNodeStates = states;
+
+    if (!canUseCache || firstChanged < 0) return plan;
+
+    const bool belowEnabled = Private::belowEnabled;
+    const bool aboveEnabled = Private::aboveEnabled;
+
+    if (!belowEnabled && !aboveEnabled) {
+        // release the memory
+        if (m_d->splitNode) {
+            m_d->resetData();
+        }
+        return plan;
+    }
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(projection, plan);
+
+    if (splitIndex >= 0 && !m_d->projectionMatches(projection)) {
+        m_d->resetData();
+        splitIndex = -1;
+    }
+
+    if (splitIndex == firstChanged) {
+        m_d->candidateNode = 0;
+        m_d->candidateHits = 0;
+    } else if (numFilthy > 1) {
+        /**
+         * Refresh of the whole group doesn't tell anything
+         * about the layer the user works with
+         */
+        m_d->candidateNode = 0;
+        m_d->candidateHits = 0;
+    } else {
+        KisNode *changedNode = nodes[firstChanged].node;
+
+        if (m_d->candidateNode == changedNode) {
+            m_d->candidateHits++;
+        } else {
+            m_d->candidateNode = changedNode;
+            m_d->candidateHits = 1;
+        }
+
+        if (splitIndex < 0 || m_d->candidateHits >= switchSplitThreshold) {
+            m_d->switchSplit(changedNode, projection);
+            splitIndex = firstChanged;
+        }
+    }
+
+    const bool useBelow =
+        belowEnabled &&
+        splitIndex >= minCachedLayers &&
+        firstChanged >= splitIndex;
+
+    bool useAbove =
+        aboveEnabled &&
+        items.size() - 1 - splitIndex >= minCachedLayers &&
+        lastChanged <= splitIndex;
+
+    for (int i = splitIndex + 1; useAbove && i < items.size(); i++) {
+        useAbove = Private::canBeMergedWithOver(items[i]);
+    }
+
+    if (!useBelow && !useAbove) return plan;
+
+    if (useBelow && !m_d->belowDevice) {
+        m_d->belowDevice = new KisPaintDevice(projection->colorSpace());
+        m_d->belowDevice->prepareClone(projection);
+    }
+
+    if (useAbove && !m_d->aboveDevice) {
+        m_d->aboveDevice = new KisPaintDevice(projection->colorSpace());
+        m_d->aboveDevice->setDefaultBounds(projection->defaultBounds());
+    }
+
+    KisPaintDeviceSP belowDevice = useBelow ? m_d->belowDevice : 0;
+    KisPaintDeviceSP aboveDevice = useAbove ? m_d->aboveDevice : 0;
+
+    const QRegion belowMissingRegion = useBelow ? QRegion(rect) - m_d->belowValidRegion : QRegion();
+    const QRegion aboveMissingRegion = useAbove ? QRegion(rect) - m_d->aboveValidRegion : QRegion();
+    /**
+     * The apply rects of the jobs of the same group may intersect,
+     * so the devices are filled under the lock
+     */
+    if (!belowMissingRegion.isEmpty()) {
+        Private::fillProjection(belowDevice, belowMissingRegion, items, 0, splitIndex);
+    }
+
+    if (!aboveMissingRegion.isEmpty()) {
+        Private::fillProjection(aboveDevice, aboveMissingRegion, items, splitIndex + 1, items.size());
+    }
+
+    m_d->belowValidRegion += belowMissingRegion;
+    m_d->aboveValidRegion += aboveMissingRegion;
+
+    if (m_d->belowValidRegion.rectCount() > maxValidRegionRects) {
+        m_d->belowValidRegion = QRegion();
+    }
+
+    if (m_d->aboveValidRegion.rectCount() > maxValidRegionRects) {
+        m_d->aboveValidRegion = QRegion();
+    }
+
+    plan.splitIndex = splitIndex;
+    plan.belowProjection = belowDevice;
+    plan.aboveProjection = aboveDevice;
+
+    return plan;
+}
+
+void KisPartialProjectionsCache::reset()
+{
+    QMutexLocker l(&m_d->lock);
+
+    m_d->resetData();
+    m_d->levelNodes.clear();
+    m_d->levelNodeStates.clear();
+    m_d->graphSequenceNumber = -1;
+    m_d->candidateNode = 0;
+    m_d->candidateHits = 0;
+}
+
+void KisPartialProjectionsCache::setCachingEnabled(bool belowEnabled, bool aboveEnabled)
+{
+    Private::belowEnabled = belowEnabled;
+    Private::aboveEnabled = aboveEnabled;
+}
+
+bool KisPartialProjectionsCache::belowCachingEnabled()
+{
+    return Private::belowEnabled;
+}
+
+bool KisPartialProjectionsCache::aboveCachingEnabled()
+{
+    return Private::aboveEnabled;
+}
+
+QRegion KisPartialProjectionsCache::belowValidRegion() const
+{
+    QMutexLocker l(&m_d->lock);
+    return m_d->belowValidRegion;
+}
+
+QRegion KisPartialProjectionsCache::aboveValidRegion() const
+{
+    QMutexLocker l(&m_d->lock);
+    return m_d->aboveValidRegion;
+}
@@ -0,0 +1,139 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_PARTIAL_PROJECTIONS_CACHE_H
+#define __KIS_PARTIAL_PROJECTIONS_CACHE_H
+
+#include <QRegion>
+#include <QScopedPointer>
+#include <QVector>
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+#include "kis_base_rects_walker.h"
+
+/**
+ * The cache of the partial projections of a group layer, which is
+ * used by KisAsyncMerger to avoid recompositing of the layers that
+ * have not been changed.
+ *
+ * When the user paints on a layer (the "split" layer), every update
+ * of the group's original composites all the siblings of this layer
+ * in the dirty rect, though only the split layer has actually been
+ * changed. The cache keeps two devices:
+ *
+ *   - the "below" projection: the composition of all the siblings
+ *     lying below the split layer. It is copied into the original
+ *     instead of compositing them one by one. The result is exactly
+ *     the same as without the cache.
+ *
+ *   - the "above" projection: the composition of all the siblings
+ *     lying above the split layer, made on a transparent background.
+ *     It is composited over the split layer with a single COMPOSITE_OVER
+ *     operation. It is possible only when all these siblings are plain
+ *     layers painted with COMPOSITE_OVER without any channel flags and
+ *     layer styles, since only such an operation is associative. The
+ *     result may differ from the uncached one by rounding, so this
+ *     part is disabled by default.
+ *
+ * Both the projections are filled lazily, only in the rects needed for
+ * the updates, and the regions of valid data are tracked separately.
+ * When the merger meets a change of a layer other than the split one, the
+ * corresponding projection is invalidated in the update rect. If such
+ * changes come several times in a row, the cache switches to the new
+ * split layer, so it follows the layer the user is painting on. Any
+ * change in the list of the siblings resets the cache.
+ *
+ * Besides that, the cache compares the sequence numbers of the
+ * projections and the blending properties of the siblings on every
+ * update. A sibling changed without an update, e.g. while the updates
+ * were disabled, invalidates the whole projection it belongs to.
+ *
+ * The object is used concurrently by the merge jobs of the same group.
+ * Their apply rects may intersect, so the devices are filled under the
+ * same lock as the bookkeeping.
+ */
+class KRITAIMAGE_EXPORT KisPartialProjectionsCache
+{
+public:
+    typedef KisBaseRectsWalker::JobItem JobItem;
+
+    /**
+     * The layers that should be merged into one projection to make the
+     * cache worth it. A single layer is composited as fast as it is copied.
+     */
+    static const int minCachedLayers = 2;
+
+    /**
+     * The number of consecutive updates of the same non-split layer
+     * that makes the cache switch to this layer
+     */
+    static const int switchSplitThreshold = 3;
+
+    struct Plan {
+        /**
+         * Index of the split layer in the list of the level's items,
+         * or -1 if the cache cannot be used for the update
+         */
+        int splitIndex = -1;
+
+        /**
+         * If not null, should be copied into the original instead of
+         * compositing the items [0, splitIndex)
+         */
+        KisPaintDeviceSP belowProjection;
+
+        /**
+         * If not null, should be composited over the original right after
+         * the split layer instead of compositing the items (splitIndex, end)
+         */
+        KisPaintDeviceSP aboveProjection;
+    };
+
+public:
+    KisPartialProjectionsCache();
+    ~KisPartialProjectionsCache();
+
+    /**
+     * Prepares the cache for merging of a group level of an update.
+     *
+     * \p items are the walker's job items of a single group, from the
+     * bottommost to the topmost one. The cache invalidates the parts
+     * changed by the update and, if \p canUseCache is true, makes sure
+     * the projections contain valid data in the apply rect of the items
+     * and returns the plan of the merge into \p projection.
+     *
+     * The items must share the same apply rect if \p canUseCache is true.
+     */
+    Plan prepareUpdate(const QVector<JobItem> &items, KisPaintDeviceSP projection, bool canUseCache);
+
+    /**
+     * Drops all the cached data
+     */
+    void reset();
+
+    /**
+     * Enables or disables the two parts of the cache for all the groups
+     * of all the images. The values are read from KisImageConfig by the
+     * update scheduler.
+     */
+    static void setCachingEnabled(bool belowEnabled, bool aboveEnabled);
+    static bool belowCachingEnabled();
+    static bool aboveCachingEnabled();
+
+    /**
+     * The regions of the valid data of the projections, used by
+     * the unit tests
+     */
+    QRegion belowValidRegion() const;
+    QRegion aboveValidRegion() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PARTIAL_PROJECTIONS_CACHE_H */
@@ -0,0 +1,294 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_RECTS_GRID_INDEX_H
+#define __KIS_RECTS_GRID_INDEX_H
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+#include "kis_assert.h"
+
+/**
+ * A spatial index of rectangles, based on a uniform grid of square cells.
+ * Every rectangle is registered in all the cells it covers, so a lookup
+ * checks only the rectangles stored in the cells of the requested area.
+ *
+ * The rectangles covering more than maxCellsPerRect cells (e.g. full
+ * refresh of a huge image) are not split into the cells, but are kept
+ * in a separate list, which is checked on every lookup.
+ *
+ * The update rects are usually not bigger than the update patch, so the
+ * cell size is expected to be close to the patch size.
+ *
+ * The values are compared with operator==(). The same value may be
+ * registered several times with different rects.
+ */
+template <typename T>
+class KisRectsGridIndex
+{
+public:
+    static const int maxCellsPerRect = 64;
+
+    struct Entry {
+        QRect rect;
+        T value;
+    };
+
+public:
+    KisRectsGridIndex(int cellSize = 512)
+        : m_cellSize(cellSize)
+    {
+        KIS_SAFE_ASSERT_RECOVER(m_cellSize > 0) { m_cellSize = 512; }
+    }
+
+    int cellSize() const {
+        return m_cellSize;
+    }
+
+    /**
+     * Changes the size of the cells. All the stored rects
+     * are redistributed
+     */
+    void setCellSize(int value) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(value > 0);
+        if (value == m_cellSize) return;
+
+        const QVector<Entry> entries = this->entries();
+        clear();
+
+        m_cellSize = value;
+
+        Q_FOREACH (const Entry &entry, entries) {
+            insert(entry.rect, entry.value);
+        }
+    }
+
+    void insert(const QRect &rc, const T &value) {
+        if (rc.isEmpty()) return;
+
+        m_size++;
+
+        const QRect cells = cellsRect(rc);
+
+        if (isOversized(cells)) {
+            m_oversizedEntries.append({rc, value});
+            return;
+        }
+
+        for (int y = cells.top(); y <= cells.bottom(); y++) {
+            for (int x = cells.left(); x <= cells.right(); x++) {
+                m_cells[cellKey(x, y)].append({rc, value});
+            }
+        }
+    }
+
+    /**
+     * Removes the value registered with \p rc. The rect should
+     * be exactly the same as the one passed to insert().
+     *
+     * \return true if the value has been found
+     */
+    bool remove(const QRect &rc, const T &value) {
+        return take(rc, value, 0);
+    }
+
+    /**
+     * The same as remove(), but also returns the stored copy
+     * of the value in \p storedValue
+     */
+    bool take(const QRect &rc, const T &value, T *storedValue) {
+        if (rc.isEmpty()) return false;
+
+        const QRect cells = cellsRect(rc);
+
+        bool found = false;
+
+        if (isOversized(cells)) {
+            found = removeFromList(m_oversizedEntries, rc, value, storedValue);
+        } else {
+            for (int y = cells.top(); y <= cells.bottom(); y++) {
+                for (int x = cells.left(); x <= cells.right(); x++) {
+                    auto it = m_cells.find(cellKey(x, y));
+                    if (it == m_cells.end()) continue;
+
+                    found |= removeFromList(*it, rc, value, storedValue);
+
+                    if (it->isEmpty()) {
+                        m_cells.erase(it);
+                    }
+                }
+            }
+        }
+
+        if (found) {
+            m_size--;
+        }
+
+        return found;
+    }
+
+    /**
+     * Calls \p func(rect, value) for every stored rect intersecting
+     * \p rc. Every pair is visited only once, even when it is stored
+     * in several cells. The iteration stops as soon as \p func
+     * returns false.
+     *
+     * \return false if the iteration was stopped by \p func
+     */
+    template <typename Func>
+    bool forEachIntersecting(const QRect &rc, Func func) const {
+        if (rc.isEmpty() || !m_size) return true;
+
+        for (const Entry &entry : m_oversizedEntries) {
+            if (entry.rect.intersects(rc) && !func(entry.rect, entry.value)) {
+                return false;
+            }
+        }
+
+        const QRect cells = cellsRect(rc);
+
+        /**
+         * A huge request rect would visit too many empty cells,
+         * just check all the non-empty ones instead
+         */
+        if (qint64(cells.width()) * cells.height() > m_cells.size()) {
+            for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+                const int x = int(qint32(it.key() >> 32));
+                const int y = int(qint32(it.key() & 0xFFFFFFFF));
+
+                if (!visitCell(*it, x, y, rc, func)) {
+                    return false;
+                }
+            }
+        } else {
+            for (int y = cells.top(); y <= cells.bottom(); y++) {
+                for (int x = cells.left(); x <= cells.right(); x++) {
+                    auto it = m_cells.constFind(cellKey(x, y));
+                    if (it == m_cells.constEnd()) continue;
+
+                    if (!visitCell(*it, x, y, rc, func)) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool hasIntersecting(const QRect &rc) const {
+        return !forEachIntersecting(rc, [] (const QRect &, const T &) { return false; });
+    }
+
+    QVector<T> intersecting(const QRect &rc) const {
+        QVector<T> result;
+        forEachIntersecting(rc, [&result] (const QRect &, const T &value) {
+            result.append(value);
+            return true;
+        });
+        return result;
+    }
+
+    /**
+     * Returns all the stored (rect, value) pairs
+     */
+    QVector<Entry> entries() const {
+        QVector<Entry> result = m_oversizedEntries;
+
+        for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+            const int x = int(qint32(it.key() >> 32));
+            const int y = int(qint32(it.key() & 0xFFFFFFFF));
+
+            Q_FOREACH (const Entry &entry, *it) {
+                // every entry is returned by its top-left cell only
+                if (cellCoord(entry.rect.left()) == x &&
+                    cellCoord(entry.rect.top()) == y) {
+
+                    result.append(entry);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void clear() {
+        m_cells.clear();
+        m_oversizedEntries.clear();
+        m_size = 0;
+    }
+
+    bool isEmpty() const {
+        return !m_size;
+    }
+
+    int size() const {
+        return m_size;
+    }
+
+private:
+    template <typename Func>
+    inline bool visitCell(const QVector<Entry> &cell, int x, int y, const QRect &rc, Func &func) const {
+        for (const Entry &entry : cell) {
+            if (!entry.rect.intersects(rc)) continue;
+
+            /**
+             * The entry is reported by the cell containing the top-left
+             * corner of its intersection with the requested rect. This
+             * cell is present in both the entry and the request.
+             */
+            const QRect common = entry.rect & rc;
+            if (cellCoord(common.left()) != x || cellCoord(common.top()) != y) continue;
+
+            if (!func(entry.rect, entry.value)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool removeFromList(QVector<Entry> &list, const QRect &rc, const T &value, T *storedValue) {
+        for (auto it = list.begin(); it != list.end(); ++it) {
+            if (it->rect == rc && it->value == value) {
+                if (storedValue) {
+                    *storedValue = it->value;
+                }
+                list.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline int cellCoord(int coord) const {
+        // round towards negative infinity
+        return coord >= 0 ? coord / m_cellSize : -((-coord - 1) / m_cellSize) - 1;
+    }
+
+    inline QRect cellsRect(const QRect &rc) const {
+        return QRect(QPoint(cellCoord(rc.left()), cellCoord(rc.top())),
+                     QPoint(cellCoord(rc.right()), cellCoord(rc.bottom())));
+    }
+
+    static inline bool isOversized(const QRect &cells) {
+        return qint64(cells.width()) * cells.height() > maxCellsPerRect;
+    }
+
+    static inline quint64 cellKey(int x, int y) {
+        return (quint64(quint32(x)) << 32) | quint64(quint32(y));
+    }
+
+private:
+    int m_cellSize;
+    int m_size = 0;
+    QHash<quint64, QVector<Entry>> m_cells;
+    QVector<Entry> m_oversizedEntries;
+};
+
+#endif /* __KIS_RECTS_GRID_INDEX_H */
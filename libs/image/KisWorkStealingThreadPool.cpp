@@ -0,0 +1,352 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisWorkStealingThreadPool.h"
+
+#include <atomic>
+#include <deque>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "kis_assert.h"
+#include "KisNumaTopology.h"
+
+struct KisWorkStealingThreadPool::Private
+{
+    struct Worker;
+
+    /**
+     * The worker the current thread belongs to, or null if the
+     * current thread is not a worker of any pool
+     */
+    static thread_local Worker *currentWorker;
+
+    /**
+     * The workers are created lazily on the first start() call,
+     * since many images never do any updates in background
+     */
+    QVector<Worker*> workers;
+    std::atomic<bool> workersStarted {false};
+    int threadCount = 1;
+
+    /**
+     * The number of runnables sitting in the queues and the number
+     * of runnables being executed right now. A runnable is counted
+     * as active before it is removed from the pending counter, so
+     * the pool is never seen as idle in the middle of the handover.
+     */
+    std::atomic<int> numPending {0};
+    std::atomic<int> numActive {0};
+
+    std::atomic<unsigned int> nextWorker {0};
+
+    const KisNumaTopology *topology = 0;
+
+    /**
+     * The workers of every node of the topology
+     */
+    QVector<QVector<Worker*>> nodeWorkers;
+
+    /**
+     * Guards sleeping and waking of the workers and the waiters
+     * of waitForDone(). The queues themselves don't use it.
+     */
+    QMutex sleepLock;
+    QWaitCondition workAvailable;
+    QWaitCondition allDone;
+    bool stopRequested = false;
+
+    QRunnable* takeRunnable(Worker *worker);
+    void runRunnable(QRunnable *runnable);
+    void startWorkers(int count);
+    void stopWorkers();
+};
+
+thread_local KisWorkStealingThreadPool::Private::Worker *KisWorkStealingThreadPool::Private::currentWorker = 0;
+
+struct KisWorkStealingThreadPool::Private::Worker : public QThread
+{
+    Worker(KisWorkStealingThreadPool::Private *_pool, int _index, int _node)
+        : pool(_pool),
+          index(_index),
+          node(_node)
+    {
+        setObjectName(QString("KisWorkStealingThreadPool worker %1").arg(index));
+    }
+
+    void run() override {
+        currentWorker = this;
+
+        if (node >= 0) {
+            pool->topology->bindCurrentThreadToNode(node);
+        }
+
+        while (1) {
+            QRunnable *runnable = pool->takeRunnable(this);
+            if (runnable) {
+                pool->runRunnable(runnable);
+                continue;
+            }
+
+            QMutexLocker l(&pool->sleepLock);
+
+            if (pool->stopRequested) break;
+
+            /**
+             * start() increments the counter before locking the sleep
+             * lock, so the runnable queued after our check will wake
+             * us up after we go to sleep.
+             */
+            if (pool->numPending.load() > 0) continue;
+
+            pool->workAvailable.wait(&pool->sleepLock);
+        }
+
+        currentWorker = 0;
+    }
+
+    void push(QRunnable *runnable) {
+        QMutexLocker l(&queueLock);
+        queue.push_back(runnable);
+    }
+
+    QRunnable* popNewest() {
+        QMutexLocker l(&queueLock);
+        if (queue.empty()) return 0;
+
+        QRunnable *runnable = queue.back();
+        queue.pop_back();
+        return runnable;
+    }
+
+    QRunnable* stealOldest() {
+        // don't wait for the owner, just try the next victim
+        if (!queueLock.tryLock()) return 0;
+
+        QRunnable *runnable = 0;
+        if (!queue.empty()) {
+            runnable = queue.front();
+            queue.pop_front();
+        }
+
+        queueLock.unlock();
+        return runnable;
+    }
+
+    KisWorkStealingThreadPool::Private *pool;
+    const int index;
+
+    /**
+     * The node the worker is bound to, or -1 if the
+     * pool is not NUMA-aware
+     */
+    const int node;
+
+    /**
+     * The workers to steal from, the ones of the
+     * same node go first
+     */
+    QVector<Worker*> victims;
+
+    QMutex queueLock;
+    std::deque<QRunnable*> queue;
+};
+
+QRunnable* KisWorkStealingThreadPool::Private::takeRunnable(Worker *worker)
+{
+    if (numPending.load() <= 0) return 0;
+
+    QRunnable *runnable = worker->popNewest();
+
+    for (int i = 0; !runnable && i < worker->victims.size(); i++) {
+        runnable = worker->victims[i]->stealOldest();
+    }
+
+    if (runnable) {
+        numActive++;
+        numPending--;
+    }
+
+    return runnable;
+}
+
+void KisWorkStealingThreadPool::Private::runRunnable(QRunnable *runnable)
+{
+    const bool autoDelete = runnable->autoDelete();
+
+    runnable->run();
+
+    if (autoDelete) {
+        delete runnable;
+    }
+
+    if (numActive.fetch_sub(1) == 1 && numPending.load() == 0) {
+        QMutexLocker l(&sleepLock);
+        allDone.wakeAll();
+    }
+}
+
+void KisWorkStealingThreadPool::Private::startWorkers(int count)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(workers.isEmpty());
+
+    nodeWorkers.clear();
+    if (topology) {
+        nodeWorkers.resize(topology->numNodes());
+    }
+
+    for (int i = 0; i < count; i++) {
+        const int node = topology ? i % topology->numNodes() : -1;
+
+        Worker *worker = new Worker(this, i, node);
+        workers.append(worker);
+
+        if (node >= 0) {
+            nodeWorkers[node].append(worker);
+        }
+    }
+
+    Q_FOREACH (Worker *worker, workers) {
+        for (int i = 1; i < workers.size(); i++) {
+            Worker *victim = workers[(worker->index + i) % workers.size()];
+            if (victim->node == worker->node) {
+                worker->victims.append(victim);
+            }
+        }
+
+        for (int i = 1; i < workers.size(); i++) {
+            Worker *victim = workers[(worker->index + i) % workers.size()];
+            if (victim->node != worker->node) {
+                worker->victims.append(victim);
+            }
+        }
+    }
+
+    Q_FOREACH (Worker *worker, workers) {
+        worker->start();
+    }
+}
+
+void KisWorkStealingThreadPool::Private::stopWorkers()
+{
+    {
+        QMutexLocker l(&sleepLock);
+        stopRequested = true;
+        workAvailable.wakeAll();
+    }
+
+    Q_FOREACH (Worker *worker, workers) {
+        worker->wait();
+        KIS_SAFE_ASSERT_RECOVER_NOOP(worker->queue.empty());
+    }
+
+    qDeleteAll(workers);
+    workers.clear();
+    nodeWorkers.clear();
+
+    stopRequested = false;
+    workersStarted = false;
+}
+
+KisWorkStealingThreadPool::KisWorkStealingThreadPool()
+    : m_d(new Private)
+{
+    KisNumaTopology *topology = KisNumaTopology::instance();
+    m_d->topology = topology->isNumaAware() ? topology : 0;
+}
+
+KisWorkStealingThreadPool::~KisWorkStealingThreadPool()
+{
+    waitForDone();
+    m_d->stopWorkers();
+}
+
+void KisWorkStealingThreadPool::start(QRunnable *runnable)
+{
+    start(runnable, -1);
+}
+
+void KisWorkStealingThreadPool::start(QRunnable *runnable, int preferredNode)
+{
+    if (!m_d->workersStarted.load()) {
+        QMutexLocker l(&m_d->sleepLock);
+
+        if (!m_d->workersStarted.load()) {
+            m_d->startWorkers(m_d->threadCount);
+            m_d->workersStarted = true;
+        }
+    }
+
+    Private::Worker *worker = Private::currentWorker;
+
+    if (worker && worker->pool != m_d.data()) {
+        worker = 0;
+    }
+
+    if (preferredNode >= 0 && preferredNode < m_d->nodeWorkers.size() &&
+        !m_d->nodeWorkers[preferredNode].isEmpty() &&
+        (!worker || worker->node != preferredNode)) {
+
+        const QVector<Private::Worker*> &nodeWorkers = m_d->nodeWorkers[preferredNode];
+        worker = nodeWorkers[m_d->nextWorker++ % nodeWorkers.size()];
+    }
+
+    if (!worker) {
+        worker = m_d->workers[m_d->nextWorker++ % m_d->workers.size()];
+    }
+
+    // the counter goes first, so that it never becomes negative
+    m_d->numPending++;
+    worker->push(runnable);
+
+    QMutexLocker l(&m_d->sleepLock);
+    m_d->workAvailable.wakeOne();
+}
+
+void KisWorkStealingThreadPool::waitForDone()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!Private::currentWorker || Private::currentWorker->pool != m_d.data());
+
+    QMutexLocker l(&m_d->sleepLock);
+
+    while (m_d->numPending.load() > 0 || m_d->numActive.load() > 0) {
+        m_d->allDone.wait(&m_d->sleepLock);
+    }
+}
+
+void KisWorkStealingThreadPool::setMaxThreadCount(int value)
+{
+    value = qMax(1, value);
+    if (value == m_d->threadCount) return;
+
+    waitForDone();
+    m_d->stopWorkers();
+    m_d->threadCount = value;
+}
+
+int KisWorkStealingThreadPool::maxThreadCount() const
+{
+    return m_d->threadCount;
+}
+
+void KisWorkStealingThreadPool::setNumaTopology(const KisNumaTopology *topology)
+{
+    if (topology == m_d->topology) return;
+
+    waitForDone();
+    m_d->stopWorkers();
+    m_d->topology = topology;
+}
+
+const KisNumaTopology* KisWorkStealingThreadPool::numaTopology() const
+{
+    return m_d->topology;
+}
@@ -0,0 +1,85 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_WORK_STEALING_THREAD_POOL_H
+#define __KIS_WORK_STEALING_THREAD_POOL_H
+
+#include <QScopedPointer>
+#include "kritaimage_export.h"
+
+class QRunnable;
+class KisNumaTopology;
+
+/**
+ * A thread pool with a separate queue for every worker thread. It is
+ * used by KisUpdaterContext instead of QThreadPool, which keeps all
+ * the runnables in a single global queue guarded by a single mutex.
+ *
+ * The runnables started from a worker thread of the pool are pushed
+ * into the worker's own queue and are executed by this worker in LIFO
+ * order, while the data of the finished job is still hot in the cache.
+ * The runnables started from the other threads are distributed over
+ * the workers in round-robin manner. An idle worker first checks its
+ * own queue, then steals the oldest runnable from the queues of the
+ * other workers, and only when there is nothing to steal it goes to
+ * sleep.
+ *
+ * On NUMA systems (see KisNumaTopology) the workers are distributed
+ * over the nodes and bound to them. A runnable may be started with a
+ * preferred node, then it is queued to a worker of this node, and the
+ * idle workers steal from the workers of their own node first.
+ *
+ * The interface repeats the subset of QThreadPool used by the context,
+ * the semantics of the methods are the same.
+ */
+class KRITAIMAGE_EXPORT KisWorkStealingThreadPool
+{
+public:
+    KisWorkStealingThreadPool();
+    ~KisWorkStealingThreadPool();
+
+    /**
+     * Queues \p runnable for execution. If runnable->autoDelete()
+     * is true, the pool takes the ownership of the runnable.
+     */
+    void start(QRunnable *runnable);
+
+    /**
+     * Queues \p runnable for execution on a worker of \p preferredNode.
+     * If the node is -1 or the pool is not NUMA-aware, it is the same
+     * as start(runnable).
+     */
+    void start(QRunnable *runnable, int preferredNode);
+
+    /**
+     * Blocks the caller until all the queued runnables are finished.
+     * Must not be called from the worker threads of the pool.
+     */
+    void waitForDone();
+
+    /**
+     * Sets the number of the worker threads. The threads are created
+     * on the next call to start(). The pool must be idle when the
+     * number of threads is changed.
+     */
+    void setMaxThreadCount(int value);
+    int maxThreadCount() const;
+
+    /**
+     * Sets the topology the workers are distributed over. By default it
+     * is KisNumaTopology::instance() if the system is NUMA-aware and null
+     * otherwise. Null topology disables the NUMA awareness. The pool must
+     * be idle when the topology is changed.
+     */
+    void setNumaTopology(const KisNumaTopology *topology);
+    const KisNumaTopology* numaTopology() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_WORK_STEALING_THREAD_POOL_H */
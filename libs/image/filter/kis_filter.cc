@@ -19,6 +19,7 @@
 #include "filter/kis_filter.h"
 
 #include <QString>
+#include <QMutexLocker>
 
 #include <KoCompositeOpRegistry.h>
 #include "kis_bookmarked_configuration_manager.h"
@@ -30,10 +31,12 @@
 #include "kis_types.h"
 #include <kis_painter.h>
 #include <KoUpdater.h>
+#include "kis_lod_transform.h"
 
 KisFilter::KisFilter(const KoID& _id, const KoID & category, const QString & entry)
     : KisBaseProcessor(_id, category, entry),
-      m_supportsLevelOfDetail(false)
+      m_supportsLevelOfDetail(false),
+      m_supportsGenericLevelOfDetail(true)
 {
     init(id() + "_filter_bookmarks");
 }
@@ -58,7 +61,11 @@ void KisFilter::process(const KisPaintDeviceSP src,
                         KoUpdater* progressUpdater ) const
 {
     if (applyRect.isEmpty()) return;
-    QRect needRect = neededRect(applyRect, config, src->defaultBounds()->currentLevelOfDetail());
+
+    const int lod = src->defaultBounds()->currentLevelOfDetail();
+    const KisFilterConfigurationSP lodConfig = levelOfDetailConfiguration(config, lod);
+
+    QRect needRect = neededRect(applyRect, lodConfig, lod);
 
     KisPaintDeviceSP temporary;
     KisTransaction *transaction = 0;
@@ -85,7 +92,7 @@ void KisFilter::process(const KisPaintDeviceSP src,
             progressUpdater = fakeUpdater.data();
         }
 
-        processImpl(temporary, applyRect, config, progressUpdater);
+        processImpl(temporary, applyRect, lodConfig, progressUpdater);
     }
     catch (const std::bad_alloc&) {
         warnKrita << "Filter" << name() << "failed to allocate enough memory to run.";
@@ -116,7 +123,7 @@ bool KisFilter::supportsLevelOfDetail(const KisFilterConfigurationSP config, int
 {
     Q_UNUSED(config);
     Q_UNUSED(lod);
-    return m_supportsLevelOfDetail;
+    return m_supportsLevelOfDetail || m_supportsGenericLevelOfDetail;
 }
 
 void KisFilter::setSupportsLevelOfDetail(bool value)
@@ -124,6 +131,93 @@ void KisFilter::setSupportsLevelOfDetail(bool value)
     m_supportsLevelOfDetail = value;
 }
 
+void KisFilter::setSupportsGenericLevelOfDetail(bool value)
+{
+    m_supportsGenericLevelOfDetail = value;
+}
+
+void KisFilter::setLevelOfDetailScaledProperties(const QStringList &properties)
+{
+    m_levelOfDetailScaledProperties = properties;
+}
+
+KisFilterConfigurationSP KisFilter::levelOfDetailConfiguration(const KisFilterConfigurationSP config, int lod) const
+{
+    if (!lod || !config || m_supportsLevelOfDetail || !m_supportsGenericLevelOfDetail) return config;
+
+    /**
+     * process() is called for every rect of every update, so keep the
+     * last scaled configuration and rescale it only when the source
+     * configuration or the level of detail changes. The source is
+     * compared by value, because the configurations of the layers
+     * are edited in place.
+     */
+    QMutexLocker l(&m_lodConfigCacheLock);
+
+    if (m_lodConfigCacheSource &&
+        lod == m_lodConfigCacheLevelOfDetail &&
+        m_lodConfigCacheSource->getPropertiesKeys().size() == config->getPropertiesKeys().size() &&
+        m_lodConfigCacheSource->compareTo(config.data())) {
+
+        return m_lodConfigCacheResult;
+    }
+
+    KisFilterConfigurationSP source = new KisFilterConfiguration(*config);
+    source->setChannelFlags(config->channelFlags());
+    source->setCurve(config->curve());
+    QList<KisCubicCurve> curves = config->curves();
+    source->setCurves(curves);
+
+    m_lodConfigCacheResult = scaleConfiguration(config, KisLodTransform::lodToScale(lod));
+    m_lodConfigCacheSource = source;
+    m_lodConfigCacheLevelOfDetail = lod;
+
+    return m_lodConfigCacheResult;
+}
+
+KisFilterConfigurationSP KisFilter::scaleConfiguration(const KisFilterConfigurationSP config, qreal scale) const
+{
+    if (m_levelOfDetailScaledProperties.isEmpty()) return config;
+
+    KisFilterConfigurationSP scaledConfig = factoryConfiguration();
+    scaledConfig->fromXML(config->toXML());
+
+    // these ones are not saved into XML
+    scaledConfig->setChannelFlags(config->channelFlags());
+    scaledConfig->setCurve(config->curve());
+    QList<KisCubicCurve> curves = config->curves();
+    scaledConfig->setCurves(curves);
+
+    Q_FOREACH (const QString &property, m_levelOfDetailScaledProperties) {
+        QVariant value;
+        if (!scaledConfig->getProperty(property, value)) continue;
+
+        /**
+         * The values loaded from XML are stored as strings,
+         * so check the contents, not the type of the variant
+         */
+        bool isInt = false;
+        const int intValue = value.toString().toInt(&isInt);
+
+        if (isInt) {
+            int scaledValue = qRound(intValue * scale);
+            if (intValue && !scaledValue) {
+                scaledValue = intValue > 0 ? 1 : -1;
+            }
+            scaledConfig->setProperty(property, scaledValue);
+        } else {
+            bool isReal = false;
+            const qreal realValue = value.toDouble(&isReal);
+
+            if (isReal) {
+                scaledConfig->setProperty(property, realValue * scale);
+            }
+        }
+    }
+
+    return scaledConfig;
+}
+
 bool KisFilter::needsTransparentPixels(const KisFilterConfigurationSP config, const KoColorSpace *cs) const
 {
     Q_UNUSED(config);
@@ -20,7 +20,9 @@
 
 #include <list>
 
+#include <QMutex>
 #include <QString>
+#include <QStringList>
 
 #include <klocalizedstring.h>
 
@@ -107,9 +109,33 @@ public:
     /**
      * Returns true if the filter is capable of handling LoD scaled planes
      * when generating preview.
+     *
+     * The filters that do not handle LoD planes natively are still run on
+     * them via the generic path (see levelOfDetailConfiguration()), unless
+     * they explicitly disable it with setSupportsGenericLevelOfDetail(false).
+     * The preview is approximate then, the exact result is calculated by
+     * the full resolution (LoD0) pass that follows the preview.
      */
     virtual bool supportsLevelOfDetail(const KisFilterConfigurationSP config, int lod) const;
 
+    /**
+     * Returns the configuration that should be passed to processImpl()
+     * when the filter is applied to a plane of level of detail \p lod.
+     *
+     * For the filters supporting LoD natively and for \p lod == 0 the
+     * configuration is returned as it is. Otherwise the filter doesn't
+     * know anything about the scaled plane and processes it as a usual
+     * device, so its size-like parameters (radius, kernel size, etc.)
+     * are scaled with scaleConfiguration().
+     *
+     * The last scaled configuration is cached, so the scaling happens
+     * only when \p config or \p lod changes.
+     *
+     * process() does the conversion automatically, the callers of
+     * processImpl() should do that themselves.
+     */
+    KisFilterConfigurationSP levelOfDetailConfiguration(const KisFilterConfigurationSP config, int lod) const;
+
     virtual bool needsTransparentPixels(const KisFilterConfigurationSP config, const KoColorSpace *cs) const;
 
     virtual bool configurationAllowedForMask(KisFilterConfigurationSP config) const;
@@ -120,9 +146,41 @@ protected:
     QString configEntryGroup() const;
     void setSupportsLevelOfDetail(bool value);
 
+    /**
+     * Enables or disables the generic LoD path for the filters that
+     * don't support LoD natively. Enabled by default.
+     */
+    void setSupportsGenericLevelOfDetail(bool value);
+
+    /**
+     * Sets the names of the properties of the configuration that are
+     * measured in pixels and should be scaled by the default
+     * implementation of scaleConfiguration()
+     */
+    void setLevelOfDetailScaledProperties(const QStringList &properties);
+
+    /**
+     * Returns a copy of \p config adjusted for processing of a device
+     * scaled by \p scale. The default implementation multiplies the
+     * properties set with setLevelOfDetailScaledProperties(), the
+     * integer properties are rounded, but never become zero. If there
+     * are no such properties, \p config is returned as it is.
+     *
+     * Override it if the parameters of the filter cannot be scaled
+     * by a simple multiplication.
+     */
+    virtual KisFilterConfigurationSP scaleConfiguration(const KisFilterConfigurationSP config, qreal scale) const;
+
 
 private:
     bool m_supportsLevelOfDetail;
+    bool m_supportsGenericLevelOfDetail;
+    QStringList m_levelOfDetailScaledProperties;
+
+    mutable QMutex m_lodConfigCacheLock;
+    mutable KisFilterConfigurationSP m_lodConfigCacheSource;
+    mutable KisFilterConfigurationSP m_lodConfigCacheResult;
+    mutable int m_lodConfigCacheLevelOfDetail = 0;
 };
 
 
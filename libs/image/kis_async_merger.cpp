@@ -261,6 +261,10 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
             setupProjection(currentLeaf, applyRect, useTempProjections);
         }
 
+        if (m_levelItemIndex < 0) {
+            setupPartialProjections(walker, item, useTempProjections);
+        }
+
         KisUpdateOriginalVisitor originalVisitor(applyRect,
                                                  m_currentProjection,
                                                  walker.cropRect());
@@ -292,7 +296,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
             /* nothing to do */
         }
 
-        compositeWithProjection(currentLeaf, applyRect);
+        compositeLevelItem(currentLeaf, applyRect);
 
         if(item.m_position & KisMergeWalker::N_TOPMOST) {
             writeProjection(currentLeaf, useTempProjections, applyRect);
@@ -321,6 +325,8 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
 void KisAsyncMerger::resetProjection() {
     m_currentProjection = 0;
     m_finalProjection = 0;
+    m_levelPlan = KisPartialProjectionsCache::Plan();
+    m_levelItemIndex = -1;
 }
 
 void KisAsyncMerger::setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection) {
@@ -351,6 +357,81 @@ void KisAsyncMerger::setupProjection(KisProjectionLeafSP currentLeaf, const QRec
     }
 }
 
+void KisAsyncMerger::setupPartialProjections(KisBaseRectsWalker &walker, const KisBaseRectsWalker::JobItem &firstItem, bool useTempProjection) {
+    m_levelPlan = KisPartialProjectionsCache::Plan();
+    m_levelItemIndex = 0;
+
+    /**
+     * The cache keeps the data of the finest level of detail only.
+     * The updates of the other levels cannot change the layers.
+     */
+    if (walker.levelOfDetail() > 0) return;
+
+    KisProjectionLeafSP parentLeaf = firstItem.m_leaf->parent();
+    KisGroupLayer *group = parentLeaf ? qobject_cast<KisGroupLayer*>(parentLeaf->node().data()) : 0;
+    if (!group) return;
+
+    /**
+     * The items of the group lie on the stack sequentially,
+     * from the bottommost to the topmost one.
+     */
+    QVector<KisBaseRectsWalker::JobItem> items;
+    items.append(firstItem);
+
+    const KisBaseRectsWalker::LeafStack &leafStack = walker.leafStack();
+
+    for (int i = leafStack.size() - 1; !(items.last().m_position & KisMergeWalker::N_TOPMOST); i--) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(i >= 0);
+
+        const KisBaseRectsWalker::JobItem &item = leafStack[i];
+        KIS_SAFE_ASSERT_RECOVER_RETURN(!item.m_leaf->isRoot());
+        KIS_SAFE_ASSERT_RECOVER_RETURN(!(item.m_position & KisMergeWalker::N_EXTRA));
+
+        items.append(item);
+    }
+
+    /**
+     * With varying need rects the items are merged in different
+     * rects, the cache is only invalidated then.
+     */
+    const bool canUseCache =
+        !useTempProjection &&
+        m_currentProjection &&
+        m_currentProjection == m_finalProjection;
+
+    m_levelPlan = group->partialProjectionsCache()->prepareUpdate(items, m_currentProjection, canUseCache);
+}
+
+void KisAsyncMerger::compositeLevelItem(KisProjectionLeafSP leaf, const QRect &rect) {
+    const int index = m_levelItemIndex++;
+
+    if (m_levelPlan.belowProjection && index < m_levelPlan.splitIndex) {
+        if (index == 0) {
+            KisPainter::copyAreaOptimized(rect.topLeft(), m_levelPlan.belowProjection, m_currentProjection, rect);
+            DEBUG_NODE_ACTION("Copying cached projection below", "", leaf, rect);
+        }
+        return;
+    }
+
+    if (m_levelPlan.aboveProjection && index > m_levelPlan.splitIndex) {
+        // already composited together with the split layer
+        return;
+    }
+
+    compositeWithProjection(leaf, rect);
+
+    if (m_levelPlan.aboveProjection && index == m_levelPlan.splitIndex) {
+        const QRect applyRect = rect & m_levelPlan.aboveProjection->extent();
+
+        if (!applyRect.isEmpty()) {
+            KisPainter gc(m_currentProjection);
+            gc.setCompositeOp(COMPOSITE_OVER);
+            gc.bitBlt(applyRect.topLeft(), m_levelPlan.aboveProjection, applyRect);
+        }
+        DEBUG_NODE_ACTION("Compositing cached projection above", "", leaf, rect);
+    }
+}
+
 void KisAsyncMerger::writeProjection(KisProjectionLeafSP topmostLeaf, bool useTempProjection, const QRect &rect) {
     Q_UNUSED(useTempProjection);
     Q_UNUSED(topmostLeaf);
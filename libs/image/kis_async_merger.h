@@ -21,6 +21,7 @@
 
 #include "kritaimage_export.h"
 #include "kis_types.h"
+#include "KisPartialProjectionsCache.h"
 
 class QRect;
 class KisBaseRectsWalker;
@@ -33,6 +34,8 @@ public:
 private:
     inline void resetProjection();
     inline void setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection);
+    inline void setupPartialProjections(KisBaseRectsWalker &walker, const KisBaseRectsWalker::JobItem &firstItem, bool useTempProjection);
+    inline void compositeLevelItem(KisProjectionLeafSP leaf, const QRect &rect);
     inline void writeProjection(KisProjectionLeafSP topmostLeaf, bool useTempProjection, const QRect &rect);
     inline bool compositeWithProjection(KisProjectionLeafSP leaf, const QRect &rect);
     inline void doNotifyClones(KisBaseRectsWalker &walker);
@@ -62,6 +65,15 @@ private:
      * setupProjection()
      */
     KisPaintDeviceSP m_cachedPaintDevice;
+
+    /**
+     * The plan of using the partial projections cache of the
+     * group being merged now (\see KisPartialProjectionsCache)
+     * and the index of the current item in this group. The index
+     * is -1 when no group is being merged.
+     */
+    KisPartialProjectionsCache::Plan m_levelPlan;
+    int m_levelItemIndex = -1;
 };
 
 
@@ -86,7 +86,7 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
 
 #ifdef HAVE_FFTW3
     if (useFFTImplementation(kernel)) {
-        worker = new KisConvolutionWorkerFFT<factory>(painter, progress);
+        worker = new KisConvolutionWorkerFFT<factory>(painter, progress, m_fftTilingEnabled);
     } else {
         worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
     }
@@ -108,28 +108,48 @@ bool KisConvolutionPainter::supportsFFTW()
 #endif
 }
 
+qint64 KisConvolutionPainter::fftPeakMemoryUsage()
+{
+#ifdef HAVE_FFTW3
+    return KisConvolutionWorkerFFTLock::peakMemory;
+#else
+    return 0;
+#endif
+}
+
+void KisConvolutionPainter::resetFFTPeakMemoryUsage()
+{
+#ifdef HAVE_FFTW3
+    KisConvolutionWorkerFFTLock::peakMemory = qint64(KisConvolutionWorkerFFTLock::currentMemory);
+#endif
+}
+
 
 KisConvolutionPainter::KisConvolutionPainter()
     : KisPainter(),
-      m_enginePreference(NONE)
+      m_enginePreference(NONE),
+      m_fftTilingEnabled(true)
 {
 }
 
 KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device)
     : KisPainter(device),
-      m_enginePreference(NONE)
+      m_enginePreference(NONE),
+      m_fftTilingEnabled(true)
 {
 }
 
 KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device, KisSelectionSP selection)
     : KisPainter(device, selection),
-      m_enginePreference(NONE)
+      m_enginePreference(NONE),
+      m_fftTilingEnabled(true)
 {
 }
 
 KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device, EnginePreference enginePreference)
     : KisPainter(device),
-      m_enginePreference(enginePreference)
+      m_enginePreference(enginePreference),
+      m_fftTilingEnabled(true)
 {
 }
 
@@ -138,6 +158,11 @@ void KisConvolutionPainter::setEnginePreference(EnginePreference value)
     m_enginePreference = value;
 }
 
+void KisConvolutionPainter::setFFTTilingEnabled(bool value)
+{
+    m_fftTilingEnabled = value;
+}
+
 void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, KisConvolutionBorderOp borderOp)
 {
     /**
@@ -58,6 +58,13 @@ public:
 
     void setEnginePreference(EnginePreference value);
 
+    /**
+     * By default the FFT engine splits the area into tiles and convolves
+     * them in parallel. When tiling is disabled, the whole area is
+     * transformed at once on the calling thread.
+     */
+    void setFFTTilingEnabled(bool value);
+
     /**
      * Convolve all channels in src using the specified kernel; there is only one kernel for all
      * channels possible.
@@ -92,6 +99,13 @@ public:
 
     static bool supportsFFTW();
 
+    /**
+     * The peak amount of memory allocated for the FFT buffers since the
+     * last call to resetFFTPeakMemoryUsage(). Used for benchmarking.
+     */
+    static qint64 fftPeakMemoryUsage();
+    static void resetFFTPeakMemoryUsage();
+
 protected:
     friend class KisConvolutionPainterTest;
 
@@ -107,5 +121,6 @@ private:
 
 private:
     EnginePreference m_enginePreference;
+    bool m_fftTilingEnabled;
 };
 #endif //KIS_CONVOLUTION_PAINTER_H_
@@ -20,6 +20,7 @@
 #ifndef KIS_CONVOLUTION_WORKER_FFT_H
 #define KIS_CONVOLUTION_WORKER_FFT_H
 
+#include <atomic>
 #include <iostream>
 
 #include <KoChannelInfo.h>
@@ -28,10 +29,15 @@
 #include "kis_math_toolbox.h"
 
 #include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QPair>
+#include <QThread>
 #include <QVector>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
 
 #include <fftw3.h>
 
@@ -39,19 +45,53 @@ template<class _IteratorFactory_> class KisConvolutionWorkerFFT;
 class KisConvolutionWorkerFFTLock
 {
 private:
+    struct Plans {
+        fftw_plan forward;
+        fftw_plan backward;
+    };
+
     static QMutex fftwMutex;
+
+    /**
+     * The plans depend on the size of the transform only, and all the
+     * tiles of a convolution have the same size, so the plans are created
+     * once and shared by all the calls. FFTW keeps the wisdom gathered while
+     * creating them, so planning of the similar sizes becomes cheaper too.
+     * Guarded by fftwMutex.
+     */
+    static QHash<QPair<int, int>, Plans> plansCache;
+    static const int maxCachedPlans = 32;
+
+    static std::atomic<qint64> currentMemory;
+    static std::atomic<qint64> peakMemory;
+
     template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
+    friend class KisConvolutionPainter;
 };
 
 QMutex KisConvolutionWorkerFFTLock::fftwMutex;
+QHash<QPair<int, int>, KisConvolutionWorkerFFTLock::Plans> KisConvolutionWorkerFFTLock::plansCache;
+std::atomic<qint64> KisConvolutionWorkerFFTLock::currentMemory(0);
+std::atomic<qint64> KisConvolutionWorkerFFTLock::peakMemory(0);
 
 
 template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 {
 public:
-    KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
-        : KisConvolutionWorker<_IteratorFactory_>(painter, progress)
+    /**
+     * The area is split into tiles with the side of about preferredFFTSize
+     * (or four kernel sizes for the big kernels), which are convolved in
+     * parallel using overlap-save. The number of tiles processed at once
+     * is limited so that their buffers would fit into maxTilesMemory.
+     */
+    static const int preferredFFTSize = 512;
+    static const qint64 maxTilesMemory = 256 * 1024 * 1024;
+
+public:
+    KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress, bool useTiling = true)
+        : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
+          m_useTiling(useTiling)
     {
     }
 
@@ -77,34 +117,43 @@ public:
         addToProgress(0);
         if (isInterrupted()) return;
 
-        const quint32 halfKernelWidth = (kernel->width() - 1) / 2;
-        const quint32 halfKernelHeight = (kernel->height() - 1) / 2;
-
-        m_fftWidth = areaSize.width() + 4 * halfKernelWidth;
-        m_fftHeight = areaSize.height() + 2 * halfKernelHeight;
+        const int halfKernelWidth = (kernel->width() - 1) / 2;
+        const int halfKernelHeight = (kernel->height() - 1) / 2;
 
-        /**
-         * FIXME: check whether this "optimization" is needed to
-         * be uncommented. My tests showed about 30% better performance
-         * when the line is commented out (DK).
-         */
-        //optimumDimensions(m_fftWidth, m_fftHeight);
+        m_fftWidth = fftSize(areaSize.width(), kernel->width());
+        m_fftHeight = fftSize(areaSize.height(), kernel->height());
 
         m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
         m_extraMem = (m_fftWidth % 2) ? 1 : 2;
 
-        // create and fill kernel
-        m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
-        fftFillKernelMatrix(kernel, m_kernelFFT);
+        const int tileWidth = m_fftWidth - (kernel->width() - 1);
+        const int tileHeight = m_fftHeight - (kernel->height() - 1);
+
+        QVector<QRect> tiles;
+        for (int y = 0; y < areaSize.height(); y += tileHeight) {
+            for (int x = 0; x < areaSize.width(); x += tileWidth) {
+                tiles.append(QRect(x, y,
+                                   qMin(tileWidth, areaSize.width() - x),
+                                   qMin(tileHeight, areaSize.height() - y)));
+            }
+        }
 
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        }
+        const qint64 tileMemory = qint64(sizeof(fftw_complex)) * m_fftLength * convChannelList.count();
+        const int numJobs =
+            !m_useTiling ? 1 :
+            qBound(1, int(qMin(qint64(QThread::idealThreadCount()), maxTilesMemory / qMax(tileMemory, qint64(1)))), tiles.size());
+
+        KisConvolutionWorkerFFTLock::Plans plans = acquirePlans();
+
+        // create and fill kernel
+        m_kernelFFT = allocateBuffer();
+        fftFillKernelMatrix(kernel, m_kernelFFT);
+        fftw_execute_dft_r2c(plans.forward, (double*)m_kernelFFT, m_kernelFFT);
+
+        addToProgress(10);
 
         const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
         const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
@@ -112,56 +161,66 @@ public:
         FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
         int cacheRowStride = m_fftWidth + m_extraMem;
 
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
-
-        addToProgress(10);
-        if (isInterrupted()) return;
+        /**
+         * The tiles read the pixels around them, which may have already
+         * been overwritten by the neighbouring tiles when the source and
+         * destination devices coincide. The copy shares the tile data with
+         * the source, so it costs almost nothing.
+         */
+        KisPaintDeviceSP source = src;
+        if (src == this->m_painter->device()) {
+            source = new KisPaintDevice(*src);
+        }
 
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
+        const float progressPerTile = 90.0 / tiles.size();
+        std::atomic<int> nextTile(0);
 
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
+        auto processTiles = [&] (int) {
+            QVector<fftw_complex*> channelFFT(convChannelList.count());
+            for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+                *i = allocateBuffer();
+            }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+            int tileIndex;
+            while ((tileIndex = nextTile++) < tiles.size() && !isInterrupted()) {
+                const QRect &tile = tiles.at(tileIndex);
+
+                fillCacheFromDevice(source,
+                                    QRect(srcPos.x() + tile.x() - halfKernelWidth,
+                                          srcPos.y() + tile.y() - halfKernelHeight,
+                                          m_fftWidth,
+                                          m_fftHeight),
+                                    cacheRowStride,
+                                    info, dataRect, channelFFT);
+
+                for (auto k = channelFFT.begin(); k != channelFFT.end(); ++k)
+                {
+                    fftw_execute_dft_r2c(plans.forward, (double*)(*k), *k);
+                    fftMultiply(*k, m_kernelFFT);
+                    fftw_execute_dft_c2r(plans.backward, *k, (double*)*k);
+                }
 
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
-        if (isInterrupted()) return;
+                writeResultToDevice(QRect(dstPos.x() + tile.x(), dstPos.y() + tile.y(),
+                                          tile.width(), tile.height()),
+                                    cacheRowStride, halfKernelWidth, halfKernelHeight,
+                                    info, dataRect, channelFFT);
 
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+                addToProgress(progressPerTile);
+            }
 
-            fftMultiply(*k, m_kernelFFT);
+            Q_FOREACH (fftw_complex *channel, channelFFT) {
+                freeBuffer(channel);
+            }
+        };
 
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+        if (numJobs > 1) {
+            QVector<int> jobs(numJobs);
+            QtConcurrent::blockingMap(jobs, processTiles);
+        } else {
+            processTiles(0);
         }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
-
-
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
-
-        addToProgress(20);
+        releasePlans(plans);
         cleanUp();
     }
 
@@ -221,7 +280,8 @@ public:
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -233,7 +293,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -326,7 +386,8 @@ public:
                              const int halfKernelWidth,
                              const int halfKernelHeight,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineIterator hitDst =
             _IteratorFactory_::createHLineIterator(this->m_painter->device(),
@@ -340,7 +401,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -466,26 +527,99 @@ private:
         }
     }
 
-    void optimumDimensions(quint32& w, quint32& h)
+    /**
+     * Returns the size of the transform for the area of \p areaSize
+     * pixels and a kernel of \p kernelSize. FFTW is most efficient when
+     * the size is a product of 2, 3, 5 and 7, and rounding to such sizes
+     * also lets the calls with similar areas share the plans.
+     */
+    int fftSize(int areaSize, int kernelSize) const
     {
-        // FFTW is most efficient when array size is a factor of 2, 3, 5 or 7
-        quint32 optW = w, optH = h;
+        const int overlap = kernelSize - 1;
+
+        int size = areaSize + overlap;
+        if (m_useTiling) {
+            size = qMin(size, qMax(int(preferredFFTSize), 4 * overlap));
+        }
+
+        for (;; size++) {
+            int rest = size;
+            for (int factor : {2, 3, 5, 7}) {
+                while (rest % factor == 0) {
+                    rest /= factor;
+                }
+            }
+            if (rest == 1) break;
+        }
 
-        while ((optW % 2 != 0) || (optW % 3 != 0) || (optW % 5 != 0) || (optW % 7 != 0))
-            ++optW;
+        return size;
+    }
 
-        while ((optH % 2 != 0) || (optH % 3 != 0) || (optH % 5 != 0) || (optH % 7 != 0))
-            ++optH;
+    KisConvolutionWorkerFFTLock::Plans acquirePlans()
+    {
+        QMutexLocker l(&KisConvolutionWorkerFFTLock::fftwMutex);
 
-        quint32 optAreaW = optW * h;
-        quint32 optAreaH = optH * w;
+        const QPair<int, int> key(m_fftWidth, m_fftHeight);
 
-        if (optAreaW < optAreaH) {
-            w = optW;
+        auto it = KisConvolutionWorkerFFTLock::plansCache.constFind(key);
+        if (it != KisConvolutionWorkerFFTLock::plansCache.constEnd()) {
+            return *it;
         }
-        else {
-            h = optH;
+
+        /**
+         * The plans are executed on the other buffers with the new-array
+         * execute functions, which is allowed, since the buffers allocated
+         * with fftw_malloc() have the same alignment. FFTW_ESTIMATE doesn't
+         * touch the buffer, so it can be freed right away.
+         */
+        fftw_complex *buffer = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+
+        KisConvolutionWorkerFFTLock::Plans plans;
+        plans.forward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)buffer, buffer, FFTW_ESTIMATE);
+        plans.backward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, buffer, (double*)buffer, FFTW_ESTIMATE);
+
+        fftw_free(buffer);
+
+        if (KisConvolutionWorkerFFTLock::plansCache.size() < KisConvolutionWorkerFFTLock::maxCachedPlans) {
+            KisConvolutionWorkerFFTLock::plansCache.insert(key, plans);
         }
+
+        return plans;
+    }
+
+    void releasePlans(const KisConvolutionWorkerFFTLock::Plans &plans)
+    {
+        QMutexLocker l(&KisConvolutionWorkerFFTLock::fftwMutex);
+
+        const QPair<int, int> key(m_fftWidth, m_fftHeight);
+
+        auto it = KisConvolutionWorkerFFTLock::plansCache.constFind(key);
+        if (it == KisConvolutionWorkerFFTLock::plansCache.constEnd() ||
+            it->forward != plans.forward) {
+
+            fftw_destroy_plan(plans.forward);
+            fftw_destroy_plan(plans.backward);
+        }
+    }
+
+    fftw_complex* allocateBuffer()
+    {
+        const qint64 size = sizeof(fftw_complex) * m_fftLength;
+
+        const qint64 memory = KisConvolutionWorkerFFTLock::currentMemory += size;
+        qint64 peak = KisConvolutionWorkerFFTLock::peakMemory;
+        while (memory > peak &&
+               !KisConvolutionWorkerFFTLock::peakMemory.compare_exchange_weak(peak, memory));
+
+        fftw_complex *buffer = (fftw_complex *)fftw_malloc(size);
+        memset(buffer, 0, size);
+        return buffer;
+    }
+
+    void freeBuffer(fftw_complex *buffer)
+    {
+        KisConvolutionWorkerFFTLock::currentMemory -= sizeof(fftw_complex) * m_fftLength;
+        fftw_free(buffer);
     }
 
     void fftLogMatrix(double* channel, const QString &f)
@@ -519,6 +653,9 @@ private:
 
     void addToProgress(float amount)
     {
+        // the tiles are reported from several threads
+        QMutexLocker l(&m_progressLock);
+
         m_currentProgress += amount;
 
         if (this->m_progress) {
@@ -528,35 +665,29 @@ private:
 
     bool isInterrupted()
     {
-        if (this->m_progress && this->m_progress->interrupted()) {
-            cleanUp();
-            return true;
-        }
-
-        return false;
+        return this->m_progress && this->m_progress->interrupted();
     }
 
     void cleanUp()
     {
         // free kernel fft data
         if (m_kernelFFT) {
-            fftw_free(m_kernelFFT);
+            freeBuffer(m_kernelFFT);
+            m_kernelFFT = 0;
         }
-
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
     }
 private:
+    bool m_useTiling {true};
+
     quint32 m_fftWidth {0};
     quint32 m_fftHeight {0};
     quint32 m_fftLength {0};
     quint32 m_extraMem {0};
+
+    QMutex m_progressLock;
     float m_currentProgress {0.0};
 
     fftw_complex* m_kernelFFT {0};
-    QVector<fftw_complex*> m_channelFFT;
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include <kis_transaction.h>
 #include <QRect>
 
+#include "KisFastGaussianBlur.h"
+
 
 qreal KisGaussianKernel::sigmaFromRadius(qreal radius)
 {
@@ -117,10 +119,24 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                       const QBitArray &channelFlags,
                                       KoUpdater *progressUpdater,
                                       bool createTransaction,
-                                      KisConvolutionBorderOp borderOp)
+                                      KisConvolutionBorderOp borderOp,
+                                      BlurMethod method)
 {
-    QPoint srcTopLeft = rect.topLeft();
+    if (method == BLUR_AUTO) {
+        method = qMax(xRadius, yRadius) >= fastBlurRadiusThreshold ? BLUR_FAST : BLUR_EXACT;
+    }
 
+    if (method == BLUR_FAST) {
+        /**
+         * The fast blur reads all the source pixels before writing
+         * anything, so it never needs a transaction
+         */
+        KisFastGaussianBlur::apply(device, rect, xRadius, yRadius,
+                                   channelFlags, progressUpdater, borderOp);
+        return;
+    }
+
+    QPoint srcTopLeft = rect.topLeft();
 
     if (KisConvolutionPainter::supportsFFTW()) {
         KisConvolutionPainter painter(device, KisConvolutionPainter::FFTW);
@@ -30,6 +30,19 @@ class QRect;
 class KRITAIMAGE_EXPORT KisGaussianKernel
 {
 public:
+    enum BlurMethod {
+        BLUR_EXACT, // convolve with the full Gaussian kernel
+        BLUR_FAST,  // approximate with KisFastGaussianBlur, the cost doesn't depend on the radius
+        BLUR_AUTO   // use BLUR_FAST for the radii of fastBlurRadiusThreshold and more
+    };
+
+    /**
+     * The error of the approximation doesn't depend on the radius, but on
+     * the small radii the exact kernel is cheap enough and the difference
+     * in the shape of the blur is more noticeable
+     */
+    static const int fastBlurRadiusThreshold = 20;
+
     static Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>
         createHorizontalMatrix(qreal radius);
 
@@ -54,7 +67,8 @@ public:
                               const QBitArray &channelFlags,
                               KoUpdater *updater,
                               bool createTransaction = false,
-                              KisConvolutionBorderOp borderOp = BORDER_REPEAT);
+                              KisConvolutionBorderOp borderOp = BORDER_REPEAT,
+                              BlurMethod method = BLUR_EXACT);
 
     static Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> createLoGMatrix(qreal radius, qreal coeff, bool zeroCentered, bool includeWrappedArea);
 
@@ -37,6 +37,7 @@
 #include "kis_selection_mask.h"
 #include "kis_psd_layer_style.h"
 #include "kis_layer_properties_icons.h"
+#include "KisPartialProjectionsCache.h"
 
 
 struct Q_DECL_HIDDEN KisGroupLayer::Private
@@ -54,6 +55,7 @@ public:
     qint32 x;
     qint32 y;
     bool passThroughMode;
+    KisPartialProjectionsCache partialProjectionsCache;
 };
 
 KisGroupLayer::KisGroupLayer(KisImageWSP image, const QString &name, quint8 opacity) :
@@ -217,6 +219,13 @@ void KisGroupLayer::resetCache(const KoColorSpace *colorSpace)
 
         m_d->paintDevice->clear();
     }
+
+    m_d->partialProjectionsCache.reset();
+}
+
+KisPartialProjectionsCache* KisGroupLayer::partialProjectionsCache() const
+{
+    return &m_d->partialProjectionsCache;
 }
 
 KisLayer* KisGroupLayer::onlyMeaningfulChild() const
@@ -23,6 +23,7 @@
 #include "kis_types.h"
 
 class KoColorSpace;
+class KisPartialProjectionsCache;
 
 /**
  * A KisLayer that bundles child layers into a single layer.
@@ -107,6 +108,12 @@ public:
 
     bool projectionIsValid() const;
 
+    /**
+     * The cache of the partial projections of the children,
+     * used by KisAsyncMerger. \see KisPartialProjectionsCache
+     */
+    KisPartialProjectionsCache* partialProjectionsCache() const;
+
 protected:
     KisLayer* onlyMeaningfulChild() const;
     KisPaintDeviceSP tryObligeChild() const;
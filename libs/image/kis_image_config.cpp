@@ -33,6 +33,7 @@
 #include <QDir>
 
 #include "kis_global.h"
+#include "tiles3/swap/kis_compression_factory.h"
 #include <cmath>
 #include <QTemporaryFile>
 
@@ -115,6 +116,28 @@ void KisImageConfig::setUpdatePatchWidth(int value)
     m_config.writeEntry("updatePatchWidth", value);
 }
 
+bool KisImageConfig::adaptiveUpdatePatchSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("adaptiveUpdatePatchSize", false) : false;
+}
+
+void KisImageConfig::setAdaptiveUpdatePatchSize(bool value)
+{
+    m_config.writeEntry("adaptiveUpdatePatchSize", value);
+}
+
+qreal KisImageConfig::updatePatchTargetTime(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("updatePatchTargetTime", 10.0) : 10.0; // in ms
+}
+
+void KisImageConfig::setUpdatePatchTargetTime(qreal value)
+{
+    m_config.writeEntry("updatePatchTargetTime", value);
+}
+
 qreal KisImageConfig::maxCollectAlpha() const
 {
     return m_config.readEntry("maxCollectAlpha", 2.5);
@@ -143,6 +166,50 @@ void KisImageConfig::setSchedulerBalancingRatio(qreal value)
     m_config.writeEntry("schedulerBalancingRatio", value);
 }
 
+bool KisImageConfig::cacheProjectionBelowActiveLayer(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("cacheProjectionBelowActiveLayer", false) : false;
+}
+
+void KisImageConfig::setCacheProjectionBelowActiveLayer(bool value)
+{
+    m_config.writeEntry("cacheProjectionBelowActiveLayer", value);
+}
+
+bool KisImageConfig::cacheProjectionAboveActiveLayer(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("cacheProjectionAboveActiveLayer", false) : false;
+}
+
+void KisImageConfig::setCacheProjectionAboveActiveLayer(bool value)
+{
+    m_config.writeEntry("cacheProjectionAboveActiveLayer", value);
+}
+
+bool KisImageConfig::useProjectionMipmap(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useProjectionMipmap", true) : true;
+}
+
+void KisImageConfig::setUseProjectionMipmap(bool value)
+{
+    m_config.writeEntry("useProjectionMipmap", value);
+}
+
+bool KisImageConfig::numaAwareness(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("numaAwareness", true) : true;
+}
+
+void KisImageConfig::setNumaAwareness(bool value)
+{
+    m_config.writeEntry("numaAwareness", value);
+}
+
 int KisImageConfig::maxSwapSize(bool requestDefault) const
 {
     return !requestDefault ?
@@ -174,6 +241,67 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+bool KisImageConfig::useMappedSwapFile(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useMappedSwapFile", false) : false;
+}
+
+void KisImageConfig::setUseMappedSwapFile(bool value)
+{
+    m_config.writeEntry("useMappedSwapFile", value);
+}
+
+QString KisImageConfig::swapTileCompression(bool requestDefault) const
+{
+    const QString defaultValue = KisCompressionFactory::defaultSwapCompression();
+    const QString value = !requestDefault ?
+        m_config.readEntry("swapTileCompression", defaultValue) : defaultValue;
+
+    return KisCompressionFactory::isAvailable(value) ? value : defaultValue;
+}
+
+void KisImageConfig::setSwapTileCompression(const QString &value)
+{
+    m_config.writeEntry("swapTileCompression", value);
+}
+
+QString KisImageConfig::documentTileCompression(bool requestDefault) const
+{
+    const QString defaultValue = KisCompressionFactory::LZF;
+    const QString value = !requestDefault ?
+        m_config.readEntry("documentTileCompression", defaultValue) : defaultValue;
+
+    return KisCompressionFactory::isAvailable(value) ? value : defaultValue;
+}
+
+void KisImageConfig::setDocumentTileCompression(const QString &value)
+{
+    m_config.writeEntry("documentTileCompression", value);
+}
+
+int KisImageConfig::lazyTileLoadingThreshold(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("lazyTileLoadingThreshold", 256) : 256; // in MiB
+}
+
+void KisImageConfig::setLazyTileLoadingThreshold(int value)
+{
+    m_config.writeEntry("lazyTileLoadingThreshold", value);
+}
+
+bool KisImageConfig::layerStylesFastBlur(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("layerStylesFastBlur", false) : false;
+}
+
+void KisImageConfig::setLayerStylesFastBlur(bool value)
+{
+    m_config.writeEntry("layerStylesFastBlur", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -563,6 +691,16 @@ void KisImageConfig::setFpsLimit(int value)
     m_config.writeEntry("fpsLimit", value);
 }
 
+bool KisImageConfig::canvasFramePacing(bool defaultValue) const
+{
+    return defaultValue ? true : m_config.readEntry("canvasFramePacing", true);
+}
+
+void KisImageConfig::setCanvasFramePacing(bool value)
+{
+    m_config.writeEntry("canvasFramePacing", value);
+}
+
 bool KisImageConfig::useOnDiskAnimationCacheSwapping(bool defaultValue) const
 {
     return defaultValue ? true : m_config.readEntry("useOnDiskAnimationCacheSwapping", true);
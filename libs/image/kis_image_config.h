@@ -43,12 +43,55 @@ public:
     int updatePatchWidth() const;
     void setUpdatePatchWidth(int value);
 
+    /**
+     * If true, the update queue adjusts the patch size at runtime,
+     * so that a single patch is processed in about
+     * updatePatchTargetTime() milliseconds. The configured patch size
+     * is used until the queue gathers enough statistics.
+     *
+     * The split of the updates depends on the measured timings then,
+     * so it is not reproducible from run to run. Disabled by default.
+     */
+    bool adaptiveUpdatePatchSize(bool requestDefault = false) const;
+    void setAdaptiveUpdatePatchSize(bool value);
+    qreal updatePatchTargetTime(bool requestDefault = false) const;
+    void setUpdatePatchTargetTime(qreal value);
+
     qreal maxCollectAlpha() const;
     qreal maxMergeAlpha() const;
     qreal maxMergeCollectAlpha() const;
     qreal schedulerBalancingRatio() const;
     void setSchedulerBalancingRatio(qreal value);
 
+    /**
+     * Enables caching of the composition of the layers lying below
+     * and above the layer the user is painting on, see
+     * KisPartialProjectionsCache. Both the parts are disabled by
+     * default. The result of the above part may also differ from the
+     * uncached composition by rounding.
+     */
+    bool cacheProjectionBelowActiveLayer(bool requestDefault = false) const;
+    void setCacheProjectionBelowActiveLayer(bool value);
+    bool cacheProjectionAboveActiveLayer(bool requestDefault = false) const;
+    void setCacheProjectionAboveActiveLayer(bool value);
+
+    /**
+     * Enables the mipmap of the image projection, which is used by
+     * the overview docker to update its thumbnail incrementally,
+     * see KisPaintDeviceMipmap.
+     */
+    bool useProjectionMipmap(bool requestDefault = false) const;
+    void setUseProjectionMipmap(bool value);
+
+    /**
+     * Enables the NUMA-aware allocation of the tile data and scheduling
+     * of the update jobs on the systems with several NUMA nodes, see
+     * KisNumaTopology. The value is read once, so the change takes
+     * effect after restart.
+     */
+    bool numaAwareness(bool requestDefault = false) const;
+    void setNumaAwareness(bool value);
+
     int maxSwapSize(bool requestDefault = false) const;
     void setMaxSwapSize(int value);
 
@@ -58,6 +101,49 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    /**
+     * If true, the whole swap file is mapped into memory at once
+     * (see KisMappedSwapSpace), otherwise it is accessed through
+     * the windows of swapWindowSize() (see KisMemoryWindow)
+     */
+    bool useMappedSwapFile(bool requestDefault = false) const;
+    void setUseMappedSwapFile(bool value);
+
+    /**
+     * The codec used for compressing tiles in the swap file,
+     * see KisCompressionFactory for the list of ids
+     */
+    QString swapTileCompression(bool requestDefault = false) const;
+    void setSwapTileCompression(const QString &value);
+
+    /**
+     * The codec used for compressing tiles when saving .kra
+     * documents. Defaults to LZF, because the tiles saved with
+     * other codecs are written as version 3, and older versions of
+     * Krita crash with "Unknown version of the tiles" when they
+     * open such documents.
+     */
+    QString documentTileCompression(bool requestDefault = false) const;
+    void setDocumentTileCompression(const QString &value);
+
+    /**
+     * Paint devices whose uncompressed size exceeds this threshold
+     * are loaded lazily: their tiles are put into the swap in
+     * compressed form and decompressed only when they are accessed
+     * for the first time. Zero disables lazy loading.
+     */
+    int lazyTileLoadingThreshold(bool requestDefault = false) const; // MiB
+    void setLazyTileLoadingThreshold(int value);
+
+    /**
+     * Blur the masks of the layer styles (shadows, glows, satin) with
+     * the fast approximation of the Gaussian when the radius is big
+     * enough, see KisGaussianKernel::BLUR_AUTO. Disabled by default,
+     * because it slightly changes how the existing documents look.
+     */
+    bool layerStylesFastBlur(bool requestDefault = false) const;
+    void setLayerStylesFastBlur(bool value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
@@ -120,6 +206,14 @@ public:
     int fpsLimit(bool defaultValue = false) const;
     void setFpsLimit(int value);
 
+    /**
+     * If true, the canvas is updated not more often than the display
+     * refreshes, and the updates superseded during the refresh
+     * interval are dropped, see KisCanvasUpdatesCompressor
+     */
+    bool canvasFramePacing(bool defaultValue = false) const;
+    void setCanvasFramePacing(bool value);
+
     bool useOnDiskAnimationCacheSwapping(bool defaultValue = false) const;
     void setUseOnDiskAnimationCacheSwapping(bool value);
 
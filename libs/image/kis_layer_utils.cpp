@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include <QUuid>
+#include <QSet>
 #include <KoColorSpaceConstants.h>
 #include <KoProperties.h>
 
@@ -1666,6 +1667,27 @@ namespace KisLayerUtils {
         });
     }
 
+    void requestTilesPrefetch(KisNodeSP root, const QRect &rect)
+    {
+        if (!root) return;
+
+        QSet<KisPaintDevice*> devices;
+
+        auto requestPrefetch = [&devices, rect] (KisPaintDeviceSP device) {
+            if (device && !devices.contains(device.data())) {
+                devices.insert(device.data());
+                device->requestTilesPrefetch(rect);
+            }
+        };
+
+        KisLayerUtils::recursiveApplyNodes(root,
+        [requestPrefetch] (KisNodeSP node) {
+            requestPrefetch(node->paintDevice());
+            requestPrefetch(node->original());
+            requestPrefetch(node->projection());
+        });
+    }
+
     KisImageSP findImageByHierarchy(KisNodeSP node)
     {
         while (node) {
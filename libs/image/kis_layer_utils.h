@@ -59,6 +59,14 @@ namespace KisLayerUtils
 
     KRITAIMAGE_EXPORT void forceAllHiddenOriginalsUpdate(KisNodeSP root);
 
+    /**
+     * Requests background prefetching of the swapped-out tiles in \p rect
+     * for all the paint devices of \p root and its descendants
+     *
+     * \see KisPaintDevice::requestTilesPrefetch()
+     */
+    KRITAIMAGE_EXPORT void requestTilesPrefetch(KisNodeSP root, const QRect &rect);
+
     KRITAIMAGE_EXPORT KisNodeList sortAndFilterMergableInternalNodes(KisNodeList nodes, bool allowMasks = false);
 
     KRITAIMAGE_EXPORT void mergeDown(KisImageSP image, KisLayerSP layer, const KisMetaData::MergeStrategy* strategy);
@@ -157,6 +157,10 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
 
     stats.swapSize = tileStats.swapSize;
 
+    stats.prefetchedTiles = tileStats.prefetchedTiles;
+    stats.prefetchHits = tileStats.prefetchHits;
+    stats.swapInMisses = tileStats.swapInMisses;
+
     KisImageConfig cfg(true);
 
     stats.tilesHardLimit = cfg.tilesHardLimit() * MiB;
@@ -49,7 +49,11 @@ public:
               totalMemoryLimit(0),
               tilesHardLimit(0),
               tilesSoftLimit(0),
-              tilesPoolLimit(0)
+              tilesPoolLimit(0),
+
+              prefetchedTiles(0),
+              prefetchHits(0),
+              swapInMisses(0)
         {
         }
 
@@ -69,6 +73,15 @@ public:
         qint64 tilesHardLimit;
         qint64 tilesSoftLimit;
         qint64 tilesPoolLimit;
+
+        /**
+         * Efficiency of the swap prefetcher: the tiles loaded in
+         * advance, the ones of them accessed afterwards, and the
+         * tiles that had to be loaded from the swap synchronously
+         */
+        qint64 prefetchedTiles;
+        qint64 prefetchHits;
+        qint64 swapInMisses;
     };
 
 
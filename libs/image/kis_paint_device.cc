@@ -54,6 +54,7 @@
 #include "tiles3/kis_hline_iterator.h"
 #include "tiles3/kis_vline_iterator.h"
 #include "tiles3/kis_random_accessor.h"
+#include "tiles3/kis_tile_data_store.h"
 
 #include "kis_default_bounds.h"
 
@@ -62,6 +63,7 @@
 #include "kis_raster_keyframe_channel.h"
 
 #include "kis_paint_device_cache.h"
+#include "KisPaintDeviceMipmap.h"
 #include "kis_paint_device_data.h"
 #include "kis_paint_device_frames_interface.h"
 
@@ -109,10 +111,13 @@ public:
     QScopedPointer<KisPaintDeviceFramesInterface> framesInterface;
     bool isProjectionDevice;
 
+    QSharedPointer<KisPaintDeviceMipmap> mipmap;
+    mutable QMutex mipmapLock;
+
     KisPaintDeviceStrategy* currentStrategy();
 
     void init(const KoColorSpace *cs, const quint8 *defaultPixel);
-    void convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand);
+    void convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KisRunnableStrokeJobsInterface *jobsInterface);
     bool assignProfile(const KoColorProfile * profile, KUndo2Command *parentCommand);
 
     KUndo2Command* reincarnateWithDetachedHistory(bool copyContent);
@@ -982,7 +987,7 @@ public:
     }
 };
 
-void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand)
+void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KisRunnableStrokeJobsInterface *jobsInterface)
 {
     QList<Data*> dataObjects = allDataObjects();
     if (dataObjects.isEmpty()) return;
@@ -993,7 +998,7 @@ void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpa
     Q_FOREACH (Data *data, dataObjects) {
         if (!data) continue;
 
-        data->convertDataColorSpace(dstColorSpace, renderingIntent, conversionFlags, mainCommand);
+        data->convertDataColorSpace(dstColorSpace, renderingIntent, conversionFlags, mainCommand, jobsInterface);
     }
 
     q->emitColorSpaceChanged();
@@ -1181,6 +1186,35 @@ void KisPaintDevice::requestTimeSwitch(int time)
     }
 }
 
+void KisPaintDevice::setMipmapEnabled(bool value)
+{
+    QMutexLocker l(&m_d->mipmapLock);
+
+    if (value && !m_d->mipmap) {
+        m_d->mipmap.reset(new KisPaintDeviceMipmap(this));
+    } else if (!value) {
+        m_d->mipmap.reset();
+    }
+}
+
+bool KisPaintDevice::mipmapEnabled() const
+{
+    QMutexLocker l(&m_d->mipmapLock);
+    return !m_d->mipmap.isNull();
+}
+
+KisPaintDeviceSP KisPaintDevice::mipmapLevel(int level) const
+{
+    QSharedPointer<KisPaintDeviceMipmap> mipmap;
+
+    {
+        QMutexLocker l(&m_d->mipmapLock);
+        mipmap = m_d->mipmap;
+    }
+
+    return mipmap ? mipmap->level(level) : KisPaintDeviceSP();
+}
+
 int KisPaintDevice::sequenceNumber() const
 {
     return m_d->cache()->sequenceNumber();
@@ -1191,6 +1225,12 @@ void KisPaintDevice::estimateMemoryStats(qint64 &imageData, qint64 &temporaryDat
     m_d->estimateMemoryStats(imageData, temporaryData, lodData);
 }
 
+void KisPaintDevice::requestTilesPrefetch(const QRect &rect) const
+{
+    KisTileDataStore::instance()->requestPrefetch(m_d->dataManager().data(),
+                                                  rect.translated(-x(), -y()));
+}
+
 void KisPaintDevice::setParentNode(KisNodeWSP parent)
 {
     m_d->parent = parent;
@@ -1567,9 +1607,9 @@ void KisPaintDevice::emitProfileChanged()
     emit profileChanged(m_d->colorSpace()->profile());
 }
 
-void KisPaintDevice::convertTo(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand)
+void KisPaintDevice::convertTo(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KisRunnableStrokeJobsInterface *jobsInterface)
 {
-    m_d->convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand);
+    m_d->convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand, jobsInterface);
 }
 
 bool KisPaintDevice::setProfile(const KoColorProfile * profile, KUndo2Command *parentCommand)
@@ -1683,19 +1723,46 @@ inline bool moveBy(KisSequentialConstIterator& iter, int numPixels)
     return true;
 }
 
+static int thumbnailMipmapLevel(const KisPaintDevice* srcDev, qint32 srcWidth, qint32 srcHeight, qint32 w, qint32 h)
+{
+    if (!srcDev->mipmapEnabled()) return 0;
+
+    const int scale = qMin(srcWidth / w, srcHeight / h);
+
+    int level = 0;
+    while (level < KisPaintDeviceMipmap::maxLevel && (2 << level) <= scale) {
+        level++;
+    }
+
+    return level;
+}
+
 static KisPaintDeviceSP createThumbnailDeviceInternal(const KisPaintDevice* srcDev, qint32 srcX0, qint32 srcY0, qint32 srcWidth, qint32 srcHeight, qint32 w, qint32 h, QRect outputRect)
 {
     KisPaintDeviceSP thumbnail = new KisPaintDevice(srcDev->colorSpace());
     qint32 pixelSize = srcDev->pixelSize();
 
-    KisRandomConstAccessorSP srcIter = srcDev->createRandomConstAccessorNG();
+    /**
+     * Sample the mipmap level instead of the device itself. The pixels
+     * of the level are box-filtered, so the thumbnail also gets some
+     * antialiasing for free.
+     */
+    int mipLevel = thumbnailMipmapLevel(srcDev, srcWidth, srcHeight, w, h);
+    KisPaintDeviceSP mipDevice = mipLevel > 0 ? srcDev->mipmapLevel(mipLevel) : KisPaintDeviceSP();
+    if (!mipDevice) {
+        mipLevel = 0;
+    }
+
+    KisRandomConstAccessorSP srcIter = mipDevice ?
+        mipDevice->createRandomConstAccessorNG() :
+        srcDev->createRandomConstAccessorNG();
     KisRandomAccessorSP dstIter = thumbnail->createRandomAccessorNG();
 
     for (qint32 y = outputRect.y(); y < outputRect.y() + outputRect.height(); ++y) {
         qint32 iY = srcY0 + (y * srcHeight) / h;
         for (qint32 x = outputRect.x(); x < outputRect.x() + outputRect.width(); ++x) {
             qint32 iX = srcX0 + (x * srcWidth) / w;
-            srcIter->moveTo(iX, iY);
+            srcIter->moveTo(iX >> mipLevel, iY >> mipLevel);
             dstIter->moveTo(x,  y);
             memcpy(dstIter->rawData(), srcIter->rawDataConst(), pixelSize);
         }
@@ -52,6 +52,7 @@ class KisKeyframe;
 class KisRasterKeyframeChannel;
 
 class KisPaintDeviceFramesInterface;
+class KisRunnableStrokeJobsInterface;
 
 typedef KisSharedPtr<KisDataManager> KisDataManagerSP;
 
@@ -483,11 +484,18 @@ public:
 
     /**
      * Converts the paint device to a different colorspace
+     *
+     * If \p jobsInterface is passed, the pixel data is converted in
+     * parallel by the jobs added to this interface, otherwise the
+     * conversion happens synchronously in the calling thread. In the
+     * former case the data of the device is valid only after all the
+     * jobs have been completed.
      */
     void convertTo(const KoColorSpace * dstColorSpace,
                    KoColorConversionTransformation::Intent renderingIntent = KoColorConversionTransformation::internalRenderingIntent(),
                    KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags(),
-                   KUndo2Command *parentCommand = 0);
+                   KUndo2Command *parentCommand = 0,
+                   KisRunnableStrokeJobsInterface *jobsInterface = 0);
 
     /**
      * Changes the profile of the colorspace of this paint device to the given
@@ -590,6 +598,28 @@ public:
                            KoColorConversionTransformation::Intent renderingIntent = KoColorConversionTransformation::internalRenderingIntent(),
                            KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags());
 
+    /**
+     * Enables the chain of downscaled copies of the device, which is
+     * updated incrementally on request (see KisPaintDeviceMipmap). When
+     * the mipmap is enabled, the thumbnails downscaling the device more
+     * than twice are sampled from the level closest to their resolution,
+     * so only the changed tiles of the device are read.
+     *
+     * The mipmap costs about one third of the memory of the device, so
+     * it should be enabled only for the devices that are sampled often,
+     * like the image projection.
+     */
+    void setMipmapEnabled(bool value);
+    bool mipmapEnabled() const;
+
+    /**
+     * \return a copy of the device downscaled by 2^level with a box filter
+     * in the coordinate system of the level of detail planes, or null
+     * if the mipmap is disabled or the device is switched to a level of
+     * detail plane.
+     */
+    KisPaintDeviceSP mipmapLevel(int level) const;
+
     /**
      * Fill c and opacity with the values found at x and y.
      *
@@ -794,6 +824,13 @@ public:
 
     void estimateMemoryStats(qint64 &imageData, qint64 &temporaryData, qint64 &lodData) const;
 
+    /**
+     * Hints the tile engine that the pixels in \p rect will most
+     * probably be accessed soon, so the swapped-out tiles in this
+     * area are loaded in the background in advance
+     */
+    void requestTilesPrefetch(const QRect &rect) const;
+
 public:
 
     KisHLineIteratorSP createHLineIteratorNG(qint32 x, qint32 y, qint32 w);
@@ -19,9 +19,15 @@
 #ifndef __KIS_PAINT_DEVICE_DATA_H
 #define __KIS_PAINT_DEVICE_DATA_H
 
+#include <QThread>
+
 #include "KoAlwaysInline.h"
 #include "kundo2command.h"
 #include "kis_command_utils.h"
+#include "krita_utils.h"
+#include "KisRunnableStrokeJobUtils.h"
+#include "KisRunnableStrokeJobsInterface.h"
+#include "KisFakeRunnableStrokeJobsExecutor.h"
 
 
 struct DirectDataAccessPolicy {
@@ -164,10 +170,39 @@ public:
         }
     }
 
-    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand) {
+    /**
+     * The size of the patch used for parallel color space conversion,
+     * 4x4 tiles
+     */
+    static const int conversionPatchSize = 256;
+
+    static void convertPatch(const KoColorConversionTransformation *transform,
+                             KisDataManager *srcDataManager,
+                             KisDataManager *dstDataManager,
+                             KisIteratorCompleteListener *completionListener,
+                             const QRect &rc)
+    {
         typedef KisSequentialIteratorBase<ReadOnlyIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialConstIterator;
         typedef KisSequentialIteratorBase<WritableIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialIterator;
 
+        InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(srcDataManager, completionListener), rc);
+        InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager, completionListener), rc);
+
+        int nConseqPixels = srcIt.nConseqPixels();
+
+        // since we are accessing data managers directly, the columns are always aligned
+        KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
+
+        while(srcIt.nextPixels(nConseqPixels) &&
+              dstIt.nextPixels(nConseqPixels)) {
+
+            nConseqPixels = srcIt.nConseqPixels();
+
+            transform->transform(srcIt.rawDataConst(), dstIt.rawData(), nConseqPixels);
+        }
+    }
+
+    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KisRunnableStrokeJobsInterface *jobsInterface = 0) {
         if (m_colorSpace == dstColorSpace || *m_colorSpace == *dstColorSpace) {
             return;
         }
@@ -183,27 +218,57 @@ public:
 
 
         if (!rc.isEmpty()) {
-            InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(m_dataManager.data(), cacheInvalidator()), rc);
-            InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), cacheInvalidator()), rc);
+            /**
+             * The conversion is split into tile-aligned patches, which are
+             * distributed between the workers. Every worker creates its own
+             * color transformation, because LCMS transformations cannot be
+             * shared between threads.
+             *
+             * When no jobs interface is given, the jobs are executed right
+             * away in the current thread.
+             */
+            const bool isSynchronous = !jobsInterface;
+
+            QScopedPointer<KisRunnableStrokeJobsInterface> fakeJobsInterface;
+            if (isSynchronous) {
+                fakeJobsInterface.reset(new KisFakeRunnableStrokeJobsExecutor());
+                jobsInterface = fakeJobsInterface.data();
+            }
 
-            int nConseqPixels = srcIt.nConseqPixels();
+            const QVector<QRect> patches =
+                KritaUtils::splitRectIntoPatches(rc, QSize(conversionPatchSize, conversionPatchSize));
 
-            // since we are accessing data managers directly, the columns are always aligned
-            KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
+            const int numWorkers =
+                isSynchronous ? 1 : qBound(1, QThread::idealThreadCount(), patches.size());
 
-            while(srcIt.nextPixels(nConseqPixels) &&
-                  dstIt.nextPixels(nConseqPixels)) {
+            KisDataManagerSP srcDataManager = m_dataManager;
+            const KoColorSpace *srcColorSpace = m_colorSpace;
+            KisIteratorCompleteListener *completionListener = cacheInvalidator();
 
-                nConseqPixels = srcIt.nConseqPixels();
+            QVector<KisRunnableStrokeJobDataBase*> jobs;
 
-                const quint8 *srcData = srcIt.rawDataConst();
-                quint8 *dstData = dstIt.rawData();
+            for (int worker = 0; worker < numWorkers; worker++) {
+                QVector<QRect> workerPatches;
+                for (int i = worker; i < patches.size(); i += numWorkers) {
+                    workerPatches << patches[i];
+                }
 
-                m_colorSpace->convertPixelsTo(srcData, dstData,
-                                              dstColorSpace,
-                                              nConseqPixels,
-                                              renderingIntent, conversionFlags);
+                KritaUtils::addJobConcurrent(jobs,
+                    [srcDataManager, dstDataManager, srcColorSpace, dstColorSpace,
+                     renderingIntent, conversionFlags, completionListener, workerPatches] () {
+
+                        QScopedPointer<KoColorConversionTransformation> transform(
+                            srcColorSpace->createColorConverter(dstColorSpace, renderingIntent, conversionFlags));
+
+                        Q_FOREACH (const QRect &patchRect, workerPatches) {
+                            convertPatch(transform.data(),
+                                         srcDataManager.data(), dstDataManager.data(),
+                                         completionListener, patchRect);
+                        }
+                    });
             }
+
+            jobsInterface->addRunnableJobs(jobs);
         }
 
         // becomes owned by the parent
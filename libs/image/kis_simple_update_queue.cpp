@@ -20,8 +20,14 @@
 
 #include <QMutexLocker>
 #include <QVector>
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
 
 #include "kis_image_config.h"
+#include "kis_update_time_monitor.h"
 #include "kis_full_refresh_walker.h"
 #include "kis_spontaneous_job.h"
 
@@ -53,8 +59,41 @@
 #endif /* ENABLE_ACCUMULATOR */
 
 
+namespace {
+
+/**
+ * Parameters of the patch size adaptation
+ */
+const int minAdaptivePatchSize = 128;
+const int maxAdaptivePatchSize = 2048;
+
+/**
+ * The jobs smaller than this size are dominated by the
+ * constant overhead of the walkers and are not measured
+ */
+const int minMeasuredPixels = 64 * 64;
+
+const int minMergeTimeSamples = 8;
+const qreal mergeTimeSmoothing = 0.1;
+
+/**
+ * The patch size is changed only when the ideal size
+ * differs from the current one by more than 2^0.75 times
+ */
+const qreal patchSizeHysteresis = 0.75;
+
+}
+
+
 KisSimpleUpdateQueue::KisSimpleUpdateQueue()
-    : m_overrideLevelOfDetail(-1)
+    : m_patchWidth(0),
+      m_patchHeight(0),
+      m_adaptivePatchSize(false),
+      m_patchTargetTime(0.0),
+      m_configPatchWidth(0),
+      m_configPatchHeight(0),
+      m_threadsLimit(QThread::idealThreadCount()),
+      m_overrideLevelOfDetail(-1)
 {
     updateSettings();
 }
@@ -74,8 +113,31 @@ void KisSimpleUpdateQueue::updateSettings()
 
     KisImageConfig config(true);
 
-    m_patchWidth = config.updatePatchWidth();
-    m_patchHeight = config.updatePatchHeight();
+    const bool adaptivePatchSize = config.adaptiveUpdatePatchSize();
+    const qint32 configPatchWidth = config.updatePatchWidth();
+    const qint32 configPatchHeight = config.updatePatchHeight();
+
+    /**
+     * Keep the adapted size if only unrelated options have been changed
+     */
+    const bool keepAdaptedSize =
+        m_numMergeTimeSamples > 0 &&
+        adaptivePatchSize && m_adaptivePatchSize &&
+        configPatchWidth == m_configPatchWidth &&
+        configPatchHeight == m_configPatchHeight;
+
+    m_adaptivePatchSize = adaptivePatchSize;
+    m_patchTargetTime = config.updatePatchTargetTime();
+    m_configPatchWidth = configPatchWidth;
+    m_configPatchHeight = configPatchHeight;
+
+    if (!keepAdaptedSize) {
+        m_mergeTimePerPixel = 0.0;
+        m_numMergeTimeSamples = 0;
+        setPatchSizeLocked(QSize(m_configPatchWidth, m_configPatchHeight));
+    }
+
+    adaptPatchSizeLocked();
 
     m_maxCollectAlpha = config.maxCollectAlpha();
     m_maxMergeAlpha = config.maxMergeAlpha();
@@ -87,6 +149,110 @@ int KisSimpleUpdateQueue::overrideLevelOfDetail() const
     return m_overrideLevelOfDetail;
 }
 
+void KisSimpleUpdateQueue::reportMergeJobFinished(const QRect &rect, qint64 nsecs)
+{
+    const qint64 numPixels = qint64(rect.width()) * rect.height();
+    if (numPixels < minMeasuredPixels || nsecs <= 0) return;
+
+    const qreal timePerPixel = qreal(nsecs) / numPixels;
+
+    QMutexLocker locker(&m_lock);
+
+    if (!m_adaptivePatchSize) return;
+
+    m_mergeTimePerPixel =
+        m_numMergeTimeSamples ?
+        (1.0 - mergeTimeSmoothing) * m_mergeTimePerPixel + mergeTimeSmoothing * timePerPixel :
+        timePerPixel;
+
+    m_numMergeTimeSamples++;
+
+    adaptPatchSizeLocked();
+}
+
+void KisSimpleUpdateQueue::setThreadsLimit(int value)
+{
+    QMutexLocker locker(&m_lock);
+
+    m_threadsLimit = value;
+    adaptPatchSizeLocked();
+}
+
+QSize KisSimpleUpdateQueue::patchSize() const
+{
+    QMutexLocker locker(&m_lock);
+    return QSize(m_patchWidth, m_patchHeight);
+}
+
+qreal KisSimpleUpdateQueue::mergeTimePerPixel() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_numMergeTimeSamples >= minMergeTimeSamples ? m_mergeTimePerPixel : 0.0;
+}
+
+void KisSimpleUpdateQueue::setPatchSizeLocked(const QSize &size)
+{
+    if (size == QSize(m_patchWidth, m_patchHeight)) return;
+
+    m_patchWidth = size.width();
+    m_patchHeight = size.height();
+
+    m_updatesIndex.setCellSize(qMax(m_patchWidth, m_patchHeight));
+    KisUpdateTimeMonitor::instance()->reportPatchSizeChanged(size);
+}
+
+int KisSimpleUpdateQueue::maxPatchSizeForThreadsLocked() const
+{
+    if (m_threadsLimit <= 1 || m_imageSize.isEmpty()) {
+        return maxAdaptivePatchSize;
+    }
+
+    int size = maxAdaptivePatchSize;
+
+    while (size > minAdaptivePatchSize) {
+        const qint64 numCols = (m_imageSize.width() + size - 1) / size;
+        const qint64 numRows = (m_imageSize.height() + size - 1) / size;
+
+        if (numCols * numRows >= m_threadsLimit) break;
+
+        size /= 2;
+    }
+
+    return size;
+}
+
+void KisSimpleUpdateQueue::adaptPatchSizeLocked()
+{
+    if (!m_adaptivePatchSize) return;
+
+    const qreal currentSize = std::sqrt(qreal(m_patchWidth) * m_patchHeight);
+    const int maxSize = maxPatchSizeForThreadsLocked();
+
+    qreal idealSize = currentSize;
+
+    if (m_numMergeTimeSamples >= minMergeTimeSamples &&
+        m_mergeTimePerPixel > 0.0) {
+
+        const qreal targetTime = m_patchTargetTime * 1000000.0; // ms -> ns
+        idealSize = std::sqrt(targetTime / m_mergeTimePerPixel);
+    }
+
+    idealSize = qMin(idealSize, qreal(maxSize));
+
+    if (currentSize <= maxSize &&
+        std::abs(std::log2(idealSize / currentSize)) <= patchSizeHysteresis) {
+
+        return;
+    }
+
+    const int newSize =
+        qBound(minAdaptivePatchSize,
+               1 << qRound(std::log2(qMax(idealSize, 1.0))),
+               maxSize);
+
+    setPatchSizeLocked(QSize(newSize, newSize));
+}
+
 void KisSimpleUpdateQueue::processQueue(KisUpdaterContext &updaterContext)
 {
     updaterContext.lock();
@@ -122,6 +288,7 @@ bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
             updaterContext.isJobAllowed(item)) {
 
             updaterContext.addMergeJob(item);
+            removeFromIndex(item.data());
             iter.remove();
             jobAdded = true;
             break;
@@ -214,6 +381,9 @@ void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QVector<QRect> &rects,
     if (!walkers.isEmpty()) {
         m_lock.lock();
         m_updatesList.append(walkers);
+        Q_FOREACH (KisBaseRectsWalkerSP walker, walkers) {
+            addToIndex(walker.data());
+        }
         m_lock.unlock();
     }
 }
@@ -256,23 +426,38 @@ bool KisSimpleUpdateQueue::trySplitJob(KisNodeSP node, const QRect& rc,
                                        int levelOfDetail,
                                        KisBaseRectsWalker::UpdateType type)
 {
-    if(rc.width() <= m_patchWidth || rc.height() <= m_patchHeight)
+    /**
+     * The patch size may be changed by the worker threads,
+     * so fetch it under the lock
+     */
+    m_lock.lock();
+
+    if (cropRect.size() != m_imageSize && !cropRect.isEmpty()) {
+        m_imageSize = cropRect.size();
+        adaptPatchSizeLocked();
+    }
+
+    const qint32 patchWidth = m_patchWidth;
+    const qint32 patchHeight = m_patchHeight;
+    m_lock.unlock();
+
+    if(rc.width() <= patchWidth || rc.height() <= patchHeight)
         return false;
 
     // a bit of recursive splitting...
 
-    qint32 firstCol = rc.x() / m_patchWidth;
-    qint32 firstRow = rc.y() / m_patchHeight;
+    qint32 firstCol = rc.x() / patchWidth;
+    qint32 firstRow = rc.y() / patchHeight;
 
-    qint32 lastCol = (rc.x() + rc.width()) / m_patchWidth;
-    qint32 lastRow = (rc.y() + rc.height()) / m_patchHeight;
+    qint32 lastCol = (rc.x() + rc.width()) / patchWidth;
+    qint32 lastRow = (rc.y() + rc.height()) / patchHeight;
 
     QVector<QRect> splitRects;
 
     for(qint32 i = firstRow; i <= lastRow; i++) {
         for(qint32 j = firstCol; j <= lastCol; j++) {
-            QRect maxPatchRect(j * m_patchWidth, i * m_patchHeight,
-                               m_patchWidth, m_patchHeight);
+            QRect maxPatchRect(j * patchWidth, i * patchHeight,
+                               patchWidth, patchHeight);
             QRect patchRect = rc & maxPatchRect;
             splitRects.append(patchRect);
         }
@@ -294,18 +479,15 @@ bool KisSimpleUpdateQueue::tryMergeJob(KisNodeSP node, const QRect& rc,
     QRect baseRect = rc;
 
     KisBaseRectsWalkerSP goodCandidate;
-    KisBaseRectsWalkerSP item;
-    KisWalkersListIterator iter(m_updatesList);
+    const QVector<IndexedWalker> candidates = findMergeCandidates(rc);
 
     /**
      * We add new jobs to the tail of the list,
      * so it's more probable to find a good candidate here.
      */
 
-    iter.toBack();
-
-    while(iter.hasPrevious()) {
-        item = iter.previous();
+    for (auto it = candidates.crbegin(); it != candidates.crend(); ++it) {
+        KisBaseRectsWalker *item = it->walker;
 
         if(item->startNode() != node) continue;
         if(item->type() != type) continue;
@@ -340,28 +522,90 @@ void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
                                        QRect baseRect,
                                        const qreal maxAlpha)
 {
-    KisBaseRectsWalkerSP item;
-    KisMutableWalkersListIterator iter(m_updatesList);
+    QSet<KisBaseRectsWalker*> collectedWalkers;
 
-    while(iter.hasNext()) {
-        item = iter.next();
+    /**
+     * The base rect only grows while collecting, so all the walkers
+     * that can be joined are in the neighbourhood of the initial one
+     */
+    const QVector<IndexedWalker> candidates = findMergeCandidates(baseRect);
 
-        if(item == baseWalker) continue;
+    Q_FOREACH (const IndexedWalker &candidate, candidates) {
+        KisBaseRectsWalker *item = candidate.walker;
+
+        if(item == baseWalker.data()) continue;
         if(item->type() != baseWalker->type()) continue;
         if(item->startNode() != baseWalker->startNode()) continue;
         if(item->cropRect() != baseWalker->cropRect()) continue;
         if(item->levelOfDetail() != baseWalker->levelOfDetail()) continue;
 
         if(joinRects(baseRect, item->requestedRect(), maxAlpha)) {
-            iter.remove();
+            removeFromIndex(item);
+            collectedWalkers.insert(item);
+        }
+    }
+
+    if (!collectedWalkers.isEmpty()) {
+        KisMutableWalkersListIterator iter(m_updatesList);
+        while(iter.hasNext()) {
+            if (collectedWalkers.contains(iter.next().data())) {
+                iter.remove();
+            }
         }
     }
 
     if(baseWalker->requestedRect() != baseRect) {
+        IndexedWalker indexedBase = {baseWalker.data(), 0};
+        const bool baseIsIndexed =
+            m_updatesIndex.take(baseWalker->requestedRect(), indexedBase, &indexedBase);
+
         baseWalker->collectRects(baseWalker->startNode(), baseRect);
+
+        if (baseIsIndexed) {
+            m_updatesIndex.insert(baseWalker->requestedRect(), indexedBase);
+        }
     }
 }
 
+QVector<KisSimpleUpdateQueue::IndexedWalker>
+KisSimpleUpdateQueue::findMergeCandidates(const QRect &baseRect) const
+{
+    /**
+     * joinRects() never produces rects bigger than a patch, so the
+     * candidates should lie within one patch from the edges of the
+     * base rect
+     */
+    const QRect searchRect(QPoint(baseRect.right() - m_patchWidth + 1,
+                                  baseRect.bottom() - m_patchHeight + 1),
+                           QPoint(baseRect.left() + m_patchWidth - 1,
+                                  baseRect.top() + m_patchHeight - 1));
+
+    QVector<IndexedWalker> candidates;
+
+    m_updatesIndex.forEachIntersecting(searchRect,
+        [&candidates] (const QRect &, const IndexedWalker &walker) {
+            candidates.append(walker);
+            return true;
+        });
+
+    std::sort(candidates.begin(), candidates.end(),
+              [] (const IndexedWalker &lhs, const IndexedWalker &rhs) {
+                  return lhs.sequenceNumber < rhs.sequenceNumber;
+              });
+
+    return candidates;
+}
+
+void KisSimpleUpdateQueue::addToIndex(KisBaseRectsWalker *walker)
+{
+    m_updatesIndex.insert(walker->requestedRect(), {walker, m_nextSequenceNumber++});
+}
+
+void KisSimpleUpdateQueue::removeFromIndex(KisBaseRectsWalker *walker)
+{
+    m_updatesIndex.remove(walker->requestedRect(), {walker, 0});
+}
+
 bool KisSimpleUpdateQueue::joinRects(QRect& baseRect,
                                      const QRect& newRect, qreal maxAlpha)
 {
@@ -20,7 +20,9 @@
 #define __KIS_SIMPLE_UPDATE_QUEUE_H
 
 #include <QMutex>
+#include <QSize>
 #include "kis_updater_context.h"
+#include "KisRectsGridIndex.h"
 
 typedef QList<KisBaseRectsWalkerSP> KisWalkersList;
 typedef QListIterator<KisBaseRectsWalkerSP> KisWalkersListIterator;
@@ -56,6 +58,31 @@ public:
 
     int overrideLevelOfDetail() const;
 
+    /**
+     * Reports the time spent by a merge job on \p rect. The measurements
+     * are used for adapting the size of the update patches, when the
+     * adaptation is enabled in the configuration.
+     */
+    void reportMergeJobFinished(const QRect &rect, qint64 nsecs);
+
+    /**
+     * The number of threads the merge jobs are executed by. When the
+     * patch size is adapted, it is kept small enough for a full update
+     * of the image to be split into at least this number of patches.
+     */
+    void setThreadsLimit(int value);
+
+    /**
+     * The current size of the update patches
+     */
+    QSize patchSize() const;
+
+    /**
+     * The averaged time of merging of one pixel in nanoseconds,
+     * or zero if there were not enough measurements yet
+     */
+    qreal mergeTimePerPixel() const;
+
 protected:
     void addJob(KisNodeSP node, const QVector<QRect> &rects, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
 
@@ -68,12 +95,39 @@ protected:
                      const qreal maxAlpha);
     bool joinRects(QRect& baseRect, const QRect& newRect, qreal maxAlpha);
 
+    void setPatchSizeLocked(const QSize &size);
+    void adaptPatchSizeLocked();
+    int maxPatchSizeForThreadsLocked() const;
+
 protected:
 
     mutable QMutex m_lock;
     KisWalkersList m_updatesList;
     KisSpontaneousJobsList m_spontaneousJobsList;
 
+    /**
+     * Spatial index of the requested rects of the walkers in m_updatesList.
+     * The walkers are merged only when their united rect fits into one patch,
+     * so the index lets tryMergeJob() and collectJobs() check only the
+     * walkers in the neighbourhood of the rect instead of the whole list.
+     *
+     * The sequence number keeps the order of the walkers in the list.
+     */
+    struct IndexedWalker {
+        KisBaseRectsWalker *walker;
+        qint64 sequenceNumber;
+
+        bool operator==(const IndexedWalker &rhs) const {
+            return walker == rhs.walker;
+        }
+    };
+    KisRectsGridIndex<IndexedWalker> m_updatesIndex;
+    qint64 m_nextSequenceNumber = 0;
+
+    QVector<IndexedWalker> findMergeCandidates(const QRect &baseRect) const;
+    void addToIndex(KisBaseRectsWalker *walker);
+    void removeFromIndex(KisBaseRectsWalker *walker);
+
     /**
      * Parameters of optimization
      * (loaded from a configuration file)
@@ -87,6 +141,33 @@ protected:
     qint32 m_patchWidth;
     qint32 m_patchHeight;
 
+    /**
+     * If the adaptation is enabled, the patch size is chosen so that
+     * a merge job takes about m_patchTargetTime milliseconds. The time
+     * of merging of one pixel is measured on the finished merge jobs
+     * and is averaged with an exponential moving average.
+     *
+     * The size is always a power of two, so that the patches of different
+     * sizes are still aligned to each other. It is changed only when the
+     * ideal size is far enough from the current one, otherwise the
+     * patches would jitter between two neighbouring sizes.
+     */
+    bool m_adaptivePatchSize;
+    qreal m_patchTargetTime;
+    qint32 m_configPatchWidth;
+    qint32 m_configPatchHeight;
+
+    qreal m_mergeTimePerPixel = 0.0;
+    int m_numMergeTimeSamples = 0;
+
+    /**
+     * The adapted size is limited so that a full update of an image of
+     * m_imageSize is still split into at least m_threadsLimit patches.
+     * The image size is taken from the crop rect of the split jobs.
+     */
+    int m_threadsLimit;
+    QSize m_imageSize;
+
     /**
      * Maximum coefficient of work while regular optimization()
      */
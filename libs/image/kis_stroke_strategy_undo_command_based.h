@@ -50,7 +50,7 @@ public:
         }
 
     private:
-        KisRunnableStrokeJobsInterface *m_mutatedJobsInterface;
+        KisRunnableStrokeJobsInterface *m_mutatedJobsInterface = 0;
     };
 
 
@@ -22,6 +22,7 @@
 #include <atomic>
 
 #include <QRunnable>
+#include <QElapsedTimer>
 #include <QReadWriteLock>
 
 #include "kis_stroke_job.h"
@@ -61,8 +62,8 @@ public:
         if (!isRunning()) return;
 
         /**
-         * Here we break the idea of QThreadPool a bit. Ideally, we should split the
-         * jobs into distinct QRunnable objects and pass all of them to QThreadPool.
+         * Here we break the idea of a thread pool a bit. Ideally, we should split the
+         * jobs into distinct QRunnable objects and pass all of them to the pool.
          * That is a nice idea, but it doesn't work well when the jobs are small enough
          * and the number of available cores is high (>4 cores). It this case the
          * threads just tend to execute the job very quickly and go to sleep, which is
@@ -132,8 +133,13 @@ public:
 
 #endif
 
+        QElapsedTimer timer;
+        timer.start();
+
         m_merger.startMerge(*m_walker);
 
+        m_updaterContext->reportMergeJobFinished(m_walker->requestedRect(), timer.nsecsElapsed());
+
         QRect changeRect = m_walker->changeRect();
         m_updaterContext->continueUpdate(changeRect);
     }
@@ -29,10 +29,13 @@
 
 #include "kis_queues_progress_updater.h"
 #include "KisImageConfigNotifier.h"
+#include "KisPartialProjectionsCache.h"
 
 #include <QReadWriteLock>
 #include "kis_lazy_wait_condition.h"
 #include <mutex>
+#include <atomic>
+#include <QMutex>
 
 //#define DEBUG_BALANCING
 
@@ -64,6 +67,9 @@ struct Q_DECL_HIDDEN KisUpdateScheduler::Private {
     KisProjectionUpdateListener *projectionUpdateListener;
     KisQueuesProgressUpdater *progressUpdater = 0;
 
+    QMutex processQueuesLock;
+    std::atomic<bool> processQueuesRequested {false};
+
     QAtomicInt updatesLockCounter;
     QReadWriteLock updatesStartLock;
     KisLazyWaitCondition updatesFinishedCondition;
@@ -105,6 +111,7 @@ void KisUpdateScheduler::setThreadsLimit(int value)
     lock();
     m_d->updaterContext.lock();
     m_d->updaterContext.setThreadsLimit(value);
+    m_d->updatesQueue.setThreadsLimit(m_d->updaterContext.threadsLimit());
     m_d->updaterContext.unlock();
     unlock(false);
 }
@@ -306,6 +313,8 @@ void KisUpdateScheduler::updateSettings()
     m_d->updatesQueue.updateSettings();
     KisImageConfig config(true);
     m_d->defaultBalancingRatio = config.schedulerBalancingRatio();
+    KisPartialProjectionsCache::setCachingEnabled(config.cacheProjectionBelowActiveLayer(),
+                                                  config.cacheProjectionAboveActiveLayer());
     setThreadsLimit(config.maxNumberOfThreads());
 }
 
@@ -382,6 +391,31 @@ void KisUpdateScheduler::processQueues()
 
     if(m_d->processingBlocked) return;
 
+    m_d->processQueuesRequested = true;
+    m_d->processQueuesLock.lock();
+    processQueuesLocked();
+}
+
+void KisUpdateScheduler::processQueuesLocked()
+{
+    /**
+     * Only one thread distributes the jobs at a time. If some other
+     * thread asks for processing meanwhile, we make one more pass
+     * for it after releasing the lock.
+     */
+    do {
+        m_d->processQueuesRequested = false;
+
+        if (!m_d->processingBlocked) {
+            processQueuesImpl();
+        }
+
+        m_d->processQueuesLock.unlock();
+    } while (m_d->processQueuesRequested && m_d->processQueuesLock.tryLock());
+}
+
+void KisUpdateScheduler::processQueuesImpl()
+{
     if(m_d->strokesQueue.needsExclusiveAccess()) {
         DEBUG_BALANCING_METRICS("STROKES", "X");
         m_d->strokesQueue.processQueue(m_d->updaterContext,
@@ -457,6 +491,11 @@ void KisUpdateScheduler::continueUpdate(const QRect &rect)
     m_d->projectionUpdateListener->notifyProjectionUpdated(rect);
 }
 
+void KisUpdateScheduler::reportMergeJobFinished(const QRect &rect, qint64 nsecs)
+{
+    m_d->updatesQueue.reportMergeJobFinished(rect, nsecs);
+}
+
 void KisUpdateScheduler::doSomeUsefulWork()
 {
     m_d->updatesQueue.optimize();
@@ -464,7 +503,21 @@ void KisUpdateScheduler::doSomeUsefulWork()
 
 void KisUpdateScheduler::spareThreadAppeared()
 {
-    processQueues();
+    wakeUpWaitingThreads();
+
+    if(m_d->processingBlocked) return;
+
+    /**
+     * The job has just finished in a worker thread. If another thread
+     * is already distributing the jobs, don't wait for the context lock,
+     * just ask that thread to make one more pass and let the worker go.
+     * The slot of the worker is already free, so it will be reused by
+     * that pass either way.
+     */
+    m_d->processQueuesRequested = true;
+    if (!m_d->processQueuesLock.tryLock()) return;
+
+    processQueuesLocked();
 }
 
 KisTestableUpdateScheduler::KisTestableUpdateScheduler(KisProjectionUpdateListener *projectionUpdateListener,
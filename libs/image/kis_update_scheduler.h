@@ -202,6 +202,7 @@ public:
     int currentLevelOfDetail() const;
 
     void continueUpdate(const QRect &rect);
+    void reportMergeJobFinished(const QRect &rect, qint64 nsecs);
     void doSomeUsefulWork();
     void spareThreadAppeared();
 
@@ -222,6 +223,8 @@ private:
     bool haveUpdatesRunning();
     void tryProcessUpdatesQueue();
     void wakeUpWaitingThreads();
+    void processQueuesLocked();
+    void processQueuesImpl();
 
     void progressUpdate();
 
@@ -33,6 +33,8 @@
 
 #include <QFileInfo>
 
+#include <atomic>
+
 #include "kis_debug.h"
 #include "kis_global.h"
 #include "kis_image_config.h"
@@ -105,6 +107,17 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
     KisPaintOpPresetSP preset;
 
     bool loggingEnabled;
+
+    /**
+     * The merge jobs of all the images report their timings here,
+     * so the counters are updated without taking a lock
+     */
+    std::atomic<qint64> numMergeJobs {0};
+    std::atomic<qint64> numMergePixels {0};
+    std::atomic<qint64> totalMergeTime {0};
+
+    QSize patchSize;
+    mutable QMutex patchSizeMutex;
 };
 
 KisUpdateTimeMonitor::KisUpdateTimeMonitor()
@@ -199,11 +212,16 @@ void KisUpdateTimeMonitor::printValues()
     logFile.open(QIODevice::Append);
     QTextStream stream(&logFile);
 
+    const MergeJobsStatistics mergeStats = mergeJobsStatistics();
+
     stream << i18n("Stroke Time:") << strokeTime << "\t"
            << i18n("Mouse Speed:") << QString::number( mouseSpeed, 'f', 3 ) << "\t"
            << i18n("Jobs/Update:") << QString::number( jobsPerUpdate, 'f', 3 ) << "\t"
            << i18n("Non Update Time:") << QString::number( nonUpdateTime, 'f', 3 ) << "\t"
-           << i18n("Response Time:") << responseTime << endl; // 'endl' will use the correct OS line ending
+           << i18n("Response Time:") << responseTime << "\t"
+           << i18n("Merge Time/Job:") << QString::number( mergeStats.averageJobTime(), 'f', 3 ) << "\t"
+           << i18n("Patch Size:") << mergeStats.patchSize.width() << "x" << mergeStats.patchSize.height()
+           << endl; // 'endl' will use the correct OS line ending
     logFile.close();
 }
 
@@ -256,3 +274,36 @@ void KisUpdateTimeMonitor::reportUpdateFinished(const QRect &rect)
     }
     m_d->numUpdates++;
 }
+
+void KisUpdateTimeMonitor::reportMergeJobFinished(const QRect &rect, qint64 nsecs)
+{
+    m_d->numMergeJobs.fetch_add(1, std::memory_order_relaxed);
+    m_d->numMergePixels.fetch_add(qint64(rect.width()) * rect.height(), std::memory_order_relaxed);
+    m_d->totalMergeTime.fetch_add(nsecs, std::memory_order_relaxed);
+}
+
+void KisUpdateTimeMonitor::reportPatchSizeChanged(const QSize &size)
+{
+    QMutexLocker locker(&m_d->patchSizeMutex);
+    m_d->patchSize = size;
+}
+
+KisUpdateTimeMonitor::MergeJobsStatistics KisUpdateTimeMonitor::mergeJobsStatistics() const
+{
+    MergeJobsStatistics stats;
+    stats.numJobs = m_d->numMergeJobs.load(std::memory_order_relaxed);
+    stats.numPixels = m_d->numMergePixels.load(std::memory_order_relaxed);
+    stats.totalTime = m_d->totalMergeTime.load(std::memory_order_relaxed);
+
+    QMutexLocker locker(&m_d->patchSizeMutex);
+    stats.patchSize = m_d->patchSize;
+
+    return stats;
+}
+
+void KisUpdateTimeMonitor::resetMergeJobsStatistics()
+{
+    m_d->numMergeJobs.store(0, std::memory_order_relaxed);
+    m_d->numMergePixels.store(0, std::memory_order_relaxed);
+    m_d->totalMergeTime.store(0, std::memory_order_relaxed);
+}
@@ -24,12 +24,38 @@
 
 
 #include <QVector>
+#include <QSize>
 class QPointF;
 class QRect;
 
 
 class KRITAIMAGE_EXPORT KisUpdateTimeMonitor
 {
+public:
+    /**
+     * Timings of the merge jobs of all the images. Unlike the stroke
+     * measurements, they are collected even when the performance log
+     * is disabled.
+     */
+    struct MergeJobsStatistics {
+        qint64 numJobs = 0;
+        qint64 numPixels = 0;
+        qint64 totalTime = 0; // in nanoseconds
+
+        /**
+         * The patch size most recently chosen by the update queue
+         */
+        QSize patchSize;
+
+        qreal nsecsPerPixel() const {
+            return numPixels ? qreal(totalTime) / numPixels : 0.0;
+        }
+
+        qreal averageJobTime() const {
+            return numJobs ? qreal(totalTime) / numJobs / 1000000.0 : 0.0; // in ms
+        }
+    };
+
 public:
     KisUpdateTimeMonitor();
     ~KisUpdateTimeMonitor();
@@ -46,6 +72,11 @@ public:
     void reportJobFinished(void *key, const QVector<QRect> &rects);
     void reportUpdateFinished(const QRect &rect);
 
+    void reportMergeJobFinished(const QRect &rect, qint64 nsecs);
+    void reportPatchSizeChanged(const QSize &size);
+    MergeJobsStatistics mergeJobsStatistics() const;
+    void resetMergeJobsStatistics();
+
 
 private:
     struct Private;
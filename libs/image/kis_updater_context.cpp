@@ -19,10 +19,13 @@
 #include "kis_updater_context.h"
 
 #include <QThread>
-#include <QThreadPool>
 
 #include "kis_update_job_item.h"
 #include "kis_stroke_job.h"
+#include "kis_update_time_monitor.h"
+#include "kis_node.h"
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
 
 const int KisUpdaterContext::useIdealThreadCountTag = -1;
 
@@ -117,16 +120,17 @@ bool KisUpdaterContext::isJobAllowed(KisBaseRectsWalkerSP walker)
     int lod = this->currentLevelOfDetail();
     if (lod >= 0 && walker->levelOfDetail() != lod) return false;
 
-    bool intersects = false;
-
-    Q_FOREACH (const KisUpdateJobItem *item, m_jobs) {
-        if(item->isRunning() && walkerIntersectsJob(walker, item)) {
-            intersects = true;
-            break;
-        }
-    }
-
-    return !intersects;
+    /**
+     * The running jobs are looked up in the spatial index, so the check
+     * doesn't depend on the number of threads. The index may still keep
+     * the rects of the finished jobs, they are filtered out here.
+     */
+    auto isFinishedJob = [this] (const QRect &, int jobIndex) {
+        return !m_jobs[jobIndex]->isRunning();
+    };
+
+    return m_changeRectsIndex.forEachIntersecting(walker->accessRect(), isFinishedJob) &&
+        m_accessRectsIndex.forEachIntersecting(walker->changeRect(), isFinishedJob);
 }
 
 /**
@@ -143,12 +147,14 @@ void KisUpdaterContext::addMergeJob(KisBaseRectsWalkerSP walker)
     qint32 jobIndex = findSpareThread();
     Q_ASSERT(jobIndex >= 0);
 
+    updateJobRectsIndex(jobIndex, walker->accessRect(), walker->changeRect());
+    const int preferredNode = preferredNumaNode(walker);
     const bool shouldStartThread = m_jobs[jobIndex]->setWalker(walker);
 
     // it might happen that we call this function from within
     // the thread itself, right when it finished its work
     if (shouldStartThread && !m_testingMode) {
-        m_threadPool.start(m_jobs[jobIndex]);
+        m_threadPool.start(m_jobs[jobIndex], preferredNode);
     }
 }
 
@@ -158,6 +164,7 @@ void KisUpdaterContext::addStrokeJob(KisStrokeJob *strokeJob)
     qint32 jobIndex = findSpareThread();
     Q_ASSERT(jobIndex >= 0);
 
+    updateJobRectsIndex(jobIndex, QRect(), QRect());
     const bool shouldStartThread = m_jobs[jobIndex]->setStrokeJob(strokeJob);
 
     // it might happen that we call this function from within
@@ -173,6 +180,7 @@ void KisUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneousJob)
     qint32 jobIndex = findSpareThread();
     Q_ASSERT(jobIndex >= 0);
 
+    updateJobRectsIndex(jobIndex, QRect(), QRect());
     const bool shouldStartThread = m_jobs[jobIndex]->setSpontaneousJob(spontaneousJob);
 
     // it might happen that we call this function from within
@@ -182,6 +190,28 @@ void KisUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneousJob)
     }
 }
 
+int KisUpdaterContext::preferredNumaNode(KisBaseRectsWalkerSP walker) const
+{
+    if (!m_threadPool.numaTopology()) return -1;
+
+    /**
+     * All the merge jobs end up writing into the projection of the
+     * image, and the tile data of the projection is placed on the node
+     * of the thread that wrote it first, so running the jobs on the
+     * node owning the rect keeps the rect on the same node.
+     */
+    KisNodeSP root = walker->startNode();
+    while (root && root->parent()) {
+        root = root->parent();
+    }
+
+    KisPaintDeviceSP projection = root ? root->projection() : 0;
+    if (!projection) return -1;
+
+    const QRect rect = walker->changeRect().translated(-projection->x(), -projection->y());
+    return projection->dataManager()->dominantNumaNode(rect);
+}
+
 void KisUpdaterContext::waitForDone()
 {
     m_threadPool.waitForDone();
@@ -194,6 +224,20 @@ bool KisUpdaterContext::walkerIntersectsJob(KisBaseRectsWalkerSP walker,
         (job->accessRect().intersects(walker->changeRect()));
 }
 
+void KisUpdaterContext::updateJobRectsIndex(qint32 jobIndex, const QRect &accessRect, const QRect &changeRect)
+{
+    IndexedJobRects &rects = m_indexedJobRects[jobIndex];
+
+    m_accessRectsIndex.remove(rects.accessRect, jobIndex);
+    m_changeRectsIndex.remove(rects.changeRect, jobIndex);
+
+    rects.accessRect = accessRect;
+    rects.changeRect = changeRect;
+
+    m_accessRectsIndex.insert(rects.accessRect, jobIndex);
+    m_changeRectsIndex.insert(rects.changeRect, jobIndex);
+}
+
 qint32 KisUpdaterContext::findSpareThread()
 {
     for(qint32 i=0; i < m_jobs.size(); i++)
@@ -228,6 +272,10 @@ void KisUpdaterContext::setThreadsLimit(int value)
 
     m_jobs.resize(value);
 
+    m_accessRectsIndex.clear();
+    m_changeRectsIndex.clear();
+    m_indexedJobRects.fill(IndexedJobRects(), value);
+
     for(qint32 i = 0; i < m_jobs.size(); i++) {
         m_jobs[i] = new KisUpdateJobItem(this);
     }
@@ -244,6 +292,12 @@ void KisUpdaterContext::continueUpdate(const QRect& rc)
     if (m_scheduler) m_scheduler->continueUpdate(rc);
 }
 
+void KisUpdaterContext::reportMergeJobFinished(const QRect &rc, qint64 nsecs)
+{
+    KisUpdateTimeMonitor::instance()->reportMergeJobFinished(rc, nsecs);
+    if (m_scheduler) m_scheduler->reportMergeJobFinished(rc, nsecs);
+}
+
 void KisUpdaterContext::doSomeUsefulWork()
 {
     if (m_scheduler) m_scheduler->doSomeUsefulWork();
@@ -271,6 +325,10 @@ void KisUpdaterContext::clear()
         item->testingSetDone();
     }
 
+    m_accessRectsIndex.clear();
+    m_changeRectsIndex.clear();
+    m_indexedJobRects.fill(IndexedJobRects());
+
     m_lodCounter.testingClear();
 }
 
@@ -21,11 +21,12 @@
 
 #include <QMutex>
 #include <QReadWriteLock>
-#include <QThreadPool>
 
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
 #include "kis_lock_free_lod_counter.h"
+#include "KisWorkStealingThreadPool.h"
+#include "KisRectsGridIndex.h"
 
 #include "KisUpdaterContextSnapshotEx.h"
 #include "kis_update_scheduler.h"
@@ -139,6 +140,7 @@ public:
     int threadsLimit() const;
 
     void continueUpdate(const QRect& rc);
+    void reportMergeJobFinished(const QRect &rc, qint64 nsecs);
     void doSomeUsefulWork();
     void jobFinished();
 
@@ -148,6 +150,13 @@ protected:
     static bool walkerIntersectsJob(KisBaseRectsWalkerSP walker,
                                     const KisUpdateJobItem* job);
     qint32 findSpareThread();
+    void updateJobRectsIndex(qint32 jobIndex, const QRect &accessRect, const QRect &changeRect);
+
+    /**
+     * Returns the NUMA node owning most of the image projection in
+     * the change rect of \p walker, or -1 if the pool is not NUMA-aware
+     */
+    int preferredNumaNode(KisBaseRectsWalkerSP walker) const;
 
 protected:
     /**
@@ -160,7 +169,22 @@ protected:
 
     QMutex m_lock;
     QVector<KisUpdateJobItem*> m_jobs;
-    QThreadPool m_threadPool;
+    KisWorkStealingThreadPool m_threadPool;
+
+    /**
+     * Spatial index of the rects of the running merge jobs, the values
+     * are the indexes of the jobs in m_jobs. The rects of a job are
+     * replaced only when the job slot is reused, so the index may
+     * contain the rects of the finished jobs as well.
+     */
+    struct IndexedJobRects {
+        QRect accessRect;
+        QRect changeRect;
+    };
+    KisRectsGridIndex<int> m_accessRectsIndex;
+    KisRectsGridIndex<int> m_changeRectsIndex;
+    QVector<IndexedJobRects> m_indexedJobRects;
+
     KisLockFreeLodCounter m_lodCounter;
     KisUpdateScheduler *m_scheduler;
     bool m_testingMode = false;
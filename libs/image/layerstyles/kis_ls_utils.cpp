@@ -41,6 +41,7 @@
 #include "kis_multiple_projection.h"
 #include "kis_default_bounds_base.h"
 #include "kis_cached_paint_device.h"
+#include "kis_image_config.h"
 
 namespace KisLsUtils
 {
@@ -114,10 +115,21 @@ namespace KisLsUtils
                                       const QRect &applyRect,
                                       qreal radius)
     {
+        /**
+         * Shadows and glows are usually blurred with huge radii, and
+         * the tiny deviation of the approximation from the real Gaussian
+         * is invisible on such a soft mask. Still, it changes the pixels
+         * of the existing documents, so the user should opt in.
+         */
+        const KisGaussianKernel::BlurMethod method =
+            KisImageConfig(true).layerStylesFastBlur() ?
+                KisGaussianKernel::BLUR_AUTO : KisGaussianKernel::BLUR_EXACT;
+
         KisGaussianKernel::applyGaussian(selection, applyRect,
                                          radius, radius,
                                          QBitArray(), 0, true,
-                                         BORDER_IGNORE);
+                                         BORDER_IGNORE,
+                                         method);
     }
 
     namespace Private {
@@ -32,6 +32,7 @@
 #include "kis_time_range.h"
 #include <commands_new/KisChangeChannelFlagsCommand.h>
 #include <commands_new/KisChangeChannelLockFlagsCommand.h>
+#include "kis_stroke_strategy_undo_command_based.h"
 
 
 KisConvertColorSpaceProcessingVisitor::KisConvertColorSpaceProcessingVisitor(const KoColorSpace *dstColorSpace,
@@ -44,6 +45,35 @@ KisConvertColorSpaceProcessingVisitor::KisConvertColorSpaceProcessingVisitor(con
 {
 }
 
+struct KisConvertColorSpaceProcessingVisitor::InitCommand
+    : public KUndo2Command,
+      public KisStrokeStrategyUndoCommandBased::MutatedCommandInterface
+{
+    InitCommand(KisConvertColorSpaceProcessingVisitor *visitor)
+        : m_visitor(visitor)
+    {
+    }
+
+    void redo() override {
+        // the interface is needed only for the first run of the visitor
+        if (m_visitor) {
+            m_visitor->m_jobsInterface = runnableJobsInterface();
+            m_visitor = 0;
+        }
+    }
+
+    void undo() override {
+    }
+
+private:
+    KisConvertColorSpaceProcessingVisitor *m_visitor;
+};
+
+KUndo2Command *KisConvertColorSpaceProcessingVisitor::createInitCommand()
+{
+    return new InitCommand(this);
+}
+
 void KisConvertColorSpaceProcessingVisitor::visitExternalLayer(KisExternalLayer *layer, KisUndoAdapter *undoAdapter)
 {
     undoAdapter->addCommand(layer->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags));
@@ -74,15 +104,15 @@ void KisConvertColorSpaceProcessingVisitor::visitNodeWithPaintDevice(KisNode *no
 
 
     if (layer->original()) {
-        layer->original()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+        layer->original()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand, m_jobsInterface);
     }
 
     if (layer->paintDevice()) {
-        layer->paintDevice()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+        layer->paintDevice()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand, m_jobsInterface);
     }
 
     if (layer->projection()) {
-        layer->projection()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+        layer->projection()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand, m_jobsInterface);
     }
 
     if (layer && alphaDisabled) {
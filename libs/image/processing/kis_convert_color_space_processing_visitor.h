@@ -25,6 +25,7 @@
 #include <KoColorConversionTransformation.h>
 
 class KoColorSpace;
+class KisRunnableStrokeJobsInterface;
 
 class KRITAIMAGE_EXPORT  KisConvertColorSpaceProcessingVisitor : public KisSimpleProcessingVisitor
 {
@@ -33,6 +34,14 @@ public:
                                           KoColorConversionTransformation::Intent renderingIntent,
                                           KoColorConversionTransformation::ConversionFlags conversionFlags);
 
+    /**
+     * The init command fetches the runnable jobs interface of the stroke,
+     * so that the pixel data of every layer could be converted in parallel.
+     * When the visitor is used without the init command, the conversion
+     * happens synchronously.
+     */
+    KUndo2Command* createInitCommand() override;
+
 private:
     void visitNodeWithPaintDevice(KisNode *node, KisUndoAdapter *undoAdapter) override;
     void visitExternalLayer(KisExternalLayer *layer, KisUndoAdapter *undoAdapter) override;
@@ -47,6 +56,9 @@ private:
     const KoColorSpace *m_dstColorSpace;
     KoColorConversionTransformation::Intent m_renderingIntent;
     KoColorConversionTransformation::ConversionFlags m_conversionFlags;
+    KisRunnableStrokeJobsInterface *m_jobsInterface = 0;
+
+    struct InitCommand;
 };
 
 #endif /* __KIS_CONVERT_COLORSPACE_PROCESSING_VISITOR_H */
@@ -0,0 +1,109 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisNumaTopologyTest.h"
+
+#include <QTest>
+#include <QThread>
+
+#include "KisNumaTopology.h"
+
+Q_DECLARE_METATYPE(QVector<int>)
+
+void KisNumaTopologyTest::testParseCpuList_data()
+{
+    QTest::addColumn<QString>("list");
+    QTest::addColumn<QVector<int>>("cpus");
+
+    QTest::newRow("single") << "3" << QVector<int>({3});
+    QTest::newRow("range") << "0-3\n" << QVector<int>({0, 1, 2, 3});
+    QTest::newRow("mixed") << "0-1,4,6-7" << QVector<int>({0, 1, 4, 6, 7});
+    QTest::newRow("empty") << "\n" << QVector<int>();
+    QTest::newRow("broken") << "0-a" << QVector<int>();
+    QTest::newRow("reversed") << "3-1" << QVector<int>();
+}
+
+void KisNumaTopologyTest::testParseCpuList()
+{
+    QFETCH(QString, list);
+    QFETCH(QVector<int>, cpus);
+
+    QCOMPARE(KisNumaTopology::parseCpuList(list), cpus);
+}
+
+void KisNumaTopologyTest::testSystemTopology()
+{
+    KisNumaTopology *topology = KisNumaTopology::instance();
+
+    QVERIFY(topology->numNodes() >= 1);
+
+    const int node = topology->currentNode();
+    QVERIFY(node >= 0 && node < topology->numNodes());
+
+    for (int i = 0; i < topology->numNodes(); i++) {
+        QVERIFY(!topology->nodeCpus(i).isEmpty());
+    }
+
+    const size_t size = 1 << 20;
+    quint8 *ptr = static_cast<quint8*>(topology->allocateOnNode(size, node));
+    QVERIFY(ptr);
+
+    memset(ptr, 0x80, size);
+    QCOMPARE(ptr[size - 1], quint8(0x80));
+
+    topology->freeOnNode(ptr, size);
+}
+
+void KisNumaTopologyTest::testSimulatedTopology()
+{
+    const int numCpus = QThread::idealThreadCount();
+    if (numCpus < 2) {
+        QSKIP("At least two CPUs are needed for simulating two nodes");
+    }
+
+    QVector<QVector<int>> nodeCpus(2);
+    for (int cpu = 0; cpu < numCpus; cpu++) {
+        nodeCpus[cpu % 2].append(cpu);
+    }
+
+    KisNumaTopology topology(nodeCpus);
+    QCOMPARE(topology.numNodes(), 2);
+    QVERIFY(topology.isNumaAware());
+    QCOMPARE(topology.nodeCpus(1), nodeCpus[1]);
+
+#ifdef Q_OS_LINUX
+    struct BindingThread : public QThread {
+        BindingThread(KisNumaTopology *_topology) : topology(_topology) {}
+
+        void run() override {
+            if (!topology->bindCurrentThreadToNode(1)) return;
+            bound = true;
+
+            for (int i = 0; i < 100; i++) {
+                if (topology->currentNode() != 1) {
+                    stayedOnNode = false;
+                }
+                QThread::yieldCurrentThread();
+            }
+        }
+
+        KisNumaTopology *topology;
+        bool bound = false;
+        bool stayedOnNode = true;
+    };
+
+    BindingThread thread(&topology);
+    thread.start();
+    thread.wait();
+
+    // the CPUs may be restricted by the environment
+    if (thread.bound) {
+        QVERIFY(thread.stayedOnNode);
+    }
+#endif
+}
+
+QTEST_MAIN(KisNumaTopologyTest)
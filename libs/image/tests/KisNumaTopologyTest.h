@@ -0,0 +1,22 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISNUMATOPOLOGYTEST_H
+#define KISNUMATOPOLOGYTEST_H
+
+#include <QtTest>
+
+class KisNumaTopologyTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testParseCpuList_data();
+    void testParseCpuList();
+    void testSystemTopology();
+    void testSimulatedTopology();
+};
+
+#endif // KISNUMATOPOLOGYTEST_H
@@ -0,0 +1,231 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisPartialProjectionsCacheTest.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_group_layer.h"
+#include "kis_paint_device.h"
+#include "kis_merge_walker.h"
+#include "kis_full_refresh_walker.h"
+#include "kis_async_merger.h"
+#include "KisPartialProjectionsCache.h"
+
+#include "../../sdk/tests/testutil.h"
+
+namespace {
+
+    /*
+      +----------------+
+      |root            |
+      | group          |
+      |  layer 5       |
+      |  ...           |
+      |  layer 0       |
+      | background     |
+      +----------------+
+     */
+
+struct TestImage
+{
+    TestImage() {
+        cs = KoColorSpaceRegistry::instance()->rgb8();
+        image = new KisImage(0, 256, 256, cs, "partial projections test");
+
+        KisPaintLayerSP background = new KisPaintLayer(image, "background", OPACITY_OPAQUE_U8);
+        background->paintDevice()->fill(image->bounds(), KoColor(Qt::white, cs));
+        image->addNode(background, image->root());
+
+        group = new KisGroupLayer(image, "group", OPACITY_OPAQUE_U8);
+        image->addNode(group, image->root());
+
+        for (int i = 0; i < 6; i++) {
+            KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), 105 + 30 * i);
+            layer->paintDevice()->fill(QRect(20 * i, 10 * i, 150, 150),
+                                       KoColor(QColor(40 * i, 255 - 40 * i, 128, 180), cs));
+            image->addNode(layer, group);
+            layers << layer;
+        }
+
+        refreshAll();
+    }
+
+    void refreshAll() {
+        KisFullRefreshWalker walker(image->bounds());
+        walker.collectRects(image->root(), image->bounds());
+        KisAsyncMerger merger;
+        merger.startMerge(walker);
+    }
+
+    void paintDab(int layerIndex, const QRect &rc, const QColor &color) {
+        layers[layerIndex]->paintDevice()->fill(rc, KoColor(color, cs));
+        update(layerIndex, rc);
+    }
+
+    void update(int layerIndex, const QRect &rc) {
+        KisMergeWalker walker(image->bounds());
+        walker.collectRects(layers[layerIndex], rc);
+        KisAsyncMerger merger;
+        merger.startMerge(walker);
+    }
+
+    QImage projection() const {
+        return image->projection()->convertToQImage(0, image->bounds());
+    }
+
+    /**
+     * Recalculates the whole image without the cache
+     */
+    QImage referenceProjection() {
+        const bool belowEnabled = KisPartialProjectionsCache::belowCachingEnabled();
+        const bool aboveEnabled = KisPartialProjectionsCache::aboveCachingEnabled();
+
+        KisPartialProjectionsCache::setCachingEnabled(false, false);
+        refreshAll();
+        KisPartialProjectionsCache::setCachingEnabled(belowEnabled, aboveEnabled);
+
+        return projection();
+    }
+
+    const KoColorSpace *cs;
+    KisImageSP image;
+    KisGroupLayerSP group;
+    QVector<KisPaintLayerSP> layers;
+};
+
+QRect dabRect(int index)
+{
+    return QRect(10 + 17 * index, 20 + 11 * index, 40, 40);
+}
+
+void paintStroke(TestImage &t, int layerIndex, int firstDab, int numDabs)
+{
+    for (int i = firstDab; i < firstDab + numDabs; i++) {
+        t.paintDab(layerIndex, dabRect(i), QColor(255, 10 * i, 0, 128));
+    }
+}
+
+}
+
+void KisPartialProjectionsCacheTest::cleanup()
+{
+    KisPartialProjectionsCache::setCachingEnabled(false, false);
+}
+
+void KisPartialProjectionsCacheTest::testBelowCache()
+{
+    KisPartialProjectionsCache::setCachingEnabled(true, false);
+
+    TestImage t;
+
+    paintStroke(t, 3, 0, 10);
+
+    // change a layer below the active one in the area of the cached dabs
+    t.paintDab(1, QRect(30, 30, 60, 60), QColor(0, 0, 255, 200));
+
+    paintStroke(t, 3, 0, 10);
+
+    const QImage result = t.projection();
+
+    // the below cache is exact
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, result, t.referenceProjection()));
+}
+
+void KisPartialProjectionsCacheTest::testAboveCache()
+{
+    KisPartialProjectionsCache::setCachingEnabled(true, true);
+
+    TestImage t;
+
+    paintStroke(t, 3, 0, 10);
+
+    // change a layer above the active one in the area of the cached dabs
+    t.paintDab(5, QRect(30, 30, 60, 60), QColor(0, 0, 255, 200));
+
+    paintStroke(t, 3, 0, 10);
+
+    const QImage result = t.projection();
+
+    // COMPOSITE_OVER is associative up to rounding only
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, result, t.referenceProjection(), 1, 1));
+}
+
+void KisPartialProjectionsCacheTest::testSwitchSplitLayer()
+{
+    KisPartialProjectionsCache::setCachingEnabled(true, false);
+
+    TestImage t;
+
+    paintStroke(t, 3, 0, 5);
+    paintStroke(t, 4, 2, 5);
+    paintStroke(t, 2, 4, 5);
+
+    // interleaved updates do not switch the split layer
+    for (int i = 0; i < 5; i++) {
+        paintStroke(t, 3, i, 1);
+        paintStroke(t, 2, i + 1, 1);
+    }
+
+    const QImage result = t.projection();
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, result, t.referenceProjection()));
+}
+
+void KisPartialProjectionsCacheTest::testCacheIsUsed()
+{
+    KisPartialProjectionsCache::setCachingEnabled(true, false);
+
+    TestImage t;
+    KisPartialProjectionsCache *cache = t.group->partialProjectionsCache();
+
+    const QRect rc(100, 100, 20, 20);
+    const QPoint samplePoint(110, 110);
+
+    auto isCached = [cache] (const QRect &rect) {
+        return (QRegion(rect) - cache->belowValidRegion()).isEmpty();
+    };
+
+    t.update(3, rc);
+    QVERIFY(isCached(rc));
+    QVERIFY(!isCached(dabRect(0)));
+
+    const QRgb originalColor = t.projection().pixel(samplePoint);
+
+    // change the layer below without notifying the image
+    t.layers[1]->paintDevice()->fill(rc, KoColor(Qt::blue, t.cs));
+
+    // the change of the layer is noticed anyway
+    t.update(3, rc);
+    QVERIFY(isCached(rc));
+
+    const QRgb changedColor = t.projection().pixel(samplePoint);
+    QVERIFY(changedColor != originalColor);
+
+    // the update of the layer invalidates the cache in the update rect
+    t.update(1, rc);
+    QVERIFY(!isCached(rc));
+    QCOMPARE(t.projection().pixel(samplePoint), changedColor);
+
+    t.update(3, rc);
+    QVERIFY(isCached(rc));
+
+    const QImage result = t.projection();
+    QCOMPARE(result.pixel(samplePoint), changedColor);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, result, t.referenceProjection()));
+}
+
+QTEST_MAIN(KisPartialProjectionsCacheTest)
@@ -0,0 +1,24 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISPARTIALPROJECTIONSCACHETEST_H
+#define KISPARTIALPROJECTIONSCACHETEST_H
+
+#include <QtTest>
+
+class KisPartialProjectionsCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void cleanup();
+
+    void testBelowCache();
+    void testAboveCache();
+    void testSwitchSplitLayer();
+    void testCacheIsUsed();
+};
+
+#endif // KISPARTIALPROJECTIONSCACHETEST_H
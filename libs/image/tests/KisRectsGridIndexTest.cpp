@@ -0,0 +1,106 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisRectsGridIndexTest.h"
+
+#include <QTest>
+#include <algorithm>
+
+#include "KisRectsGridIndex.h"
+
+void KisRectsGridIndexTest::testBasic()
+{
+    KisRectsGridIndex<int> index(64);
+
+    index.insert(QRect(0,0,10,10), 1);
+    index.insert(QRect(50,50,100,100), 2);
+    index.insert(QRect(-100,-100,20,20), 3);
+
+    QCOMPARE(index.size(), 3);
+
+    QCOMPARE(index.intersecting(QRect(5,5,10,10)), QVector<int>({1}));
+    QCOMPARE(index.intersecting(QRect(140,140,10,10)), QVector<int>({2}));
+    QCOMPARE(index.intersecting(QRect(-90,-90,5,5)), QVector<int>({3}));
+    QVERIFY(index.intersecting(QRect(20,20,10,10)).isEmpty());
+
+    // the rect spans several cells, but is reported only once
+    QCOMPARE(index.intersecting(QRect(0,0,200,200)).size(), 2);
+
+    QVERIFY(index.remove(QRect(50,50,100,100), 2));
+    QVERIFY(!index.remove(QRect(50,50,100,100), 2));
+    QVERIFY(!index.hasIntersecting(QRect(140,140,10,10)));
+    QCOMPARE(index.size(), 2);
+
+    index.setCellSize(16);
+    QCOMPARE(index.intersecting(QRect(5,5,10,10)), QVector<int>({1}));
+    QCOMPARE(index.intersecting(QRect(-90,-90,5,5)), QVector<int>({3}));
+}
+
+void KisRectsGridIndexTest::testOversizedRects()
+{
+    KisRectsGridIndex<int> index(16);
+
+    const QRect hugeRect(0,0,10000,10000);
+    index.insert(hugeRect, 1);
+    index.insert(QRect(5000,5000,10,10), 2);
+
+    QVector<int> result = index.intersecting(QRect(5005,5005,1,1));
+    std::sort(result.begin(), result.end());
+    QCOMPARE(result, QVector<int>({1, 2}));
+
+    QVERIFY(index.remove(hugeRect, 1));
+    QCOMPARE(index.intersecting(QRect(5005,5005,1,1)), QVector<int>({2}));
+}
+
+void KisRectsGridIndexTest::testRandomAgainstBruteForce()
+{
+    KisRectsGridIndex<int> index(128);
+    QVector<QPair<QRect, int>> reference;
+
+    quint32 seed = 1;
+    auto random = [&seed] (int max) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 8) % max);
+    };
+
+    auto randomRect = [&random] () {
+        const int maxSize = random(20) ? 300 : 5000;
+        return QRect(random(8000) - 4000, random(8000) - 4000,
+                     1 + random(maxSize), 1 + random(maxSize));
+    };
+
+    for (int i = 0; i < 5000; i++) {
+        if (random(3) || reference.isEmpty()) {
+            const QRect rc = randomRect();
+            index.insert(rc, i);
+            reference.append(qMakePair(rc, i));
+        } else {
+            const int pos = random(reference.size());
+            QVERIFY(index.remove(reference[pos].first, reference[pos].second));
+            reference.removeAt(pos);
+        }
+
+        if (i % 50 == 0) {
+            const QRect request = randomRect();
+
+            QVector<int> result = index.intersecting(request);
+            std::sort(result.begin(), result.end());
+
+            QVector<int> expected;
+            Q_FOREACH (const auto &item, reference) {
+                if (item.first.intersects(request)) {
+                    expected.append(item.second);
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+
+            QCOMPARE(result, expected);
+            QCOMPARE(index.size(), reference.size());
+        }
+    }
+}
+
+QTEST_MAIN(KisRectsGridIndexTest)
@@ -0,0 +1,21 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISRECTSGRIDINDEXTEST_H
+#define KISRECTSGRIDINDEXTEST_H
+
+#include <QtTest>
+
+class KisRectsGridIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBasic();
+    void testOversizedRects();
+    void testRandomAgainstBruteForce();
+};
+
+#endif // KISRECTSGRIDINDEXTEST_H
@@ -0,0 +1,154 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisWorkStealingThreadPoolTest.h"
+
+#include <atomic>
+#include <QRunnable>
+#include <QTest>
+#include <QThread>
+
+#include "KisWorkStealingThreadPool.h"
+#include "KisNumaTopology.h"
+
+namespace {
+
+struct CountingRunnable : public QRunnable
+{
+    CountingRunnable(std::atomic<int> *counter)
+        : m_counter(counter)
+    {
+    }
+
+    void run() override {
+        QTest::qSleep(1);
+        (*m_counter)++;
+    }
+
+    std::atomic<int> *m_counter;
+};
+
+/**
+ * Starts its children from the worker thread, so they
+ * go to the local queue of the worker and get stolen
+ * by the other workers
+ */
+struct SpawningRunnable : public QRunnable
+{
+    SpawningRunnable(KisWorkStealingThreadPool *pool, std::atomic<int> *counter, int numChildren)
+        : m_pool(pool),
+          m_counter(counter),
+          m_numChildren(numChildren)
+    {
+    }
+
+    void run() override {
+        for (int i = 0; i < m_numChildren; i++) {
+            m_pool->start(new CountingRunnable(m_counter));
+        }
+    }
+
+    KisWorkStealingThreadPool *m_pool;
+    std::atomic<int> *m_counter;
+    int m_numChildren;
+};
+
+}
+
+void KisWorkStealingThreadPoolTest::testExternalStart()
+{
+    KisWorkStealingThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QCOMPARE(pool.maxThreadCount(), 4);
+
+    std::atomic<int> counter(0);
+
+    for (int i = 0; i < 200; i++) {
+        pool.start(new CountingRunnable(&counter));
+    }
+
+    pool.waitForDone();
+    QCOMPARE(counter.load(), 200);
+}
+
+void KisWorkStealingThreadPoolTest::testNestedStart()
+{
+    KisWorkStealingThreadPool pool;
+    pool.setMaxThreadCount(8);
+
+    std::atomic<int> counter(0);
+
+    for (int i = 0; i < 4; i++) {
+        pool.start(new SpawningRunnable(&pool, &counter, 100));
+    }
+
+    pool.waitForDone();
+    QCOMPARE(counter.load(), 400);
+}
+
+void KisWorkStealingThreadPoolTest::testChangeThreadCount()
+{
+    KisWorkStealingThreadPool pool;
+    std::atomic<int> counter(0);
+
+    for (int numThreads = 1; numThreads <= 16; numThreads *= 2) {
+        pool.setMaxThreadCount(numThreads);
+        QCOMPARE(pool.maxThreadCount(), numThreads);
+
+        for (int i = 0; i < 50; i++) {
+            pool.start(new CountingRunnable(&counter));
+        }
+
+        pool.waitForDone();
+    }
+
+    QCOMPARE(counter.load(), 250);
+}
+
+void KisWorkStealingThreadPoolTest::testPreferredNode()
+{
+    const int numCpus = QThread::idealThreadCount();
+    if (numCpus < 2) {
+        QSKIP("At least two CPUs are needed for simulating two nodes");
+    }
+
+    // split the CPUs into two simulated nodes
+    QVector<QVector<int>> nodeCpus(2);
+    for (int cpu = 0; cpu < numCpus; cpu++) {
+        nodeCpus[cpu < numCpus / 2 ? 0 : 1].append(cpu);
+    }
+
+    KisNumaTopology topology(nodeCpus);
+    QVERIFY(topology.isNumaAware());
+
+    KisWorkStealingThreadPool pool;
+    pool.setNumaTopology(&topology);
+    pool.setMaxThreadCount(4);
+    QCOMPARE(pool.numaTopology(), &topology);
+
+    std::atomic<int> counter(0);
+
+    for (int i = 0; i < 200; i++) {
+        pool.start(new CountingRunnable(&counter), i % 3 - 1);
+    }
+
+    pool.start(new SpawningRunnable(&pool, &counter, 100), 1);
+
+    pool.waitForDone();
+    QCOMPARE(counter.load(), 300);
+
+    // the workers must be restarted without the topology
+    pool.setNumaTopology(0);
+
+    for (int i = 0; i < 50; i++) {
+        pool.start(new CountingRunnable(&counter), 1);
+    }
+
+    pool.waitForDone();
+    QCOMPARE(counter.load(), 350);
+}
+
+QTEST_MAIN(KisWorkStealingThreadPoolTest)
@@ -0,0 +1,22 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISWORKSTEALINGTHREADPOOLTEST_H
+#define KISWORKSTEALINGTHREADPOOLTEST_H
+
+#include <QtTest>
+
+class KisWorkStealingThreadPoolTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testExternalStart();
+    void testNestedStart();
+    void testChangeThreadCount();
+    void testPreferredNode();
+};
+
+#endif // KISWORKSTEALINGTHREADPOOLTEST_H
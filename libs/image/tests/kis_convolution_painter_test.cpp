@@ -32,6 +32,8 @@
 #include "kis_convolution_painter.h"
 #include "kis_convolution_kernel.h"
 #include <kis_gaussian_kernel.h>
+#include <KisFastGaussianBlur.h>
+#include <kis_sequential_iterator.h>
 #include <kis_mask_generator.h>
 #include "testutil.h"
 #include "testing_timed_default_bounds.h"
@@ -461,6 +463,161 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testFFTTiling()
+{
+    if (!KisConvolutionPainter::supportsFFTW()) {
+        QSKIP("FFTW is not available");
+    }
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect imageRect(0, 0, 1500, 1100);
+
+    KisPaintDeviceSP tiledDev = new KisPaintDevice(cs);
+    tiledDev->setDefaultBounds(new TestUtil::TestingTimedDefaultBounds(imageRect));
+
+    srand(31524744);
+
+    KisSequentialIterator it(tiledDev, imageRect);
+    while (it.nextPixel()) {
+        quint8 *ptr = it.rawData();
+        for (int i = 0; i < 4; i++) {
+            ptr[i] = rand() % 256;
+        }
+    }
+
+    KisPaintDeviceSP wholeDev = new KisPaintDevice(*tiledDev);
+
+    /**
+     * The kernel is big enough to split the area into several tiles,
+     * and the convolution is done in-place, so the tiles should not
+     * read the pixels already written by their neighbours
+     */
+    KisConvolutionKernelSP kernel = KisGaussianKernel::createUniform2DKernel(40, 40);
+    const QRect applyRect = imageRect.adjusted(20, 30, -40, -10);
+
+    KisConvolutionPainter tiledPainter(tiledDev, KisConvolutionPainter::FFTW);
+    tiledPainter.applyMatrix(kernel, tiledDev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+    KisConvolutionPainter wholePainter(wholeDev, KisConvolutionPainter::FFTW);
+    wholePainter.setFFTTilingEnabled(false);
+    wholePainter.applyMatrix(kernel, wholeDev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt,
+                                     tiledDev->convertToQImage(0, imageRect),
+                                     wholeDev->convertToQImage(0, imageRect),
+                                     1, 1));
+}
+
+void KisConvolutionPainterTest::testFastGaussianBoxVariance_data()
+{
+    QTest::addColumn<qreal>("sigma");
+
+    QTest::newRow("0.5") << 0.5;
+    QTest::newRow("1.0") << 1.0;
+    QTest::newRow("3.3") << 3.3;
+    QTest::newRow("17.1") << 17.1;
+    QTest::newRow("60.3") << 60.3;
+}
+
+void KisConvolutionPainterTest::testFastGaussianBoxVariance()
+{
+    QFETCH(qreal, sigma);
+
+    const KisFastGaussianBlur::BoxParameters params = KisFastGaussianBlur::boxParameters(sigma);
+    const int r = params.radius;
+
+    QVERIFY(params.edgeWeight >= 0.0);
+    QVERIFY(params.edgeWeight < 1.0);
+    QVERIFY(qAbs(params.scale * (2 * r + 1 + 2 * params.edgeWeight) - 1.0) < 1e-6);
+
+    // the cascade should never be wider than the exact kernel
+    QVERIFY(KisFastGaussianBlur::numPasses * (r + 1) <= 3 * std::ceil(sigma));
+
+    const qreal boxVariance = params.scale *
+        ((2 * r + 1) * r * (r + 1) / 3.0 + 2 * params.edgeWeight * pow2(r + 1));
+
+    QVERIFY(qAbs(KisFastGaussianBlur::numPasses * boxVariance - pow2(sigma)) < 1e-4 * pow2(sigma));
+}
+
+void KisConvolutionPainterTest::testFastGaussianAccuracy_data()
+{
+    QTest::addColumn<qreal>("xRadius");
+    QTest::addColumn<qreal>("yRadius");
+
+    QTest::newRow("20") << 20.0 << 20.0;
+    QTest::newRow("50") << 50.0 << 50.0;
+    QTest::newRow("200") << 200.0 << 200.0;
+    QTest::newRow("horizontal") << 70.0 << 0.0;
+    QTest::newRow("vertical") << 0.0 << 70.0;
+    QTest::newRow("anisotropic") << 30.0 << 120.0;
+}
+
+void KisConvolutionPainterTest::testFastGaussianAccuracy()
+{
+    QFETCH(qreal, xRadius);
+    QFETCH(qreal, yRadius);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect imageRect(0, 0, 300, 300);
+
+    KisPaintDeviceSP exactDev = new KisPaintDevice(cs);
+    exactDev->setDefaultBounds(new TestUtil::TestingTimedDefaultBounds(imageRect));
+
+    KoColor c(Qt::red, cs);
+    exactDev->fill(QRect(20, 30, 150, 100), c);
+
+    c = KoColor(Qt::blue, cs);
+    c.setOpacity(quint8(160));
+    exactDev->fill(QRect(100, 80, 40, 200), c);
+
+    c = KoColor(Qt::yellow, cs);
+    c.setOpacity(quint8(60));
+    exactDev->fill(QRect(180, 150, 110, 10), c);
+
+    KisPaintDeviceSP fastDev = new KisPaintDevice(*exactDev);
+
+    KisGaussianKernel::applyGaussian(exactDev, imageRect, xRadius, yRadius,
+                                     QBitArray(), 0, false, BORDER_REPEAT,
+                                     KisGaussianKernel::BLUR_EXACT);
+
+    KisGaussianKernel::applyGaussian(fastDev, imageRect, xRadius, yRadius,
+                                     QBitArray(), 0, false, BORDER_REPEAT,
+                                     KisGaussianKernel::BLUR_FAST);
+
+    /**
+     * The colors of almost transparent pixels are too imprecise, so
+     * the pixels are compared in premultiplied form
+     */
+    KisSequentialConstIterator exactIt(exactDev, imageRect);
+    KisSequentialConstIterator fastIt(fastDev, imageRect);
+
+    qreal maxDifference = 0;
+    qreal totalDifference = 0;
+    int numSamples = 0;
+
+    while (exactIt.nextPixel() && fastIt.nextPixel()) {
+        const KoBgrU8Traits::Pixel *exactPixel = reinterpret_cast<const KoBgrU8Traits::Pixel*>(exactIt.rawDataConst());
+        const KoBgrU8Traits::Pixel *fastPixel = reinterpret_cast<const KoBgrU8Traits::Pixel*>(fastIt.rawDataConst());
+
+        const qreal differences[] = {
+            qAbs(exactPixel->blue * exactPixel->alpha - fastPixel->blue * fastPixel->alpha) / 255.0,
+            qAbs(exactPixel->green * exactPixel->alpha - fastPixel->green * fastPixel->alpha) / 255.0,
+            qAbs(exactPixel->red * exactPixel->alpha - fastPixel->red * fastPixel->alpha) / 255.0,
+            qAbs(qreal(exactPixel->alpha) - fastPixel->alpha)
+        };
+
+        for (qreal difference : differences) {
+            maxDifference = qMax(maxDifference, difference);
+            totalDifference += difference;
+            numSamples++;
+        }
+    }
+
+    QVERIFY2(maxDifference <= 5.0, QString("max difference: %1").arg(maxDifference).toLatin1());
+    QVERIFY2(totalDifference / numSamples <= 1.0, QString("mean difference: %1").arg(totalDifference / numSamples).toLatin1());
+}
+
 #include "kis_transaction.h"
 
 void KisConvolutionPainterTest::testDilate()
@@ -59,6 +59,14 @@ private Q_SLOTS:
     void testGaussianDetailsSpatial();
     void testGaussianDetailsFFTW();
 
+    void testFFTTiling();
+
+    void testFastGaussianBoxVariance_data();
+    void testFastGaussianBoxVariance();
+
+    void testFastGaussianAccuracy_data();
+    void testFastGaussianAccuracy();
+
     void testDilate();
     void testErode();
 
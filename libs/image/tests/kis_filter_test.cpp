@@ -29,7 +29,11 @@
 
 #include <KoProgressUpdater.h>
 #include <KoUpdater.h>
+#include <KoColor.h>
 #include "testing_timed_default_bounds.h"
+#include "kis_default_bounds_base.h"
+#include "krita_utils.h"
+#include "KisRegion.h"
 
 class TestFilter : public KisFilter
 {
@@ -249,4 +253,153 @@ void KisFilterTest::testBlurFilterApplicationRect()
 }
 
 
+/**
+ * Shifts the device to the right by "shift" pixels. The filter doesn't
+ * know anything about LoD, so it is run on LoD planes via the generic path.
+ */
+class TestShiftFilter : public KisFilter
+{
+public:
+    TestShiftFilter()
+        : KisFilter(KoID("testshift", "testshift"), KoID("test", "test"), "TestShiftFilter")
+    {
+        setLevelOfDetailScaledProperties({"shift"});
+    }
+
+    void processImpl(KisPaintDeviceSP device,
+                     const QRect& applyRect,
+                     const KisFilterConfigurationSP config,
+                     KoUpdater* progressUpdater) const override {
+        Q_UNUSED(progressUpdater);
+
+        const int shift = config->getInt("shift", 0);
+
+        QVector<quint8> buffer(applyRect.width() * applyRect.height() * device->pixelSize());
+        device->readBytes(buffer.data(), applyRect.translated(-shift, 0));
+        device->writeBytes(buffer.data(), applyRect);
+    }
+
+    QRect neededRect(const QRect &rect, const KisFilterConfigurationSP config, int lod) const override {
+        Q_UNUSED(lod);
+        return rect.adjusted(-config->getInt("shift", 0), 0, 0, 0);
+    }
+
+    QRect changedRect(const QRect &rect, const KisFilterConfigurationSP config, int lod) const override {
+        Q_UNUSED(lod);
+        return rect.adjusted(0, 0, config->getInt("shift", 0), 0);
+    }
+};
+
+struct TestingLodDefaultBounds : public KisDefaultBoundsBase {
+    TestingLodDefaultBounds(const QRect &bounds)
+        : m_lod(0), m_bounds(bounds) {}
+
+    QRect bounds() const override {
+        return m_bounds;
+    }
+    bool wrapAroundMode() const override {
+        return false;
+    }
+    int currentLevelOfDetail() const override {
+        return m_lod;
+    }
+    int currentTime() const override {
+        return 0;
+    }
+    bool externalFrameActive() const override {
+        return false;
+    }
+    void * sourceCookie() const override {
+        return 0;
+    }
+
+    void testingSetLevelOfDetail(int lod) {
+        m_lod = lod;
+    }
+
+private:
+    int m_lod;
+    QRect m_bounds;
+};
+
+void syncLodCache(KisPaintDeviceSP dev, int levelOfDetail)
+{
+    KisPaintDevice::LodDataStruct* s = dev->createLodDataStruct(levelOfDetail);
+
+    KisRegion region = dev->regionForLodSyncing();
+    Q_FOREACH(QRect rect, KritaUtils::splitRegionIntoPatches(region, KritaUtils::optimalPatchSize())) {
+        dev->updateLodDataStruct(s, rect);
+    }
+
+    dev->uploadLodDataStruct(s);
+}
+
+void KisFilterTest::testGenericLevelOfDetail()
+{
+    const int lod = 2;
+    const QRect imageRect(0, 0, 256, 256);
+    const QRect lodImageRect(0, 0, 64, 64);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisFilterSP f = new TestShiftFilter();
+    KisFilterConfigurationSP kfc = f->defaultConfiguration();
+    kfc->setProperty("shift", 32);
+
+    QVERIFY(f->supportsLevelOfDetail(kfc, lod));
+    QCOMPARE(f->levelOfDetailConfiguration(kfc, 0)->getInt("shift"), 32);
+    QCOMPARE(f->levelOfDetailConfiguration(kfc, lod)->getInt("shift"), 8);
+    QCOMPARE(f->levelOfDetailConfiguration(kfc, 6)->getInt("shift"), 1);
+    QCOMPARE(kfc->getInt("shift"), 32);
+
+    // the scaled configuration is reused until the source changes
+    KisFilterConfigurationSP lodConfig = f->levelOfDetailConfiguration(kfc, lod);
+    QCOMPARE(f->levelOfDetailConfiguration(kfc, lod).data(), lodConfig.data());
+
+    kfc->setProperty("shift", 16);
+    QCOMPARE(f->levelOfDetailConfiguration(kfc, lod)->getInt("shift"), 4);
+    QCOMPARE(lodConfig->getInt("shift"), 8);
+
+    kfc->setProperty("shift", 32);
+
+    // all the blocks are aligned to the LoD cells, so the downsampling is exact
+    auto fillDevice = [cs] (KisPaintDeviceSP dev) {
+        dev->fill(QRect(32, 32, 64, 64), KoColor(Qt::red, cs));
+        dev->fill(QRect(96, 64, 32, 48), KoColor(Qt::blue, cs));
+        dev->fill(QRect(160, 128, 16, 96), KoColor(Qt::green, cs));
+    };
+
+    TestingLodDefaultBounds *bounds = new TestingLodDefaultBounds(imageRect);
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->setDefaultBounds(bounds);
+    fillDevice(dev);
+
+    TestingLodDefaultBounds *refBounds = new TestingLodDefaultBounds(imageRect);
+    KisPaintDeviceSP ref = new KisPaintDevice(cs);
+    ref->setDefaultBounds(refBounds);
+    fillDevice(ref);
+
+    f->process(ref, imageRect, kfc);
+    const QImage refImage = ref->convertToQImage(0, imageRect);
+
+    refBounds->testingSetLevelOfDetail(lod);
+    syncLodCache(ref, lod);
+    const QImage refLodImage = ref->convertToQImage(0, lodImageRect);
+
+    // preview pass: the filter is applied to the LoD plane with the scaled shift
+    bounds->testingSetLevelOfDetail(lod);
+    syncLodCache(dev, lod);
+    f->process(dev, lodImageRect, kfc);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, refLodImage, dev->convertToQImage(0, lodImageRect), 1, 1));
+
+    // refinement pass: the full resolution result is exactly the same
+    // as if there were no preview
+    bounds->testingSetLevelOfDetail(0);
+    f->process(dev, imageRect, kfc);
+
+    QVERIFY(TestUtil::compareQImages(pt, refImage, dev->convertToQImage(0, imageRect)));
+}
+
 QTEST_MAIN(KisFilterTest)
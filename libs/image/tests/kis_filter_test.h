@@ -32,6 +32,7 @@ private Q_SLOTS:
     void testDifferentSrcAndDst();
     void testOldDataApiAfterCopy();
     void testBlurFilterApplicationRect();
+    void testGenericLevelOfDetail();
 };
 
 #endif
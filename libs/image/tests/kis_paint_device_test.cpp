@@ -1539,6 +1539,117 @@ void KisPaintDeviceTest::testLodDevice()
                                   "lod", "lod1-offset-6-14"));
 }
 
+KisPaintDeviceSP referenceMipmapLevel(KisPaintDeviceSP dev, int level)
+{
+    KisPaintDeviceSP src = dev;
+
+    for (int i = 0; i < level; i++) {
+        KisPaintDeviceSP dst = new KisPaintDevice(dev->colorSpace());
+        dst->moveTo(dev->x(), dev->y());
+        src->generateLodCloneDevice(dst, src->extent(), 1);
+        src = dst;
+    }
+
+    return src;
+}
+
+bool compareMipmapLevels(KisPaintDeviceSP dev, int level)
+{
+    KisPaintDeviceSP mip = dev->mipmapLevel(level);
+    KisPaintDeviceSP ref = referenceMipmapLevel(dev, level);
+
+    const QRect rc = mip->extent() | ref->extent();
+
+    QPoint pt;
+    if (!TestUtil::compareQImages(pt,
+                                  mip->convertToQImage(0, rc),
+                                  ref->convertToQImage(0, rc))) {
+        qDebug() << "Failed mipmap level" << level << ppVar(rc) << ppVar(pt);
+        return false;
+    }
+
+    return true;
+}
+
+void KisPaintDeviceTest::testMipmap()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->moveTo(13, 7);
+
+    fillGradientDevice(dev, QRect(0, 0, 300, 200));
+
+    QVERIFY(!dev->mipmapLevel(1));
+
+    dev->setMipmapEnabled(true);
+    QVERIFY(dev->mipmapEnabled());
+
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(compareMipmapLevels(dev, i));
+    }
+
+    // the levels are updated after a change of the device
+    KisPaintDeviceSP level2 = dev->mipmapLevel(2);
+    const QPoint samplePoint(110, 110);
+
+    dev->fill(QRect(100, 100, 20, 20), KoColor(Qt::red, cs));
+
+    KisPaintDeviceSP newLevel2 = dev->mipmapLevel(2);
+
+    QColor oldColor;
+    QColor newColor;
+    level2->pixel(samplePoint.x() >> 2, samplePoint.y() >> 2, &oldColor);
+    newLevel2->pixel(samplePoint.x() >> 2, samplePoint.y() >> 2, &newColor);
+    QVERIFY(oldColor != newColor);
+
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(compareMipmapLevels(dev, i));
+    }
+
+    // the removed tiles are also tracked
+    dev->clear(QRect(0, 0, 200, 200));
+
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(compareMipmapLevels(dev, i));
+    }
+
+    // the tiles written through an iterator are tracked when it is released
+    {
+        const KoColor green(Qt::green, cs);
+        KisRandomAccessorSP it = dev->createRandomAccessorNG();
+
+        for (int y = 150; y < 170; y++) {
+            for (int x = 190; x < 230; x++) {
+                it->moveTo(x, y);
+                memcpy(it->rawData(), green.data(), cs->pixelSize());
+            }
+        }
+    }
+
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(compareMipmapLevels(dev, i));
+    }
+
+    // undo is not tracked per tile, the levels are rebuilt
+    {
+        KisTransaction transaction(dev);
+        dev->fill(QRect(50, 20, 200, 150), KoColor(Qt::blue, cs));
+
+        for (int i = 1; i <= 3; i++) {
+            QVERIFY(compareMipmapLevels(dev, i));
+        }
+
+        transaction.revert();
+    }
+
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(compareMipmapLevels(dev, i));
+    }
+
+    dev->setMipmapEnabled(false);
+    QVERIFY(!dev->mipmapLevel(1));
+}
+
 void KisPaintDeviceTest::benchmarkLod1Generation()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
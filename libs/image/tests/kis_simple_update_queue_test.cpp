@@ -18,6 +18,7 @@
 
 #include "kis_simple_update_queue_test.h"
 #include <QTest>
+#include <QElapsedTimer>
 
 #include "kistest.h"
 
@@ -31,6 +32,7 @@
 #include "filter/kis_filter_configuration.h"
 #include "filter/kis_filter_registry.h"
 #include "kis_selection.h"
+#include "kis_image_config.h"
 
 #include "kis_update_job_item.h"
 #include "kis_simple_update_queue.h"
@@ -278,5 +280,209 @@ void KisSimpleUpdateQueueTest::testSpontaneousJobsCompression()
     QCOMPARE(jobsList[0], job3);
 }
 
+void KisSimpleUpdateQueueTest::testAdaptivePatchSize()
+{
+    KisImageConfig config(false);
+    const bool oldAdaptive = config.adaptiveUpdatePatchSize();
+    const qreal oldTargetTime = config.updatePatchTargetTime();
+    const int oldPatchWidth = config.updatePatchWidth();
+    const int oldPatchHeight = config.updatePatchHeight();
+
+    const int initialPatchSize = 512;
+
+    config.setAdaptiveUpdatePatchSize(true);
+    config.setUpdatePatchTargetTime(10.0);
+    config.setUpdatePatchWidth(initialPatchSize);
+    config.setUpdatePatchHeight(initialPatchSize);
+
+    const QRect imageRect(0, 0, 1024, 1024);
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "adaptive patch test");
+
+    KisPaintLayerSP paintLayer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+
+    image->barrierLock();
+    image->addNode(paintLayer);
+    image->unlock();
+
+    const QRect jobRect(0, 0, 256, 256);
+
+    auto jobTime = [jobRect] (int idealPatchSize) {
+        // the time of a job with which a patch of idealPatchSize takes 10 ms
+        return qint64(10000000.0 * jobRect.width() * jobRect.height() / (qreal(idealPatchSize) * idealPatchSize));
+    };
+
+    {
+        KisTestableSimpleUpdateQueue queue;
+        queue.setThreadsLimit(4);
+        QCOMPARE(queue.patchSize(), QSize(initialPatchSize, initialPatchSize));
+
+        // too few measurements
+        for (int i = 0; i < 4; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(4 * initialPatchSize));
+        }
+        QCOMPARE(queue.patchSize(), QSize(initialPatchSize, initialPatchSize));
+        QCOMPARE(queue.mergeTimePerPixel(), 0.0);
+
+        // tiny jobs are not measured
+        for (int i = 0; i < 16; i++) {
+            queue.reportMergeJobFinished(QRect(0, 0, 16, 16), 100000000);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(4 * initialPatchSize));
+        }
+        QCOMPARE(queue.patchSize(), QSize(4 * initialPatchSize, 4 * initialPatchSize));
+        QVERIFY(queue.mergeTimePerPixel() > 0.0);
+
+        // cheap jobs are limited by the maximum patch size
+        for (int i = 0; i < 100; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(100000));
+        }
+        QCOMPARE(queue.patchSize(), QSize(2048, 2048));
+
+        for (int i = 0; i < 100; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(256));
+        }
+        QCOMPARE(queue.patchSize(), QSize(256, 256));
+
+        // small fluctuations do not change the size
+        for (int i = 0; i < 100; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(i % 2 ? 200 : 320));
+        }
+        QCOMPARE(queue.patchSize(), QSize(256, 256));
+
+        KisWalkersList& walkersList = queue.getWalkersList();
+        queue.addFullRefreshJob(paintLayer, QRect(0, 0, 1000, 1000), imageRect, 0);
+        QCOMPARE(walkersList.size(), 16);
+
+        // a full refresh should still be split into a patch per thread
+        queue.setThreadsLimit(64);
+        QCOMPARE(queue.patchSize(), QSize(128, 128));
+
+        for (int i = 0; i < 100; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(100000));
+        }
+        QCOMPARE(queue.patchSize(), QSize(128, 128));
+    }
+
+    config.setAdaptiveUpdatePatchSize(false);
+
+    {
+        KisTestableSimpleUpdateQueue queue;
+
+        for (int i = 0; i < 100; i++) {
+            queue.reportMergeJobFinished(jobRect, jobTime(256));
+        }
+        QCOMPARE(queue.patchSize(), QSize(initialPatchSize, initialPatchSize));
+    }
+
+    config.setAdaptiveUpdatePatchSize(oldAdaptive);
+    config.setUpdatePatchTargetTime(oldTargetTime);
+    config.setUpdatePatchWidth(oldPatchWidth);
+    config.setUpdatePatchHeight(oldPatchHeight);
+}
+
+void KisSimpleUpdateQueueTest::testQueueStress_data()
+{
+    QTest::addColumn<int>("numRects");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("5000") << 5000;
+}
+
+/**
+ * Emulates a fast stroke over a stack of layers: lots of small
+ * dirty rects, some of them overlapping and merged by the queue.
+ * Checks that the running jobs never intersect and reports the
+ * scheduling overhead per rect.
+ */
+void KisSimpleUpdateQueueTest::testQueueStress()
+{
+    QFETCH(int, numRects);
+
+    const QRect imageRect(0,0,4096,4096);
+    const int numLayers = 8;
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "stress test");
+
+    QVector<KisPaintLayerSP> layers;
+
+    image->barrierLock();
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        image->addNode(layer);
+        layers << layer;
+    }
+    image->unlock();
+
+    KisTestableSimpleUpdateQueue queue;
+    KisTestableUpdaterContext context(8);
+    KisWalkersList& walkersList = queue.getWalkersList();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    quint32 seed = 1;
+    QPoint pos(2048, 2048);
+
+    for (int i = 0; i < numRects; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        // every few rects the stroke jumps into a random place
+        if (i % 16 == 0) {
+            pos = QPoint(int((seed >> 8) % 4000), int((seed >> 16) % 4000));
+        } else {
+            pos += QPoint(12, int((seed >> 16) % 9) - 4);
+        }
+
+        const QRect rc = QRect(pos, QSize(32, 32)) & imageRect;
+        queue.addUpdateJob(layers[(i / 16) % numLayers], rc, imageRect, 0);
+    }
+
+    const qint64 addTime = timer.nsecsElapsed();
+    const int numPending = walkersList.size();
+
+    QVERIFY(numPending > 0);
+    QVERIFY(numPending <= numRects);
+
+    timer.restart();
+
+    int numProcessed = 0;
+
+    while (!queue.isEmpty()) {
+        queue.processQueue(context);
+
+        const QVector<KisUpdateJobItem*> jobs = context.getJobs();
+        int numRunning = 0;
+
+        for (int i = 0; i < jobs.size(); i++) {
+            if (!jobs[i]->isRunning()) continue;
+            numRunning++;
+
+            for (int j = 0; j < jobs.size(); j++) {
+                if (i == j || !jobs[j]->isRunning()) continue;
+                QVERIFY(!KisUpdaterContext::walkerIntersectsJob(jobs[i]->walker(), jobs[j]));
+            }
+        }
+
+        QVERIFY(numRunning > 0);
+        numProcessed += numRunning;
+
+        context.clear();
+    }
+
+    const qint64 processTime = timer.nsecsElapsed();
+
+    QCOMPARE(numProcessed, numPending);
+
+    qDebug() << "Rects:" << numRects
+             << "Pending walkers:" << numPending
+             << "Add:" << addTime / 1000.0 / numRects << "us/rect"
+             << "Dispatch:" << processTime / 1000.0 / numPending << "us/walker";
+}
+
 KISTEST_MAIN(KisSimpleUpdateQueueTest)
 
@@ -36,6 +36,9 @@ private Q_SLOTS:
     void testChecksum();
     void testMixingTypes();
     void testSpontaneousJobsCompression();
+    void testAdaptivePatchSize();
+    void testQueueStress_data();
+    void testQueueStress();
 };
 
 #endif /* KIS_SIMPLE_UPDATE_QUEUE_TEST_H */
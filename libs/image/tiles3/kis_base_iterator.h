@@ -56,6 +56,9 @@ protected:
     inline void unlockTile(KisTileSP &tile) {
         if (m_writable) {
             tile->unlockForWrite();
+            if (m_dataManager) {
+                m_dataManager->notifyTileChanged(tile->col(), tile->row());
+            }
         } else {
             tile->unlockForRead();
         }
@@ -61,6 +61,9 @@ private:
     inline void unlockTile(KisTileSP &tile) {
         if (m_writable) {
             tile->unlockForWrite();
+            if (m_ktm) {
+                m_ktm->notifyTileChanged(tile->col(), tile->row());
+            }
         } else {
             tile->unlockForRead();
         }
@@ -227,6 +227,19 @@ void KisTile::lockForRead() const
 }
 
 
+bool KisTile::prefetch() const
+{
+    /**
+     * The barrier lock guarantees the tile data will not be
+     * released by COW while we are swapping it in
+     */
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    if (m_tileData->data()) return true;
+    return m_tileData->m_store->prefetchTileData(m_tileData);
+}
+
+
 #define lazyCopying() (m_tileData->m_usersCount>1)
 
 void KisTile::lockForWrite()
@@ -92,6 +92,15 @@ public:
     void unlockForWrite();
     void unlockForRead() const;
 
+    /**
+     * Loads the tile data from the swap in advance, if it has
+     * been swapped out. Returns false if the store refuses to
+     * prefetch the data due to the memory limits.
+     *
+     * \see KisTileDataPrefetcher
+     */
+    bool prefetch() const;
+
 
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
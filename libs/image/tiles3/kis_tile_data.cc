@@ -23,8 +23,14 @@
 
 #include <kis_debug.h>
 
+#include <QGlobalStatic>
+#include <QMutex>
+#include <QMutexLocker>
+#include <cstdlib>
+
 #include <boost/pool/singleton_pool.hpp>
 #include "kis_tile_data_store_iterators.h"
+#include "KisNumaTopology.h"
 
 // BPP == bytes per pixel
 #define TILE_SIZE_4BPP (4 * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
@@ -38,6 +44,136 @@ const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
 SimpleCache KisTileData::m_cache;
 
+namespace {
+
+/**
+ * The memory of the tile data used on NUMA systems instead of the boost
+ * pools. Every node has its own slabs, which are placed on this node, and
+ * its own lists of free blocks. The block freed by any thread is reused
+ * only for the tile data of the same node, so the tile data always stays
+ * on the node it has been allocated for.
+ */
+class NumaTileDataPool
+{
+public:
+    static const int maxPixelSize = 64;
+    static const size_t slabSize = 4 << 20;
+
+    NumaTileDataPool() {
+        for (int i = 0; i < KisNumaTopology::instance()->numNodes(); i++) {
+            m_nodes.append(new Node());
+        }
+    }
+
+    ~NumaTileDataPool() {
+        purge();
+        qDeleteAll(m_nodes);
+    }
+
+    quint8* allocate(qint32 pixelSize, int node) {
+        node = qBound(0, node, m_nodes.size() - 1);
+        Node *n = m_nodes[node];
+
+        quint8 *ptr = 0;
+        if (n->freeBlocks[pixelSize].pop(ptr)) {
+            return ptr;
+        }
+
+        const size_t blockSize = pixelSize * KisTileData::WIDTH * KisTileData::HEIGHT;
+
+        QMutexLocker l(&n->slabLock);
+
+        if (size_t(n->slabEnd - n->slabPos) < blockSize) {
+            Slab slab;
+            slab.data = static_cast<quint8*>(
+                KisNumaTopology::instance()->allocateOnNode(slabSize, node));
+
+            /**
+             * If the system refuses to map the memory, the slab is
+             * allocated in the usual way and is placed wherever the
+             * system decides
+             */
+            if (!slab.data) {
+                warnTiles << "Failed to allocate the tile data on NUMA node" << node;
+                slab.data = static_cast<quint8*>(malloc(slabSize));
+                slab.isOnNode = false;
+            }
+
+            KIS_ASSERT(slab.data);
+
+            n->slabs.append(slab);
+            n->slabPos = slab.data;
+            n->slabEnd = slab.data + slabSize;
+        }
+
+        ptr = n->slabPos;
+        n->slabPos += blockSize;
+
+        return ptr;
+    }
+
+    void free(quint8 *ptr, qint32 pixelSize, int node) {
+        Node *n = m_nodes[qBound(0, node, m_nodes.size() - 1)];
+        n->freeBlocks[pixelSize].push(ptr);
+    }
+
+    /**
+     * Returns all the memory to the system. Must be called only
+     * when none of the blocks is used.
+     */
+    void purge() {
+        Q_FOREACH (Node *n, m_nodes) {
+            QMutexLocker l(&n->slabLock);
+
+            for (int i = 0; i <= maxPixelSize; i++) {
+                n->freeBlocks[i].clear();
+            }
+
+            Q_FOREACH (const Slab &slab, n->slabs) {
+                if (slab.isOnNode) {
+                    KisNumaTopology::instance()->freeOnNode(slab.data, slabSize);
+                } else {
+                    ::free(slab.data);
+                }
+            }
+
+            n->slabs.clear();
+            n->slabPos = 0;
+            n->slabEnd = 0;
+        }
+    }
+
+private:
+    struct Slab {
+        quint8 *data = 0;
+        bool isOnNode = true;
+    };
+
+    struct Node {
+        QMutex slabLock;
+        QVector<Slab> slabs;
+        quint8 *slabPos = 0;
+        quint8 *slabEnd = 0;
+        KisLocklessStack<quint8*> freeBlocks[maxPixelSize + 1];
+    };
+
+    QVector<Node*> m_nodes;
+};
+
+Q_GLOBAL_STATIC(NumaTileDataPool, s_numaPool)
+
+/**
+ * The policy is chosen once, since the memory allocated
+ * with one policy cannot be freed with the other one
+ */
+bool numaAwareAllocation()
+{
+    static const bool value = KisNumaTopology::instance()->isNumaAware();
+    return value;
+}
+
+}
+
 SimpleCache::~SimpleCache()
 {
     clear();
@@ -69,12 +205,13 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(pixelSize),
+      m_numaNode(currentNumaNode()),
       m_store(store)
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
     }
-    m_data = allocateData(m_pixelSize);
+    m_data = allocateData(m_pixelSize, m_numaNode);
 
     fillWithPixel(defPixel);
 }
@@ -91,24 +228,39 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
  * to disable the memory check with checkFreeMemory, otherwise, there
  * is a deadlock.
  */
-KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
+KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory, int numaNode)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(rhs.m_pixelSize),
+      m_numaNode(numaNode >= 0 ? numaNode : currentNumaNode()),
       m_store(rhs.m_store)
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
     }
-    m_data = allocateData(m_pixelSize);
+    m_data = allocateData(m_pixelSize, m_numaNode);
 
     memcpy(m_data, rhs.data(), m_pixelSize * WIDTH * HEIGHT);
 }
 
 
+KisTileData::KisTileData(qint32 pixelSize, KisTileDataStore *store)
+    : m_state(NORMAL),
+      m_mementoFlag(0),
+      m_age(0),
+      m_data(0),
+      m_usersCount(0),
+      m_refCount(0),
+      m_pixelSize(pixelSize),
+      m_numaNode(0),
+      m_store(store)
+{
+}
+
+
 KisTileData::~KisTileData()
 {
     releaseMemory();
@@ -126,7 +278,7 @@ void KisTileData::fillWithPixel(const quint8 *defPixel)
 void KisTileData::releaseMemory()
 {
     if (m_data) {
-        freeData(m_data, m_pixelSize);
+        freeData(m_data, m_pixelSize, m_numaNode);
         m_data = 0;
     }
 
@@ -141,11 +293,32 @@ void KisTileData::releaseMemory()
 void KisTileData::allocateMemory()
 {
     Q_ASSERT(!m_data);
-    m_data = allocateData(m_pixelSize);
+
+    // the data is going to be written by the current thread
+    m_numaNode = currentNumaNode();
+    m_data = allocateData(m_pixelSize, m_numaNode);
+}
+
+int KisTileData::currentNumaNode()
+{
+    return numaAwareAllocation() ? KisNumaTopology::instance()->currentNode() : 0;
+}
+
+bool KisTileData::isPooledPixelSize(const qint32 pixelSize)
+{
+    return numaAwareAllocation() ?
+        pixelSize <= NumaTileDataPool::maxPixelSize :
+        pixelSize == 4 || pixelSize == 8;
 }
 
-quint8* KisTileData::allocateData(const qint32 pixelSize)
+quint8* KisTileData::allocateData(const qint32 pixelSize, int numaNode)
 {
+    if (numaAwareAllocation()) {
+        return pixelSize <= NumaTileDataPool::maxPixelSize ?
+            s_numaPool->allocate(pixelSize, numaNode) :
+            (quint8*) malloc(pixelSize * WIDTH * HEIGHT);
+    }
+
     quint8 *ptr = 0;
 
     if (!m_cache.pop(pixelSize, ptr)) {
@@ -165,8 +338,17 @@ quint8* KisTileData::allocateData(const qint32 pixelSize)
     return ptr;
 }
 
-void KisTileData::freeData(quint8* ptr, const qint32 pixelSize)
+void KisTileData::freeData(quint8* ptr, const qint32 pixelSize, int numaNode)
 {
+    if (numaAwareAllocation()) {
+        if (pixelSize > NumaTileDataPool::maxPixelSize) {
+            free(ptr);
+        } else if (!s_numaPool.isDestroyed()) {
+            s_numaPool->free(ptr, pixelSize, numaNode);
+        }
+        return;
+    }
+
     if (!m_cache.push(pixelSize, ptr)) {
         switch (pixelSize) {
         case 4:
@@ -210,9 +392,7 @@ void KisTileData::releaseInternalPools()
             }
 
             // check if the tile data has actually been pooled
-            if (item->m_pixelSize != 4 &&
-                item->m_pixelSize != 8) {
-
+            if (!isPooledPixelSize(item->m_pixelSize)) {
                 continue;
             }
 
@@ -237,6 +417,10 @@ void KisTileData::releaseInternalPools()
             BoostPool4BPP::purge_memory();
             BoostPool8BPP::purge_memory();
 
+            if (numaAwareAllocation()) {
+                s_numaPool->purge();
+            }
+
             auto it = dataObjects.begin();
             auto chunkIt = memoryChunks.constBegin();
 
@@ -244,7 +428,7 @@ void KisTileData::releaseInternalPools()
                 KisTileData *item = *it;
                 const int chunkSize = item->m_pixelSize * WIDTH * HEIGHT;
 
-                item->m_data = allocateData(item->m_pixelSize);
+                item->m_data = allocateData(item->m_pixelSize, item->m_numaNode);
                 memcpy(item->m_data, chunkIt->data(), chunkSize);
 
                 item->m_swapLock.unlock();
@@ -44,6 +44,10 @@ inline quint32 KisTileData::pixelSize() const {
     return m_pixelSize;
 }
 
+inline int KisTileData::numaNode() const {
+    return m_numaNode;
+}
+
 inline bool KisTileData::acquire() {
     /**
      * We need to ensure the clones in the stack are
@@ -94,6 +98,13 @@ inline void KisTileData::blockSwapping() {
         m_swapLock.unlock();
         m_store->ensureTileDataLoaded(this);
     }
+
+    if (Q_UNLIKELY(m_prefetched.loadAcquire()) &&
+        m_prefetched.testAndSetOrdered(1, 0)) {
+
+        m_store->notifyPrefetchHit();
+    }
+
     resetAge();
 }
 
@@ -103,7 +103,18 @@ public:
     KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory = true);
 
 private:
-    KisTileData(const KisTileData& rhs, bool checkFreeMemory = true);
+    /**
+     * Duplicates \p rhs. The memory of the new tile data is allocated
+     * on \p numaNode, or on the node of the calling thread if it is -1.
+     */
+    KisTileData(const KisTileData& rhs, bool checkFreeMemory = true, int numaNode = -1);
+
+    /**
+     * Creates a tile data without any memory allocated. Used by
+     * KisTileDataStore for the tile data, whose content is put
+     * directly into the swap.
+     */
+    KisTileData(qint32 pixelSize, KisTileDataStore *store);
 
 public:
     ~KisTileData();
@@ -121,6 +132,13 @@ public:
     inline void setData(const quint8 *data);
     inline quint32 pixelSize() const;
 
+    /**
+     * The NUMA node the memory of the tile data has been allocated
+     * on, see KisNumaTopology. Always 0 if the NUMA-aware allocation
+     * is disabled.
+     */
+    inline int numaNode() const;
+
     /**
      * Increments usersCount of a TD and refs shared pointer counter
      * Used by KisTile for COW
@@ -223,8 +241,10 @@ public:
 private:
     void fillWithPixel(const quint8 *defPixel);
 
-    static quint8* allocateData(const qint32 pixelSize);
-    static void freeData(quint8 *ptr, const qint32 pixelSize);
+    static int currentNumaNode();
+    static bool isPooledPixelSize(const qint32 pixelSize);
+    static quint8* allocateData(const qint32 pixelSize, int numaNode);
+    static void freeData(quint8 *ptr, const qint32 pixelSize, int numaNode);
 private:
     friend class KisTileDataPooler;
     friend class KisTileDataPoolerTest;
@@ -283,6 +303,13 @@ private:
     int m_age;
 
 
+    /**
+     * Set when the tile data has been swapped in by
+     * KisTileDataPrefetcher and reset on the first access
+     * to it. Used for counting prefetch hits only.
+     */
+    QAtomicInt m_prefetched;
+
     /**
      * The primitive for controlling swapping of the tile.
      * lockForRead() - used by regular threads to ensure swapper
@@ -316,6 +343,8 @@ private:
     qint32 m_pixelSize;
     //qint32 m_timeStamp;
 
+    int m_numaNode;
+
     KisTileDataStore *m_store;
     static SimpleCache m_cache;
 
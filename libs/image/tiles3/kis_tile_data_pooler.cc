@@ -136,7 +136,12 @@ void KisTileDataPooler::cloneTileData(KisTileData *td, qint32 numClones) const
     if (numClones > 0) {
         td->blockSwapping();
         for (qint32 i = 0; i < numClones; i++) {
-            td->m_clonesStack.push(new KisTileData(*td, false));
+            /**
+             * The clone will be written by the thread doing the
+             * copy-on-write, which most probably runs on the node
+             * of the original data, not on the node of the pooler
+             */
+            td->m_clonesStack.push(new KisTileData(*td, false, td->numaNode()));
         }
         td->unblockSwapping();
     } else {
@@ -70,6 +70,7 @@ qint64 __preclone_miss_age = 0;
 KisTileDataStore::KisTileDataStore()
     : m_pooler(this),
       m_swapper(this),
+      m_prefetcher(this),
       m_numTiles(0),
       m_memoryMetric(0),
       m_counter(1),
@@ -77,12 +78,14 @@ KisTileDataStore::KisTileDataStore()
 {
     m_pooler.start();
     m_swapper.start();
+    m_prefetcher.start();
 }
 
 KisTileDataStore::~KisTileDataStore()
 {
     m_pooler.terminatePooler();
     m_swapper.terminateSwapper();
+    m_prefetcher.terminatePrefetcher();
 
     if (numTiles() > 0) {
         errKrita << "Warning: some tiles have leaked:";
@@ -118,6 +121,10 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
 
+    stats.prefetchedTiles = m_numPrefetchedTiles.loadAcquire();
+    stats.prefetchHits = m_numPrefetchHits.loadAcquire();
+    stats.swapInMisses = m_numSwapInMisses.loadAcquire();
+
     return stats;
 }
 
@@ -178,6 +185,24 @@ KisTileData *KisTileDataStore::allocTileData(qint32 pixelSize, const quint8 *def
     return td;
 }
 
+KisTileData *KisTileDataStore::createSwappedTileData(qint32 pixelSize,
+                                                     const QString &compressionName,
+                                                     const QByteArray &compressedData)
+{
+    /**
+     * The tile data is not visible to anyone yet, so we don't
+     * need to take its swap lock
+     */
+    KisTileData *td = new KisTileData(pixelSize, this);
+
+    if (!m_swappedStore.tryPutCompressedTileData(td, compressionName, compressedData)) {
+        delete td;
+        td = 0;
+    }
+
+    return td;
+}
+
 KisTileData *KisTileDataStore::duplicateTileData(KisTileData *rhs)
 {
     KisTileData *td = 0;
@@ -252,6 +277,7 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
 
             m_swappedStore.swapInTileData(td);
             registerTileDataImp(td);
+            m_numSwapInMisses.ref();
 
             td->m_swapLock.unlock();
         }
@@ -278,6 +304,7 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     if (td->data()) {
         if (m_swappedStore.trySwapOutTileData(td)) {
             unregisterTileDataImp(td);
+            td->m_prefetched = 0;
             result = true;
         }
     }
@@ -286,6 +313,31 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+bool KisTileDataStore::prefetchTileData(KisTileData *td)
+{
+    if (!m_prefetcher.canPrefetch()) return false;
+
+    /**
+     * The same locking order as in ensureTileDataLoaded()
+     */
+    m_iteratorLock.lockForWrite();
+
+    if (!td->data()) {
+        td->m_swapLock.lockForWrite();
+
+        m_swappedStore.swapInTileData(td);
+        registerTileDataImp(td);
+        td->m_prefetched = 1;
+        m_numPrefetchedTiles.ref();
+
+        td->m_swapLock.unlock();
+    }
+
+    m_iteratorLock.unlock();
+
+    return true;
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_iteratorLock.lockForWrite();
@@ -374,6 +426,7 @@ void KisTileDataStore::testingRereadConfig()
 {
     m_pooler.testingRereadConfig();
     m_swapper.testingRereadConfig();
+    m_prefetcher.testingRereadConfig();
     kickPooler();
 }
 
@@ -27,6 +27,7 @@
 
 #include "kis_tile_data_pooler.h"
 #include "swap/kis_tile_data_swapper.h"
+#include "swap/kis_tile_data_prefetcher.h"
 #include "swap/kis_swapped_data_store.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
 
@@ -54,6 +55,15 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+
+        /**
+         * The number of tiles swapped in by the prefetcher, the number of
+         * prefetched tiles that have been accessed afterwards (hits) and
+         * the number of tiles swapped in synchronously on access (misses)
+         */
+        qint64 prefetchedTiles;
+        qint64 prefetchHits;
+        qint64 swapInMisses;
     };
 
     MemoryStatistics memoryStatistics();
@@ -102,6 +112,42 @@ public:
         return allocTileData(pixelSize, defPixel);
     }
 
+    /**
+     * Creates a tile data, whose content is stored in the swap
+     * in compressed form and is decompressed on the first access.
+     * Returns null if the swap cannot accept the data.
+     *
+     * \see KisSwappedDataStore::tryPutCompressedTileData()
+     */
+    KisTileData* createSwappedTileData(qint32 pixelSize,
+                                       const QString &compressionName,
+                                       const QByteArray &compressedData);
+
+    /**
+     * Asks the prefetcher to load the swapped-out tiles of \p dm
+     * in \p rect in the background. The request is ignored if
+     * nothing is swapped out.
+     */
+    inline void requestPrefetch(KisTiledDataManager *dm, const QRect &rect)
+    {
+        if (m_swappedStore.numTiles() > 0) {
+            m_prefetcher.addRequest(dm, rect);
+        }
+    }
+
+    /**
+     * Loads the swapped-out \p td in advance. Returns false if the
+     * memory limits do not allow prefetching anymore.
+     * LOCKING: the caller must guarantee \p td is not released
+     *          during the call, see KisTile::prefetch()
+     */
+    bool prefetchTileData(KisTileData *td);
+
+    inline void notifyPrefetchHit()
+    {
+        m_numPrefetchHits.ref();
+    }
+
     // Called by The Memento Manager after every commit
     inline void kickPooler()
     {
@@ -164,6 +210,7 @@ private:
 private:
     KisTileDataPooler m_pooler;
     KisTileDataSwapper m_swapper;
+    KisTileDataPrefetcher m_prefetcher;
 
     friend class KisTileDataStoreTest;
     friend class KisTileDataPoolerTest;
@@ -178,6 +225,11 @@ private:
     QAtomicInt m_memoryMetric;
     QAtomicInt m_counter;
     QAtomicInt m_clockIndex;
+
+    QAtomicInt m_numPrefetchedTiles;
+    QAtomicInt m_numPrefetchHits;
+    QAtomicInt m_numSwapInMisses;
+
     ConcurrentMap<int, KisTileData*> m_tileDataMap;
     QReadWriteLock m_iteratorLock;
 };
@@ -52,6 +52,7 @@ public:
 
         KisTileSP tile = dm->getTile(col, row, type == WRITE);
 
+        m_dataManager = dm;
         m_tile = tile;
         m_offset = pixelIndex * dm->pixelSize();
 
@@ -71,6 +72,7 @@ public:
             m_tile->unlockForRead();
         } else {
             m_tile->unlockForWrite();
+            m_dataManager->notifyTileChanged(m_tile->col(), m_tile->row());
         }
     }
 
@@ -107,6 +109,7 @@ public:
 private:
     Q_DISABLE_COPY(KisTileDataWrapper)
 
+    KisTiledDataManager *m_dataManager;
     KisTileSP m_tile;
     qint32 m_offset;
     KisTileDataWrapper::accessType m_type;
@@ -38,6 +38,11 @@
  *   1) each hash must be unique, otherwise tiles would rewrite each-other
  *   2) 0 key is reserved, so can't be used
  *   3) col and row must be less than 0x7FFF to guarantee uniqueness of hash for each pair
+ *
+ * The read path (getExistingTile(), getReadOnlyTileLazy() and the lookup
+ * part of getTileLazy()) takes no locks at all. The tiles removed from the
+ * table and the replaced default tile data are released by the map's QSBR
+ * collector only when no reader can hold a raw pointer to them anymore.
  */
 
 template <class T>
@@ -135,6 +140,19 @@ private:
         TileType *d;
     };
 
+    struct DefaultTileDataReclaimer {
+        DefaultTileDataReclaimer(KisTileData *data) : d(data) {}
+
+        void destroy()
+        {
+            d->release();
+            delete this;
+        }
+
+    private:
+        KisTileData *d;
+    };
+
     inline quint32 calculateHash(qint32 col, qint32 row)
     {
 #ifdef SANITY_CHECK
@@ -199,14 +217,16 @@ private:
     mutable LockFreeTileMap m_map;
 
     /**
-     * We still need something to guard changes in m_defaultTileData,
-     * otherwise there will be concurrent read/writes, resulting in broken memory.
+     * The readers fetch m_defaultTileData without any locks, so it is
+     * replaced in RCU manner: the new data is published atomically and
+     * the old one is released by the garbage collector. The lock only
+     * serializes the writers.
      */
-    QReadWriteLock m_defaultPixelDataLock;
+    QMutex m_defaultTileDataWriteLock;
     mutable QReadWriteLock m_iteratorLock;
 
     QAtomicInt m_numTiles;
-    KisTileData *m_defaultTileData;
+    QAtomicPointer<KisTileData> m_defaultTileData;
     KisMementoManager *m_mementoManager;
 };
 
@@ -275,7 +295,7 @@ template <class T>
 KisTileHashTableTraits2<T>::KisTileHashTableTraits2(const KisTileHashTableTraits2<T> &ht, KisMementoManager *mm)
     : KisTileHashTableTraits2(mm)
 {
-    setDefaultTileData(ht.m_defaultTileData);
+    setDefaultTileData(ht.m_defaultTileData.loadAcquire());
 
     QWriteLocker locker(&ht.m_iteratorLock);
     typename ConcurrentMap<quint32, TileType*>::Iterator iter(ht.m_map);
@@ -330,10 +350,9 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getT
         // raw-pointer lock held
         m_map.getGC().unlockRawPointerAccess();
 
-        {
-            QReadLocker locker(&m_defaultPixelDataLock);
-            tile = new TileType(col, row, m_defaultTileData, 0);
-        }
+        KisTileData *defaultTileData = refAndFetchDefaultTileData();
+        tile = new TileType(col, row, defaultTileData, 0);
+        defaultTileData->deref();
 
         TileTypeSP::ref(&tile, tile.data());
         TileType *discardedTile = 0;
@@ -387,14 +406,25 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getR
     quint32 idx = calculateHash(col, row);
 
     m_map.getGC().lockRawPointerAccess();
-    TileTypeSP tile = m_map.get(idx);
-    m_map.getGC().unlockRawPointerAccess();
 
+    TileTypeSP tile = m_map.get(idx);
     existingTile = tile;
 
+    KisTileData *defaultTileData = 0;
     if (!existingTile) {
-        QReadLocker locker(&m_defaultPixelDataLock);
-        tile = new TileType(col, row, m_defaultTileData, 0);
+        defaultTileData = m_defaultTileData.loadAcquire();
+        defaultTileData->ref();
+    }
+
+    m_map.getGC().unlockRawPointerAccess();
+
+    /**
+     * The tile is created outside the raw-pointer section, because
+     * acquiring the tile data may free its stale clones
+     */
+    if (defaultTileData) {
+        tile = new TileType(col, row, defaultTileData, 0);
+        defaultTileData->deref();
     }
 
     m_map.getGC().update();
@@ -453,32 +483,40 @@ void KisTileHashTableTraits2<T>::clear()
 template <class T>
 inline void KisTileHashTableTraits2<T>::setDefaultTileData(KisTileData *defaultTileData)
 {
-    QWriteLocker locker(&m_defaultPixelDataLock);
+    {
+        QMutexLocker locker(&m_defaultTileDataWriteLock);
 
-    if (m_defaultTileData) {
-        m_defaultTileData->release();
-        m_defaultTileData = 0;
-    }
+        if (defaultTileData) {
+            defaultTileData->acquire();
+        }
 
-    if (defaultTileData) {
-        defaultTileData->acquire();
-        m_defaultTileData = defaultTileData;
+        KisTileData *oldTileData = m_defaultTileData.fetchAndStoreOrdered(defaultTileData);
+
+        if (oldTileData) {
+            m_map.getGC().enqueue(&DefaultTileDataReclaimer::destroy, new DefaultTileDataReclaimer(oldTileData));
+        }
     }
+
+    m_map.getGC().update();
 }
 
 template <class T>
 inline KisTileData* KisTileHashTableTraits2<T>::defaultTileData()
 {
-    QReadLocker locker(&m_defaultPixelDataLock);
-    return m_defaultTileData;
+    return m_defaultTileData.loadAcquire();
 }
 
 template <class T>
 inline KisTileData* KisTileHashTableTraits2<T>::refAndFetchDefaultTileData()
 {
-    QReadLocker locker(&m_defaultPixelDataLock);
-    m_defaultTileData->ref();
-    return m_defaultTileData;
+    m_map.getGC().lockRawPointerAccess();
+
+    KisTileData *defaultTileData = m_defaultTileData.loadAcquire();
+    defaultTileData->ref();
+
+    m_map.getGC().unlockRawPointerAccess();
+
+    return defaultTileData;
 }
 
 
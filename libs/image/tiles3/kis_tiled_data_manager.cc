@@ -18,8 +18,14 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
+
 #include <QRect>
 #include <QVector>
+#include <QVarLengthArray>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
@@ -28,6 +34,9 @@
 #include "kis_memento_manager.h"
 #include "swap/kis_legacy_tile_compressor.h"
 #include "swap/kis_tile_compressor_factory.h"
+#include "swap/kis_compression_factory.h"
+#include "swap/kis_tile_compressor_2.h"
+#include "kis_image_config.h"
 
 #include "kis_paint_device_writer.h"
 
@@ -107,6 +116,8 @@ void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
     m_mementoManager->setDefaultTileData(td);
 
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
+
+    notifyAllTilesChanged();
 }
 
 bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
@@ -115,33 +126,165 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
 
     bool retval = true;
 
-    if(CURRENT_VERSION == LEGACY_VERSION) {
+    /**
+     * Tiles compressed with LZF are still saved as version 2,
+     * so that the documents could be opened by older versions
+     * of Krita
+     */
+    const QString compressionName = KisImageConfig(true).documentTileCompression();
+    const qint32 version =
+        compressionName == KisCompressionFactory::LZF ? CURRENT_VERSION : CODEC_VERSION;
+
+    if(version == LEGACY_VERSION) {
         char str[80];
         sprintf(str, "%d\n", m_hashTable->numTiles());
         retval = store.write(str, strlen(str));
     }
     else {
-        retval = writeTilesHeader(store, m_hashTable->numTiles());
+        retval = writeTilesHeader(store, m_hashTable->numTiles(), version);
     }
 
 
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
+
     KisTileHashTableConstIterator iter(m_hashTable);
     KisTileSP tile;
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
-
     while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
-        }
+        tiles.append(tile);
         iter.next();
     }
 
+    if (retval) {
+        retval = writeTiles(store, tiles, version, compressionName);
+    }
+
     return retval;
 }
+
+namespace {
+
+/**
+ * Collects the compressed tiles in memory, so that
+ * they could be written into the real store later
+ */
+class KisBufferPaintDeviceWriter : public KisPaintDeviceWriter
+{
+public:
+    KisBufferPaintDeviceWriter(QByteArray *buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    bool write(const QByteArray &data) override {
+        m_buffer->append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_buffer->append(data, length);
+        return true;
+    }
+
+private:
+    QByteArray *m_buffer;
+};
+
+struct TileCompressionJob
+{
+    QVector<KisTileSP>::const_iterator begin;
+    QVector<KisTileSP>::const_iterator end;
+    QByteArray result;
+    bool success = true;
+};
+
+}
+
+bool KisTiledDataManager::writeTiles(KisPaintDeviceWriter &store,
+                                     const QVector<KisTileSP> &tiles,
+                                     qint32 version,
+                                     const QString &compressionName)
+{
+    /**
+     * Small devices are not worth the threading overhead
+     */
+    const int minTilesForParallelWrite = 64;
+
+    /**
+     * The number of tiles compressed by a single job. Every job
+     * creates its own compressor, so it should not be too small.
+     */
+    const int tilesPerJob = 32;
+
+    const int numThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+    if (numThreads <= 1 ||
+        tiles.size() < minTilesForParallelWrite ||
+        version == LEGACY_VERSION) {
+
+        KisAbstractTileCompressorSP compressor =
+            KisTileCompressorFactory::create(version, compressionName);
+
+        Q_FOREACH (KisTileSP tile, tiles) {
+            if (!compressor->writeTile(tile, store)) {
+                warnFile << "Failed to write tile";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * The tiles are compressed by the worker threads in batches,
+     * and only the final write into the store is serialized. The
+     * size of the batch limits the amount of memory occupied by
+     * compressed data waiting to be written. The order of the tiles
+     * in the stream is preserved, so the result is byte-exact to
+     * the one produced by the serial code.
+     */
+    const int jobsPerBatch = 2 * numThreads;
+    const int tilesPerBatch = jobsPerBatch * tilesPerJob;
+
+    for (auto batchBegin = tiles.constBegin(); batchBegin != tiles.constEnd();) {
+        const auto batchEnd = batchBegin + qMin(tilesPerBatch, int(tiles.constEnd() - batchBegin));
+
+        QVector<TileCompressionJob> jobs;
+        for (auto it = batchBegin; it != batchEnd;) {
+            TileCompressionJob job;
+            job.begin = it;
+            job.end = it + qMin(tilesPerJob, int(batchEnd - it));
+            jobs.append(job);
+            it = job.end;
+        }
+
+        QtConcurrent::blockingMap(jobs,
+            [version, compressionName] (TileCompressionJob &job) {
+                KisAbstractTileCompressorSP compressor =
+                    KisTileCompressorFactory::create(version, compressionName);
+                KisBufferPaintDeviceWriter writer(&job.result);
+
+                for (auto it = job.begin; it != job.end; ++it) {
+                    if (!compressor->writeTile(*it, writer)) {
+                        job.success = false;
+                        break;
+                    }
+                }
+            });
+
+        Q_FOREACH (const TileCompressionJob &job, jobs) {
+            if (!job.success || !store.write(job.result)) {
+                warnFile << "Failed to write tile";
+                return false;
+            }
+        }
+
+        batchBegin = batchEnd;
+    }
+
+    return true;
+}
 bool KisTiledDataManager::read(QIODevice *stream)
 {
     clear();
@@ -176,21 +319,192 @@ bool KisTiledDataManager::read(QIODevice *stream)
         numTiles = line.toUInt();
     }
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(tilesVersion);
+    bool readSuccess = readTiles(stream, numTiles, tilesVersion);
+    notifyAllTilesChanged();
+
+    m_mementoManager->commit();
+    return readSuccess;
+}
+
+namespace {
+
+struct TileDecompressionJob
+{
+    QVector<KisTileCompressor2::TileRecord> records;
+    QVector<KisTileSP> tiles;
+    bool success = true;
+};
+
+}
+
+bool KisTiledDataManager::readTiles(QIODevice *stream, quint32 numTiles, qint32 version)
+{
+    const quint32 minTilesForParallelRead = 64;
+    const int tilesPerJob = 32;
+
+    const qint64 lazyLoadingThreshold =
+        qint64(KisImageConfig(true).lazyTileLoadingThreshold()) << 20;
+
+    if (version != LEGACY_VERSION &&
+        lazyLoadingThreshold > 0 &&
+        qint64(numTiles) * pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT > lazyLoadingThreshold) {
+
+        return readTilesLazily(stream, numTiles);
+    }
+
+    const int numThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+    if (numThreads <= 1 ||
+        numTiles < minTilesForParallelRead ||
+        version == LEGACY_VERSION) {
+
+        KisAbstractTileCompressorSP compressor =
+            KisTileCompressorFactory::create(version);
+
+        bool readSuccess = true;
+        for (quint32 i = 0; i < numTiles; i++) {
+            if (!compressor->readTile(stream, this)) {
+                readSuccess = false;
+            }
+        }
+
+        return readSuccess;
+    }
+
+    /**
+     * The compressed tiles are read from the stream sequentially,
+     * but decompressed by the worker threads in batches. The tiles
+     * themselves are created in the calling thread, so the hash
+     * table is not touched concurrently. If the stream has the same
+     * tile twice, the batch is flushed before accepting the second
+     * copy, so the result is the same as with the serial reading.
+     */
+    const int jobsPerBatch = 2 * numThreads;
+    const int tilesPerBatch = jobsPerBatch * tilesPerJob;
+
+    KisTileCompressor2 parser;
+    bool readSuccess = true;
+
+    QVector<TileDecompressionJob> jobs;
+    QSet<KisTile*> batchTiles;
+    int tilesInBatch = 0;
+
+    auto processBatch = [&] () {
+        QtConcurrent::blockingMap(jobs,
+            [] (TileDecompressionJob &job) {
+                KisTileCompressor2 compressor;
+
+                for (int i = 0; i < job.records.size(); i++) {
+                    KisTileSP tile = job.tiles[i];
+
+                    tile->lockForWrite();
+                    job.success &= compressor.decompressTileRecord(job.records[i], tile->tileData());
+                    tile->unlockForWrite();
+                }
+            });
+
+        Q_FOREACH (const TileDecompressionJob &job, jobs) {
+            readSuccess &= job.success;
+        }
+
+        jobs.clear();
+        batchTiles.clear();
+        tilesInBatch = 0;
+    };
+
+    for (quint32 i = 0; i < numTiles; i++) {
+        KisTileCompressor2::TileRecord record;
+
+        if (!parser.readTileRecord(stream, pixelSize(), &record)) {
+            readSuccess = false;
+            continue;
+        }
+
+        KisTileSP tile = getTile(xToCol(record.x), yToRow(record.y), true);
+
+        if (batchTiles.contains(tile.data()) || tilesInBatch >= tilesPerBatch) {
+            processBatch();
+        }
+
+        if (jobs.isEmpty() || jobs.last().records.size() >= tilesPerJob) {
+            jobs.append(TileDecompressionJob());
+        }
+
+        jobs.last().records.append(record);
+        jobs.last().tiles.append(tile);
+        batchTiles.insert(tile.data());
+        tilesInBatch++;
+    }
+
+    processBatch();
+
+    return readSuccess;
+}
 
+bool KisTiledDataManager::readTilesLazily(QIODevice *stream, quint32 numTiles)
+{
+    /**
+     * The tiles are not decompressed on loading. Their compressed
+     * data is put directly into the swap and the tile data objects
+     * are created in the swapped-out state, so the data is
+     * decompressed by KisTileDataStore on the first access only. If
+     * the swap cannot accept a tile, it is decompressed right away.
+     */
+    KisTileDataStore *tileDataStore = KisTileDataStore::instance();
+    KisTileCompressor2 compressor;
     bool readSuccess = true;
+
     for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
+        KisTileCompressor2::TileRecord record;
+
+        if (!compressor.readTileRecord(stream, pixelSize(), &record)) {
             readSuccess = false;
+            continue;
+        }
+
+        const qint32 col = xToCol(record.x);
+        const qint32 row = yToRow(record.y);
+
+        KisTileData *td = 0;
+        if (KisCompressionFactory::isAvailable(record.compressionName)) {
+            td = tileDataStore->createSwappedTileData(pixelSize(),
+                                                      record.compressionName,
+                                                      record.data);
+        }
+
+        if (!td) {
+            KisTileSP tile = getTile(col, row, true);
+
+            tile->lockForWrite();
+            readSuccess &= compressor.decompressTileRecord(record, tile->tileData());
+            tile->unlockForWrite();
+            continue;
+        }
+
+        /**
+         * The tile is replaced the same way clear() and bitBlt() replace
+         * whole tiles. The deleted tile is reported to the memento manager
+         * in deleteTile() and the new one in the constructor of KisTile,
+         * just like a tile created by getTile() is reported when it is
+         * attached to the hash table. The memento keeps a reference to the
+         * swapped-out tile data, and the data is swapped in by the regular
+         * blockSwapping() path before it is read, written or duplicated by
+         * COW, so both undo and swapping treat it as any other tile.
+         */
+        const bool wasDeleted = m_hashTable->deleteTile(col, row);
+
+        KisTileSP tile = KisTileSP(new KisTile(col, row, td, m_mementoManager));
+        m_hashTable->addTile(tile);
+
+        if (!wasDeleted) {
+            m_extentManager.notifyTileAdded(col, row);
         }
     }
 
-    m_mementoManager->commit();
     return readSuccess;
 }
 
-bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles)
+bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles, qint32 version)
 {
     QString buffer;
 
@@ -199,7 +513,7 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
                      "TILEHEIGHT %3\n"
                      "PIXELSIZE %4\n"
                      "DATA %5\n")
-        .arg(CURRENT_VERSION)
+        .arg(version)
         .arg(KisTileData::WIDTH)
         .arg(KisTileData::HEIGHT)
         .arg(pixelSize())
@@ -301,6 +615,7 @@ void KisTiledDataManager::purge(const QRect& area)
     Q_FOREACH (KisTileSP tile, tilesToDelete) {
         if (m_hashTable->deleteTile(tile)) {
             m_extentManager.notifyTileRemoved(tile->col(), tile->row());
+            notifyTileChanged(tile->col(), tile->row());
         }
     }
 }
@@ -386,6 +701,8 @@ void KisTiledDataManager::clear(QRect clearRect, const quint8 *clearPixel)
                      m_hashTable->addTile(clearedTile);
                      m_extentManager.notifyTileAdded(column, row);
                  }
+
+                 notifyTileChanged(column, row);
             } else {
                 const qint32 lineSize = clearTileRect.width() * pixelSize;
                 qint32 rowsRemaining = clearTileRect.height();
@@ -438,6 +755,7 @@ void KisTiledDataManager::clear()
 {
     m_hashTable->clear();
     m_extentManager.clear();
+    notifyAllTilesChanged();
 }
 
 
@@ -492,6 +810,8 @@ void KisTiledDataManager::bitBltImpl(KisTiledDataManager *srcDM, const QRect &re
                      m_extentManager.notifyTileRemoved(column, row);
                  }
 
+                 notifyTileChanged(column, row);
+
             } else {
                 const qint32 lineSize = cloneTileRect.width() * pixelSize;
                 qint32 rowsRemaining = cloneTileRect.height();
@@ -565,6 +885,8 @@ void KisTiledDataManager::bitBltRoughImpl(KisTiledDataManager *srcDM, const QRec
             } else if (wasDeleted) {
                 m_extentManager.notifyTileRemoved(column, row);
             }
+
+            notifyTileChanged(column, row);
         }
     }
 }
@@ -635,9 +957,11 @@ void KisTiledDataManager::setExtent(QRect newRect)
                     }
                 }
                 tile->unlockForWrite();
+                notifyTileChanged(tile->col(), tile->row());
                 iter.next();
             } else {
                 m_extentManager.notifyTileRemoved(tile->col(), tile->row());
+                notifyTileChanged(tile->col(), tile->row());
                 iter.deleteCurrent();
             }
         }
@@ -667,6 +991,29 @@ void KisTiledDataManager::extent(qint32 &x, qint32 &y, qint32 &w, qint32 &h) con
     rect.getRect(&x, &y, &w, &h);
 }
 
+void KisTiledDataManager::prefetchTiles(const QRect &rect)
+{
+    QReadLocker locker(&m_lock);
+
+    const QRect prefetchRect = rect & m_extentManager.extent();
+    if (prefetchRect.isEmpty()) return;
+
+    const qint32 firstColumn = xToCol(prefetchRect.left());
+    const qint32 lastColumn = xToCol(prefetchRect.right());
+    const qint32 firstRow = yToRow(prefetchRect.top());
+    const qint32 lastRow = yToRow(prefetchRect.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; row++) {
+        for (qint32 column = firstColumn; column <= lastColumn; column++) {
+            KisTileSP tile = m_hashTable->getExistingTile(column, row);
+
+            if (tile && !tile->prefetch()) {
+                return;
+            }
+        }
+    }
+}
+
 QRect KisTiledDataManager::extent() const
 {
     return m_extentManager.extent();
@@ -687,6 +1034,108 @@ KisRegion KisTiledDataManager::region() const
     return KisRegion(std::move(rects));
 }
 
+void KisTiledDataManager::setDirtyTilesTrackingEnabled(bool value)
+{
+    QMutexLocker locker(&m_dirtyTilesLock);
+
+    m_dirtyTilesTrackingEnabled = value;
+    m_dirtyTiles.clear();
+
+    // the changes made before enabling are unknown
+    m_allTilesDirty = value;
+}
+
+QVector<QRect> KisTiledDataManager::takeDirtyTiles(bool *allTilesDirty)
+{
+    QMutexLocker locker(&m_dirtyTilesLock);
+
+    QVector<QRect> rects;
+    rects.reserve(m_dirtyTiles.size());
+
+    Q_FOREACH (quint64 key, m_dirtyTiles) {
+        const qint32 col = qint32(key >> 32);
+        const qint32 row = qint32(key & 0xFFFFFFFF);
+
+        rects.append(QRect(col * KisTileData::WIDTH, row * KisTileData::HEIGHT,
+                           KisTileData::WIDTH, KisTileData::HEIGHT));
+    }
+
+    *allTilesDirty = m_allTilesDirty;
+
+    m_dirtyTiles.clear();
+    m_allTilesDirty = false;
+
+    return rects;
+}
+
+void KisTiledDataManager::addDirtyTile(qint32 col, qint32 row)
+{
+    QMutexLocker locker(&m_dirtyTilesLock);
+    m_dirtyTiles.insert((quint64(quint32(col)) << 32) | quint64(quint32(row)));
+}
+
+void KisTiledDataManager::notifyAllTilesChanged()
+{
+    if (!m_dirtyTilesTrackingEnabled.load(std::memory_order_relaxed)) return;
+
+    QMutexLocker locker(&m_dirtyTilesLock);
+    m_dirtyTiles.clear();
+    m_allTilesDirty = true;
+}
+
+int KisTiledDataManager::dominantNumaNode(const QRect &rect) const
+{
+    if (rect.isEmpty()) return -1;
+
+    /**
+     * The function is called by the scheduler for every merge job,
+     * so only a few tiles of the rect are sampled: at most
+     * samplesPerSide x samplesPerSide tiles, spread evenly.
+     */
+    const int samplesPerSide = 3;
+
+    QVarLengthArray<int, 8> tilesPerNode;
+
+    const qint32 firstColumn = xToCol(rect.left());
+    const qint32 lastColumn = xToCol(rect.right());
+    const qint32 firstRow = yToRow(rect.top());
+    const qint32 lastRow = yToRow(rect.bottom());
+
+    auto sampleStep = [samplesPerSide] (qint32 range) {
+        return qMax(1, (range + samplesPerSide - 2) / (samplesPerSide - 1));
+    };
+
+    const qint32 columnStep = sampleStep(lastColumn - firstColumn);
+    const qint32 rowStep = sampleStep(lastRow - firstRow);
+
+    for (qint32 row = firstRow; row <= lastRow; row += rowStep) {
+        for (qint32 column = firstColumn; column <= lastColumn; column += columnStep) {
+            KisTileSP tile = m_hashTable->getExistingTile(column, row);
+            if (!tile) continue;
+
+            const int node = tile->tileData()->numaNode();
+            if (node >= tilesPerNode.size()) {
+                const int oldSize = tilesPerNode.size();
+                tilesPerNode.resize(node + 1);
+                std::fill(tilesPerNode.begin() + oldSize, tilesPerNode.end(), 0);
+            }
+
+            tilesPerNode[node]++;
+        }
+    }
+
+    int bestNode = -1;
+    for (int node = 0; node < tilesPerNode.size(); node++) {
+        if (tilesPerNode[node] > 0 &&
+            (bestNode < 0 || tilesPerNode[node] > tilesPerNode[bestNode])) {
+
+            bestNode = node;
+        }
+    }
+
+    return bestNode;
+}
+
 void KisTiledDataManager::setPixel(qint32 x, qint32 y, const quint8 * data)
 {
     KisTileDataWrapper tw(this, x, y, KisTileDataWrapper::WRITE);
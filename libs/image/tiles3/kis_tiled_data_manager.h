@@ -20,9 +20,13 @@
 #define KIS_TILEDDATAMANAGER_H_
 
 #include <QtGlobal>
+#include <QMutex>
+#include <QSet>
 #include <QVector>
 #include <KisRegion.h>
 
+#include <atomic>
+
 #include <kis_shared.h>
 #include <kis_shared_ptr.h>
 #include "config-hash-table-implementation.h"
@@ -69,6 +73,7 @@ class KRITAIMAGE_EXPORT KisTiledDataManager : public KisShared
 private:
     static const qint32 LEGACY_VERSION = 1;
     static const qint32 CURRENT_VERSION = 2;
+    static const qint32 CODEC_VERSION = 3;
 
 protected:
     /*FIXME:*/
@@ -174,6 +179,7 @@ public:
             setDefaultPixelImpl(defaultPixel);
         }
         recalculateExtent();
+        notifyAllTilesChanged();
     }
     void rollforward(KisMementoSP memento) {
         commit();
@@ -185,6 +191,7 @@ public:
             setDefaultPixelImpl(defaultPixel);
         }
         recalculateExtent();
+        notifyAllTilesChanged();
     }
     bool hasCurrentMemento() const {
         return m_mementoManager->hasCurrentMemento();
@@ -204,6 +211,13 @@ public:
 
     static void releaseInternalPools();
 
+    /**
+     * Loads the swapped-out tiles in \p rect into memory in advance.
+     * The call is synchronous, use KisTileDataStore::requestPrefetch()
+     * for doing that in the background.
+     */
+    void prefetchTiles(const QRect &rect);
+
 protected:
     /**
      * Reads and writes the tiles 
@@ -228,6 +242,41 @@ public:
 
     KisRegion region() const;
 
+    /**
+     * Enables recording of the tiles changed in the data manager, see
+     * takeDirtyTiles(). The recording takes a lock for every written
+     * tile, so it is disabled by default.
+     */
+    void setDirtyTilesTrackingEnabled(bool value);
+
+    /**
+     * Returns the extents of the tiles that have been written, added or
+     * removed since the previous call and clears the record. A written
+     * tile is recorded when its write lock is released. If the data
+     * manager has been changed in a way that is not recorded per tile
+     * (undo, reading, changing of the default pixel), \p allTilesDirty
+     * is set to true.
+     */
+    QVector<QRect> takeDirtyTiles(bool *allTilesDirty);
+
+    /**
+     * Called by the iterators and KisTileDataWrapper when they have
+     * finished writing into the tile
+     */
+    inline void notifyTileChanged(qint32 col, qint32 row) {
+        if (m_dirtyTilesTrackingEnabled.load(std::memory_order_relaxed)) {
+            addDirtyTile(col, row);
+        }
+    }
+
+    /**
+     * Returns the NUMA node owning most of the existing tiles of \p rect,
+     * or -1 if there are no tiles in the rect, see KisNumaTopology. Only
+     * a few tiles spread over the rect are checked, so the call is cheap
+     * even for huge rects.
+     */
+    int dominantNumaNode(const QRect &rect) const;
+
     void clear(QRect clearRect, quint8 clearValue);
     void clear(QRect clearRect, const quint8 *clearPixel);
     void clear(qint32 x, qint32 y, qint32 w, qint32 h, quint8 clearValue);
@@ -350,6 +399,11 @@ private:
     qint32 m_pixelSize;
     KisTiledExtentManager m_extentManager;
 
+    std::atomic<bool> m_dirtyTilesTrackingEnabled {false};
+    QMutex m_dirtyTilesLock;
+    QSet<quint64> m_dirtyTiles;
+    bool m_allTilesDirty = false;
+
     mutable QReadWriteLock m_lock;
 
 private:
@@ -363,13 +417,20 @@ private:
 private:
     void setDefaultPixelImpl(const quint8 *defPixel);
 
-    bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
+    bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles, qint32 version);
+    bool writeTiles(KisPaintDeviceWriter &store, const QVector<KisTileSP> &tiles,
+                    qint32 version, const QString &compressionName);
     bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
+    bool readTiles(QIODevice *stream, quint32 numTiles, qint32 version);
+    bool readTilesLazily(QIODevice *stream, quint32 numTiles);
 
     qint32 divideRoundDown(qint32 x, const qint32 y) const;
 
     void recalculateExtent();
 
+    void addDirtyTile(qint32 col, qint32 row);
+    void notifyAllTilesChanged();
+
     quint8* duplicatePixel(qint32 num, const quint8 *pixel);
 
     template<bool useOldSrcData>
@@ -39,7 +39,8 @@ public:
      * \param input the input
      * \param inputLength the input length
      * \param output the output
-     * \param outputLength is not used!
+     * \param outputLength the size of the output buffer, LZF codec
+     * doesn't use it, but other codecs may rely on it
      * \return number of bytes written to the output buffer
      * and 0 if error occurred.
      *
@@ -53,7 +54,8 @@ public:
      * \param input the input
      * \param inputLength the input length
      * \param output the output
-     * \param outputLength is not used!
+     * \param outputLength the size of the output buffer, LZF codec
+     * doesn't use it, but other codecs may rely on it
      * \return number of bytes written to the output buffer
      * and 0 if error occurred.
      */
@@ -0,0 +1,37 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_ABSTRACT_SWAP_SPACE_H
+#define __KIS_ABSTRACT_SWAP_SPACE_H
+
+#include "kis_chunk_allocator.h"
+
+/**
+ * Base class for the backends of KisSwappedDataStore. A backend
+ * gives access to the chunks of the swap file, allocated by
+ * KisChunkAllocator.
+ *
+ * The returned pointers stay valid only until the next request
+ * to the backend.
+ */
+class KRITAIMAGE_EXPORT KisAbstractSwapSpace
+{
+public:
+    virtual ~KisAbstractSwapSpace() {}
+
+    inline quint8* getReadChunkPtr(KisChunk readChunk) {
+        return getReadChunkPtr(readChunk.data());
+    }
+
+    inline quint8* getWriteChunkPtr(KisChunk writeChunk) {
+        return getWriteChunkPtr(writeChunk.data());
+    }
+
+    virtual quint8* getReadChunkPtr(const KisChunkData &readChunk) = 0;
+    virtual quint8* getWriteChunkPtr(const KisChunkData &writeChunk) = 0;
+};
+
+#endif /* __KIS_ABSTRACT_SWAP_SPACE_H */
@@ -0,0 +1,75 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "kis_compression_factory.h"
+
+#include "config-compression.h"
+
+#include "kis_lzf_compression.h"
+
+#ifdef HAVE_LZ4
+#include "kis_lz4_compression.h"
+#endif
+
+#ifdef HAVE_ZSTD
+#include "kis_zstd_compression.h"
+#endif
+
+
+const QString KisCompressionFactory::LZF = "LZF";
+const QString KisCompressionFactory::LZ4 = "LZ4";
+const QString KisCompressionFactory::ZSTD = "ZSTD";
+
+KisAbstractCompression* KisCompressionFactory::create(const QString &id)
+{
+    if (id == LZF) {
+        return new KisLzfCompression();
+    }
+
+#ifdef HAVE_LZ4
+    if (id == LZ4) {
+        return new KisLz4Compression();
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    if (id == ZSTD) {
+        return new KisZstdCompression();
+    }
+#endif
+
+    return 0;
+}
+
+bool KisCompressionFactory::isAvailable(const QString &id)
+{
+    return availableCompressions().contains(id);
+}
+
+QStringList KisCompressionFactory::availableCompressions()
+{
+    QStringList result;
+    result << LZF;
+
+#ifdef HAVE_LZ4
+    result << LZ4;
+#endif
+
+#ifdef HAVE_ZSTD
+    result << ZSTD;
+#endif
+
+    return result;
+}
+
+QString KisCompressionFactory::defaultSwapCompression()
+{
+#ifdef HAVE_LZ4
+    return LZ4;
+#else
+    return LZF;
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_COMPRESSION_FACTORY_H
+#define __KIS_COMPRESSION_FACTORY_H
+
+#include "kritaimage_export.h"
+#include <QStringList>
+
+class KisAbstractCompression;
+
+/**
+ * A registry of the compression codecs that can be used for
+ * compressing tiles in the swap file and in .kra documents.
+ *
+ * The codecs are identified by short (not longer than 5 symbols)
+ * names, which are stored in the header of every compressed tile,
+ * so the names must never be changed. LZF is always available,
+ * the other codecs are present only if Krita has been built
+ * with the corresponding library.
+ */
+class KRITAIMAGE_EXPORT KisCompressionFactory
+{
+public:
+    static const QString LZF;
+    static const QString LZ4;
+    static const QString ZSTD;
+
+    /**
+     * Creates a new codec object. The caller takes the ownership
+     * of the object. Returns null if the codec \p id is not
+     * supported by this build.
+     */
+    static KisAbstractCompression* create(const QString &id);
+
+    static bool isAvailable(const QString &id);
+
+    /**
+     * The list of the codec ids supported by this build, LZF
+     * is always the first item of the list
+     */
+    static QStringList availableCompressions();
+
+    /**
+     * The fastest codec available, used for the swap file
+     */
+    static QString defaultSwapCompression();
+
+private:
+    KisCompressionFactory();
+};
+
+#endif /* __KIS_COMPRESSION_FACTORY_H */
@@ -0,0 +1,154 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "kis_debug.h"
+#include "kis_mapped_swap_space.h"
+
+#include <QDir>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define SWP_PREFIX "KRITA_SWAP_FILE_XXXXXX"
+#define MIN_MAPPING_SIZE (64*MiB)
+
+
+KisMappedSwapSpace::KisMappedSwapSpace(const QString &swapDir, quint64 prefetchSize)
+    : m_valid(true),
+      m_mapping(0),
+      m_mappingSize(0),
+      m_prefetchSize(prefetchSize),
+      m_pageSize(4096),
+      m_prefetchedBegin(0),
+      m_prefetchedEnd(0)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(!swapDir.isEmpty());
+
+#ifdef Q_OS_UNIX
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0) {
+        m_pageSize = pageSize;
+    }
+#endif
+
+    QDir d(swapDir);
+    if (!d.exists()) {
+        m_valid = d.mkpath(swapDir);
+    }
+
+    const QString swapFileTemplate = swapDir + '/' + SWP_PREFIX;
+
+    if (m_valid) {
+        m_file.setFileTemplate(swapFileTemplate);
+        bool res = m_file.open();
+        if (!res || m_file.fileName().isEmpty()) {
+            m_valid = false;
+        }
+    }
+
+    if (!m_valid) {
+        qWarning() << "Could not create or open swapfile; disabling swapfile" << swapFileTemplate;
+    }
+}
+
+KisMappedSwapSpace::~KisMappedSwapSpace()
+{
+    if (m_mapping) {
+        m_file.unmap(m_mapping);
+    }
+}
+
+quint8* KisMappedSwapSpace::getReadChunkPtr(const KisChunkData &readChunk)
+{
+    if (!ensureMapped(readChunk)) {
+        return nullptr;
+    }
+
+    prefetch(readChunk);
+
+    return m_mapping + readChunk.m_begin;
+}
+
+quint8* KisMappedSwapSpace::getWriteChunkPtr(const KisChunkData &writeChunk)
+{
+    if (!ensureMapped(writeChunk)) {
+        return nullptr;
+    }
+
+    return m_mapping + writeChunk.m_begin;
+}
+
+bool KisMappedSwapSpace::ensureMapped(const KisChunkData &chunk)
+{
+    if (m_mapping && chunk.m_end < m_mappingSize) return true;
+    if (!m_valid) return false;
+
+    quint64 newSize = qMax(2 * m_mappingSize, quint64(MIN_MAPPING_SIZE));
+    while (newSize <= chunk.m_end) {
+        newSize *= 2;
+    }
+
+    if (m_mapping) {
+        m_file.unmap(m_mapping);
+        m_mapping = 0;
+        m_mappingSize = 0;
+    }
+
+    if (!m_file.resize(newSize)) {
+        warnKrita << "KisMappedSwapSpace: failed to resize the swap file to" << newSize;
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    // A workaround for https://bugreports.qt-project.org/browse/QTBUG-6330
+    m_file.exists();
+#endif
+
+    m_mapping = m_file.map(0, newSize);
+    if (!m_mapping) {
+        warnKrita << "KisMappedSwapSpace: failed to map the swap file of size" << newSize;
+        return false;
+    }
+
+    m_mappingSize = newSize;
+    m_prefetchedBegin = m_prefetchedEnd = 0;
+
+#if defined(Q_OS_UNIX) && defined(MADV_HUGEPAGE)
+    // just a hint, the system is free to ignore it
+    madvise(m_mapping, m_mappingSize, MADV_HUGEPAGE);
+#endif
+
+    return true;
+}
+
+void KisMappedSwapSpace::prefetch(const KisChunkData &chunk)
+{
+#if defined(Q_OS_UNIX) && defined(MADV_WILLNEED)
+    if (!m_prefetchSize) return;
+
+    /**
+     * Don't bother the kernel if the chunk has already been
+     * covered by the previous prefetch request
+     */
+    if (chunk.m_begin >= m_prefetchedBegin && chunk.m_end < m_prefetchedEnd) return;
+
+    const quint64 halfSize = m_prefetchSize / 2;
+
+    quint64 begin = chunk.m_begin > halfSize ? chunk.m_begin - halfSize : 0;
+    begin &= ~(m_pageSize - 1);
+
+    const quint64 end = qMin(chunk.m_end + 1 + halfSize, m_mappingSize);
+
+    if (!madvise(m_mapping + begin, end - begin, MADV_WILLNEED)) {
+        m_prefetchedBegin = begin;
+        m_prefetchedEnd = end;
+    }
+#else
+    Q_UNUSED(chunk);
+#endif
+}
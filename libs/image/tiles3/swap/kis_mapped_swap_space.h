@@ -0,0 +1,65 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_MAPPED_SWAP_SPACE_H
+#define __KIS_MAPPED_SWAP_SPACE_H
+
+#include <QTemporaryFile>
+
+#include "kis_abstract_swap_space.h"
+
+
+#define DEFAULT_PREFETCH_SIZE (4*MiB)
+
+/**
+ * A backend of KisSwappedDataStore that maps the whole swap file
+ * at once, so the tiles are paged in by the system directly, without
+ * moving the mapping windows over the file.
+ *
+ * When a chunk is read, the neighbouring part of the file is
+ * prefetched with madvise(MADV_WILLNEED), because the tiles swapped
+ * out together usually lie close to each other on the canvas. Where
+ * supported, the mapping is also marked as eligible for huge pages.
+ *
+ * The file grows geometrically and is remapped when a chunk doesn't
+ * fit into it.
+ */
+class KRITAIMAGE_EXPORT KisMappedSwapSpace : public KisAbstractSwapSpace
+{
+public:
+    /**
+     * @param swapDir If the dir doesn't exist, it'll be created
+     * @param prefetchSize the size of the area around the read chunk
+     *        that is prefetched from the swap file
+     */
+    KisMappedSwapSpace(const QString &swapDir, quint64 prefetchSize = DEFAULT_PREFETCH_SIZE);
+    ~KisMappedSwapSpace() override;
+
+    quint8* getReadChunkPtr(const KisChunkData &readChunk) override;
+    quint8* getWriteChunkPtr(const KisChunkData &writeChunk) override;
+
+    using KisAbstractSwapSpace::getReadChunkPtr;
+    using KisAbstractSwapSpace::getWriteChunkPtr;
+
+private:
+    bool ensureMapped(const KisChunkData &chunk);
+    void prefetch(const KisChunkData &chunk);
+
+private:
+    QTemporaryFile m_file;
+    bool m_valid;
+
+    quint8 *m_mapping;
+    quint64 m_mappingSize;
+
+    const quint64 m_prefetchSize;
+    quint64 m_pageSize;
+
+    quint64 m_prefetchedBegin;
+    quint64 m_prefetchedEnd;
+};
+
+#endif /* __KIS_MAPPED_SWAP_SPACE_H */
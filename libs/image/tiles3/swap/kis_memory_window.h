@@ -21,12 +21,17 @@
 
 #include <QTemporaryFile>
 
-#include "kis_chunk_allocator.h"
+#include "kis_abstract_swap_space.h"
 
 
 #define DEFAULT_WINDOW_SIZE (16*MiB)
 
-class KRITAIMAGE_EXPORT KisMemoryWindow
+/**
+ * The default backend of KisSwappedDataStore. It maps two small
+ * windows of the swap file (one for reading and one for writing)
+ * and moves them over the file when needed.
+ */
+class KRITAIMAGE_EXPORT KisMemoryWindow : public KisAbstractSwapSpace
 {
 public:
     /**
@@ -34,7 +39,7 @@ public:
      * @param writeWindowSize write window size.
      */
     KisMemoryWindow(const QString &swapDir, quint64 writeWindowSize = DEFAULT_WINDOW_SIZE);
-    ~KisMemoryWindow();
+    ~KisMemoryWindow() override;
 
     inline quint8* getReadChunkPtr(KisChunk readChunk) {
         return getReadChunkPtr(readChunk.data());
@@ -44,8 +49,8 @@ public:
         return getWriteChunkPtr(writeChunk.data());
     }
 
-    quint8* getReadChunkPtr(const KisChunkData &readChunk);
-    quint8* getWriteChunkPtr(const KisChunkData &writeChunk);
+    quint8* getReadChunkPtr(const KisChunkData &readChunk) override;
+    quint8* getWriteChunkPtr(const KisChunkData &writeChunk) override;
 
 private:
     struct MappingWindow {
@@ -19,6 +19,7 @@
 //#include "kis_debug.h"
 #include "kis_swapped_data_store.h"
 #include "kis_memory_window.h"
+#include "kis_mapped_swap_space.h"
 #include "kis_image_config.h"
 
 #include "kis_tile_compressor_2.h"
@@ -34,10 +35,14 @@ KisSwappedDataStore::KisSwappedDataStore()
     const quint64 swapWindowSize = config.swapWindowSize() * MiB;
 
     m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
-    m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
-    // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    if (config.useMappedSwapFile()) {
+        m_swapSpace = new KisMappedSwapSpace(config.swapDir(), swapWindowSize / 4);
+    } else {
+        m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
+    }
+
+    m_compressor = new KisTileCompressor2(config.swapTileCompression());
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
@@ -89,6 +94,31 @@ bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
     return true;
 }
 
+bool KisSwappedDataStore::tryPutCompressedTileData(KisTileData *td,
+                                                   const QString &compressionName,
+                                                   const QByteArray &data)
+{
+    Q_ASSERT(!td->data());
+    QMutexLocker locker(&m_lock);
+
+    m_compressor->packTileRecord(compressionName, data, &m_buffer);
+
+    KisChunk chunk = m_allocator->getChunk(m_buffer.size());
+    quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
+    if (!ptr) {
+        qWarning() << "putting compressed tile into swap failed";
+        m_allocator->freeChunk(chunk);
+        return false;
+    }
+    memcpy(ptr, m_buffer.data(), m_buffer.size());
+
+    td->setSwapChunk(chunk);
+
+    m_memoryMetric += td->pixelSize();
+
+    return true;
+}
+
 void KisSwappedDataStore::swapInTileData(KisTileData *td)
 {
     Q_ASSERT(!td->data());
@@ -103,7 +133,10 @@ void KisSwappedDataStore::swapInTileData(KisTileData *td)
 
     quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
     Q_ASSERT(ptr);
-    m_compressor->decompressTileData(ptr, chunk.size(), td);
+    if (!m_compressor->decompressTileData(ptr, chunk.size(), td)) {
+        qWarning() << "swap in of tile failed, the data is corrupted";
+        memset(td->data(), 0, td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT);
+    }
     m_allocator->freeChunk(chunk);
 
     m_memoryMetric -= td->pixelSize();
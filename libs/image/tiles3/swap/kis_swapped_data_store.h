@@ -27,9 +27,9 @@
 
 class QMutex;
 class KisTileData;
-class KisAbstractTileCompressor;
+class KisTileCompressor2;
 class KisChunkAllocator;
-class KisMemoryWindow;
+class KisAbstractSwapSpace;
 
 class KRITAIMAGE_EXPORT KisSwappedDataStore
 {
@@ -50,6 +50,19 @@ public:
      */
     bool trySwapOutTileData(KisTileData *td);
 
+    /**
+     * Puts the tile data, compressed with \a compressionName, directly
+     * into the swap file, without decompressing it. \a td should have
+     * no memory allocated, its data will be decompressed by
+     * swapInTileData() on the first access. Used for lazy loading of
+     * the documents.
+     *
+     * \see KisTileCompressor2::readTileRecord()
+     */
+    bool tryPutCompressedTileData(KisTileData *td,
+                                  const QString &compressionName,
+                                  const QByteArray &data);
+
     /**
      * Restore the data of a \a td basing on information
      * stored in the swap file.
@@ -78,10 +91,10 @@ public:
 
 private:
     QByteArray m_buffer;
-    KisAbstractTileCompressor *m_compressor;
+    KisTileCompressor2 *m_compressor;
 
     KisChunkAllocator *m_allocator;
-    KisMemoryWindow *m_swapSpace;
+    KisAbstractSwapSpace *m_swapSpace;
 
     QMutex m_lock;
 
@@ -17,24 +17,54 @@
  */
 
 #include "kis_tile_compressor_2.h"
-#include "kis_lzf_compression.h"
+#include "kis_compression_factory.h"
+#include "kis_abstract_compression.h"
 #include <QIODevice>
 #include "kis_paint_device_writer.h"
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
-const QString KisTileCompressor2::m_compressionName = "LZF";
 
-
-KisTileCompressor2::KisTileCompressor2()
+KisTileCompressor2::KisTileCompressor2(const QString &compressionName)
+    : m_compressionName(compressionName)
 {
-    m_compression = new KisLzfCompression();
+    m_compression = KisCompressionFactory::create(m_compressionName);
+
+    if (!m_compression) {
+        warnKrita << "Tile compression" << m_compressionName << "is not supported, falling back to LZF";
+        m_compressionName = KisCompressionFactory::LZF;
+        m_compression = KisCompressionFactory::create(m_compressionName);
+    }
 }
 
 KisTileCompressor2::~KisTileCompressor2()
 {
+    qDeleteAll(m_readCompressions);
     delete m_compression;
 }
 
+QString KisTileCompressor2::compressionName() const
+{
+    return m_compressionName;
+}
+
+KisAbstractCompression* KisTileCompressor2::compressionForName(const QString &name)
+{
+    if (name == m_compressionName) {
+        return m_compression;
+    }
+
+    KisAbstractCompression *compression = m_readCompressions.value(name, 0);
+
+    if (!compression) {
+        compression = KisCompressionFactory::create(name);
+        if (compression) {
+            m_readCompressions.insert(name, compression);
+        }
+    }
+
+    return compression;
+}
+
 bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 {
     const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
@@ -62,36 +92,65 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 
 bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
-    prepareStreamingBuffer(tileDataSize);
+    if (!readTileRecord(stream, pixelSize(dm), &m_readRecord)) {
+        return false;
+    }
+
+    if (!compressionForName(m_readRecord.compressionName)) {
+        warnFile << "Unsupported tile compression" << m_readRecord.compressionName;
+        return false;
+    }
+
+    qint32 row = yToRow(dm, m_readRecord.y);
+    qint32 col = xToCol(dm, m_readRecord.x);
+
+    KisTileSP tile = dm->getTile(col, row, true);
+
+    tile->lockForWrite();
+    bool res = decompressTileRecord(m_readRecord, tile->tileData());
+    tile->unlockForWrite();
+    return res;
+}
+
+bool KisTileCompressor2::readTileRecord(QIODevice *stream, qint32 pixelSize, TileRecord *record)
+{
+    const qint32 maxDataSize = TILE_DATA_SIZE(pixelSize) + 1;
 
     QByteArray header = stream->readLine(maxHeaderLength());
 
     QList<QByteArray> headerItems = header.trimmed().split(',');
     if (headerItems.size() == 4) {
-        qint32 x = headerItems.takeFirst().toInt();
-        qint32 y = headerItems.takeFirst().toInt();
-        QString compressionName = headerItems.takeFirst();
+        record->x = headerItems.takeFirst().toInt();
+        record->y = headerItems.takeFirst().toInt();
+        record->compressionName = headerItems.takeFirst();
         qint32 dataSize = headerItems.takeFirst().toInt();
 
         Q_ASSERT(headerItems.isEmpty());
-        Q_ASSERT(compressionName == m_compressionName);
-
-        qint32 row = yToRow(dm, y);
-        qint32 col = xToCol(dm, x);
 
-        KisTileSP tile = dm->getTile(col, row, true);
-
-        stream->read(m_streamingBuffer.data(), dataSize);
+        if (dataSize <= 0 || dataSize > maxDataSize) {
+            warnFile << "Corrupted tile header" << header;
+            return false;
+        }
 
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlockForWrite();
-        return res;
+        record->data.resize(dataSize);
+        return stream->read(record->data.data(), dataSize) == dataSize;
     }
     return false;
 }
 
+bool KisTileCompressor2::decompressTileRecord(const TileRecord &record, KisTileData *tileData)
+{
+    KisAbstractCompression *compression = compressionForName(record.compressionName);
+    if (!compression) {
+        warnFile << "Unsupported tile compression" << record.compressionName;
+        return false;
+    }
+
+    return decompressTileDataImpl(compression,
+                                  reinterpret_cast<const quint8*>(record.data.constData()),
+                                  record.data.size(), tileData);
+}
+
 void KisTileCompressor2::prepareStreamingBuffer(qint32 tileDataSize)
 {
     /**
@@ -129,7 +188,7 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
     compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
                                               (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
 
-    if(compressedBytes < tileDataSize) {
+    if(compressedBytes > 0 && compressedBytes < tileDataSize) {
         buffer[0] = COMPRESSED_DATA_FLAG;
         memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
@@ -144,25 +203,37 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 bool KisTileCompressor2::decompressTileData(quint8 *buffer,
                                             qint32 bufferSize,
                                             KisTileData *tileData)
+{
+    return decompressTileDataImpl(m_compression, buffer, bufferSize, tileData);
+}
+
+bool KisTileCompressor2::decompressTileDataImpl(KisAbstractCompression *compression,
+                                                const quint8 *buffer,
+                                                qint32 bufferSize,
+                                                KisTileData *tileData)
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
 
     if(buffer[0] == COMPRESSED_DATA_FLAG) {
-        prepareWorkBuffers(tileDataSize);
-
-        qint32 bytesWritten;
-        bytesWritten = m_compression->decompress(buffer + 1, bufferSize - 1,
-                                                 (quint8*)m_linearizationBuffer.data(), tileDataSize);
-        if (bytesWritten == tileDataSize) {
-            KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
-                                                      tileData->data(),
-                                                      tileDataSize, pixelSize);
-            return true;
+        return decompressPayload(compression, buffer + 1, bufferSize - 1, tileData);
+    }
+    else if (buffer[0] == FOREIGN_COMPRESSED_DATA_FLAG) {
+        if (bufferSize < 2 || bufferSize < 2 + buffer[1]) return false;
+
+        const QString name = QString::fromLatin1((const char*)buffer + 2, buffer[1]);
+        KisAbstractCompression *foreignCompression = compressionForName(name);
+        if (!foreignCompression) {
+            warnKrita << "Unsupported tile compression" << name;
+            return false;
         }
-        return false;
+
+        const qint32 headerSize = 2 + buffer[1];
+        return decompressPayload(foreignCompression,
+                                 buffer + headerSize, bufferSize - headerSize,
+                                 tileData);
     }
-    else {
+    else if (bufferSize >= tileDataSize + 1) {
         memcpy(tileData->data(), buffer + 1, tileDataSize);
         return true;
     }
@@ -170,6 +241,52 @@ bool KisTileCompressor2::decompressTileData(quint8 *buffer,
 
 }
 
+bool KisTileCompressor2::decompressPayload(KisAbstractCompression *compression,
+                                           const quint8 *payload,
+                                           qint32 payloadSize,
+                                           KisTileData *tileData)
+{
+    const qint32 pixelSize = tileData->pixelSize();
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+
+    prepareWorkBuffers(tileDataSize);
+
+    qint32 bytesWritten;
+    bytesWritten = compression->decompress(payload, payloadSize,
+                                           (quint8*)m_linearizationBuffer.data(), tileDataSize);
+    if (bytesWritten == tileDataSize) {
+        KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
+                                                  tileData->data(),
+                                                  tileDataSize, pixelSize);
+        return true;
+    }
+    return false;
+}
+
+void KisTileCompressor2::packTileRecord(const QString &compressionName,
+                                        const QByteArray &data,
+                                        QByteArray *buffer) const
+{
+    if (data.isEmpty() ||
+        data[0] != COMPRESSED_DATA_FLAG ||
+        compressionName == m_compressionName) {
+
+        *buffer = data;
+        return;
+    }
+
+    const QByteArray name = compressionName.toLatin1();
+    Q_ASSERT(name.size() < 256);
+
+    buffer->resize(2 + name.size() + data.size() - 1);
+    quint8 *ptr = reinterpret_cast<quint8*>(buffer->data());
+
+    ptr[0] = FOREIGN_COMPRESSED_DATA_FLAG;
+    ptr[1] = quint8(name.size());
+    memcpy(ptr + 2, name.constData(), name.size());
+    memcpy(ptr + 2 + name.size(), data.constData() + 1, data.size() - 1);
+}
+
 qint32 KisTileCompressor2::tileDataBufferSize(KisTileData *tileData)
 {
     return TILE_DATA_SIZE(tileData->pixelSize()) + 1;
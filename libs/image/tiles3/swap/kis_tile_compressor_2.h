@@ -21,12 +21,26 @@
 
 #include "kis_abstract_tile_compressor.h"
 
+#include <QHash>
+
 class KisAbstractCompression;
 
+/**
+ * Version 2 of the tile compressor. The header of every tile
+ * contains the name of the codec used for compressing its data,
+ * so the compressor can read tiles compressed by any codec
+ * registered in KisCompressionFactory, not only the one it uses
+ * for writing.
+ */
 class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
-    KisTileCompressor2();
+    /**
+     * \p compressionName is the id of the codec used for writing
+     * tiles, see KisCompressionFactory. If the codec is not supported
+     * by the build, LZF is used instead.
+     */
+    KisTileCompressor2(const QString &compressionName = "LZF");
     ~KisTileCompressor2() override;
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
@@ -38,6 +52,47 @@ public:
     bool decompressTileData(quint8 *buffer, qint32 bufferSize, KisTileData *tileData) override;
     qint32 tileDataBufferSize(KisTileData *tileData) override;
 
+    /**
+     * The id of the codec used for writing tiles
+     */
+    QString compressionName() const;
+
+    /**
+     * A compressed tile read from the stream, but not yet
+     * decompressed
+     */
+    struct TileRecord {
+        qint32 x = 0;
+        qint32 y = 0;
+        QString compressionName;
+        QByteArray data;
+    };
+
+    /**
+     * Reads the header and the compressed data of the next tile
+     * from \p stream without decompressing it. It lets the caller
+     * to decompress the tiles in multiple threads.
+     *
+     * \see decompressTileRecord()
+     */
+    bool readTileRecord(QIODevice *stream, qint32 pixelSize, TileRecord *record);
+
+    /**
+     * Decompresses a \p record read by readTileRecord() into
+     * \p tileData. The tile data should be locked by the caller.
+     */
+    bool decompressTileRecord(const TileRecord &record, KisTileData *tileData);
+
+    /**
+     * Converts the data of a \p record into the form accepted by
+     * decompressTileData() without decompressing it. If the record
+     * has been compressed with a codec different from the one of
+     * this compressor, the name of the codec is stored in the
+     * result, so decompressTileData() can still read it.
+     */
+    void packTileRecord(const QString &compressionName, const QByteArray &data,
+                        QByteArray *buffer) const;
+
 private:
     /**
      * Quite self describing
@@ -49,16 +104,40 @@ private:
     void prepareWorkBuffers(qint32 tileDataSize);
     void prepareStreamingBuffer(qint32 tileDataSize);
 
+    KisAbstractCompression* compressionForName(const QString &name);
+
+    bool decompressTileDataImpl(KisAbstractCompression *compression,
+                                const quint8 *buffer, qint32 bufferSize,
+                                KisTileData *tileData);
+
+    bool decompressPayload(KisAbstractCompression *compression,
+                           const quint8 *payload, qint32 payloadSize,
+                           KisTileData *tileData);
+
 private:
     static const qint8 RAW_DATA_FLAG = 0;
     static const qint8 COMPRESSED_DATA_FLAG = 1;
 
+    /**
+     * The data is compressed by a codec, whose name follows the flag:
+     * one byte of the name length and the name itself in Latin1. Used
+     * only in memory and in the swap, never written into documents.
+     */
+    static const qint8 FOREIGN_COMPRESSED_DATA_FLAG = 2;
+
 private:
     QByteArray m_linearizationBuffer;
     QByteArray m_compressionBuffer;
     QByteArray m_streamingBuffer;
+    TileRecord m_readRecord;
     KisAbstractCompression *m_compression;
-    static const QString m_compressionName;
+    QString m_compressionName;
+
+    /**
+     * Codecs used for reading the tiles written with a
+     * codec different from m_compression
+     */
+    QHash<QString, KisAbstractCompression*> m_readCompressions;
 };
 
 #endif /* __KIS_TILE_COMPRESSOR_2_H */
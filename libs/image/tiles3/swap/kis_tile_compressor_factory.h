@@ -21,17 +21,32 @@
 
 #include "tiles3/swap/kis_legacy_tile_compressor.h"
 #include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/swap/kis_compression_factory.h"
 
 class KRITAIMAGE_EXPORT KisTileCompressorFactory
 {
 public:
-    static KisAbstractTileCompressorSP create(qint32 version) {
+    /**
+     * Creates a compressor for the tiles \p version. Version 3 shares
+     * the format with version 2, but is written only when the tiles
+     * are compressed with something other than LZF. Older versions of
+     * Krita don't know version 3 and abort in this very factory (see
+     * the qFatal() below) when they load such tiles, so documents are
+     * saved with LZF (version 2) by default.
+     *
+     * \p compressionName is the codec used for writing the tiles (see
+     * KisCompressionFactory). On reading the codec is always taken from
+     * the header of the tile.
+     */
+    static KisAbstractTileCompressorSP create(qint32 version,
+                                              const QString &compressionName = KisCompressionFactory::LZF) {
         switch(version) {
         case 1:
             return KisAbstractTileCompressorSP(new KisLegacyTileCompressor());
             break;
         case 2:
-            return KisAbstractTileCompressorSP(new KisTileCompressor2());
+        case 3:
+            return KisAbstractTileCompressorSP(new KisTileCompressor2(compressionName));
             break;
         default:
             qFatal("Unknown version of the tiles");
@@ -0,0 +1,119 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "kis_tile_data_prefetcher.h"
+
+#include <QSemaphore>
+#include <QMutex>
+#include <QVector>
+
+#include "tiles3/swap/kis_tile_data_swapper_p.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "tiles3/kis_tiled_data_manager.h"
+
+const int KisTileDataPrefetcher::MAX_PENDING_REQUESTS = 256;
+
+
+struct Q_DECL_HIDDEN KisTileDataPrefetcher::Private
+{
+    struct Request {
+        KisTiledDataManagerSP dm;
+        QRect rect;
+    };
+
+    QSemaphore semaphore;
+    QAtomicInt shouldExitFlag;
+    KisTileDataStore *store;
+
+    QMutex requestsLock;
+    QVector<Request> requests;
+
+    QMutex limitsLock;
+    KisStoreLimits limits;
+
+    bool takeRequest(Request *request) {
+        QMutexLocker l(&requestsLock);
+        if (requests.isEmpty()) return false;
+
+        *request = requests.takeLast();
+        return true;
+    }
+};
+
+KisTileDataPrefetcher::KisTileDataPrefetcher(KisTileDataStore *store)
+    : QThread(),
+      m_d(new Private())
+{
+    m_d->shouldExitFlag = 0;
+    m_d->store = store;
+}
+
+KisTileDataPrefetcher::~KisTileDataPrefetcher()
+{
+    delete m_d;
+}
+
+void KisTileDataPrefetcher::addRequest(KisTiledDataManager *dm, const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    {
+        QMutexLocker l(&m_d->requestsLock);
+
+        if (m_d->requests.size() >= MAX_PENDING_REQUESTS) {
+            m_d->requests.removeFirst();
+        }
+
+        m_d->requests.append({dm, rect});
+    }
+
+    m_d->semaphore.release();
+}
+
+void KisTileDataPrefetcher::terminatePrefetcher()
+{
+    unsigned long exitTimeout = 100;
+    do {
+        m_d->shouldExitFlag = true;
+        m_d->semaphore.release();
+    } while(!wait(exitTimeout));
+
+    QMutexLocker l(&m_d->requestsLock);
+    m_d->requests.clear();
+}
+
+bool KisTileDataPrefetcher::canPrefetch() const
+{
+    QMutexLocker l(&m_d->limitsLock);
+    return m_d->store->memoryMetric() < m_d->limits.softLimitThreshold();
+}
+
+void KisTileDataPrefetcher::testingRereadConfig()
+{
+    QMutexLocker l(&m_d->limitsLock);
+    m_d->limits = KisStoreLimits();
+}
+
+void KisTileDataPrefetcher::run()
+{
+    while (1) {
+        m_d->semaphore.acquire();
+
+        if (m_d->shouldExitFlag)
+            return;
+
+        Private::Request request;
+        if (!m_d->takeRequest(&request)) continue;
+
+        if (!canPrefetch()) {
+            QMutexLocker l(&m_d->requestsLock);
+            m_d->requests.clear();
+            continue;
+        }
+
+        request.dm->prefetchTiles(request.rect);
+    }
+}
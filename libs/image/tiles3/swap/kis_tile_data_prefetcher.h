@@ -0,0 +1,59 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_TILE_DATA_PREFETCHER_H
+#define __KIS_TILE_DATA_PREFETCHER_H
+
+#include <QThread>
+#include <QRect>
+
+#include "kritaimage_export.h"
+
+class KisTileDataStore;
+class KisTiledDataManager;
+
+/**
+ * The thread that swaps in the tiles that will most probably be
+ * needed soon, so the painting threads do not stall on loading them
+ * from the swap file synchronously.
+ *
+ * The hints come from the canvas (the area around the viewport)
+ * and from the freehand tools (the area in front of the brush).
+ * The newest hints are processed first, the oldest ones are
+ * dropped if the queue grows too long. Prefetching stops as soon
+ * as the memory usage reaches the soft limit of the swapper.
+ */
+class KRITAIMAGE_EXPORT KisTileDataPrefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    KisTileDataPrefetcher(KisTileDataStore *store);
+    ~KisTileDataPrefetcher() override;
+
+    void addRequest(KisTiledDataManager *dm, const QRect &rect);
+    void terminatePrefetcher();
+
+    /**
+     * Returns true if the memory limits allow swapping in
+     * one more tile in advance
+     */
+    bool canPrefetch() const;
+
+    void testingRereadConfig();
+
+private:
+    void run() override;
+
+private:
+    static const int MAX_PENDING_REQUESTS;
+
+private:
+    struct Private;
+    Private * const m_d;
+};
+
+#endif /* __KIS_TILE_DATA_PREFETCHER_H */
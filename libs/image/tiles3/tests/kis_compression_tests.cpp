@@ -23,6 +23,7 @@
 
 #include "../../../sdk/tests/testutil.h"
 #include "tiles3/swap/kis_lzf_compression.h"
+#include "tiles3/swap/kis_compression_factory.h"
 #include <kis_debug.h>
 
 #define TEST_FILE "tile.png"
@@ -262,5 +263,108 @@ void KisCompressionTests::benchmarkDecompressionLzfTwoPass()
     delete compression;
 }
 
+static void addCodecRows()
+{
+    QTest::addColumn<QString>("codec");
+
+    Q_FOREACH (const QString &codec, KisCompressionFactory::availableCompressions()) {
+        QTest::newRow(codec.toLatin1()) << codec;
+    }
+}
+
+void KisCompressionTests::testCodecRoundTrip_data()
+{
+    addCodecRows();
+}
+
+void KisCompressionTests::testCodecRoundTrip()
+{
+    QFETCH(QString, codec);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    QVERIFY(compression);
+
+    roundTrip(compression.data());
+    roundTripTwoPass(compression.data());
+}
+
+void KisCompressionTests::testCodecOverflow_data()
+{
+    addCodecRows();
+}
+
+void KisCompressionTests::testCodecOverflow()
+{
+    QFETCH(QString, codec);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    QVERIFY(compression);
+
+    testOverflow(compression.data());
+}
+
+void KisCompressionTests::testCodecRatio_data()
+{
+    addCodecRows();
+}
+
+void KisCompressionTests::testCodecRatio()
+{
+    QFETCH(QString, codec);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    QVERIFY(compression);
+
+    QImage image(QString(FILES_DATA_DIR) + QDir::separator() + TEST_FILE);
+
+    const qint32 srcSize = image.byteCount();
+    const qint32 outputSize = compression->outputBufferSize(srcSize);
+
+    QVector<quint8> tempBuffer(srcSize);
+    QVector<quint8> output(outputSize);
+
+    KisAbstractCompression::linearizeColors(image.bits(), tempBuffer.data(),
+                                            srcSize, 4);
+
+    const qint32 compressedBytes =
+        compression->compress(tempBuffer.data(), srcSize,
+                              output.data(), outputSize);
+
+    PRINT_COMPRESSION(codec + " ratio:\t", srcSize, compressedBytes);
+
+    QVERIFY(compressedBytes > 0);
+    QVERIFY(compressedBytes <= outputSize);
+}
+
+void KisCompressionTests::benchmarkCodecCompression_data()
+{
+    addCodecRows();
+}
+
+void KisCompressionTests::benchmarkCodecCompression()
+{
+    QFETCH(QString, codec);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    QVERIFY(compression);
+
+    benchmarkCompressionTwoPass(compression.data());
+}
+
+void KisCompressionTests::benchmarkCodecDecompression_data()
+{
+    addCodecRows();
+}
+
+void KisCompressionTests::benchmarkCodecDecompression()
+{
+    QFETCH(QString, codec);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    QVERIFY(compression);
+
+    benchmarkDecompressionTwoPass(compression.data());
+}
+
 QTEST_MAIN(KisCompressionTests)
 
@@ -48,6 +48,17 @@ private Q_SLOTS:
     void benchmarkCompressionLzfTwoPass();
     void benchmarkDecompressionLzf();
     void benchmarkDecompressionLzfTwoPass();
+
+    void testCodecRoundTrip_data();
+    void testCodecRoundTrip();
+    void testCodecOverflow_data();
+    void testCodecOverflow();
+    void testCodecRatio_data();
+    void testCodecRatio();
+    void benchmarkCodecCompression_data();
+    void benchmarkCodecCompression();
+    void benchmarkCodecDecompression_data();
+    void benchmarkCodecDecompression();
 };
 
 #endif /* KIS_COMPRESSION_TESTS_H */
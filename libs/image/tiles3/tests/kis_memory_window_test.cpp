@@ -23,6 +23,7 @@
 #include <QTemporaryDir>
 
 #include "../swap/kis_memory_window.h"
+#include "../swap/kis_mapped_swap_space.h"
 
 void KisMemoryWindowTest::testWindow()
 {
@@ -54,6 +55,38 @@ void KisMemoryWindowTest::testWindow()
     QVERIFY(!memcmp(ptr, oddBuf, chunkLength));
 }
 
+void KisMemoryWindowTest::testMappedSwapSpace()
+{
+    QTemporaryDir swapDir;
+    KisMappedSwapSpace memory(swapDir.path(), 1024);
+
+    quint8 oddValue = 0xee;
+    const quint8 chunkLength = 10;
+
+    quint8 oddBuf[chunkLength];
+    memset(oddBuf, oddValue, chunkLength);
+
+    KisChunkData chunk1(0, chunkLength);
+    // big enough to make the file be remapped
+    KisChunkData chunk2(100 * MiB, chunkLength);
+
+    quint8 *ptr;
+
+    ptr = memory.getWriteChunkPtr(chunk1);
+    QVERIFY(ptr);
+    memcpy(ptr, oddBuf, chunkLength);
+
+    ptr = memory.getWriteChunkPtr(chunk2);
+    QVERIFY(ptr);
+    memcpy(ptr, oddBuf, chunkLength);
+
+    ptr = memory.getReadChunkPtr(chunk1);
+    QVERIFY(!memcmp(ptr, oddBuf, chunkLength));
+
+    ptr = memory.getReadChunkPtr(chunk2);
+    QVERIFY(!memcmp(ptr, oddBuf, chunkLength));
+}
+
 void KisMemoryWindowTest::testTopReports()
 {
 
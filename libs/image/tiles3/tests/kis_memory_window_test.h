@@ -27,6 +27,7 @@ class KisMemoryWindowTest : public QObject
 
 private Q_SLOTS:
     void testWindow();
+    void testMappedSwapSpace();
 
 private:
     // disabled since long-running
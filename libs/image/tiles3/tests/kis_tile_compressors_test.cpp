@@ -22,6 +22,7 @@
 #include "tiles3/kis_tiled_data_manager.h"
 #include "tiles3/swap/kis_legacy_tile_compressor.h"
 #include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/swap/kis_compression_factory.h"
 
 #include "tiles_test_utils.h"
 
@@ -179,6 +180,70 @@ void KisTileCompressorsTest::testLowLevelRoundTripIncompressible2()
     delete compressor;
 }
 
+void KisTileCompressorsTest::testRoundTripCodecs_data()
+{
+    QTest::addColumn<QString>("codec");
+
+    Q_FOREACH (const QString &codec, KisCompressionFactory::availableCompressions()) {
+        QTest::newRow(codec.toLatin1()) << codec;
+    }
+}
+
+void KisTileCompressorsTest::testRoundTripCodecs()
+{
+    QFETCH(QString, codec);
+
+    KisTileCompressor2 compressor(codec);
+    QCOMPARE(compressor.compressionName(), codec);
+
+    doRoundTrip(&compressor);
+    doLowLevelRoundTrip(&compressor);
+    doLowLevelRoundTripIncompressible(&compressor);
+}
+
+void KisTileCompressorsTest::testReadForeignCodec_data()
+{
+    QTest::addColumn<QString>("writeCodec");
+    QTest::addColumn<QString>("readCodec");
+
+    Q_FOREACH (const QString &writeCodec, KisCompressionFactory::availableCompressions()) {
+        Q_FOREACH (const QString &readCodec, KisCompressionFactory::availableCompressions()) {
+            QTest::newRow(QString("%1->%2").arg(writeCodec).arg(readCodec).toLatin1())
+                << writeCodec << readCodec;
+        }
+    }
+}
+
+void KisTileCompressorsTest::testReadForeignCodec()
+{
+    QFETCH(QString, writeCodec);
+    QFETCH(QString, readCodec);
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    dm.clear(64, 64, 64, 64, &oddPixel1);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+
+    KisTileCompressor2 writeCompressor(writeCodec);
+    QVERIFY(writeCompressor.writeTile(dm.getTile(1, 1, false), writer));
+
+    fakeStore.startReading();
+    dm.clear();
+
+    /**
+     * The codec of the tile is stored in its header, so
+     * the reader should not depend on its own codec
+     */
+    KisTileCompressor2 readCompressor(readCodec);
+    QVERIFY(readCompressor.readTile(fakeStore.device(), &dm));
+
+    KisTileSP tile11 = dm.getTile(1, 1, false);
+    QVERIFY(memoryIsFilled(oddPixel1, tile11->data(), TILESIZE));
+}
 
 QTEST_MAIN(KisTileCompressorsTest)
 
@@ -38,6 +38,11 @@ private Q_SLOTS:
     void testRoundTrip2();
     void testLowLevelRoundTrip2();
     void testLowLevelRoundTripIncompressible2();
+
+    void testRoundTripCodecs_data();
+    void testRoundTripCodecs();
+    void testReadForeignCodec_data();
+    void testReadForeignCodec();
 };
 
 #endif /* KIS_TILE_COMPRESSORS_TEST_H */
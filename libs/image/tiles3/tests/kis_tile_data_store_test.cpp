@@ -188,5 +188,50 @@ void KisTileDataStoreTest::testSwapping()
     }
 }
 
+void KisTileDataStoreTest::testPrefetching()
+{
+    KisImageConfig config(false);
+    config.setMemoryHardLimitPercent(50);
+    config.setMemorySoftLimitPercent(25);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugClear();
+    store->testingRereadConfig();
+
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 128;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    const QRect fullRect(0, 0, 8 * KisTileData::WIDTH, 8 * KisTileData::HEIGHT);
+    const QRect prefetchRect(0, 0, 4 * KisTileData::WIDTH, 4 * KisTileData::HEIGHT);
+
+    QVector<quint8> bytes(fullRect.width() * fullRect.height(), 42);
+    dm.writeBytes(bytes.data(), fullRect.x(), fullRect.y(), fullRect.width(), fullRect.height());
+
+    store->debugSwapAll();
+
+    const KisTileDataStore::MemoryStatistics before = store->memoryStatistics();
+
+    dm.prefetchTiles(prefetchRect);
+
+    KisTileDataStore::MemoryStatistics stats = store->memoryStatistics();
+    QCOMPARE(stats.prefetchedTiles - before.prefetchedTiles, qint64(16));
+
+    // the prefetched tiles don't need to be swapped in again
+    QVector<quint8> result(bytes.size());
+    dm.readBytes(result.data(), prefetchRect.x(), prefetchRect.y(), prefetchRect.width(), prefetchRect.height());
+
+    stats = store->memoryStatistics();
+    QCOMPARE(stats.prefetchHits - before.prefetchHits, qint64(16));
+    QCOMPARE(stats.swapInMisses - before.swapInMisses, qint64(0));
+
+    // ... and the rest of them do
+    dm.readBytes(result.data(), fullRect.x(), fullRect.y(), fullRect.width(), fullRect.height());
+    QVERIFY(result == bytes);
+
+    stats = store->memoryStatistics();
+    QCOMPARE(stats.swapInMisses - before.swapInMisses, qint64(48));
+}
+
 QTEST_MAIN(KisTileDataStoreTest)
 
@@ -19,7 +19,12 @@
 #include "kis_tiled_data_manager_test.h"
 #include <QTest>
 
+#include <QThreadPool>
+#include <QBuffer>
+
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "kis_image_config.h"
 
 #include "tiles_test_utils.h"
 #include "config-limit-long-tests.h"
@@ -539,6 +544,154 @@ void KisTiledDataManagerTest::testUndoSetDefaultPixel()
     QVERIFY(memoryIsFilled(oddPixel2, tile10->data(), TILESIZE));
 }
 
+class KisByteArrayPaintDeviceWriter : public KisPaintDeviceWriter {
+public:
+    bool write(const QByteArray &data) override {
+        m_data.append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_data.append(data, length);
+        return true;
+    }
+
+    QByteArray m_data;
+};
+
+void KisTiledDataManagerTest::testParallelReadWrite()
+{
+    const QRect rect(0, 0, 2048, 2048);
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    QVector<quint8> bytes(rect.width() * rect.height());
+    for (int i = 0; i < bytes.size(); i++) {
+        bytes[i] = quint8((i / 7) ^ (i >> 11));
+    }
+    dm.writeBytes(bytes.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    const int originalThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+
+    KisByteArrayPaintDeviceWriter serialWriter;
+    QThreadPool::globalInstance()->setMaxThreadCount(1);
+    QVERIFY(dm.write(serialWriter));
+
+    KisByteArrayPaintDeviceWriter parallelWriter;
+    QThreadPool::globalInstance()->setMaxThreadCount(8);
+    QVERIFY(dm.write(parallelWriter));
+
+    // the order of the tiles must be preserved
+    QCOMPARE(parallelWriter.m_data, serialWriter.m_data);
+
+    Q_FOREACH (int numThreads, QVector<int>({1, 8})) {
+        QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+        QBuffer buffer(&parallelWriter.m_data);
+        buffer.open(QIODevice::ReadOnly);
+
+        KisTiledDataManager dm2(1, &defaultPixel);
+        QVERIFY(dm2.read(&buffer));
+
+        QVector<quint8> result(bytes.size());
+        dm2.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+        QVERIFY(result == bytes);
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(originalThreadCount);
+}
+
+void KisTiledDataManagerTest::testLazyRead()
+{
+    const QRect rect(0, 0, 2048, 2048);
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    QVector<quint8> bytes(rect.width() * rect.height());
+    for (int i = 0; i < bytes.size(); i++) {
+        bytes[i] = quint8((i / 7) ^ (i >> 11));
+    }
+    dm.writeBytes(bytes.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    KisByteArrayPaintDeviceWriter writer;
+    QVERIFY(dm.write(writer));
+
+    KisImageConfig config(false);
+    const int originalThreshold = config.lazyTileLoadingThreshold();
+    config.setLazyTileLoadingThreshold(1);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    const qint32 tilesInMemoryBefore = store->numTilesInMemory();
+
+    QBuffer buffer(&writer.m_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    KisTiledDataManager dm2(1, &defaultPixel);
+    QVERIFY(dm2.read(&buffer));
+
+    QCOMPARE(dm2.extent(), rect);
+
+    // the tiles should stay in the swap until they are accessed
+    QVERIFY(store->numTilesInMemory() - tilesInMemoryBefore < 16);
+
+    QVector<quint8> result(bytes.size());
+    dm2.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(result == bytes);
+
+    config.setLazyTileLoadingThreshold(originalThreshold);
+}
+
+void KisTiledDataManagerTest::testLazyReadUndo()
+{
+    const QRect rect(0, 0, 512, 512);
+    const QRect changeRect(100, 100, 200, 200);
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    QVector<quint8> bytes(rect.width() * rect.height());
+    for (int i = 0; i < bytes.size(); i++) {
+        bytes[i] = quint8((i / 3) ^ (i >> 9));
+    }
+    dm.writeBytes(bytes.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    KisByteArrayPaintDeviceWriter writer;
+    QVERIFY(dm.write(writer));
+
+    KisImageConfig config(false);
+    const int originalThreshold = config.lazyTileLoadingThreshold();
+    config.setLazyTileLoadingThreshold(1);
+
+    QBuffer buffer(&writer.m_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    KisTiledDataManager dm2(1, &defaultPixel);
+    QVERIFY(dm2.read(&buffer));
+
+    config.setLazyTileLoadingThreshold(originalThreshold);
+
+    QVector<quint8> result(bytes.size());
+    quint8 fillPixel = 7;
+
+    // the lazily loaded tiles, still swapped out, are restored by the undo of a change...
+    KisMementoSP memento1 = dm2.getMemento();
+    dm2.clear(changeRect, &fillPixel);
+    dm2.commit();
+
+    dm2.rollback(memento1);
+    dm2.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(result == bytes);
+
+    // ... and are replaced again by the redo
+    dm2.rollforward(memento1);
+
+    QVector<quint8> changedBytes(changeRect.width() * changeRect.height());
+    dm2.readBytes(changedBytes.data(), changeRect.x(), changeRect.y(), changeRect.width(), changeRect.height());
+    QVERIFY(memoryIsFilled(fillPixel, changedBytes.data(), changedBytes.size()));
+}
+
 //#include <valgrind/callgrind.h>
 
 void KisTiledDataManagerTest::benchmarkReadOnlyTileLazy()
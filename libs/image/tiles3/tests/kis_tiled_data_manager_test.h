@@ -52,6 +52,9 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testParallelReadWrite();
+    void testLazyRead();
+    void testLazyReadUndo();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -0,0 +1,200 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "KoColorConversionBenchmark.h"
+
+#include <QTest>
+#include <QScopedPointer>
+
+#include <KoColorSpaceRegistry.h>
+#include <KoColorSpaceEngine.h>
+#include <KoColorSpace.h>
+#include <KoColorModelStandardIds.h>
+#include <KoColorConversionTransformation.h>
+
+#define NB_PIXELS 1000000
+
+namespace {
+
+const QString srgbTrcProfile = "sRGB-elle-V2-srgbtrc.icc";
+const QString srgbLinearProfile = "sRGB-elle-V2-g10.icc";
+
+/**
+ * Creates the conversion the way the rest of Krita does, that is, through
+ * the color conversion system, which picks the fast path when available,
+ * or directly via the ICC engine, which is the old LCMS-only path
+ */
+KoColorConversionTransformation* createConverter(const KoColorSpace *srcCs, const KoColorSpace *dstCs, bool useLcms)
+{
+    const KoColorConversionTransformation::Intent intent =
+        KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags =
+        KoColorConversionTransformation::internalConversionFlags();
+
+    if (useLcms) {
+        KoColorSpaceEngine *engine = KoColorSpaceEngineRegistry::instance()->get("icc");
+        return engine ? engine->createColorTransformation(srcCs, dstCs, intent, flags) : 0;
+    }
+
+    return srcCs->createColorConverter(dstCs, intent, flags);
+}
+
+void fillRandomPixels(const KoColorSpace *cs, quint8 *data, int numPixels)
+{
+    qsrand(1);
+
+    QVector<float> channels(cs->channelCount());
+
+    for (int i = 0; i < numPixels; i++) {
+        for (int c = 0; c < channels.size(); c++) {
+            channels[c] = float(qrand()) / RAND_MAX;
+        }
+        cs->fromNormalisedChannelsValue(data + i * cs->pixelSize(), channels);
+    }
+}
+
+}
+
+void KoColorConversionBenchmark::createConversionRows(bool addLcmsRows)
+{
+    QTest::addColumn<QString>("srcDepthId");
+    QTest::addColumn<QString>("srcProfile");
+    QTest::addColumn<QString>("dstDepthId");
+    QTest::addColumn<QString>("dstProfile");
+    QTest::addColumn<bool>("useLcms");
+
+    struct Conversion {
+        KoID srcDepth;
+        QString srcProfile;
+        KoID dstDepth;
+        QString dstProfile;
+    };
+
+    const QVector<Conversion> conversions = {
+        {Integer8BitsColorDepthID, srgbTrcProfile, Integer16BitsColorDepthID, srgbTrcProfile},
+        {Integer16BitsColorDepthID, srgbTrcProfile, Integer8BitsColorDepthID, srgbTrcProfile},
+        {Integer8BitsColorDepthID, srgbTrcProfile, Float32BitsColorDepthID, srgbTrcProfile},
+        {Float32BitsColorDepthID, srgbTrcProfile, Integer8BitsColorDepthID, srgbTrcProfile},
+        {Integer16BitsColorDepthID, srgbLinearProfile, Float32BitsColorDepthID, srgbLinearProfile},
+        {Integer8BitsColorDepthID, srgbTrcProfile, Float32BitsColorDepthID, srgbLinearProfile},
+        {Float32BitsColorDepthID, srgbLinearProfile, Integer8BitsColorDepthID, srgbTrcProfile},
+        {Integer16BitsColorDepthID, srgbTrcProfile, Float32BitsColorDepthID, srgbLinearProfile},
+        {Float32BitsColorDepthID, srgbLinearProfile, Integer16BitsColorDepthID, srgbTrcProfile},
+        {Float32BitsColorDepthID, srgbTrcProfile, Float32BitsColorDepthID, srgbLinearProfile},
+        {Float32BitsColorDepthID, srgbLinearProfile, Float32BitsColorDepthID, srgbTrcProfile}
+    };
+
+    Q_FOREACH (const Conversion &c, conversions) {
+        for (int i = 0; i < (addLcmsRows ? 2 : 1); i++) {
+            const bool useLcms = addLcmsRows && i;
+
+            const QString rowName =
+                QString("%1 %2 -> %3 %4%5")
+                    .arg(c.srcDepth.id()).arg(c.srcProfile)
+                    .arg(c.dstDepth.id()).arg(c.dstProfile)
+                    .arg(useLcms ? " (lcms)" : "");
+
+            QTest::newRow(rowName.toLatin1().data())
+                << c.srcDepth.id() << c.srcProfile
+                << c.dstDepth.id() << c.dstProfile
+                << useLcms;
+        }
+    }
+}
+
+void KoColorConversionBenchmark::testFastPathMatchesLcms_data()
+{
+    createConversionRows(false);
+}
+
+void KoColorConversionBenchmark::testFastPathMatchesLcms()
+{
+    QFETCH(QString, srcDepthId);
+    QFETCH(QString, srcProfile);
+    QFETCH(QString, dstDepthId);
+    QFETCH(QString, dstProfile);
+
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), srcDepthId, srcProfile);
+    const KoColorSpace *dstCs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), dstDepthId, dstProfile);
+
+    if (!srcCs || !dstCs) {
+        QSKIP("The color space is not available");
+    }
+
+    QScopedPointer<KoColorConversionTransformation> fastPath(createConverter(srcCs, dstCs, false));
+    QScopedPointer<KoColorConversionTransformation> lcmsPath(createConverter(srcCs, dstCs, true));
+    QVERIFY(fastPath);
+    QVERIFY(lcmsPath);
+
+    const int numPixels = 4096;
+
+    QVector<quint8> src(numPixels * srcCs->pixelSize());
+    QVector<quint8> fastDst(numPixels * dstCs->pixelSize());
+    QVector<quint8> lcmsDst(numPixels * dstCs->pixelSize());
+
+    fillRandomPixels(srcCs, src.data(), numPixels);
+
+    fastPath->transform(src.constData(), fastDst.data(), numPixels);
+    lcmsPath->transform(src.constData(), lcmsDst.data(), numPixels);
+
+    QVector<float> fastChannels(dstCs->channelCount());
+    QVector<float> lcmsChannels(dstCs->channelCount());
+
+    /**
+     * The default sRGB profile stores its tone curve as a table, so
+     * LCMS result may be slightly different from the analytical curve
+     * used by the fast path
+     */
+    const float tolerance = 0.005;
+
+    for (int i = 0; i < numPixels; i++) {
+        dstCs->normalisedChannelsValue(fastDst.constData() + i * dstCs->pixelSize(), fastChannels);
+        dstCs->normalisedChannelsValue(lcmsDst.constData() + i * dstCs->pixelSize(), lcmsChannels);
+
+        for (int c = 0; c < fastChannels.size(); c++) {
+            if (qAbs(fastChannels[c] - lcmsChannels[c]) > tolerance) {
+                qDebug() << "pixel" << i << "channel" << c
+                         << "fast" << fastChannels[c] << "lcms" << lcmsChannels[c];
+                QFAIL("Fast path differs from LCMS");
+            }
+        }
+    }
+}
+
+void KoColorConversionBenchmark::benchmarkConversion_data()
+{
+    createConversionRows(true);
+}
+
+void KoColorConversionBenchmark::benchmarkConversion()
+{
+    QFETCH(QString, srcDepthId);
+    QFETCH(QString, srcProfile);
+    QFETCH(QString, dstDepthId);
+    QFETCH(QString, dstProfile);
+    QFETCH(bool, useLcms);
+
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), srcDepthId, srcProfile);
+    const KoColorSpace *dstCs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), dstDepthId, dstProfile);
+
+    if (!srcCs || !dstCs) {
+        QSKIP("The color space is not available");
+    }
+
+    QScopedPointer<KoColorConversionTransformation> converter(createConverter(srcCs, dstCs, useLcms));
+    QVERIFY(converter);
+
+    QVector<quint8> src(NB_PIXELS * srcCs->pixelSize());
+    QVector<quint8> dst(NB_PIXELS * dstCs->pixelSize());
+
+    fillRandomPixels(srcCs, src.data(), NB_PIXELS);
+
+    QBENCHMARK {
+        converter->transform(src.constData(), dst.data(), NB_PIXELS);
+    }
+}
+
+QTEST_MAIN(KoColorConversionBenchmark)
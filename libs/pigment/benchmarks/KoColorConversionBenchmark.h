@@ -0,0 +1,24 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef _KO_COLOR_CONVERSION_BENCHMARK_H_
+#define _KO_COLOR_CONVERSION_BENCHMARK_H_
+
+#include <QObject>
+
+class KoColorConversionBenchmark : public QObject
+{
+    Q_OBJECT
+private:
+    void createConversionRows(bool addLcmsRows);
+private Q_SLOTS:
+    void testFastPathMatchesLcms_data();
+    void testFastPathMatchesLcms();
+    void benchmarkConversion_data();
+    void benchmarkConversion();
+};
+
+#endif
@@ -62,6 +62,9 @@ struct OptimizedOpsSelector
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return new KoCompositeOpOver<Traits>(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<Traits>(cs);
+    }
 };
 
 template<>
@@ -75,6 +78,9 @@ struct OptimizedOpsSelector<KoBgrU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoBgrU8Traits>(cs);
+    }
 };
 
 template<>
@@ -88,6 +94,41 @@ struct OptimizedOpsSelector<KoLabU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoLabU8Traits>(cs);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoBgrU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOp64(cs);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoLabU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOp64(cs);
+    }
 };
 
 template<>
@@ -102,6 +143,73 @@ struct OptimizedOpsSelector<KoRgbF32Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp128(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoRgbF32Traits>(cs);
+    }
+};
+
+/**
+ * Maps the blending functions of KoCompositeOpFunctions.h to the modes
+ * of KoOptimizedCompositeOpFactory that implement them in a vectorized way
+ */
+template<typename T, T compositeFunc(T, T)>
+struct OptimizedGenericSCMode
+{
+    static const KoOptimizedCompositeOpFactory::GenericSCMode mode = KoOptimizedCompositeOpFactory::GenericSCNone;
+};
+
+#define DECLARE_OPTIMIZED_GENERIC_SC_MODE(_func, _mode)                 \
+    template<>                                                          \
+    struct OptimizedGenericSCMode<float, &_func<float> >                \
+    {                                                                   \
+        static const KoOptimizedCompositeOpFactory::GenericSCMode mode = KoOptimizedCompositeOpFactory::_mode; \
+    }
+
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfMultiply, GenericSCMultiply);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfScreen, GenericSCScreen);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfOverlay, GenericSCOverlay);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfHardLight, GenericSCHardLight);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfAddition, GenericSCAddition);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfSubtract, GenericSCSubtract);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfLinearBurn, GenericSCLinearBurn);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfColorDodge, GenericSCColorDodge);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfDarkenOnly, GenericSCDarken);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfLightenOnly, GenericSCLighten);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfDifference, GenericSCDifference);
+DECLARE_OPTIMIZED_GENERIC_SC_MODE(cfExclusion, GenericSCExclusion);
+
+#undef DECLARE_OPTIMIZED_GENERIC_SC_MODE
+
+/**
+ * The vectorized separable ops do their math in floating point, so they
+ * are used for float color spaces only. The integer color spaces keep
+ * KoCompositeOpGenericSC, which rounds differently.
+ */
+template<class Traits>
+struct OptimizedGenericOpsSelector
+{
+    typedef typename Traits::channels_type channels_type;
+
+    template<channels_type compositeFunc(channels_type, channels_type)>
+    static KoCompositeOp* createGenericSCOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
+};
+
+template<>
+struct OptimizedGenericOpsSelector<KoRgbF32Traits>
+{
+    template<float compositeFunc(float, float)>
+    static KoCompositeOp* createGenericSCOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        const KoOptimizedCompositeOpFactory::GenericSCMode mode = OptimizedGenericSCMode<float, compositeFunc>::mode;
+
+        return mode != KoOptimizedCompositeOpFactory::GenericSCNone ?
+            KoOptimizedCompositeOpFactory::createGenericSCOp128(cs, mode, id, description, category) : 0;
+    }
 };
 
 template<class Traits>
@@ -111,15 +219,26 @@ struct AddGeneralOps<Traits, true>
      typedef Arg (*CompositeFunc)(Arg, Arg);
      static const qint32 alpha_pos = Traits::alpha_pos;
 
+     template<CompositeFunc func>
+     static KoCompositeOp* createOp(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
+         KoCompositeOp *op = OptimizedGenericOpsSelector<Traits>::template createGenericSCOp<func>(cs, id, description, category);
+
+         if (!op) {
+             op = new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category);
+         }
+
+         return op;
+     }
+
      template<CompositeFunc func>
      static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-         cs->addCompositeOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category));
+         cs->addCompositeOp(createOp<func>(cs, id, description, category));
      }
 
      static void add(KoColorSpace* cs) {
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createOverOp(cs));
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createAlphaDarkenOp(cs));
-         cs->addCompositeOp(new KoCompositeOpCopy2<Traits>(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createCopyOp(cs));
          cs->addCompositeOp(new KoCompositeOpErase<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpBehind<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationIn<Traits>(cs));
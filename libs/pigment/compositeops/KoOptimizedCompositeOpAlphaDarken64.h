@@ -0,0 +1,253 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
+#define KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include <klocalizedstring.h>
+#include "KoStreamedMath.h"
+#include <KoAlphaDarkenParamsWrapper.h>
+
+/**
+ * Vectorized versions of ParamsWrapper::calculateZeroFlowAlphaLegacy()
+ * for 16-bit channels
+ */
+template<class ParamsWrapper>
+struct AlphaDarkenZeroFlowAlpha64;
+
+template<>
+struct AlphaDarkenZeroFlowAlpha64<KoAlphaDarkenParamsWrapperHard>
+{
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE typename KoStreamedMath<_impl>::uint_v
+    calculate(const typename KoStreamedMath<_impl>::uint_v &srcAlpha,
+              const typename KoStreamedMath<_impl>::uint_v &dstAlpha) {
+        // Arithmetic::unionShapeOpacity()
+        return srcAlpha + dstAlpha - KoStreamedMath<_impl>::mul_u16(srcAlpha, dstAlpha);
+    }
+};
+
+template<>
+struct AlphaDarkenZeroFlowAlpha64<KoAlphaDarkenParamsWrapperCreamy>
+{
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE typename KoStreamedMath<_impl>::uint_v
+    calculate(const typename KoStreamedMath<_impl>::uint_v &srcAlpha,
+              const typename KoStreamedMath<_impl>::uint_v &dstAlpha) {
+        Q_UNUSED(srcAlpha);
+        return dstAlpha;
+    }
+};
+
+/**
+ * The vectorized version of KoCompositeOpAlphaDarken for 16-bit channels.
+ * All the math is done in integers, so the result is bit-exact with the
+ * legacy scalar op.
+ */
+template<typename channels_type, typename _ParamsWrapper>
+struct AlphaDarkenCompositor64 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : fullFlow(params.flow == 1.0)
+        {
+            using namespace Arithmetic;
+
+            _ParamsWrapper wrapper(params);
+            opacity = scale<channels_type>(wrapper.opacity);
+            flow = scale<channels_type>(wrapper.flow);
+            averageOpacity = scale<channels_type>(wrapper.averageOpacity);
+        }
+        channels_type opacity;
+        channels_type flow;
+        channels_type averageOpacity;
+        bool fullFlow;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(opacity);
+
+        using uint_v = typename KoStreamedMath<_impl>::uint_v;
+
+        const uint_v zeroValue(0u);
+        const uint_v opacity_vec(oparams.opacity);
+
+        uint_v src_alpha;
+        uint_v src_c1;
+        uint_v src_c2;
+        uint_v src_c3;
+
+        uint_v dst_alpha;
+        uint_v dst_c1;
+        uint_v dst_c2;
+        uint_v dst_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_u16(src, src_alpha, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::fetch_channels_u16(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+
+        uint_v msk_alpha = src_alpha;
+
+        if (haveMask) {
+            // scale<quint16>(quint8) is just a multiplication by 257
+            const uint_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8_i(mask) * uint_v(257u);
+            msk_alpha = KoStreamedMath<_impl>::mul_u16(mask_vec, src_alpha);
+        }
+
+        src_alpha = KoStreamedMath<_impl>::mul_u16(msk_alpha, opacity_vec);
+
+        const auto empty_dst_pixels_mask = dst_alpha == zeroValue;
+
+        if (empty_dst_pixels_mask.isFull()) {
+            dst_c1 = src_c1;
+            dst_c2 = src_c2;
+            dst_c3 = src_c3;
+        } else {
+            uint_v new_c1 = KoStreamedMath<_impl>::lerp_u16(dst_c1, src_c1, src_alpha);
+            uint_v new_c2 = KoStreamedMath<_impl>::lerp_u16(dst_c2, src_c2, src_alpha);
+            uint_v new_c3 = KoStreamedMath<_impl>::lerp_u16(dst_c3, src_c3, src_alpha);
+
+            dst_c1 = Vc::iif(empty_dst_pixels_mask, src_c1, new_c1);
+            dst_c2 = Vc::iif(empty_dst_pixels_mask, src_c2, new_c2);
+            dst_c3 = Vc::iif(empty_dst_pixels_mask, src_c3, new_c3);
+        }
+
+        uint_v fullFlowAlpha;
+
+        if (oparams.averageOpacity > oparams.opacity) {
+            const uint_v average_opacity_vec(oparams.averageOpacity);
+            const auto fullFlowAlpha_mask = average_opacity_vec > dst_alpha;
+
+            if (fullFlowAlpha_mask.isEmpty()) {
+                fullFlowAlpha = dst_alpha;
+            } else {
+                // the division is valid only for dst_alpha <= averageOpacity,
+                // other lanes are dropped anyway
+                const uint_v reverse_blend =
+                    KoStreamedMath<_impl>::divide_u16(Vc::min(dst_alpha, average_opacity_vec), average_opacity_vec);
+                const uint_v opt1 = KoStreamedMath<_impl>::lerp_u16(src_alpha, average_opacity_vec, reverse_blend);
+                fullFlowAlpha = Vc::iif(fullFlowAlpha_mask, opt1, dst_alpha);
+            }
+        } else {
+            const auto fullFlowAlpha_mask = opacity_vec > dst_alpha;
+
+            if (fullFlowAlpha_mask.isEmpty()) {
+                fullFlowAlpha = dst_alpha;
+            } else {
+                const uint_v opt1 = KoStreamedMath<_impl>::lerp_u16(dst_alpha, opacity_vec, msk_alpha);
+                fullFlowAlpha = Vc::iif(fullFlowAlpha_mask, opt1, dst_alpha);
+            }
+        }
+
+        if (oparams.fullFlow) {
+            dst_alpha = fullFlowAlpha;
+        } else {
+            const uint_v zeroFlowAlpha =
+                AlphaDarkenZeroFlowAlpha64<_ParamsWrapper>::template calculate<_impl>(src_alpha, dst_alpha);
+            dst_alpha = KoStreamedMath<_impl>::lerp_u16(zeroFlowAlpha, fullFlowAlpha, uint_v(oparams.flow));
+        }
+
+        KoStreamedMath<_impl>::write_channels_u16(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+    }
+
+    /**
+     * Composes one pixel of the source into the destination
+     */
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        using namespace Arithmetic;
+        const qint32 alpha_pos = 3;
+
+        Q_UNUSED(opacity);
+
+        const channels_type *s = reinterpret_cast<const channels_type*>(src);
+        channels_type *d = reinterpret_cast<channels_type*>(dst);
+
+        channels_type dstAlpha = d[alpha_pos];
+        channels_type mskAlpha = haveMask ? mul(scale<channels_type>(*mask), s[alpha_pos]) : s[alpha_pos];
+        channels_type srcAlpha = mul(mskAlpha, oparams.opacity);
+
+        if (dstAlpha != zeroValue<channels_type>()) {
+            d[0] = lerp(d[0], s[0], srcAlpha);
+            d[1] = lerp(d[1], s[1], srcAlpha);
+            d[2] = lerp(d[2], s[2], srcAlpha);
+        } else {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+        }
+
+        const channels_type averageOpacity = oparams.averageOpacity;
+        channels_type fullFlowAlpha;
+
+        if (averageOpacity > oparams.opacity) {
+            fullFlowAlpha = averageOpacity > dstAlpha ?
+                lerp(srcAlpha, averageOpacity, channels_type(KoColorSpaceMaths<channels_type>::divide(dstAlpha, averageOpacity))) :
+                dstAlpha;
+        } else {
+            fullFlowAlpha = oparams.opacity > dstAlpha ? lerp(dstAlpha, oparams.opacity, mskAlpha) : dstAlpha;
+        }
+
+        if (oparams.fullFlow) {
+            dstAlpha = fullFlowAlpha;
+        } else {
+            channels_type zeroFlowAlpha = _ParamsWrapper::calculateZeroFlowAlphaLegacy(srcAlpha, dstAlpha);
+            dstAlpha = lerp(zeroFlowAlpha, fullFlowAlpha, oparams.flow);
+        }
+
+        d[alpha_pos] = dstAlpha;
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with alpha channel placed at the last channel of
+ * the pixel: C1_C2_C3_A.
+ */
+template<Vc::Implementation _impl, class ParamsWrapper>
+class KoOptimizedCompositeOpAlphaDarken64Impl : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpAlphaDarken64Impl(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_ALPHA_DARKEN, i18n("Alpha darken"), KoCompositeOp::categoryMix()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            KoStreamedMath<_impl>::template genericComposite64<true, true, AlphaDarkenCompositor64<quint16, ParamsWrapper> >(params);
+        } else {
+            KoStreamedMath<_impl>::template genericComposite64<false, true, AlphaDarkenCompositor64<quint16, ParamsWrapper> >(params);
+        }
+    }
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHard64 :
+        public KoOptimizedCompositeOpAlphaDarken64Impl<_impl, KoAlphaDarkenParamsWrapperHard>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenHard64(const KoColorSpace *cs)
+        : KoOptimizedCompositeOpAlphaDarken64Impl<_impl, KoAlphaDarkenParamsWrapperHard>(cs) {
+    }
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamy64 :
+        public KoOptimizedCompositeOpAlphaDarken64Impl<_impl, KoAlphaDarkenParamsWrapperCreamy>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenCreamy64(const KoColorSpace *cs)
+        : KoOptimizedCompositeOpAlphaDarken64Impl<_impl, KoAlphaDarkenParamsWrapperCreamy>(cs) {
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
@@ -0,0 +1,213 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPCOPY64_H_
+#define KOOPTIMIZEDCOMPOSITEOPCOPY64_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include <klocalizedstring.h>
+#include "KoStreamedMath.h"
+
+/**
+ * The vectorized version of KoCompositeOpCopy2 for 16-bit channels.
+ * All the math is done in integers, so the result is bit-exact with
+ * the legacy scalar op.
+ */
+template<typename channels_type, bool alphaLocked, bool allChannelsFlag>
+struct CopyCompositor64 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags),
+              opacity(Arithmetic::scale<channels_type>(params.opacity))
+        {
+        }
+        const QBitArray &channelFlags;
+        channels_type opacity;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(opacity);
+
+        using uint_v = typename KoStreamedMath<_impl>::uint_v;
+
+        const uint_v unitValue(0xFFFFu);
+        const uint_v zeroValue(0u);
+
+        if (!haveMask) {
+            if (oparams.opacity == 0xFFFF) {
+                memcpy(dst, src, 8 * Vc::float_v::size());
+                return;
+            } else if (oparams.opacity == 0) {
+                return;
+            }
+        }
+
+        uint_v opacity_vec(oparams.opacity);
+
+        if (haveMask) {
+            // scale<quint16>(quint8) is just a multiplication by 257
+            const uint_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8_i(mask) * uint_v(257u);
+            opacity_vec = KoStreamedMath<_impl>::mul_u16(mask_vec, opacity_vec);
+
+            if ((opacity_vec == zeroValue).isFull()) {
+                return;
+            }
+        }
+
+        uint_v src_alpha;
+        uint_v src_c1;
+        uint_v src_c2;
+        uint_v src_c3;
+
+        uint_v dst_alpha;
+        uint_v dst_c1;
+        uint_v dst_c2;
+        uint_v dst_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_u16(src, src_alpha, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::fetch_channels_u16(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+
+        const uint_v new_alpha = KoStreamedMath<_impl>::lerp_u16(dst_alpha, src_alpha, opacity_vec);
+        const uint_v new_alpha_divisor = Vc::max(new_alpha, uint_v(1u));
+
+        const auto unchanged_colors_mask = (opacity_vec == zeroValue) || (new_alpha == zeroValue);
+        const auto copied_pixels_mask = opacity_vec == unitValue;
+
+        auto blendChannel = [&] (const uint_v &src_c, const uint_v &dst_c) {
+            // We use the most fundamental OVER algorithm here,
+            // which multiplies, blends and then unmultiplies the
+            // channels
+            const uint_v dst_mult = KoStreamedMath<_impl>::mul_u16(dst_c, dst_alpha);
+            const uint_v src_mult = KoStreamedMath<_impl>::mul_u16(src_c, src_alpha);
+            const uint_v blended = KoStreamedMath<_impl>::lerp_u16(dst_mult, src_mult, opacity_vec);
+
+            // divide() may overflow the channel range, that is clamped
+            uint_v result = KoStreamedMath<_impl>::divide_u16(Vc::min(blended, new_alpha_divisor), new_alpha_divisor);
+            result = Vc::iif(blended >= new_alpha, unitValue, result);
+
+            result = Vc::iif(unchanged_colors_mask, dst_c, result);
+            return Vc::iif(copied_pixels_mask, src_c, result);
+        };
+
+        dst_c1 = blendChannel(src_c1, dst_c1);
+        dst_c2 = blendChannel(src_c2, dst_c2);
+        dst_c3 = blendChannel(src_c3, dst_c3);
+
+        dst_alpha = Vc::iif(opacity_vec == zeroValue, dst_alpha, new_alpha);
+
+        KoStreamedMath<_impl>::write_channels_u16(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+    }
+
+    /**
+     * Repeats KoCompositeOpBase::genericComposite() and
+     * KoCompositeOpCopy2::composeColorChannels() for one pixel
+     */
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        using namespace Arithmetic;
+        const qint32 alpha_pos = 3;
+
+        Q_UNUSED(opacity);
+
+        const channels_type *s = reinterpret_cast<const channels_type*>(src);
+        channels_type *d = reinterpret_cast<channels_type*>(dst);
+
+        const channels_type srcAlpha = s[alpha_pos];
+        const channels_type dstAlpha = d[alpha_pos];
+        const channels_type mskAlpha = haveMask ? scale<channels_type>(*mask) : unitValue<channels_type>();
+        const QBitArray &channelFlags = oparams.channelFlags;
+
+        if (!allChannelsFlag && dstAlpha == zeroValue<channels_type>()) {
+            KoStreamedMathFunctions::clearPixel<8>(dst);
+        }
+
+        const channels_type blendOpacity = mul(mskAlpha, oparams.opacity);
+        channels_type newAlpha = zeroValue<channels_type>();
+
+        if (blendOpacity == unitValue<channels_type>()) {
+            if (!alphaLocked || srcAlpha != zeroValue<channels_type>()) {
+                for (qint32 i = 0; i < alpha_pos; ++i) {
+                    if (allChannelsFlag || channelFlags.testBit(i)) {
+                        d[i] = s[i];
+                    }
+                }
+            }
+
+            newAlpha = srcAlpha;
+
+        } else if (blendOpacity == zeroValue<channels_type>()) {
+
+            newAlpha = dstAlpha;
+
+        } else if (!alphaLocked || srcAlpha != zeroValue<channels_type>()) {
+
+            newAlpha = lerp(dstAlpha, srcAlpha, blendOpacity);
+
+            if (newAlpha != zeroValue<channels_type>()) {
+                for (qint32 i = 0; i < alpha_pos; ++i) {
+                    if (allChannelsFlag || channelFlags.testBit(i)) {
+                        const channels_type dstMult = mul(d[i], dstAlpha);
+                        const channels_type srcMult = mul(s[i], srcAlpha);
+                        const channels_type blendedValue = lerp(dstMult, srcMult, blendOpacity);
+
+                        d[i] = KoColorSpaceMaths<channels_type>::clampAfterScale(
+                            KoColorSpaceMaths<channels_type>::divide(blendedValue, newAlpha));
+                    }
+                }
+            }
+        }
+
+        d[alpha_pos] = alphaLocked ? dstAlpha : newAlpha;
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with alpha channel placed at the last channel of
+ * the pixel: C1_C2_C3_A.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopy64 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpCopy64(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_COPY, i18n("Copy"), KoCompositeOp::categoryMisc()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite64<haveMask, false, CopyCompositor64<quint16, false, true> >(params);
+        } else {
+            const bool alphaLocked = !params.channelFlags.testBit(3);
+
+            if (alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, CopyCompositor64<quint16, true, false> >(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, CopyCompositor64<quint16, false, false> >(params);
+            }
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPCOPY64_H_
@@ -44,6 +44,30 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp32(const KoColorSpace
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32> >(cs);
 }
 
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<
+        KoOptimizedCompositeOpFactoryPerArch<
+            KoOptimizedCompositeOpAlphaDarkenHard64>>(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<
+        KoOptimizedCompositeOpFactoryPerArch<
+            KoOptimizedCompositeOpAlphaDarkenCreamy64>>(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64> >(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createCopyOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64> >(cs);
+}
+
 KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard128(const KoColorSpace *cs)
 {
     return createOptimizedClass<
@@ -63,3 +87,21 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp128(const KoColorSpace
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128> >(cs);
 }
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericSCOp32(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category)
+{
+    const KoOptimizedCompositeOpGenericSCParams params = {cs, mode, id, description, category};
+    return createOptimizedClass<KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU8Traits> >(params);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericSCOp64(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category)
+{
+    const KoOptimizedCompositeOpGenericSCParams params = {cs, mode, id, description, category};
+    return createOptimizedClass<KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU16Traits> >(params);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericSCOp128(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category)
+{
+    const KoOptimizedCompositeOpGenericSCParams params = {cs, mode, id, description, category};
+    return createOptimizedClass<KoOptimizedCompositeOpGenericSCFactoryPerArch<KoRgbF32Traits> >(params);
+}
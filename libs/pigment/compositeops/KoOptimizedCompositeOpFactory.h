@@ -24,6 +24,7 @@
 
 class KoCompositeOp;
 class KoColorSpace;
+class QString;
 
 /**
  * The creation of the optimized composite ops is moved into a separate
@@ -43,9 +44,47 @@ public:
     static KoCompositeOp* createAlphaDarkenOpHard32(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOpCreamy32(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp32(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOpHard64(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOpCreamy64(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOp64(const KoColorSpace *cs);
+    static KoCompositeOp* createCopyOp64(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOpHard128(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOpCreamy128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    /**
+     * Separable blending modes that have a vectorized implementation
+     */
+    enum GenericSCMode {
+        GenericSCNone,
+        GenericSCMultiply,
+        GenericSCScreen,
+        GenericSCOverlay,
+        GenericSCHardLight,
+        GenericSCAddition,
+        GenericSCSubtract,
+        GenericSCLinearBurn,
+        GenericSCColorDodge,
+        GenericSCDarken,
+        GenericSCLighten,
+        GenericSCDifference,
+        GenericSCExclusion
+    };
+
+    /**
+     * Create a vectorized version of the separable blending \p mode for
+     * the pixels of 4, 8 and 16 bytes. Returns null if there is no
+     * vectorized implementation for the current CPU, in that case
+     * KoCompositeOpGenericSC should be used instead.
+     *
+     * The math is done in floating point, so only the 128-bit version
+     * matches KoCompositeOpGenericSC closely enough to be used by the
+     * color spaces. The 32- and 64-bit versions differ from the integer
+     * ops in rounding and are used only for benchmarking.
+     */
+    static KoCompositeOp* createGenericSCOp32(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createGenericSCOp64(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createGenericSCOp128(const KoColorSpace *cs, GenericSCMode mode, const QString &id, const QString &description, const QString &category);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
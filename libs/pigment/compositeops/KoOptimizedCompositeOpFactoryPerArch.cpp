@@ -23,9 +23,14 @@
 
 #include "KoOptimizedCompositeOpFactoryPerArch.h"
 #include "KoOptimizedCompositeOpAlphaDarken32.h"
+#include "KoOptimizedCompositeOpAlphaDarken64.h"
 #include "KoOptimizedCompositeOpAlphaDarken128.h"
 #include "KoOptimizedCompositeOpOver32.h"
+#include "KoOptimizedCompositeOpOver64.h"
 #include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpCopy64.h"
+#include "KoOptimizedCompositeOpGenericSC.h"
+#include "KoColorSpaceTraits.h"
 
 #include <QString>
 #include "DebugPigment.h"
@@ -61,6 +66,38 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32>::create<Vc::C
     return new KoOptimizedCompositeOpOver32<Vc::CurrentImplementation::current()>(param);
 }
 
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenHard64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenCreamy64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpOver64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpCopy64<Vc::CurrentImplementation::current()>(param);
+}
+
 template<>
 template<>
 KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard128>::ReturnType
@@ -85,3 +122,27 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoOptimizedCompositeOpOver128<Vc::CurrentImplementation::current()>(param);
 }
+
+template<>
+template<>
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU8Traits>::ReturnType
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU8Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return KoOptimizedCompositeOpGenericSCCreator<Vc::CurrentImplementation::current(), KoBgrU8Traits>::create(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU16Traits>::ReturnType
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoBgrU16Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return KoOptimizedCompositeOpGenericSCCreator<Vc::CurrentImplementation::current(), KoBgrU16Traits>::create(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoRgbF32Traits>::ReturnType
+KoOptimizedCompositeOpGenericSCFactoryPerArch<KoRgbF32Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return KoOptimizedCompositeOpGenericSCCreator<Vc::CurrentImplementation::current(), KoRgbF32Traits>::create(param);
+}
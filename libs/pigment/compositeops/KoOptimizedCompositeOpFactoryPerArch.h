@@ -23,9 +23,15 @@
 
 #include <compositeops/KoVcMultiArchBuildSupport.h>
 
+#include <QString>
+
+#include "KoOptimizedCompositeOpFactory.h"
 
 class KoCompositeOp;
 class KoColorSpace;
+struct KoBgrU8Traits;
+struct KoBgrU16Traits;
+struct KoRgbF32Traits;
 
 
 template<Vc::Implementation _impl>
@@ -37,6 +43,18 @@ class KoOptimizedCompositeOpAlphaDarkenHard32;
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver32;
 
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHard64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamy64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOver64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopy64;
+
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpAlphaDarkenHard128;
 
@@ -56,5 +74,29 @@ struct KoOptimizedCompositeOpFactoryPerArch
     static ReturnType create(ParamType param);
 };
 
+struct KoOptimizedCompositeOpGenericSCParams
+{
+    const KoColorSpace *cs;
+    KoOptimizedCompositeOpFactory::GenericSCMode mode;
+    QString id;
+    QString description;
+    QString category;
+};
+
+/**
+ * Creates a vectorized version of a separable blending mode for the
+ * pixel layout of \p Traits. The created op is null if there is no
+ * vectorized implementation for the requested mode.
+ */
+template<class Traits>
+struct KoOptimizedCompositeOpGenericSCFactoryPerArch
+{
+    typedef const KoOptimizedCompositeOpGenericSCParams& ParamType;
+    typedef KoCompositeOp* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType param);
+};
+
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORYPERARCH_H */
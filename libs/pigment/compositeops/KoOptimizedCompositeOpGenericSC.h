@@ -0,0 +1,495 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
+
+#include <limits>
+
+#include "KoCompositeOpBase.h"
+#include "KoStreamedMath.h"
+#include "KoOptimizedCompositeOpFactoryPerArch.h"
+
+/**
+ * Loads and stores the channels of Vc::float_v::size() pixels with
+ * four channels each (C1_C2_C3_A) of the given channel type. The
+ * color channels are returned in their native range, e.g. [0, 255]
+ * for 8-bit channels, and the order of the color channels is not
+ * guaranteed, so this access can only be used for separable modes.
+ */
+template<Vc::Implementation _impl, typename channels_type>
+struct KoStreamedPixelAccess;
+
+template<Vc::Implementation _impl>
+struct KoStreamedPixelAccess<_impl, quint8>
+{
+    template <bool aligned>
+    static ALWAYS_INLINE void fetch(const quint8 *data, Vc::float_v &alpha, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3) {
+        alpha = KoStreamedMath<_impl>::template fetch_alpha_32<aligned>(data);
+        KoStreamedMath<_impl>::template fetch_colors_32<aligned>(data, c1, c2, c3);
+    }
+
+    // NOTE: \p data must be aligned pointer!
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg alpha, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3) {
+        KoStreamedMath<_impl>::write_channels_32(data, alpha, c1, c2, c3);
+    }
+
+    static ALWAYS_INLINE quint8 fromFloat(float value) {
+        return KoStreamedMath<_impl>::round_float_to_uint(qBound(0.0f, value, 255.0f));
+    }
+};
+
+template<Vc::Implementation _impl>
+struct KoStreamedPixelAccess<_impl, quint16>
+{
+    template <bool aligned>
+    static ALWAYS_INLINE void fetch(const quint8 *data, Vc::float_v &alpha, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3) {
+        KoStreamedMath<_impl>::fetch_channels_64(data, alpha, c1, c2, c3);
+    }
+
+    /**
+     * The channels are packed with a mask, so the values are clamped
+     * to keep an overshoot from wrapping around to zero
+     */
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg alpha, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3) {
+        KoStreamedMath<_impl>::write_channels_64(data, clamp(alpha), clamp(c1), clamp(c2), clamp(c3));
+    }
+
+    static ALWAYS_INLINE Vc::float_v clamp(Vc::float_v::AsArg value) {
+        const Vc::float_v unitValue(float(KoColorSpaceMathsTraits<quint16>::unitValue));
+        return Vc::min(Vc::max(value, Vc::float_v(Vc::Zero)), unitValue);
+    }
+
+    static ALWAYS_INLINE quint16 fromFloat(float value) {
+        const float unitValue = KoColorSpaceMathsTraits<quint16>::unitValue;
+        return quint16(qBound(0.0f, value, unitValue) + float(0.5));
+    }
+};
+
+template<Vc::Implementation _impl>
+struct KoStreamedPixelAccess<_impl, float>
+{
+    struct Pixel {
+        float c1;
+        float c2;
+        float c3;
+        float alpha;
+    };
+
+    template <bool aligned>
+    static ALWAYS_INLINE void fetch(const quint8 *data, Vc::float_v &alpha, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3) {
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> pixels(reinterpret_cast<Pixel*>(const_cast<quint8*>(data)));
+        tie(c1, c2, c3, alpha) = pixels[indexes];
+    }
+
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg alpha, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3) {
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> pixels(reinterpret_cast<Pixel*>(data));
+        pixels[indexes] = tie(c1, c2, c3, alpha);
+    }
+
+    static ALWAYS_INLINE float fromFloat(float value) {
+        return value;
+    }
+};
+
+/**
+ * Helpers that let a blending function be written once for both
+ * a single float and Vc::float_v
+ */
+template<Vc::Implementation _impl>
+struct KoStreamedBlendMath
+{
+    static ALWAYS_INLINE float min(float a, float b) { return qMin(a, b); }
+    static ALWAYS_INLINE float max(float a, float b) { return qMax(a, b); }
+    static ALWAYS_INLINE float select(bool cond, float a, float b) { return cond ? a : b; }
+
+    static ALWAYS_INLINE Vc::float_v min(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::min(a, b); }
+    static ALWAYS_INLINE Vc::float_v max(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::max(a, b); }
+    static ALWAYS_INLINE Vc::float_v select(const Vc::float_m &cond, Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::iif(cond, a, b); }
+
+    /**
+     * Integer channels saturate the same way Arithmetic::clamp() does,
+     * float channels are not clamped at all to keep HDR values intact
+     */
+    template <typename channels_type, typename V>
+    static ALWAYS_INLINE V clampToChannel(const V &value) {
+        if (std::numeric_limits<channels_type>::is_integer) {
+            return min(max(value, V(0.0f)), V(float(KoColorSpaceMathsTraits<channels_type>::unitValue)));
+        }
+        return value;
+    }
+};
+
+/**
+ * Vectorized counterparts of the separable blending functions from
+ * KoCompositeOpFunctions.h. The values are passed in the native range
+ * of \p channels_type, but converted to float.
+ */
+struct KoStreamedBlendMultiply
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V unitRec(1.0f / float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        return src * dst * unitRec;
+    }
+};
+
+struct KoStreamedBlendScreen
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V unitRec(1.0f / float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        return src + dst - src * dst * unitRec;
+    }
+};
+
+struct KoStreamedBlendHardLight
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V unit(float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        const V half(float(KoColorSpaceMathsTraits<channels_type>::halfValue));
+
+        const V src2 = src + src;
+        const V screenSrc = src2 - unit;
+
+        return KoStreamedBlendMath<_impl>::select(src > half,
+                                                  KoStreamedBlendScreen::blend<_impl, channels_type>(screenSrc, dst),
+                                                  KoStreamedBlendMultiply::blend<_impl, channels_type>(src2, dst));
+    }
+};
+
+struct KoStreamedBlendOverlay
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendHardLight::blend<_impl, channels_type>(dst, src);
+    }
+};
+
+struct KoStreamedBlendAddition
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendMath<_impl>::template clampToChannel<channels_type>(src + dst);
+    }
+};
+
+struct KoStreamedBlendSubtract
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendMath<_impl>::template clampToChannel<channels_type>(dst - src);
+    }
+};
+
+struct KoStreamedBlendLinearBurn
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V unit(float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        return KoStreamedBlendMath<_impl>::template clampToChannel<channels_type>(src + dst - unit);
+    }
+};
+
+struct KoStreamedBlendColorDodge
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V unit(float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        const V zero(0.0f);
+        const V invSrc = unit - src;
+
+        // the division by zero is masked out by select()
+        const V result = KoStreamedBlendMath<_impl>::template clampToChannel<channels_type>(dst * unit / invSrc);
+        return KoStreamedBlendMath<_impl>::select(invSrc == zero, unit, result);
+    }
+};
+
+struct KoStreamedBlendDarken
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendMath<_impl>::min(src, dst);
+    }
+};
+
+struct KoStreamedBlendLighten
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendMath<_impl>::max(src, dst);
+    }
+};
+
+struct KoStreamedBlendDifference
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        return KoStreamedBlendMath<_impl>::max(src, dst) - KoStreamedBlendMath<_impl>::min(src, dst);
+    }
+};
+
+struct KoStreamedBlendExclusion
+{
+    template <Vc::Implementation _impl, typename channels_type, typename V>
+    static ALWAYS_INLINE V blend(const V &src, const V &dst) {
+        const V x = KoStreamedBlendMultiply::blend<_impl, channels_type>(src, dst);
+        return KoStreamedBlendMath<_impl>::template clampToChannel<channels_type>(dst + src - (x + x));
+    }
+};
+
+/**
+ * Compositor for separable blending modes. It implements the same
+ * alpha handling as KoCompositeOpGenericSC, but does the math in
+ * floating point, which lets it process Vc::float_v::size() pixels
+ * at once.
+ */
+template<typename Traits, class BlendFunc, bool alphaLocked, bool allChannelsFlag>
+struct GenericSCCompositor {
+    typedef typename Traits::channels_type channels_type;
+    static const qint32 alpha_pos = Traits::alpha_pos;
+
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE Vc::float_v blendChannel(Vc::float_v::AsArg src, Vc::float_v::AsArg dst,
+                                                  Vc::float_v::AsArg srcWeight, Vc::float_v::AsArg dstWeight, Vc::float_v::AsArg blendWeight,
+                                                  Vc::float_v::AsArg newAlphaRec, const Vc::float_m &emptyPixels)
+    {
+        const Vc::float_v blended = BlendFunc::template blend<_impl, channels_type>(src, dst);
+        const Vc::float_v result = (dstWeight * dst + srcWeight * src + blendWeight * blended) * newAlphaRec;
+        return Vc::iif(emptyPixels, dst, result);
+    }
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+        typedef KoStreamedPixelAccess<_impl, channels_type> PixelAccess;
+
+        const Vc::float_v unitValue(float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        const Vc::float_v unitValueRec(1.0f / float(KoColorSpaceMathsTraits<channels_type>::unitValue));
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha;
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        PixelAccess::template fetch<src_aligned>(src, src_alpha, src_c1, src_c2, src_c3);
+
+        src_alpha *= Vc::float_v(opacity) * unitValueRec;
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha;
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        PixelAccess::template fetch<true>(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+
+        dst_alpha *= unitValueRec;
+
+        const Vc::float_v blendWeight = src_alpha * dst_alpha;
+        const Vc::float_v srcWeight = src_alpha - blendWeight;
+        const Vc::float_v dstWeight = dst_alpha - blendWeight;
+        const Vc::float_v new_alpha = srcWeight + dst_alpha;
+
+        /**
+         * The value of new_alpha can have *some* zero values,
+         * which will result in NaN values while division. These
+         * pixels keep their color, just like in the scalar version.
+         */
+        const Vc::float_m emptyPixels = new_alpha == zeroValue;
+        const Vc::float_v newAlphaRec = oneValue / new_alpha;
+
+        dst_c1 = blendChannel<_impl>(src_c1, dst_c1, srcWeight, dstWeight, blendWeight, newAlphaRec, emptyPixels);
+        dst_c2 = blendChannel<_impl>(src_c2, dst_c2, srcWeight, dstWeight, blendWeight, newAlphaRec, emptyPixels);
+        dst_c3 = blendChannel<_impl>(src_c3, dst_c3, srcWeight, dstWeight, blendWeight, newAlphaRec, emptyPixels);
+
+        PixelAccess::write(dst, new_alpha * unitValue, dst_c1, dst_c2, dst_c3);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        typedef KoStreamedPixelAccess<_impl, channels_type> PixelAccess;
+
+        const channels_type *s = reinterpret_cast<const channels_type*>(src);
+        channels_type *d = reinterpret_cast<channels_type*>(dst);
+
+        const float unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
+        const float unitValueRec = 1.0f / unitValue;
+
+        float srcAlpha = float(s[alpha_pos]) * unitValueRec * opacity;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255.0;
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        const float dstAlpha = float(d[alpha_pos]) * unitValueRec;
+
+        if (!allChannelsFlag && dstAlpha == 0.0f) {
+            memset(dst, 0, Traits::pixelSize);
+        }
+
+        if (alphaLocked) {
+            if (dstAlpha != 0.0f) {
+                for (qint32 i = 0; i < alpha_pos; i++) {
+                    if (allChannelsFlag || oparams.channelFlags.testBit(i)) {
+                        const float srcValue = s[i];
+                        const float dstValue = d[i];
+                        const float blended = BlendFunc::template blend<_impl, channels_type>(srcValue, dstValue);
+                        d[i] = PixelAccess::fromFloat(dstValue + (blended - dstValue) * srcAlpha);
+                    }
+                }
+            }
+        } else {
+            const float blendWeight = srcAlpha * dstAlpha;
+            const float srcWeight = srcAlpha - blendWeight;
+            const float dstWeight = dstAlpha - blendWeight;
+            const float newAlpha = srcWeight + dstAlpha;
+
+            if (newAlpha != 0.0f) {
+                const float newAlphaRec = 1.0f / newAlpha;
+
+                for (qint32 i = 0; i < alpha_pos; i++) {
+                    if (allChannelsFlag || oparams.channelFlags.testBit(i)) {
+                        const float srcValue = s[i];
+                        const float dstValue = d[i];
+                        const float blended = BlendFunc::template blend<_impl, channels_type>(srcValue, dstValue);
+                        d[i] = PixelAccess::fromFloat((dstWeight * dstValue + srcWeight * srcValue + blendWeight * blended) * newAlphaRec);
+                    }
+                }
+            }
+
+            d[alpha_pos] = PixelAccess::fromFloat(newAlpha * unitValue);
+        }
+    }
+};
+
+/**
+ * An optimized version of KoCompositeOpGenericSC for the use in 4 channel
+ * colorspaces with alpha channel placed at the last channel of the
+ * pixel: C1_C2_C3_A. Supported channel types are quint8, quint16 and float.
+ */
+template<Vc::Implementation _impl, typename Traits, class BlendFunc>
+class KoOptimizedCompositeOpGenericSC : public KoCompositeOp
+{
+    typedef typename Traits::channels_type channels_type;
+    static const qint32 pixelSize = Traits::pixelSize;
+
+public:
+    KoOptimizedCompositeOpGenericSC(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
+        : KoCompositeOp(cs, id, description, category) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite<haveMask, false, GenericSCCompositor<Traits, BlendFunc, false, true>, pixelSize>(params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite_novector<haveMask, false, GenericSCCompositor<Traits, BlendFunc, true, true>, pixelSize>(params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite_novector<haveMask, false, GenericSCCompositor<Traits, BlendFunc, false, false>, pixelSize>(params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                KoStreamedMath<_impl>::template genericComposite_novector<haveMask, false, GenericSCCompositor<Traits, BlendFunc, true, false>, pixelSize>(params);
+            }
+        }
+    }
+};
+
+/**
+ * Creates an optimized op for \p params.mode, or returns null if the
+ * blending mode has no vectorized implementation
+ */
+template<Vc::Implementation _impl, typename Traits>
+struct KoOptimizedCompositeOpGenericSCCreator
+{
+    template <class BlendFunc>
+    static KoCompositeOp* createOp(const KoOptimizedCompositeOpGenericSCParams &params) {
+        return new KoOptimizedCompositeOpGenericSC<_impl, Traits, BlendFunc>(params.cs, params.id, params.description, params.category);
+    }
+
+    static KoCompositeOp* create(const KoOptimizedCompositeOpGenericSCParams &params) {
+        switch (params.mode) {
+        case KoOptimizedCompositeOpFactory::GenericSCMultiply:
+            return createOp<KoStreamedBlendMultiply>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCScreen:
+            return createOp<KoStreamedBlendScreen>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCOverlay:
+            return createOp<KoStreamedBlendOverlay>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCHardLight:
+            return createOp<KoStreamedBlendHardLight>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCAddition:
+            return createOp<KoStreamedBlendAddition>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCSubtract:
+            return createOp<KoStreamedBlendSubtract>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCLinearBurn:
+            return createOp<KoStreamedBlendLinearBurn>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCColorDodge:
+            return createOp<KoStreamedBlendColorDodge>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCDarken:
+            return createOp<KoStreamedBlendDarken>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCLighten:
+            return createOp<KoStreamedBlendLighten>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCDifference:
+            return createOp<KoStreamedBlendDifference>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCExclusion:
+            return createOp<KoStreamedBlendExclusion>(params);
+        case KoOptimizedCompositeOpFactory::GenericSCNone:
+            break;
+        }
+
+        return 0;
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
@@ -0,0 +1,211 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPOVER64_H_
+#define KOOPTIMIZEDCOMPOSITEOPOVER64_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+/**
+ * The vectorized version of KoCompositeOpOver for 16-bit channels.
+ *
+ * Contrary to OverCompositor32, all the math is done in integers and
+ * repeats KoCompositeOpAlphaBase step by step, so the result is
+ * bit-exact with the legacy scalar op.
+ */
+template<typename channels_type, bool alphaLocked, bool allChannelsFlag>
+struct OverCompositor64 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+            // KoCompositeOpAlphaBase works with the 8-bit opacity only
+            opacity8 = Arithmetic::scale<quint8>(params.opacity);
+            opacity = KoColorSpaceMaths<quint8, channels_type>::scaleToA(opacity8);
+        }
+        const QBitArray &channelFlags;
+        quint8 opacity8;
+        channels_type opacity;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(opacity);
+
+        using uint_v = typename KoStreamedMath<_impl>::uint_v;
+
+        const uint_v unitValue(0xFFFFu);
+        const uint_v zeroValue(0u);
+
+        uint_v src_alpha;
+        uint_v src_c1;
+        uint_v src_c2;
+        uint_v src_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_u16(src, src_alpha, src_c1, src_c2, src_c3);
+
+        const bool haveOpacity = oparams.opacity != 0xFFFF;
+
+        if (haveMask) {
+            // equivalent to KoColorSpaceMaths<quint8, quint16>::multiply(mask, alpha, opacity)
+            const uint_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8_i(mask);
+            src_alpha = KoStreamedMath<_impl>::div_floor_u16(mask_vec * src_alpha * uint_v(oparams.opacity8),
+                                                            uint_v(255u * 255u));
+        } else if (haveOpacity) {
+            src_alpha = KoStreamedMath<_impl>::mul_u16(src_alpha, uint_v(oparams.opacity));
+        }
+
+        const auto empty_src_pixels_mask = src_alpha == zeroValue;
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if (empty_src_pixels_mask.isFull()) {
+            return;
+        }
+
+        if (!haveMask && !haveOpacity && (src_alpha == unitValue).isFull()) {
+            memcpy(dst, src, 8 * Vc::float_v::size());
+            return;
+        }
+
+        uint_v dst_alpha;
+        uint_v dst_c1;
+        uint_v dst_c2;
+        uint_v dst_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_u16(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+
+        /**
+         * The general formula gives exactly the same result as the
+         * special cases of KoCompositeOpAlphaBase: when dst is opaque
+         * the blend factor is equal to the source alpha and when dst
+         * is transparent the blend factor is unit.
+         *
+         * The new alpha is zero only for the pixels where both the
+         * source and destination are transparent, these pixels are
+         * left untouched below.
+         */
+        uint_v new_alpha = dst_alpha + KoStreamedMath<_impl>::mul_u16(unitValue - dst_alpha, src_alpha);
+        const uint_v src_blend = KoStreamedMath<_impl>::divide_u16(src_alpha, Vc::max(new_alpha, uint_v(1u)));
+
+        uint_v new_c1 = KoStreamedMath<_impl>::lerp_u16(dst_c1, src_c1, src_blend);
+        uint_v new_c2 = KoStreamedMath<_impl>::lerp_u16(dst_c2, src_c2, src_blend);
+        uint_v new_c3 = KoStreamedMath<_impl>::lerp_u16(dst_c3, src_c3, src_blend);
+
+        if (!empty_src_pixels_mask.isEmpty()) {
+            new_c1 = Vc::iif(empty_src_pixels_mask, dst_c1, new_c1);
+            new_c2 = Vc::iif(empty_src_pixels_mask, dst_c2, new_c2);
+            new_c3 = Vc::iif(empty_src_pixels_mask, dst_c3, new_c3);
+            new_alpha = Vc::iif(empty_src_pixels_mask, dst_alpha, new_alpha);
+        }
+
+        KoStreamedMath<_impl>::write_channels_u16(dst, new_alpha, new_c1, new_c2, new_c3);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(opacity);
+
+        const qint32 alpha_pos = 3;
+        const channels_type unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
+        const channels_type zeroValue = KoColorSpaceMathsTraits<channels_type>::zeroValue;
+
+        const channels_type *s = reinterpret_cast<const channels_type*>(src);
+        channels_type *d = reinterpret_cast<channels_type*>(dst);
+
+        channels_type srcAlpha = s[alpha_pos];
+
+        if (haveMask) {
+            srcAlpha = KoColorSpaceMaths<quint8, channels_type>::multiply(*mask, srcAlpha, oparams.opacity);
+        } else if (oparams.opacity != unitValue) {
+            srcAlpha = KoColorSpaceMaths<channels_type>::multiply(srcAlpha, oparams.opacity);
+        }
+
+        if (srcAlpha != zeroValue) {
+            channels_type dstAlpha = d[alpha_pos];
+            channels_type srcBlend;
+
+            if (alphaLocked || dstAlpha == unitValue) {
+                srcBlend = srcAlpha;
+            } else if (dstAlpha == zeroValue) {
+                if (!allChannelsFlag) {
+                    KoStreamedMathFunctions::clearPixel<8>(dst);
+                }
+
+                d[alpha_pos] = srcAlpha;
+                srcBlend = unitValue;
+            } else {
+                const channels_type newAlpha = dstAlpha + KoColorSpaceMaths<channels_type>::multiply(unitValue - dstAlpha, srcAlpha);
+
+                if (!alphaLocked) {
+                    d[alpha_pos] = newAlpha;
+                }
+                srcBlend = KoColorSpaceMaths<channels_type>::divide(srcAlpha, newAlpha);
+            }
+
+            const QBitArray &channelFlags = oparams.channelFlags;
+
+            for (int i = 0; i < alpha_pos; i++) {
+                if (allChannelsFlag || channelFlags.testBit(i)) {
+                    d[i] = srcBlend == unitValue ?
+                        s[i] : KoColorSpaceMaths<channels_type>::blend(s[i], d[i], srcBlend);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with alpha channel placed at the last channel of
+ * the pixel: C1_C2_C3_A.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOver64 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpOver64(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_OVER, i18n("Normal"), KoCompositeOp::categoryMix()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite64<haveMask, false, OverCompositor64<quint16, false, true> >(params);
+        } else {
+            /**
+             * KoCompositeOpAlphaBase treats all non-empty channel flags
+             * as partial ones, so do we
+             */
+            const bool alphaLocked = !params.channelFlags.testBit(3);
+
+            if (alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, OverCompositor64<quint16, true, false> >(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, OverCompositor64<quint16, false, false> >(params);
+            }
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPOVER64_H_
@@ -97,6 +97,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite_novector<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64_novector(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite_novector<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128_novector(const KoCompositeOp::ParameterInfo& params)
 {
@@ -120,6 +126,13 @@ static inline Vc::float_v fetch_mask_8(const quint8 *data) {
     return Vc::simd_cast<Vc::float_v>(int_v(data_i));
 }
 
+/**
+ * Same as fetch_mask_8(), but returns the mask values as integers
+ */
+static inline uint_v fetch_mask_8_i(const quint8 *data) {
+    return uint_v(data);
+}
+
 /**
  * Get an alpha values from Vc::float_v::size() pixels 32-bit each
  * (4 channels, 8 bit per channel).  The alpha value is considered
@@ -209,6 +222,150 @@ static inline void write_channels_32(quint8 *data,
     (v1 | v3).store((quint32*)data, Vc::Aligned);
 }
 
+/**
+ * Get channel values from Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel) as integers. The alpha value is
+ * considered to be stored in the last channel of the pixel.
+ *
+ * Every pixel is read as two 32-bit words, so the data is not required
+ * to be aligned.
+ */
+static inline void fetch_channels_u16(const quint8 *data,
+                                      uint_v &alpha,
+                                      uint_v &c1,
+                                      uint_v &c2,
+                                      uint_v &c3) {
+    const quint32 *words = reinterpret_cast<const quint32*>(data);
+    const int_v indexes(Vc::IndexesFromZero);
+
+    uint_v lowWords;
+    uint_v highWords;
+    lowWords.gather(words, indexes * 2);
+    highWords.gather(words, indexes * 2 + 1);
+
+    const quint32 lowWordMask = 0xFFFF;
+    uint_v mask(lowWordMask);
+
+    c1 = lowWords & mask;
+    c2 = lowWords >> 16;
+    c3 = highWords & mask;
+    alpha = highWords >> 16;
+}
+
+/**
+ * Pack integer channel values to Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The values must already be in
+ * range [0, 0xFFFF].
+ */
+static inline void write_channels_u16(quint8 *data,
+                                      const uint_v &alpha,
+                                      const uint_v &c1,
+                                      const uint_v &c2,
+                                      const uint_v &c3) {
+    quint32 *words = reinterpret_cast<quint32*>(data);
+    const int_v indexes(Vc::IndexesFromZero);
+
+    const uint_v lowWords = c1 | (c2 << 16);
+    const uint_v highWords = c3 | (alpha << 16);
+
+    lowWords.scatter(words, indexes * 2);
+    highWords.scatter(words, indexes * 2 + 1);
+}
+
+/**
+ * Get color and alpha values from Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The alpha value is considered to be
+ * stored in the last channel of the pixel.
+ */
+static inline void fetch_channels_64(const quint8 *data,
+                                     Vc::float_v &alpha,
+                                     Vc::float_v &c1,
+                                     Vc::float_v &c2,
+                                     Vc::float_v &c3) {
+    uint_v alpha_i;
+    uint_v c1_i;
+    uint_v c2_i;
+    uint_v c3_i;
+
+    fetch_channels_u16(data, alpha_i, c1_i, c2_i, c3_i);
+
+    c1 = Vc::simd_cast<Vc::float_v>(int_v(c1_i));
+    c2 = Vc::simd_cast<Vc::float_v>(int_v(c2_i));
+    c3 = Vc::simd_cast<Vc::float_v>(int_v(c3_i));
+    alpha = Vc::simd_cast<Vc::float_v>(int_v(alpha_i));
+}
+
+/**
+ * Pack color and alpha values to Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The alpha value is stored in the
+ * last channel of the pixel.
+ */
+static inline void write_channels_64(quint8 *data,
+                                     Vc::float_v::AsArg alpha,
+                                     Vc::float_v::AsArg c1,
+                                     Vc::float_v::AsArg c2,
+                                     Vc::float_v::AsArg c3) {
+
+    const quint32 lowWordMask = 0xFFFF;
+    uint_v mask(lowWordMask);
+
+    write_channels_u16(data,
+                       uint_v(int_v(Vc::round(alpha))) & mask,
+                       uint_v(int_v(Vc::round(c1))) & mask,
+                       uint_v(int_v(Vc::round(c2))) & mask,
+                       uint_v(int_v(Vc::round(c3))) & mask);
+}
+
+/**
+ * Exact integer division floor(\p n / \p d) for the case when
+ * the quotient is known to fit into 16 bits. The quotient is first
+ * estimated in floating point and then corrected by the remainder,
+ * so the result is bit-exact with the scalar integer division.
+ */
+static inline uint_v div_floor_u16(const uint_v &n, const uint_v &d) {
+    const quint32 lowWordMask = 0xFFFF;
+
+    // n may not fit into a signed integer, so convert it in two halves
+    const Vc::float_v n_f =
+        Vc::simd_cast<Vc::float_v>(int_v(n >> 16)) * Vc::float_v(65536.0f) +
+        Vc::simd_cast<Vc::float_v>(int_v(n & uint_v(lowWordMask)));
+    const Vc::float_v d_f = Vc::simd_cast<Vc::float_v>(int_v(d));
+
+    int_v q(n_f / d_f);
+    const int_v r(n - uint_v(q) * d);
+
+    q = Vc::iif(r < int_v(0), q - int_v(1),
+                Vc::iif(r >= int_v(d), q + int_v(1), q));
+
+    return uint_v(q);
+}
+
+/**
+ * Vectorized version of UINT16_MULT()
+ */
+static inline uint_v mul_u16(const uint_v &a, const uint_v &b) {
+    const uint_v c = a * b + uint_v(0x8000u);
+    return ((c >> 16) + c) >> 16;
+}
+
+/**
+ * Vectorized version of UINT16_DIVIDE(). The result is valid only
+ * when \p a <= \p b, that is, the quotient fits into 16 bits.
+ */
+static inline uint_v divide_u16(const uint_v &a, const uint_v &b) {
+    return div_floor_u16(a * uint_v(0xFFFFu) + (b >> 1), b);
+}
+
+/**
+ * Vectorized version of Arithmetic::lerp() for quint16, that is
+ * KoColorSpaceMaths<quint16>::blend(b, a, alpha)
+ */
+static inline uint_v lerp_u16(const uint_v &a, const uint_v &b, const uint_v &alpha) {
+    const int_v diff = int_v(b) - int_v(a);
+    const int_v q(div_floor_u16(uint_v(Vc::abs(diff)) * alpha, uint_v(0xFFFFu)));
+    return uint_v(int_v(a) + Vc::iif(diff < int_v(0), -q, q));
+}
+
 /**
  * Composes src pixels into dst pixles. Is optimized for 32-bit-per-pixel
  * colorspaces. Uses \p Compositor strategy parameter for doing actual
@@ -376,6 +533,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128(const KoCompositeOp::ParameterInfo& params)
 {
@@ -396,6 +559,13 @@ ALWAYS_INLINE void clearPixel<4>(quint8* dst)
     *d = 0;
 }
 
+template<>
+ALWAYS_INLINE void clearPixel<8>(quint8* dst)
+{
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = 0;
+}
+
 template<>
 ALWAYS_INLINE void clearPixel<16>(quint8* dst)
 {
@@ -415,6 +585,14 @@ ALWAYS_INLINE void copyPixel<4>(const quint8 *src, quint8* dst)
     *d = *s;
 }
 
+template<>
+ALWAYS_INLINE void copyPixel<8>(const quint8 *src, quint8* dst)
+{
+    const quint64 *s = reinterpret_cast<const quint64*>(src);
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = *s;
+}
+
 template<>
 ALWAYS_INLINE void copyPixel<16>(const quint8 *src, quint8* dst)
 {
@@ -0,0 +1,451 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "TestKoOptimizedCompositeOps.h"
+
+#include <QTest>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+
+#include <KoColorSpaceTraits.h>
+#include <KoCompositeOpRegistry.h>
+#include <KoCompositeOps.h>
+#include <KoOptimizedCompositeOpFactory.h>
+
+#include "DebugPigment.h"
+
+namespace {
+
+/**
+ * The number of columns is not a multiple of the vector size, so that
+ * the scalar tails of the rows are tested as well
+ */
+const int numColumns = 67;
+const int numRows = 8;
+const int numPixels = numColumns * numRows;
+
+/**
+ * The 64-byte alignment lets the vectorized ops use aligned access
+ * for the rows the same way they do for the tiles of a paint device
+ */
+struct AlignedBuffer {
+    AlignedBuffer(int size)
+        : data(static_cast<quint8*>(qMallocAligned(size, 64)))
+    {
+    }
+
+    ~AlignedBuffer() {
+        qFreeAligned(data);
+    }
+
+    quint8 *data;
+
+    Q_DISABLE_COPY(AlignedBuffer)
+};
+
+template <typename T>
+inline bool fuzzyCompare(T a, T b) {
+    return qAbs(int(a) - int(b)) <= 1;
+}
+
+/**
+ * Float channels are not clamped by some of the modes, so the
+ * values above unit are compared relatively
+ */
+inline bool fuzzyCompare(float a, float b) {
+    return qAbs(a - b) <= 1e-5f * qMax(1.0f, qAbs(b));
+}
+
+enum AlphaRange {
+    AlphaZero,
+    AlphaUnit,
+    AlphaRandom,
+    AlphaMixed
+};
+
+template <typename T, class RandomGenerator, class Distribution>
+T generateAlpha(AlphaRange range, RandomGenerator &rnd, Distribution &value)
+{
+    if (range == AlphaMixed) {
+        const float choice = value(rnd);
+        range = choice < 0.25f ? AlphaZero : choice < 0.5f ? AlphaUnit : AlphaRandom;
+    }
+
+    switch (range) {
+    case AlphaZero:
+        return KoColorSpaceMathsTraits<T>::zeroValue;
+    case AlphaUnit:
+        return KoColorSpaceMathsTraits<T>::unitValue;
+    default:
+        return Arithmetic::scale<T>(value(rnd));
+    }
+}
+
+template <class Traits>
+void generatePixels(quint8 *srcPixels, quint8 *dstPixels, quint8 *mask,
+                    AlphaRange srcAlphaRange = AlphaMixed,
+                    AlphaRange dstAlphaRange = AlphaMixed)
+{
+    typedef typename Traits::channels_type T;
+
+    boost::mt11213b rnd(1);
+    boost::uniform_real<float> value(0.0f, 1.0f);
+
+    T *src = reinterpret_cast<T*>(srcPixels);
+    T *dst = reinterpret_cast<T*>(dstPixels);
+
+    for (int i = 0; i < numPixels; i++) {
+        for (int ch = 0; ch < Traits::channels_nb; ch++) {
+            src[ch] = Arithmetic::scale<T>(value(rnd));
+            dst[ch] = Arithmetic::scale<T>(value(rnd));
+        }
+
+        src[Traits::alpha_pos] = generateAlpha<T>(srcAlphaRange, rnd, value);
+        dst[Traits::alpha_pos] = generateAlpha<T>(dstAlphaRange, rnd, value);
+
+        mask[i] = quint8(value(rnd) * 255.0f);
+
+        src += Traits::channels_nb;
+        dst += Traits::channels_nb;
+    }
+}
+
+template <class Traits>
+bool comparePixels(const quint8 *actualPixels, const quint8 *expectedPixels)
+{
+    typedef typename Traits::channels_type T;
+
+    const T *act = reinterpret_cast<const T*>(actualPixels);
+    const T *exp = reinterpret_cast<const T*>(expectedPixels);
+
+    for (int i = 0; i < numPixels; i++) {
+        const bool bothTransparent =
+            act[Traits::alpha_pos] == KoColorSpaceMathsTraits<T>::zeroValue &&
+            exp[Traits::alpha_pos] == KoColorSpaceMathsTraits<T>::zeroValue;
+
+        if (!bothTransparent) {
+            for (int ch = 0; ch < Traits::channels_nb; ch++) {
+                if (!fuzzyCompare(act[ch], exp[ch])) {
+                    qDebug() << "Wrong result:" << i << "channel" << ch;
+                    qDebug() << "Act:" << act[0] << act[1] << act[2] << act[3];
+                    qDebug() << "Exp:" << exp[0] << exp[1] << exp[2] << exp[3];
+                    return false;
+                }
+            }
+        }
+
+        act += Traits::channels_nb;
+        exp += Traits::channels_nb;
+    }
+
+    return true;
+}
+
+/**
+ * Composites the same pixels with both ops for a set of opacities,
+ * masks and channel flags and compares the results
+ */
+template <class Traits>
+void compareOps(const KoCompositeOp *actualOp, const KoCompositeOp *expectedOp)
+{
+    const int pixelSize = Traits::pixelSize;
+    const int bufferSize = numPixels * pixelSize;
+
+    AlignedBuffer src(bufferSize);
+    AlignedBuffer dst(bufferSize);
+    AlignedBuffer actualDst(bufferSize);
+    AlignedBuffer expectedDst(bufferSize);
+    AlignedBuffer mask(numPixels);
+
+    generatePixels<Traits>(src.data, dst.data, mask.data);
+
+    QBitArray alphaLocked(4, true);
+    alphaLocked.clearBit(Traits::alpha_pos);
+
+    QBitArray partialFlags(4, true);
+    partialFlags.clearBit(1);
+
+    const QVector<QBitArray> flagsList({QBitArray(), QBitArray(4, true), alphaLocked, partialFlags});
+    const QVector<float> opacities({1.0f, 0.5f, 0.0f});
+
+    for (int flagsIndex = 0; flagsIndex < flagsList.size(); flagsIndex++) {
+        const QBitArray &channelFlags = flagsList[flagsIndex];
+
+        Q_FOREACH (float opacity, opacities) {
+            for (int haveMask = 0; haveMask < 2; haveMask++) {
+                KoCompositeOp::ParameterInfo params;
+                params.srcRowStart   = src.data;
+                params.srcRowStride  = numColumns * pixelSize;
+                params.dstRowStride  = numColumns * pixelSize;
+                params.maskRowStart  = haveMask ? mask.data : 0;
+                params.maskRowStride = numColumns;
+                params.rows          = numRows;
+                params.cols          = numColumns;
+                params.opacity       = opacity;
+                params.channelFlags  = channelFlags;
+
+                memcpy(actualDst.data, dst.data, bufferSize);
+                params.dstRowStart = actualDst.data;
+                actualOp->composite(params);
+
+                memcpy(expectedDst.data, dst.data, bufferSize);
+                params.dstRowStart = expectedDst.data;
+                expectedOp->composite(params);
+
+                QVERIFY2(comparePixels<Traits>(actualDst.data, expectedDst.data),
+                         qPrintable(QString("flags: %1 opacity: %2 mask: %3")
+                                    .arg(flagsIndex)
+                                    .arg(opacity)
+                                    .arg(haveMask)));
+            }
+        }
+    }
+}
+
+/**
+ * Checks that both ops generate exactly the same bytes in the destination,
+ * including the color of the transparent pixels. The rows are shifted by
+ * \p srcShift and \p dstShift bytes from the aligned position.
+ */
+template <class Traits>
+bool compareOpsExact(const KoCompositeOp *actualOp, const KoCompositeOp *expectedOp,
+                     bool haveMask, float opacity, float flow, float averageOpacity,
+                     const QBitArray &channelFlags,
+                     int srcShift, int dstShift,
+                     AlphaRange srcAlphaRange, AlphaRange dstAlphaRange)
+{
+    const int pixelSize = Traits::pixelSize;
+    const int bufferSize = numPixels * pixelSize;
+
+    AlignedBuffer srcBuffer(bufferSize + srcShift);
+    AlignedBuffer dstBuffer(bufferSize + dstShift);
+    AlignedBuffer actualBuffer(bufferSize + dstShift);
+    AlignedBuffer expectedBuffer(bufferSize + dstShift);
+    AlignedBuffer mask(numPixels);
+
+    quint8 *src = srcBuffer.data + srcShift;
+    quint8 *dst = dstBuffer.data + dstShift;
+    quint8 *actualDst = actualBuffer.data + dstShift;
+    quint8 *expectedDst = expectedBuffer.data + dstShift;
+
+    generatePixels<Traits>(src, dst, mask.data, srcAlphaRange, dstAlphaRange);
+
+    KoCompositeOp::ParameterInfo params;
+    params.srcRowStart   = src;
+    params.srcRowStride  = numColumns * pixelSize;
+    params.dstRowStride  = numColumns * pixelSize;
+    params.maskRowStart  = haveMask ? mask.data : 0;
+    params.maskRowStride = numColumns;
+    params.rows          = numRows;
+    params.cols          = numColumns;
+    params.setOpacityAndAverage(opacity, averageOpacity);
+    params.flow          = flow;
+    params.channelFlags  = channelFlags;
+
+    memcpy(actualDst, dst, bufferSize);
+    params.dstRowStart = actualDst;
+    actualOp->composite(params);
+
+    memcpy(expectedDst, dst, bufferSize);
+    params.dstRowStart = expectedDst;
+    expectedOp->composite(params);
+
+    for (int i = 0; i < numPixels; i++) {
+        const int offset = i * pixelSize;
+
+        if (memcmp(actualDst + offset, expectedDst + offset, pixelSize)) {
+            qDebug() << "Wrong result:" << i << "src shift" << srcShift << "dst shift" << dstShift
+                     << "src alpha" << srcAlphaRange << "dst alpha" << dstAlphaRange;
+            qDebug() << "Act:" << QByteArray(reinterpret_cast<const char*>(actualDst + offset), pixelSize).toHex();
+            qDebug() << "Exp:" << QByteArray(reinterpret_cast<const char*>(expectedDst + offset), pixelSize).toHex();
+            qDebug() << "Src:" << QByteArray(reinterpret_cast<const char*>(src + offset), pixelSize).toHex();
+            qDebug() << "Msk:" << mask.data[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void createRgb16Ops(const QString &id, KoCompositeOp **actualOp, KoCompositeOp **expectedOp)
+{
+    if (id == COMPOSITE_OVER) {
+        *actualOp = KoOptimizedCompositeOpFactory::createOverOp64(0);
+        *expectedOp = new KoCompositeOpOver<KoBgrU16Traits>(0);
+    } else if (id == "alphadarken-hard") {
+        *actualOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(0);
+        *expectedOp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>(0);
+    } else if (id == "alphadarken-creamy") {
+        *actualOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(0);
+        *expectedOp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>(0);
+    } else {
+        *actualOp = KoOptimizedCompositeOpFactory::createCopyOp64(0);
+        *expectedOp = new KoCompositeOpCopy2<KoBgrU16Traits>(0);
+    }
+}
+
+/**
+ * The actual op is created the same way the color spaces create it,
+ * that is, it is the vectorized version when there is one. The ops do
+ * not use the color space for compositing, so none is passed.
+ */
+template <class Traits, typename Traits::channels_type compositeFunc(typename Traits::channels_type, typename Traits::channels_type)>
+void compareGenericSCOp(const QString &id)
+{
+    QScopedPointer<KoCompositeOp> actualOp(
+        _Private::AddGeneralOps<Traits, true>::template createOp<compositeFunc>(0, id, id, KoCompositeOp::categoryMisc()));
+
+    QScopedPointer<KoCompositeOp> expectedOp(
+        new KoCompositeOpGenericSC<Traits, compositeFunc>(0, id, id, KoCompositeOp::categoryMisc()));
+
+    compareOps<Traits>(actualOp.data(), expectedOp.data());
+}
+
+template <class Traits>
+void compareGenericSCOps(const QString &id)
+{
+    typedef typename Traits::channels_type T;
+
+    if (id == COMPOSITE_MULT) {
+        compareGenericSCOp<Traits, &cfMultiply<T> >(id);
+    } else if (id == COMPOSITE_SCREEN) {
+        compareGenericSCOp<Traits, &cfScreen<T> >(id);
+    } else if (id == COMPOSITE_OVERLAY) {
+        compareGenericSCOp<Traits, &cfOverlay<T> >(id);
+    } else if (id == COMPOSITE_HARD_LIGHT) {
+        compareGenericSCOp<Traits, &cfHardLight<T> >(id);
+    } else if (id == COMPOSITE_ADD) {
+        compareGenericSCOp<Traits, &cfAddition<T> >(id);
+    } else if (id == COMPOSITE_SUBTRACT) {
+        compareGenericSCOp<Traits, &cfSubtract<T> >(id);
+    } else if (id == COMPOSITE_LINEAR_BURN) {
+        compareGenericSCOp<Traits, &cfLinearBurn<T> >(id);
+    } else if (id == COMPOSITE_DODGE) {
+        compareGenericSCOp<Traits, &cfColorDodge<T> >(id);
+    } else if (id == COMPOSITE_DARKEN) {
+        compareGenericSCOp<Traits, &cfDarkenOnly<T> >(id);
+    } else if (id == COMPOSITE_LIGHTEN) {
+        compareGenericSCOp<Traits, &cfLightenOnly<T> >(id);
+    } else if (id == COMPOSITE_DIFF) {
+        compareGenericSCOp<Traits, &cfDifference<T> >(id);
+    } else if (id == COMPOSITE_EXCLUSION) {
+        compareGenericSCOp<Traits, &cfExclusion<T> >(id);
+    } else {
+        QFAIL(qPrintable(QString("Unknown op: %1").arg(id)));
+    }
+}
+
+}
+
+void TestKoOptimizedCompositeOps::testGenericSCOps_data()
+{
+    QTest::addColumn<QString>("depth");
+    QTest::addColumn<QString>("id");
+
+    const QStringList ids({COMPOSITE_MULT, COMPOSITE_SCREEN, COMPOSITE_OVERLAY,
+                           COMPOSITE_HARD_LIGHT, COMPOSITE_ADD, COMPOSITE_SUBTRACT,
+                           COMPOSITE_LINEAR_BURN, COMPOSITE_DODGE, COMPOSITE_DARKEN,
+                           COMPOSITE_LIGHTEN, COMPOSITE_DIFF, COMPOSITE_EXCLUSION});
+
+    const QStringList depths({"U8", "U16", "F32"});
+
+    Q_FOREACH (const QString &depth, depths) {
+        Q_FOREACH (const QString &id, ids) {
+            QTest::newRow(qPrintable(QString("%1-%2").arg(depth).arg(id))) << depth << id;
+        }
+    }
+}
+
+void TestKoOptimizedCompositeOps::testGenericSCOps()
+{
+    QFETCH(QString, depth);
+    QFETCH(QString, id);
+
+    if (depth == "U8") {
+        compareGenericSCOps<KoBgrU8Traits>(id);
+    } else if (depth == "U16") {
+        compareGenericSCOps<KoBgrU16Traits>(id);
+    } else {
+        compareGenericSCOps<KoRgbF32Traits>(id);
+    }
+}
+
+void TestKoOptimizedCompositeOps::testRgb16Ops_data()
+{
+    QTest::addColumn<QString>("id");
+    QTest::addColumn<bool>("haveMask");
+    QTest::addColumn<float>("opacity");
+    QTest::addColumn<float>("flow");
+    QTest::addColumn<float>("averageOpacity");
+    QTest::addColumn<QBitArray>("channelFlags");
+
+    QBitArray alphaLocked(4, true);
+    alphaLocked.clearBit(3);
+
+    QBitArray partialFlags(4, true);
+    partialFlags.clearBit(1);
+
+    struct Flags {
+        QString name;
+        QBitArray flags;
+    };
+
+    const QVector<Flags> flagsList({{"noflags", QBitArray()},
+                                    {"allflags", QBitArray(4, true)},
+                                    {"alphalocked", alphaLocked},
+                                    {"partial", partialFlags}});
+
+    const QStringList ids({COMPOSITE_OVER, "alphadarken-hard", "alphadarken-creamy", COMPOSITE_COPY});
+
+    Q_FOREACH (const QString &id, ids) {
+        Q_FOREACH (const Flags &flags, flagsList) {
+            for (int i = 0; i < 2; i++) {
+                const bool haveMask = i;
+                const QString name = QString("%1-%2-%3").arg(id).arg(flags.name).arg(haveMask ? "mask" : "nomask");
+
+                QTest::newRow(qPrintable(name + "-1.0")) << id << haveMask << 1.0f << 1.0f << 1.0f << flags.flags;
+                QTest::newRow(qPrintable(name + "-0.5")) << id << haveMask << 0.5f << 1.0f << 0.5f << flags.flags;
+                QTest::newRow(qPrintable(name + "-0.37-flow")) << id << haveMask << 0.37f << 0.3f << 0.37f << flags.flags;
+                QTest::newRow(qPrintable(name + "-0.37-average")) << id << haveMask << 0.37f << 0.6f << 0.8f << flags.flags;
+                QTest::newRow(qPrintable(name + "-0.0")) << id << haveMask << 0.0f << 1.0f << 0.0f << flags.flags;
+            }
+        }
+    }
+}
+
+void TestKoOptimizedCompositeOps::testRgb16Ops()
+{
+    QFETCH(QString, id);
+    QFETCH(bool, haveMask);
+    QFETCH(float, opacity);
+    QFETCH(float, flow);
+    QFETCH(float, averageOpacity);
+    QFETCH(QBitArray, channelFlags);
+
+    KoCompositeOp *actualOp = 0;
+    KoCompositeOp *expectedOp = 0;
+    createRgb16Ops(id, &actualOp, &expectedOp);
+
+    QScopedPointer<KoCompositeOp> actualOpHolder(actualOp);
+    QScopedPointer<KoCompositeOp> expectedOpHolder(expectedOp);
+
+    const QVector<AlphaRange> ranges({AlphaMixed, AlphaRandom, AlphaZero, AlphaUnit});
+
+    Q_FOREACH (AlphaRange srcRange, ranges) {
+        Q_FOREACH (AlphaRange dstRange, ranges) {
+            QVERIFY(compareOpsExact<KoBgrU16Traits>(actualOp, expectedOp, haveMask, opacity, flow, averageOpacity, channelFlags, 0, 0, srcRange, dstRange));
+        }
+    }
+
+    // unaligned source and destination, so that the scalar
+    // code path is also covered
+    QVERIFY(compareOpsExact<KoBgrU16Traits>(actualOp, expectedOp, haveMask, opacity, flow, averageOpacity, channelFlags, 8, 0, AlphaMixed, AlphaMixed));
+    QVERIFY(compareOpsExact<KoBgrU16Traits>(actualOp, expectedOp, haveMask, opacity, flow, averageOpacity, channelFlags, 0, 8, AlphaMixed, AlphaMixed));
+    QVERIFY(compareOpsExact<KoBgrU16Traits>(actualOp, expectedOp, haveMask, opacity, flow, averageOpacity, channelFlags, 8, 8, AlphaMixed, AlphaMixed));
+}
+
+QTEST_GUILESS_MAIN(TestKoOptimizedCompositeOps)
@@ -99,6 +99,7 @@
 #include "opengl/kis_opengl_canvas_debugger.h"
 
 #include "kis_algebra_2d.h"
+#include "kis_layer_utils.h"
 #include "kis_image_signal_router.h"
 
 #include "KisSnapPixelStrategy.h"
@@ -156,6 +157,7 @@ public:
     KisSignalCompressor regionOfInterestUpdateCompressor;
     QRect regionOfInterest;
     qreal regionOfInterestMargin = 0.25;
+    QPointF lastPanOffset;
 
     QRect renderingLimit;
     int isBatchUpdateActive = 0;
@@ -165,8 +167,35 @@ public:
     }
 
     void setActiveShapeManager(KoShapeManager *shapeManager);
+    void updateFramePacing(QWidget *widget);
 };
 
+void KisCanvas2::KisCanvas2Private::updateFramePacing(QWidget *widget)
+{
+    KisImageConfig config(true);
+    const bool framePacing = config.canvasFramePacing();
+
+    int frameInterval = 1000 / config.fpsLimit();
+
+    /**
+     * There is no point in uploading the updates more often than the
+     * display refreshes, they would be just overwritten before being
+     * shown. Instead, they are collected in projectionUpdatesCompressor,
+     * which drops the superseded ones.
+     */
+    if (framePacing && widget) {
+        const int screenNumber = QApplication::desktop()->screenNumber(widget);
+        QScreen *screen = QGuiApplication::screens().value(screenNumber);
+
+        if (screen && screen->refreshRate() > 1.0) {
+            frameInterval = qMax(frameInterval, qRound(1000.0 / screen->refreshRate()));
+        }
+    }
+
+    frameRenderStartCompressor.setDelay(frameInterval);
+    projectionUpdatesCompressor.setFramePacingEnabled(framePacing);
+}
+
 namespace {
 KoShapeManager* fetchShapeManagerFromNode(KisNodeSP node)
 {
@@ -212,7 +241,7 @@ KisCanvas2::KisCanvas2(KisCoordinatesConverter *coordConverter, KoCanvasResource
     m_d->canvasUpdateCompressor.setDelay(1000 / config.fpsLimit());
     m_d->canvasUpdateCompressor.setMode(KisSignalCompressor::FIRST_ACTIVE);
 
-    m_d->frameRenderStartCompressor.setDelay(1000 / config.fpsLimit());
+    m_d->updateFramePacing(0);
     m_d->frameRenderStartCompressor.setMode(KisSignalCompressor::FIRST_ACTIVE);
     snapGuide()->overrideSnapStrategy(KoSnapGuide::PixelSnapping, new KisSnapPixelStrategy());
 }
@@ -227,6 +256,9 @@ void KisCanvas2::setup()
 
     createCanvas(cfg.useOpenGL());
 
+    // the refresh rate of the screen can be fetched only when the widget exists
+    m_d->updateFramePacing(canvasWidget());
+
     setLodAllowedInCanvas(m_d->lodAllowedInImage);
     m_d->animationPlayer = new KisAnimationPlayer(this);
     connect(m_d->view->canvasController()->proxyObject, SIGNAL(moveDocumentOffset(QPoint)), SLOT(documentOffsetMoved(QPoint)));
@@ -989,6 +1021,30 @@ void KisCanvas2::slotUpdateRegionOfInterest()
     if (m_d->regionOfInterest != oldRegionOfInterest) {
         emit sigRegionOfInterestChanged(m_d->regionOfInterest);
     }
+
+    /**
+     * Ask the tile engine to load the swapped-out tiles around the
+     * viewport in advance. The area is extended in the direction the
+     * canvas is being panned to.
+     */
+    QRect prefetchRect = m_d->regionOfInterest;
+
+    const QPointF panOffset = m_d->lastPanOffset;
+    m_d->lastPanOffset = QPointF();
+
+    const qreal panDistance = KisAlgebra2D::norm(panOffset);
+    if (panDistance > 0 && !prefetchRect.isEmpty()) {
+        const qreal lookAhead = 0.5 * qMax(prefetchRect.width(), prefetchRect.height());
+
+        // image moves in the direction opposite to the viewport
+        const QPoint shift = (-panOffset * lookAhead / panDistance).toPoint();
+        prefetchRect |= prefetchRect.translated(shift) & imageRect;
+    }
+
+    KisImageSP image = this->image();
+    if (image && !prefetchRect.isEmpty()) {
+        KisLayerUtils::requestTilesPrefetch(image->root(), prefetchRect);
+    }
 }
 
 void KisCanvas2::slotReferenceImagesChanged()
@@ -1078,6 +1134,7 @@ void KisCanvas2::documentOffsetMoved(const QPoint &documentOffset)
     QPointF offsetAfter = m_d->coordinatesConverter->imageRectInViewportPixels().topLeft();
 
     QPointF moveOffset = offsetAfter - offsetBefore;
+    m_d->lastPanOffset += moveOffset;
 
     if (!m_d->currentCanvasIsOpenGL)
         m_d->prescaledProjection->viewportMoved(moveOffset);
@@ -1109,6 +1166,8 @@ void KisCanvas2::slotConfigChanged()
         warnUI << "Failed to get screenNumber for updating display profile.";
     }
 
+    m_d->updateFramePacing(this->canvasWidget());
+
     initializeFpsDecoration();
 }
 
@@ -18,36 +18,100 @@
 
 #include "kis_canvas_updates_compressor.h"
 
+#include <QHash>
+#include <QRegion>
+
+namespace {
+
+/**
+ * Checking the coverage of a fragmented region becomes more expensive
+ * than uploading of the extra updates, so the updates below such
+ * a region are just kept
+ */
+const int maxCoverRegionRects = 256;
+
+}
+
 bool KisCanvasUpdatesCompressor::putUpdateInfo(KisUpdateInfoSP info)
 {
-    const int levelOfDetail = info->levelOfDetail();
     const QRect newUpdateRect = info->dirtyImageRect();
     if (newUpdateRect.isEmpty()) return false;
 
     QMutexLocker l(&m_mutex);
 
+    m_statistics.numReceived++;
+
+    const bool wasEmpty = m_updatesList.isEmpty();
+
+    m_updatesList.append(info);
+
     if (info->canBeCompressed()) {
-        KisUpdateInfoList::iterator it = m_updatesList.begin();
-        while (it != m_updatesList.end()) {
-            if ((*it)->canBeCompressed() &&
-                levelOfDetail == (*it)->levelOfDetail() &&
-                newUpdateRect.contains((*it)->dirtyImageRect())) {
-
-                /**
-                 * We should always remove the overridden update and put 'info' to the end
-                 * of the queue. Otherwise, the updates will become reordered and the canvas
-                 * may have tiles artifacts with "outdated" data
-                 */
-                it = m_updatesList.erase(it);
-            } else {
-                ++it;
-            }
+        if (m_framePacingEnabled) {
+            dropCoveredUpdates();
+        } else {
+            dropContainedUpdates(info);
         }
     }
 
-    m_updatesList.append(info);
+    return wasEmpty;
+}
+
+void KisCanvasUpdatesCompressor::dropContainedUpdates(KisUpdateInfoSP info)
+{
+    const int levelOfDetail = info->levelOfDetail();
+    const QRect newUpdateRect = info->dirtyImageRect();
+
+    KisUpdateInfoList::iterator it = m_updatesList.begin();
+    KisUpdateInfoList::iterator end = std::prev(m_updatesList.end());
+
+    while (it != end) {
+        if ((*it)->canBeCompressed() &&
+            levelOfDetail == (*it)->levelOfDetail() &&
+            newUpdateRect.contains((*it)->dirtyImageRect())) {
+
+            /**
+             * We should always remove the overridden update and put 'info' to the end
+             * of the queue. Otherwise, the updates will become reordered and the canvas
+             * may have tiles artifacts with "outdated" data
+             */
+            it = m_updatesList.erase(it);
+            m_statistics.numDropped++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void KisCanvasUpdatesCompressor::dropCoveredUpdates()
+{
+    /**
+     * Walk from the newest update to the oldest one, collecting the
+     * area covered by the newer updates for every level of detail
+     *
+     * The overlapping updates are not merged into bigger ones: every
+     * update carries the data already prepared for its own rect (e.g.
+     * the tiles of the openGL canvas), which cannot be combined without
+     * regenerating it. Only the updates whose whole area is covered by
+     * the newer ones are dropped.
+     */
+    QHash<int, QRegion> newerUpdates;
+
+    KisUpdateInfoList::iterator it = m_updatesList.end();
+    while (it != m_updatesList.begin()) {
+        --it;
+
+        if (!(*it)->canBeCompressed()) continue;
 
-    return m_updatesList.size() <= 1;
+        const QRect rect = (*it)->dirtyImageRect();
+        QRegion &coveredRegion = newerUpdates[(*it)->levelOfDetail()];
+
+        if (QRegion(rect).subtracted(coveredRegion).isEmpty()) {
+            it = m_updatesList.erase(it);
+            m_statistics.numDropped++;
+        } else if (coveredRegion.rectCount() < maxCoverRegionRects) {
+            coveredRegion += rect;
+        }
+    }
 }
 
 void KisCanvasUpdatesCompressor::takeUpdateInfo(KisUpdateInfoList &list)
@@ -56,4 +120,33 @@ void KisCanvasUpdatesCompressor::takeUpdateInfo(KisUpdateInfoList &list)
 
     QMutexLocker l(&m_mutex);
     m_updatesList.swap(list);
+
+    if (!list.isEmpty()) {
+        m_statistics.numPresented += list.size();
+        m_statistics.numFrames++;
+    }
+}
+
+void KisCanvasUpdatesCompressor::setFramePacingEnabled(bool value)
+{
+    QMutexLocker l(&m_mutex);
+    m_framePacingEnabled = value;
+}
+
+bool KisCanvasUpdatesCompressor::framePacingEnabled() const
+{
+    QMutexLocker l(&m_mutex);
+    return m_framePacingEnabled;
+}
+
+KisCanvasUpdatesCompressor::Statistics KisCanvasUpdatesCompressor::statistics() const
+{
+    QMutexLocker l(&m_mutex);
+    return m_statistics;
+}
+
+void KisCanvasUpdatesCompressor::resetStatistics()
+{
+    QMutexLocker l(&m_mutex);
+    m_statistics = Statistics();
 }
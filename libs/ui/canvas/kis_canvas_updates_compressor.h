@@ -23,19 +23,77 @@
 #include <QMutex>
 #include <QMutexLocker>
 
+#include "kritaui_export.h"
 #include "kis_update_info.h"
 
 typedef QList<KisUpdateInfoSP> KisUpdateInfoList;
 
-class KisCanvasUpdatesCompressor
+/**
+ * Collects the update info objects prepared by the image threads until
+ * the GUI thread takes them for uploading to the canvas. The updates
+ * overridden by the newer ones are dropped from the queue.
+ *
+ * In the frame-paced mode the canvas takes the queue not more often
+ * than once per display refresh interval (see KisCanvas2), so a lot
+ * of updates may be queued during fast strokes. In this mode an update
+ * is dropped if it is covered by the union of the newer updates of the
+ * same level of detail, not only by a single one of them. The newer
+ * updates carry the fresh data for all the pixels of the dropped one,
+ * so the order of the updates is still preserved.
+ */
+class KRITAUI_EXPORT KisCanvasUpdatesCompressor
 {
 public:
+    struct Statistics {
+        /**
+         * The number of the non-empty updates put into the queue,
+         * including the marker ones
+         */
+        int numReceived = 0;
+
+        /**
+         * The number of the updates dropped because of being superseded
+         * by the newer ones
+         */
+        int numDropped = 0;
+
+        /**
+         * The number of the updates taken from the queue for presenting,
+         * including the marker ones
+         */
+        int numPresented = 0;
+
+        /**
+         * The number of non-empty batches taken from the queue
+         */
+        int numFrames = 0;
+    };
+
+public:
+    /**
+     * Puts \p info to the end of the queue
+     *
+     * \return true if the queue was empty, that is the caller
+     *         should schedule a new frame
+     */
     bool putUpdateInfo(KisUpdateInfoSP info);
     void takeUpdateInfo(KisUpdateInfoList &list);
 
+    void setFramePacingEnabled(bool value);
+    bool framePacingEnabled() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+private:
+    void dropContainedUpdates(KisUpdateInfoSP info);
+    void dropCoveredUpdates();
+
 private:
-    QMutex m_mutex;
+    mutable QMutex m_mutex;
     KisUpdateInfoList m_updatesList;
+    bool m_framePacingEnabled = false;
+    Statistics m_statistics;
 };
 
 #endif /* __KIS_CANVAS_UPDATES_COMPRESSOR_H */
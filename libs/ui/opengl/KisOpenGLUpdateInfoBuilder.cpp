@@ -26,6 +26,17 @@
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QtConcurrent>
+
+namespace {
+
+/**
+ * Converting of a single tile takes less time than waking up a
+ * worker thread, so small updates are processed in place
+ */
+const int minTilesForParallelProcessing = 4;
+
+}
 
 
 struct KRITAUI_NO_EXPORT KisOpenGLUpdateInfoBuilder::Private
@@ -44,6 +55,8 @@ struct KRITAUI_NO_EXPORT KisOpenGLUpdateInfoBuilder::Private
 
     KisTextureTileInfoPoolSP pool;
     QReadWriteLock lock;
+
+    bool parallelProcessingEnabled = true;
 };
 
 
@@ -151,16 +164,6 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
                                                      m_d->pool));
             // Don't update empty tiles
             if (tileInfo->valid()) {
-                tileInfo->retrieveData(projection, channelFlags, m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
-
-                if (convertColorSpace) {
-                    if (m_d->proofingTransform) {
-                        tileInfo->proofTo(m_d->conversionOptions.m_destinationColorSpace, m_d->proofingConfig->conversionFlags, m_d->proofingTransform.data());
-                    } else {
-                        tileInfo->convertTo(m_d->conversionOptions.m_destinationColorSpace, m_d->conversionOptions.m_renderingIntent, m_d->conversionOptions.m_conversionFlags);
-                    }
-                }
-
                 info->tileList.append(tileInfo);
             }
             else {
@@ -169,6 +172,33 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
         }
     }
 
+    /**
+     * The tiles don't share any data, only the read-only projection, the
+     * pool (which has its own lock) and the color transformations, which
+     * are already used concurrently by the updates coming from different
+     * threads, so every tile can be prepared in a separate job.
+     */
+    auto processTile =
+        [&] (KisTextureTileUpdateInfoSP &tileInfo) {
+            tileInfo->retrieveData(projection, channelFlags, m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
+
+            if (convertColorSpace) {
+                if (m_d->proofingTransform) {
+                    tileInfo->proofTo(m_d->conversionOptions.m_destinationColorSpace, m_d->proofingConfig->conversionFlags, m_d->proofingTransform.data());
+                } else {
+                    tileInfo->convertTo(m_d->conversionOptions.m_destinationColorSpace, m_d->conversionOptions.m_renderingIntent, m_d->conversionOptions.m_conversionFlags);
+                }
+            }
+        };
+
+    if (m_d->parallelProcessingEnabled &&
+        info->tileList.size() >= minTilesForParallelProcessing) {
+
+        QtConcurrent::blockingMap(info->tileList, processTile);
+    } else {
+        std::for_each(info->tileList.begin(), info->tileList.end(), processTile);
+    }
+
     info->assignDirtyImageRect(rect);
     info->assignLevelOfDetail(levelOfDetail);
     return info;
@@ -270,3 +300,17 @@ KisProofingConfigurationSP KisOpenGLUpdateInfoBuilder::proofingConfig() const
 
     return m_d->proofingConfig;
 }
+
+void KisOpenGLUpdateInfoBuilder::setParallelProcessingEnabled(bool value)
+{
+    QWriteLocker lock(&m_d->lock);
+
+    m_d->parallelProcessingEnabled = value;
+}
+
+bool KisOpenGLUpdateInfoBuilder::parallelProcessingEnabled() const
+{
+    QReadLocker lock(&m_d->lock);
+
+    return m_d->parallelProcessingEnabled;
+}
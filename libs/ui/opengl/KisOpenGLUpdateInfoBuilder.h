@@ -72,6 +72,15 @@ public:
     void setProofingConfig(KisProofingConfigurationSP config);
     KisProofingConfigurationSP proofingConfig() const;
 
+    /**
+     * If enabled (default), the texture tiles of a big update are
+     * prepared (fetched, converted into the display color space and
+     * proofed) in parallel by the global thread pool. The calling
+     * thread takes part in the processing.
+     */
+    void setParallelProcessingEnabled(bool value);
+    bool parallelProcessingEnabled() const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
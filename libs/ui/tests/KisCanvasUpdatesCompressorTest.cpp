@@ -0,0 +1,196 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisCanvasUpdatesCompressorTest.h"
+
+#include <QTest>
+#include <QRegion>
+
+#include "canvas/kis_canvas_updates_compressor.h"
+
+namespace {
+
+struct TestingUpdateInfo : public KisUpdateInfo
+{
+    TestingUpdateInfo(const QRect &rect, int lod = 0)
+        : m_rect(rect),
+          m_lod(lod)
+    {
+    }
+
+    QRect dirtyImageRect() const override {
+        return m_rect;
+    }
+
+    int levelOfDetail() const override {
+        return m_lod;
+    }
+
+    QRect m_rect;
+    int m_lod;
+};
+
+QVector<QRect> takeRects(KisCanvasUpdatesCompressor &compressor)
+{
+    KisUpdateInfoList list;
+    compressor.takeUpdateInfo(list);
+
+    QVector<QRect> rects;
+    Q_FOREACH (KisUpdateInfoSP info, list) {
+        rects << info->dirtyImageRect();
+    }
+    return rects;
+}
+
+}
+
+void KisCanvasUpdatesCompressorTest::testContainedUpdates()
+{
+    KisCanvasUpdatesCompressor compressor;
+
+    QVERIFY(compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 50, 100))));
+    QVERIFY(!compressor.putUpdateInfo(new TestingUpdateInfo(QRect(50, 0, 50, 100))));
+    QVERIFY(!compressor.putUpdateInfo(new TestingUpdateInfo(QRect(10, 10, 10, 10))));
+    QVERIFY(!compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 20, 20))));
+
+    // only the updates contained in a single newer one are dropped
+    QCOMPARE(takeRects(compressor),
+             QVector<QRect>({QRect(0, 0, 50, 100), QRect(50, 0, 50, 100), QRect(0, 0, 20, 20)}));
+
+    const KisCanvasUpdatesCompressor::Statistics stats = compressor.statistics();
+    QCOMPARE(stats.numReceived, 4);
+    QCOMPARE(stats.numDropped, 1);
+    QCOMPARE(stats.numPresented, 3);
+    QCOMPARE(stats.numFrames, 1);
+}
+
+void KisCanvasUpdatesCompressorTest::testCoveredUpdates()
+{
+    KisCanvasUpdatesCompressor compressor;
+    compressor.setFramePacingEnabled(true);
+
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(20, 20, 60, 60)));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(100, 100, 10, 10)));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 50, 100)));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(50, 0, 50, 100)));
+
+    // the first update is covered by the union of the last two
+    QCOMPARE(takeRects(compressor),
+             QVector<QRect>({QRect(100, 100, 10, 10), QRect(0, 0, 50, 100), QRect(50, 0, 50, 100)}));
+
+    // an empty update is ignored
+    QVERIFY(!compressor.putUpdateInfo(new TestingUpdateInfo(QRect())));
+
+    const KisCanvasUpdatesCompressor::Statistics stats = compressor.statistics();
+    QCOMPARE(stats.numReceived, 4);
+    QCOMPARE(stats.numDropped, 1);
+    QCOMPARE(stats.numPresented, 3);
+}
+
+void KisCanvasUpdatesCompressorTest::testLevelOfDetail()
+{
+    KisCanvasUpdatesCompressor compressor;
+    compressor.setFramePacingEnabled(true);
+
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 10, 10), 1));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 10, 10), 0));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 100, 100), 0));
+
+    // the updates of different levels of detail don't supersede each other
+    QCOMPARE(takeRects(compressor),
+             QVector<QRect>({QRect(0, 0, 10, 10), QRect(0, 0, 100, 100)}));
+}
+
+void KisCanvasUpdatesCompressorTest::testMarkers()
+{
+    KisCanvasUpdatesCompressor compressor;
+    compressor.setFramePacingEnabled(true);
+
+    const QRect bounds(0, 0, 100, 100);
+
+    compressor.putUpdateInfo(new KisMarkerUpdateInfo(KisMarkerUpdateInfo::StartBatch, bounds));
+    compressor.putUpdateInfo(new TestingUpdateInfo(QRect(0, 0, 10, 10)));
+    compressor.putUpdateInfo(new KisMarkerUpdateInfo(KisMarkerUpdateInfo::EndBatch, bounds));
+    compressor.putUpdateInfo(new TestingUpdateInfo(bounds));
+
+    KisUpdateInfoList list;
+    compressor.takeUpdateInfo(list);
+
+    // the markers are never dropped and don't cover anything
+    QCOMPARE(list.size(), 3);
+    QVERIFY(dynamic_cast<KisMarkerUpdateInfo*>(list[0].data()));
+    QVERIFY(dynamic_cast<KisMarkerUpdateInfo*>(list[1].data()));
+    QCOMPARE(list[2]->dirtyImageRect(), bounds);
+}
+
+/**
+ * Emulates a fast stroke: the image produces a lot of small overlapping
+ * updates, while the canvas takes them once per frame
+ */
+void KisCanvasUpdatesCompressorTest::testFramePacing()
+{
+    const int numFrames = 10;
+    const int dabsPerFrame = 20;
+
+    KisCanvasUpdatesCompressor::Statistics pacedStats;
+    KisCanvasUpdatesCompressor::Statistics unpacedStats;
+
+    for (int paced = 0; paced <= 1; paced++) {
+        KisCanvasUpdatesCompressor compressor;
+        compressor.setFramePacingEnabled(paced);
+
+        int numScheduledFrames = 0;
+
+        for (int frame = 0; frame < numFrames; frame++) {
+            for (int i = 0; i < dabsPerFrame; i++) {
+                const int dab = frame * dabsPerFrame + i;
+
+                /**
+                 * The dabs go back and forth over the same area. Every dab
+                 * is split into two patches, horizontally or vertically, so
+                 * the previous patches are covered by the union of the new
+                 * ones, but not always by a single one of them.
+                 */
+                const QRect dabRect((dab % 4) * 10, 0, 40, 40);
+                const bool splitVertically = (dab / 4) % 2;
+
+                const QRect firstPatch = splitVertically ?
+                    dabRect.adjusted(0, 0, -20, 0) : dabRect.adjusted(0, 0, 0, -20);
+                const QRect secondPatch = splitVertically ?
+                    dabRect.adjusted(20, 0, 0, 0) : dabRect.adjusted(0, 20, 0, 0);
+
+                numScheduledFrames += compressor.putUpdateInfo(new TestingUpdateInfo(firstPatch));
+                numScheduledFrames += compressor.putUpdateInfo(new TestingUpdateInfo(secondPatch));
+            }
+
+            const QVector<QRect> rects = takeRects(compressor);
+
+            // the area of the frame is not lost
+            QRegion region;
+            Q_FOREACH (const QRect &rc, rects) {
+                region += rc;
+            }
+            QCOMPARE(region, QRegion(QRect(0, 0, 70, 40)));
+        }
+
+        // the canvas is asked for a new frame only once per batch
+        QCOMPARE(numScheduledFrames, numFrames);
+
+        (paced ? pacedStats : unpacedStats) = compressor.statistics();
+    }
+
+    QCOMPARE(pacedStats.numReceived, 2 * numFrames * dabsPerFrame);
+    QCOMPARE(pacedStats.numFrames, numFrames);
+    QCOMPARE(pacedStats.numReceived, pacedStats.numPresented + pacedStats.numDropped);
+
+    QCOMPARE(unpacedStats.numReceived, pacedStats.numReceived);
+    QCOMPARE(unpacedStats.numReceived, unpacedStats.numPresented + unpacedStats.numDropped);
+
+    QVERIFY(pacedStats.numDropped > unpacedStats.numDropped);
+    QVERIFY(pacedStats.numPresented < unpacedStats.numPresented);
+}
+
+QTEST_MAIN(KisCanvasUpdatesCompressorTest)
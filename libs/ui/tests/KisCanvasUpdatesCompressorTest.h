@@ -0,0 +1,24 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef KISCANVASUPDATESCOMPRESSORTEST_H
+#define KISCANVASUPDATESCOMPRESSORTEST_H
+
+#include <QObject>
+
+class KisCanvasUpdatesCompressorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testContainedUpdates();
+    void testCoveredUpdates();
+    void testLevelOfDetail();
+    void testMarkers();
+    void testFramePacing();
+};
+
+#endif // KISCANVASUPDATESCOMPRESSORTEST_H
@@ -31,7 +31,9 @@
 #include "kis_painting_information_builder.h"
 #include "kis_image.h"
 #include "kis_painter.h"
+#include "kis_paint_device.h"
 #include <brushengine/kis_paintop_preset.h>
+#include <brushengine/kis_paintop_settings.h>
 #include <brushengine/kis_paintop_utils.h>
 
 #include "kis_update_time_monitor.h"
@@ -46,6 +48,7 @@
 #include "strokes/KisFreehandStrokeInfo.h"
 #include "KisAsyncronousStrokeUpdateHelper.h"
 #include "kis_canvas_resource_provider.h"
+#include "kis_layer_utils.h"
 
 #include <math.h>
 
@@ -88,6 +91,9 @@ struct KisToolFreehandHelper::Private
     KisPaintInformation previousPaintInformation;
     KisPaintInformation olderPaintInformation;
 
+    // The area, whose tiles have been requested to be prefetched
+    QRectF prefetchedRect;
+
     KisSmoothingOptionsSP smoothingOptions;
 
     // fake random sources for hovering outline *only*
@@ -281,6 +287,7 @@ void KisToolFreehandHelper::initPaintImpl(qreal startAngle,
     m_d->hasPaintAtLeastOnce = false;
 
     m_d->previousPaintInformation = pi;
+    m_d->prefetchedRect = QRectF();
 
     m_d->resources = new KisResourcesSnapshot(image,
                                               currentNode,
@@ -598,6 +605,8 @@ void KisToolFreehandHelper::paint(KisPaintInformation &info)
         paintLine(m_d->previousPaintInformation, info);
     }
 
+    requestTilesPrefetch(info);
+
     if (m_d->smoothingOptions->smoothingType() == KisSmoothingOptions::STABILIZER) {
         m_d->stabilizedSampler.addEvent(info);
         if (m_d->stabilizerDelayedPaintHelper.running()) {
@@ -614,6 +623,38 @@ void KisToolFreehandHelper::paint(KisPaintInformation &info)
     }
 }
 
+void KisToolFreehandHelper::requestTilesPrefetch(const KisPaintInformation &info)
+{
+    /**
+     * Extrapolate the stroke a few events ahead and ask the tile
+     * engine to load the swapped-out tiles in this area in advance,
+     * so the painting threads do not stall on the swap. The request
+     * is repeated only when the stroke leaves the prefetched area.
+     */
+    const qreal lookAheadEvents = 16.0;
+
+    const QPointF velocity = info.pos() - m_d->previousPaintInformation.pos();
+    const QPointF predictedPos = info.pos() + lookAheadEvents * velocity;
+
+    const qreal brushSize = m_d->resources->currentPaintOpPreset()->settings()->paintOpSize();
+
+    const QRectF requiredRect =
+        kisGrowRect(QRectF(info.pos(), predictedPos).normalized(), brushSize);
+
+    if (m_d->prefetchedRect.contains(requiredRect)) return;
+
+    m_d->prefetchedRect = KisAlgebra2D::blowRect(requiredRect, 0.5);
+
+    const QRect prefetchRect = m_d->prefetchedRect.toAlignedRect();
+
+    KisLayerUtils::requestTilesPrefetch(m_d->resources->currentNode(), prefetchRect);
+
+    KisImageSP image = m_d->resources->image();
+    if (image) {
+        image->projection()->requestTilesPrefetch(prefetchRect);
+    }
+}
+
 void KisToolFreehandHelper::endPaint()
 {
     if (!m_d->hasPaintAtLeastOnce) {
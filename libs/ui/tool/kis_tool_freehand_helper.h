@@ -141,6 +141,7 @@ protected:
 
 private:
     void paint(KisPaintInformation &info);
+    void requestTilesPrefetch(const KisPaintInformation &info);
     void paintBezierSegment(KisPaintInformation pi1, KisPaintInformation pi2,
                                                    QPointF tangent1, QPointF tangent2);
 
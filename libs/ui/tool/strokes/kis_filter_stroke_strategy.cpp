@@ -95,6 +95,9 @@ KisFilterStrokeStrategy::KisFilterStrokeStrategy(const KisFilterStrokeStrategy &
     // only non-started transaction are allowed
     KIS_ASSERT_RECOVER_NOOP(!m_d->secondaryTransaction);
     m_d->levelOfDetail = levelOfDetail;
+
+    // the filters not supporting LoD natively need scaled parameters
+    m_d->filterConfig = m_d->filter->levelOfDetailConfiguration(m_d->filterConfig, levelOfDetail);
 }
 
 KisFilterStrokeStrategy::~KisFilterStrokeStrategy()
@@ -66,6 +66,7 @@
 #include "colorspaces/ycbcr_f32/YCbCrF32ColorSpace.h"
 
 #include "LcmsRGBP2020PQColorSpace.h"
+#include "LcmsRGBFastPathColorSpace.h"
 
 #include <KoConfig.h>
 
@@ -172,14 +173,14 @@ LcmsEnginePlugin::LcmsEnginePlugin(QObject *parent, const QVariantList &)
     KoColorProfile *rgbProfile = LcmsColorProfileContainer::createFromLcmsProfile(cmsCreate_sRGBProfile());
     registry->addProfile(rgbProfile);
 
-    registry->add(new LcmsRGBP2020PQColorSpaceFactoryWrapper<RgbU8ColorSpaceFactory>());
-    registry->add(new LcmsRGBP2020PQColorSpaceFactoryWrapper<RgbU16ColorSpaceFactory>());
+    registry->add(new LcmsRGBFastPathColorSpaceFactoryWrapper<RgbU8ColorSpaceFactory>());
+    registry->add(new LcmsRGBFastPathColorSpaceFactoryWrapper<RgbU16ColorSpaceFactory>());
 #ifdef HAVE_LCMS24
 #ifdef HAVE_OPENEXR
-    registry->add(new LcmsRGBP2020PQColorSpaceFactoryWrapper<RgbF16ColorSpaceFactory>());
+    registry->add(new LcmsRGBFastPathColorSpaceFactoryWrapper<RgbF16ColorSpaceFactory>());
 #endif
 #endif
-    registry->add(new LcmsRGBP2020PQColorSpaceFactoryWrapper<RgbF32ColorSpaceFactory>());
+    registry->add(new LcmsRGBFastPathColorSpaceFactoryWrapper<RgbF32ColorSpaceFactory>());
 
     KoHistogramProducerFactoryRegistry::instance()->add(
         new KoBasicHistogramProducerFactory<KoBasicU8HistogramProducer>
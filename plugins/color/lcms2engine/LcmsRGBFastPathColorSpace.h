@@ -0,0 +1,74 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef LCMSRGBFASTPATHCOLORSPACE_H
+#define LCMSRGBFASTPATHCOLORSPACE_H
+
+#include <type_traits>
+
+#include "LcmsRGBP2020PQColorSpace.h"
+#include "LcmsRGBFastPathTransformation.h"
+
+/**
+ * Recursively add the fast path conversions from the source traits into
+ * every other supported bit depth. Like in addInternalConversion(), we
+ * add only **outgoing** edges for every RGB color space.
+ */
+template<typename SrcTraits, typename DstTraits>
+void addRGBFastPathConversions(QList<KoColorConversionTransformationFactory*> &list, DstTraits*)
+{
+    if (!std::is_same<SrcTraits, DstTraits>::value) {
+        list << new LcmsScaleRGBFastPathTransformationFactory<SrcTraits, DstTraits>(SRGB_TRC_PROFILE_NAME);
+        list << new LcmsScaleRGBFastPathTransformationFactory<SrcTraits, DstTraits>(SRGB_LINEAR_PROFILE_NAME);
+    }
+
+    /**
+     * Linear 8-bit color space loses too much data in shadows, so we don't
+     * let the conversion system choose it as an intermediate step for
+     * the curve conversions
+     */
+    if (!std::is_same<DstTraits, KoBgrU8Traits>::value) {
+        list << new LcmsFromSrgbTrcFastPathTransformationFactory<SrcTraits, DstTraits>();
+    }
+
+    if (!std::is_same<SrcTraits, KoBgrU8Traits>::value) {
+        list << new LcmsToSrgbTrcFastPathTransformationFactory<SrcTraits, DstTraits>();
+    }
+
+    using NextTraits = typename NextTrait<DstTraits>::type;
+    addRGBFastPathConversions<SrcTraits>(list, static_cast<NextTraits*>(0));
+}
+
+template<typename SrcTraits>
+void addRGBFastPathConversions(QList<KoColorConversionTransformationFactory*> &, void*)
+{
+    // stop recursion
+}
+
+/**
+ * Adds direct conversions between the default sRGB profiles to the
+ * RGB color space factory. The conversion system always prefers a direct
+ * link to a path going through the ICC engine, so the most common
+ * conversions (sRGB U8 <-> U16 <-> linear F32) avoid LCMS completely.
+ * All the other profiles are still handled by LCMS.
+ */
+template <class BaseColorSpaceFactory>
+class LcmsRGBFastPathColorSpaceFactoryWrapper : public LcmsRGBP2020PQColorSpaceFactoryWrapper<BaseColorSpaceFactory>
+{
+    typedef typename ColorSpaceFromFactory<BaseColorSpaceFactory>::type RelatedColorSpaceType;
+
+    QList<KoColorConversionTransformationFactory *> colorConversionLinks() const override
+    {
+        QList<KoColorConversionTransformationFactory *> list =
+            LcmsRGBP2020PQColorSpaceFactoryWrapper<BaseColorSpaceFactory>::colorConversionLinks();
+
+        addRGBFastPathConversions<typename RelatedColorSpaceType::ColorSpaceTraits>(list, static_cast<KoBgrU8Traits*>(0));
+
+        return list;
+    }
+};
+
+#endif // LCMSRGBFASTPATHCOLORSPACE_H
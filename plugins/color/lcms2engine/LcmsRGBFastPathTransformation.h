@@ -0,0 +1,335 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef LCMSRGBFASTPATHTRANSFORMATION_H
+#define LCMSRGBFASTPATHTRANSFORMATION_H
+
+#include <cmath>
+#include <limits>
+
+#include "KoAlwaysInline.h"
+#include "KoColorModelStandardIds.h"
+#include "KoColorSpaceMaths.h"
+#include "KoColorModelStandardIdsUtils.h"
+#include "KoColorConversionTransformationFactory.h"
+
+#include <colorspaces/rgb_u8/RgbU8ColorSpace.h>
+#include <colorspaces/rgb_u16/RgbU16ColorSpace.h>
+#ifdef HAVE_OPENEXR
+#include <colorspaces/rgb_f16/RgbF16ColorSpace.h>
+#endif
+#include <colorspaces/rgb_f32/RgbF32ColorSpace.h>
+
+/**
+ * Names of the default sRGB profiles that are shipped with Krita. Both
+ * of them have the same primaries, so the conversion between them is
+ * just a change of the tone curve.
+ */
+#define SRGB_TRC_PROFILE_NAME "sRGB-elle-V2-srgbtrc.icc"
+#define SRGB_LINEAR_PROFILE_NAME "sRGB-elle-V2-g10.icc"
+
+namespace
+{
+
+inline float applySrgbCurve(float x) {
+    if (x < 0.0f) return -applySrgbCurve(-x);
+
+    return x <= 0.0031308f ?
+        x * 12.92f :
+        1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+}
+
+inline float removeSrgbCurve(float x) {
+    if (x < 0.0f) return -removeSrgbCurve(-x);
+
+    return x <= 0.04045f ?
+        x / 12.92f :
+        std::pow((x + 0.055f) / 1.055f, 2.4f);
+}
+
+/**
+ * A lookup table for the tone curve sampled at every 16-bit value. It
+ * has one extra point at the end to let the float inputs interpolate
+ * between the samples without any bounds checks.
+ *
+ * Integer sources fetch the result directly (8-bit values are just
+ * scaled by 257), float sources in [0, 1] range are interpolated
+ * linearly, which gives the error well below 1e-6, and the values
+ * outside this range go through the analytical curve to keep the
+ * dynamic range of the image.
+ */
+struct SrgbCurveTable {
+    static const int size = 65536;
+
+    SrgbCurveTable(float (*curve)(float))
+        : m_curve(curve)
+    {
+        for (int i = 0; i <= size; i++) {
+            m_table[i] = curve(float(i) / 65535.0f);
+        }
+    }
+
+    ALWAYS_INLINE float valueU8(quint8 x) const {
+        return m_table[x * 257];
+    }
+
+    ALWAYS_INLINE float valueU16(quint16 x) const {
+        return m_table[x];
+    }
+
+    ALWAYS_INLINE float valueF(float x) const {
+        if (x >= 0.0f && x <= 1.0f) {
+            const float pos = x * 65535.0f;
+            const int index = int(pos);
+            const float t = pos - index;
+            return m_table[index] + t * (m_table[index + 1] - m_table[index]);
+        }
+
+        return m_curve(x);
+    }
+
+    static const SrgbCurveTable& applyCurveTable() {
+        static const SrgbCurveTable table(&applySrgbCurve);
+        return table;
+    }
+
+    static const SrgbCurveTable& removeCurveTable() {
+        static const SrgbCurveTable table(&removeSrgbCurve);
+        return table;
+    }
+
+private:
+    float m_table[size + 1];
+    float (*m_curve)(float);
+};
+
+template <typename src_channel_type>
+struct SrgbCurveTableAccessor {
+    static ALWAYS_INLINE float value(const SrgbCurveTable &table, src_channel_type x) {
+        return table.valueF(float(x));
+    }
+};
+
+template <>
+struct SrgbCurveTableAccessor<quint8> {
+    static ALWAYS_INLINE float value(const SrgbCurveTable &table, quint8 x) {
+        return table.valueU8(x);
+    }
+};
+
+template <>
+struct SrgbCurveTableAccessor<quint16> {
+    static ALWAYS_INLINE float value(const SrgbCurveTable &table, quint16 x) {
+        return table.valueU16(x);
+    }
+};
+
+template <typename src_channel_type,
+          typename dst_channel_type>
+struct FastPathScalePolicy {
+    ALWAYS_INLINE dst_channel_type process(src_channel_type value) const {
+        return KoColorSpaceMaths<src_channel_type, dst_channel_type>::scaleToA(value);
+    }
+};
+
+template <typename src_channel_type,
+          typename dst_channel_type>
+struct ApplySrgbCurvePolicy {
+    ApplySrgbCurvePolicy()
+        : m_table(SrgbCurveTable::applyCurveTable())
+    {
+    }
+
+    ALWAYS_INLINE dst_channel_type process(src_channel_type value) const {
+        return KoColorSpaceMaths<float, dst_channel_type>::scaleToA(
+            SrgbCurveTableAccessor<src_channel_type>::value(m_table, value));
+    }
+
+    const SrgbCurveTable &m_table;
+};
+
+template <typename src_channel_type,
+          typename dst_channel_type>
+struct RemoveSrgbCurvePolicy {
+    RemoveSrgbCurvePolicy()
+        : m_table(SrgbCurveTable::removeCurveTable())
+    {
+    }
+
+    ALWAYS_INLINE dst_channel_type process(src_channel_type value) const {
+        return KoColorSpaceMaths<float, dst_channel_type>::scaleToA(
+            SrgbCurveTableAccessor<src_channel_type>::value(m_table, value));
+    }
+
+    const SrgbCurveTable &m_table;
+};
+
+template <typename T>
+ALWAYS_INLINE bool isFloatChannelType() {
+    return !std::numeric_limits<T>::is_integer;
+}
+
+}
+
+/**
+ * A shortcut conversion between RGB color spaces with the same primaries,
+ * that avoids passing the data through LCMS. The pixel loop has no branches
+ * for the integer sources, so the compiler can unroll and vectorize it.
+ */
+template<typename SrcCSTraits,
+         typename DstCSTraits,
+         template<typename, typename> class Policy>
+struct ApplyRgbFastPath : public KoColorConversionTransformation
+{
+    ApplyRgbFastPath(const KoColorSpace* srcCs,
+                     const KoColorSpace* dstCs,
+                     Intent renderingIntent,
+                     ConversionFlags conversionFlags)
+        : KoColorConversionTransformation(srcCs,
+                                          dstCs,
+                                          renderingIntent,
+                                          conversionFlags)
+    {
+    }
+
+    void transform(const quint8 *src, quint8 *dst, qint32 nPixels) const override {
+        KIS_ASSERT(src != dst);
+
+        const typename SrcCSTraits::Pixel *srcPixel = reinterpret_cast<const typename SrcCSTraits::Pixel*>(src);
+        typename DstCSTraits::Pixel *dstPixel = reinterpret_cast<typename DstCSTraits::Pixel*>(dst);
+
+        typedef typename SrcCSTraits::channels_type src_channel_type;
+        typedef typename DstCSTraits::channels_type dst_channel_type;
+        const Policy<src_channel_type, dst_channel_type> policy;
+
+        for (int i = 0; i < nPixels; i++) {
+            dstPixel->red = policy.process(srcPixel->red);
+            dstPixel->green = policy.process(srcPixel->green);
+            dstPixel->blue = policy.process(srcPixel->blue);
+            dstPixel->alpha =
+                KoColorSpaceMaths<src_channel_type, dst_channel_type>::scaleToA(
+                srcPixel->alpha);
+
+            srcPixel++;
+            dstPixel++;
+        }
+    }
+};
+
+/**
+ * Base class for all the fast path factories. Both the color spaces
+ * have the same primaries, so the color information is always kept.
+ * The dynamic range is lost only when a float color space is converted
+ * into an integer one.
+ */
+template<class SrcColorSpaceTraits, class DstColorSpaceTraits>
+class LcmsRGBFastPathTransformationFactoryBase : public KoColorConversionTransformationFactory
+{
+public:
+    LcmsRGBFastPathTransformationFactoryBase(const QString &srcProfile, const QString &dstProfile)
+        : KoColorConversionTransformationFactory(RGBAColorModelID.id(),
+                                                 colorDepthIdForChannelType<typename SrcColorSpaceTraits::channels_type>().id(),
+                                                 srcProfile,
+                                                 RGBAColorModelID.id(),
+                                                 colorDepthIdForChannelType<typename DstColorSpaceTraits::channels_type>().id(),
+                                                 dstProfile)
+    {
+    }
+
+    bool conserveColorInformation() const override {
+        return true;
+    }
+
+    bool conserveDynamicRange() const override {
+        return
+            isFloatChannelType<typename DstColorSpaceTraits::channels_type>() ||
+            !isFloatChannelType<typename SrcColorSpaceTraits::channels_type>();
+    }
+};
+
+/**
+ * Changes the bit depth of the color space without touching its profile
+ */
+template<class SrcColorSpaceTraits, class DstColorSpaceTraits>
+class LcmsScaleRGBFastPathTransformationFactory : public LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>
+{
+public:
+    LcmsScaleRGBFastPathTransformationFactory(const QString &profile)
+        : LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>(profile, profile)
+    {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(this->srcColorDepthId() != this->dstColorDepthId());
+    }
+
+    KoColorConversionTransformation* createColorTransformation(const KoColorSpace* srcColorSpace,
+                                                               const KoColorSpace* dstColorSpace,
+                                                               KoColorConversionTransformation::Intent renderingIntent,
+                                                               KoColorConversionTransformation::ConversionFlags conversionFlags) const override
+    {
+        return new ApplyRgbFastPath<
+                SrcColorSpaceTraits,
+                DstColorSpaceTraits,
+                FastPathScalePolicy>(srcColorSpace,
+                                 dstColorSpace,
+                                 renderingIntent,
+                                 conversionFlags);
+    }
+};
+
+/**
+ * Converts sRGB-TRC data into the linear sRGB profile
+ */
+template<class SrcColorSpaceTraits, class DstColorSpaceTraits>
+class LcmsFromSrgbTrcFastPathTransformationFactory : public LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>
+{
+public:
+    LcmsFromSrgbTrcFastPathTransformationFactory()
+        : LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>(SRGB_TRC_PROFILE_NAME, SRGB_LINEAR_PROFILE_NAME)
+    {
+    }
+
+    KoColorConversionTransformation* createColorTransformation(const KoColorSpace* srcColorSpace,
+                                                               const KoColorSpace* dstColorSpace,
+                                                               KoColorConversionTransformation::Intent renderingIntent,
+                                                               KoColorConversionTransformation::ConversionFlags conversionFlags) const override
+    {
+        return new ApplyRgbFastPath<
+                SrcColorSpaceTraits,
+                DstColorSpaceTraits,
+                RemoveSrgbCurvePolicy>(srcColorSpace,
+                                       dstColorSpace,
+                                       renderingIntent,
+                                       conversionFlags);
+    }
+};
+
+/**
+ * Converts linear sRGB data into the sRGB-TRC profile
+ */
+template<class SrcColorSpaceTraits, class DstColorSpaceTraits>
+class LcmsToSrgbTrcFastPathTransformationFactory : public LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>
+{
+public:
+    LcmsToSrgbTrcFastPathTransformationFactory()
+        : LcmsRGBFastPathTransformationFactoryBase<SrcColorSpaceTraits, DstColorSpaceTraits>(SRGB_LINEAR_PROFILE_NAME, SRGB_TRC_PROFILE_NAME)
+    {
+    }
+
+    KoColorConversionTransformation* createColorTransformation(const KoColorSpace* srcColorSpace,
+                                                               const KoColorSpace* dstColorSpace,
+                                                               KoColorConversionTransformation::Intent renderingIntent,
+                                                               KoColorConversionTransformation::ConversionFlags conversionFlags) const override
+    {
+        return new ApplyRgbFastPath<
+                SrcColorSpaceTraits,
+                DstColorSpaceTraits,
+                ApplySrgbCurvePolicy>(srcColorSpace,
+                                      dstColorSpace,
+                                      renderingIntent,
+                                      conversionFlags);
+    }
+};
+
+#endif // LCMSRGBFASTPATHTRANSFORMATION_H
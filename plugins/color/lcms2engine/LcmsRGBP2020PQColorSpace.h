@@ -108,6 +108,7 @@ class LcmsRGBP2020PQColorSpaceFactoryWrapper : public BaseColorSpaceFactory
 {
     typedef typename ColorSpaceFromFactory<BaseColorSpaceFactory>::type RelatedColorSpaceType;
 
+public:
     KoColorSpace *createColorSpace(const KoColorProfile *p) const override
     {
         return new RelatedColorSpaceType(this->name(), p->clone());
@@ -32,6 +32,8 @@
 #include <kis_image.h>
 #include <kis_signal_compressor.h>
 #include <kis_config.h>
+#include <kis_image_config.h>
+#include <kis_paint_device.h>
 #include "kis_idle_watcher.h"
 #include <QApplication>
 #include "OverviewThumbnailStrokeStrategy.h"
@@ -51,6 +53,7 @@ OverviewWidget::OverviewWidget(QWidget * parent)
 
 OverviewWidget::~OverviewWidget()
 {
+    releaseProjectionMipmap();
 }
 
 void OverviewWidget::setCanvas(KoCanvasBase * canvas)
@@ -59,11 +62,21 @@ void OverviewWidget::setCanvas(KoCanvasBase * canvas)
         m_canvas->image()->disconnect(this);
     }
 
+    releaseProjectionMipmap();
+
     m_canvas = dynamic_cast<KisCanvas2*>(canvas);
 
     if (m_canvas) {
         m_imageIdleWatcher.setTrackedImage(m_canvas->image());
 
+        // the thumbnail is regenerated on every idle period, so keep
+        // a downscaled copy of the projection that is updated incrementally
+        KisImageConfig imageConfig(true);
+        if (imageConfig.useProjectionMipmap()) {
+            m_mipmapImage = m_canvas->image();
+            m_canvas->image()->projection()->setMipmapEnabled(true);
+        }
+
         connect(&m_imageIdleWatcher, &KisIdleWatcher::startedIdleMode, this, &OverviewWidget::generateThumbnail);
 
         connect(m_canvas->image(), SIGNAL(sigImageUpdated(QRect)),SLOT(startUpdateCanvasProjection()));
@@ -75,6 +88,22 @@ void OverviewWidget::setCanvas(KoCanvasBase * canvas)
     }
 }
 
+void OverviewWidget::unsetCanvas()
+{
+    releaseProjectionMipmap();
+    m_canvas = 0;
+}
+
+void OverviewWidget::releaseProjectionMipmap()
+{
+    KisImageSP image = m_mipmapImage.toStrongRef();
+    m_mipmapImage = 0;
+
+    if (image) {
+        image->projection()->setMipmapEnabled(false);
+    }
+}
+
 void OverviewWidget::recalculatePreviewDimensions()
 {
     if (!m_canvas || !m_canvas->image()) {
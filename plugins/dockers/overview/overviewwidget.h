@@ -43,10 +43,7 @@ public:
     ~OverviewWidget() override;
 
     virtual void setCanvas(KoCanvasBase *canvas);
-    virtual void unsetCanvas()
-    {
-        m_canvas = 0;
-    }
+    virtual void unsetCanvas();
 
 public Q_SLOTS:
     void startUpdateCanvasProjection();
@@ -84,11 +81,18 @@ private:
     QTransform previewToCanvasTransform();
     QPolygonF previewPolygon();
 
+    /**
+     * Disables the mipmap of the projection of the image the widget
+     * has been attached to, since nobody else uses it
+     */
+    void releaseProjectionMipmap();
+
     qreal m_previewScale {1.0};
     QPixmap m_oldPixmap;
     QPixmap m_pixmap;
     QImage m_image;
     QPointer<KisCanvas2> m_canvas;
+    KisImageWSP m_mipmapImage;
 
 
     QPointF m_previewOrigin; // in the same coordinates space as m_previewSize
@@ -60,6 +60,7 @@ KisFilterConfigurationSP KisGaussianBlurFilter::defaultConfiguration() const
     config->setProperty("horizRadius", 5);
     config->setProperty("vertRadius", 5);
     config->setProperty("lockAspect", true);
+    config->setProperty("fastApproximation", true);
 
     return config;
 }
@@ -90,9 +91,19 @@ void KisGaussianBlurFilter::processImpl(KisPaintDeviceSP device,
         channelFlags = QBitArray(device->colorSpace()->channelCount(), true);
     }
 
+    /**
+     * The configurations saved before the fast blur was introduced
+     * don't have the option, they should be rendered exactly as before
+     */
+    const bool fastApproximation = config->getBool("fastApproximation", false);
+
     KisGaussianKernel::applyGaussian(device, rect,
                                      horizontalRadius, verticalRadius,
-                                     channelFlags, progressUpdater);
+                                     channelFlags, progressUpdater,
+                                     false, BORDER_REPEAT,
+                                     fastApproximation ?
+                                         KisGaussianKernel::BLUR_AUTO :
+                                         KisGaussianKernel::BLUR_EXACT);
 }
 
 QRect KisGaussianBlurFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
@@ -54,6 +54,10 @@ KisHalftoneFilter::KisHalftoneFilter()
     : KisFilter(id(), FiltersCategoryArtisticId, i18n("&Halftone..."))
 {
     setSupportsPainting(true);
+
+    // the screens are defined by nested generator configurations,
+    // which cannot be scaled generically
+    setSupportsGenericLevelOfDetail(false);
 }
 
 void KisHalftoneFilter::processImpl(KisPaintDeviceSP device,
@@ -57,6 +57,7 @@ KisOilPaintFilter::KisOilPaintFilter() : KisFilter(id(), FiltersCategoryArtistic
     setSupportsPainting(true);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(true);
+    setLevelOfDetailScaledProperties({"brushSize"});
 }
 
 void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
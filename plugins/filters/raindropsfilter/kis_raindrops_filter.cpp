@@ -59,6 +59,7 @@ KisRainDropsFilter::KisRainDropsFilter()
     setSupportsPainting(false);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(false);
+    setLevelOfDetailScaledProperties({"dropSize"});
 }
 
 // This method have been ported from Pieter Z. Voloshyn algorithm code.
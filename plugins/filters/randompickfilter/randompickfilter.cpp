@@ -67,6 +67,7 @@ KisFilterRandomPick::KisFilterRandomPick() : KisFilter(id(), FiltersCategoryOthe
 {
     setColorSpaceIndependence(FULLY_INDEPENDENT);
     setSupportsPainting(true);
+    setLevelOfDetailScaledProperties({"windowsize"});
 }
 
 
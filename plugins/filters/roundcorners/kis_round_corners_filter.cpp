@@ -54,7 +54,7 @@
 KisRoundCornersFilter::KisRoundCornersFilter() : KisFilter(id(), FiltersCategoryMapId, i18n("&Round Corners..."))
 {
     setSupportsPainting(false);
-
+    setLevelOfDetailScaledProperties({"radius"});
 }
 
 void fadeOneCorner(KisPaintDeviceSP device,
@@ -52,9 +52,11 @@ KisUnsharpFilter::KisUnsharpFilter() : KisFilter(id(), FiltersCategoryEnhanceId,
      * generates subtle artifacts when the unsharp radius is smaller
      * than current zoom level. But LoD devices can still appear when
      * the filter is used in Adjustment Layer. So the actual LoD is
-     * still counted on.
+     * still counted on. The generic LoD path would bring the same
+     * artifacts into the preview, so it is disabled as well.
      */
     setSupportsLevelOfDetail(false);
+    setSupportsGenericLevelOfDetail(false);
     setColorSpaceIndependence(FULLY_INDEPENDENT);
 }
 
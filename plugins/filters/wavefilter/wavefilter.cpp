@@ -111,6 +111,8 @@ KisFilterWave::KisFilterWave() : KisFilter(id(), FiltersCategoryOtherId, i18n("&
     setColorSpaceIndependence(FULLY_INDEPENDENT);
     setSupportsPainting(false);
     setSupportsAdjustmentLayers(false);
+    setLevelOfDetailScaledProperties({"horizontalwavelength", "horizontalshift", "horizontalamplitude",
+                                      "verticalwavelength", "verticalshift", "verticalamplitude"});
 }
 
 KisFilterConfigurationSP KisFilterWave::defaultConfiguration() const
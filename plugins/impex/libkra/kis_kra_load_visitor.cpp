@@ -28,6 +28,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QMessageBox>
+#include <QtConcurrent>
 
 #include <KoHashGenerator.h>
 #include <KoHashGeneratorProvider.h>
@@ -194,10 +195,15 @@ bool KisKraLoadVisitor::visit(KisPaintLayer *layer)
 {
     loadNodeKeyframes(layer);
 
-    if (!loadPaintDevice(layer->paintDevice(), getLocation(layer))) {
+    /**
+     * The profile is assigned before the pixel data is loaded, because
+     * the device may be read asynchronously and setProfile() replaces
+     * the color space of the device
+     */
+    if (!loadProfile(layer->paintDevice(), getLocation(layer, DOT_ICC))) {
         return false;
     }
-    if (!loadProfile(layer->paintDevice(), getLocation(layer, DOT_ICC))) {
+    if (!loadPaintDevice(layer->paintDevice(), getLocation(layer), true)) {
         return false;
     }
     if (!loadMetaData(layer)) {
@@ -492,6 +498,24 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
     return true;
 }
 
+KisKraLoadVisitor::~KisKraLoadVisitor()
+{
+    waitForAsyncLoading();
+}
+
+void KisKraLoadVisitor::waitForAsyncLoading()
+{
+    Q_FOREACH (AsyncDeviceLoad load, m_asyncLoads) {
+        if (!load.result.result()) {
+            m_warningMessages << i18n("Could not read pixel data: %1.", load.location);
+            load.device->disconnect();
+        }
+    }
+
+    m_asyncLoads.clear();
+    m_asyncLoadsBytes = 0;
+}
+
 QStringList KisKraLoadVisitor::errorMessages() const
 {
     return m_errorMessages;
@@ -504,13 +528,26 @@ QStringList KisKraLoadVisitor::warningMessages() const
 
 struct SimpleDevicePolicy
 {
+    SimpleDevicePolicy(bool allowAsync = false)
+        : m_allowAsync(allowAsync) {}
+
     bool read(KisPaintDeviceSP dev, QIODevice *stream) {
         return dev->read(stream);
     }
 
+    /**
+     * Only the devices that are not touched by the visitor after
+     * loading can be read asynchronously
+     */
+    bool allowAsync() const {
+        return m_allowAsync;
+    }
+
     void setDefaultPixel(KisPaintDeviceSP dev, const KoColor &defaultPixel) const {
         return dev->setDefaultPixel(defaultPixel);
     }
+
+    bool m_allowAsync;
 };
 
 struct FramedDevicePolicy
@@ -526,10 +563,14 @@ struct FramedDevicePolicy
         return dev->framesInterface()->setFrameDefaultPixel(defaultPixel, m_frameId);
     }
 
+    bool allowAsync() const {
+        return false;
+    }
+
     int m_frameId;
 };
 
-bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString& location)
+bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString& location, bool allowAsync)
 {
     // Layer data
     KisPaintDeviceFramesInterface *frameInterface = device->framesInterface();
@@ -540,7 +581,7 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
     }
 
     if (!frameInterface || frames.count() <= 1) {
-        return loadPaintDeviceFrame(device, location, SimpleDevicePolicy());
+        return loadPaintDeviceFrame(device, location, SimpleDevicePolicy(allowAsync));
     } else {
         KisRasterKeyframeChannel *keyframeChannel = device->keyframeChannel();
 
@@ -582,7 +623,49 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
         policy.setDefaultPixel(device, color);
     }
 
-    if (m_store->open(location)) {
+    if (!m_store->open(location)) {
+        m_warningMessages << i18n("Could not load pixel data: %1.", location);
+        return true;
+    }
+
+    /**
+     * Reading from the store is sequential, but the decompression
+     * of the tiles is much more expensive, so we fetch the raw
+     * data and decompress it in a background thread. The amount
+     * of data waiting for decompression is limited to avoid
+     * keeping the whole document in memory, the blobs that are
+     * bigger than the limit are decompressed right from the store.
+     */
+    const qint64 maxAsyncLoadsBytes = 256 * 1024 * 1024;
+
+    if (policy.allowAsync() && m_store->size() <= maxAsyncLoadsBytes) {
+        const QByteArray data = m_store->read(m_store->size());
+        m_store->close();
+
+        if (m_asyncLoadsBytes + data.size() > maxAsyncLoadsBytes) {
+            waitForAsyncLoading();
+        }
+
+        /**
+         * The failures are reported through the future, the device is
+         * disconnected in waitForAsyncLoading(), in the loader thread
+         */
+        AsyncDeviceLoad load;
+        load.location = location;
+        load.device = device;
+        load.result = QtConcurrent::run(
+            [device, data, policy] () mutable {
+                QBuffer buffer;
+                buffer.setData(data);
+                buffer.open(QIODevice::ReadOnly);
+
+                return policy.read(device, &buffer);
+            });
+
+        m_asyncLoads.append(load);
+        m_asyncLoadsBytes += data.size();
+
+    } else {
         if (!policy.read(device, m_store->device())) {
             m_warningMessages << i18n("Could not read pixel data: %1.", location);
             device->disconnect();
@@ -590,9 +673,6 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
             return true;
         }
         m_store->close();
-    } else {
-        m_warningMessages << i18n("Could not load pixel data: %1.", location);
-        return true;
     }
 
     return true;
@@ -22,6 +22,7 @@
 
 #include <QRect>
 #include <QStringList>
+#include <QFuture>
 
 // kritaimage
 #include "kis_types.h"
@@ -47,6 +48,7 @@ public:
                       QMap<KisNode *, QString> &keyframeFilenames,
                       const QString & name,
                       int syntaxVersion);
+    ~KisKraLoadVisitor() override;
 
 public:
     void setExternalUri(const QString &uri);
@@ -69,9 +71,18 @@ public:
     QStringList errorMessages() const;
     QStringList warningMessages() const;
 
+    /**
+     * The pixel data of the paint layers is decompressed in the
+     * background threads while the visitor continues traversing
+     * the nodes. This method waits until all the data is loaded.
+     * It must be called before the image is used or the messages
+     * are fetched.
+     */
+    void waitForAsyncLoading();
+
 private:
 
-    bool loadPaintDevice(KisPaintDeviceSP device, const QString& location);
+    bool loadPaintDevice(KisPaintDeviceSP device, const QString& location, bool allowAsync = false);
 
     template<class DevicePolicy>
     bool loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy);
@@ -109,6 +120,15 @@ private:
     QStringList m_warningMessages;
     KoShapeControllerBase *m_shapeController;
     QMap<QByteArray, const KoColorProfile *> m_profileCache;
+
+    struct AsyncDeviceLoad {
+        QString location;
+        KisPaintDeviceSP device;
+        QFuture<bool> result;
+    };
+
+    QList<AsyncDeviceLoad> m_asyncLoads;
+    qint64 m_asyncLoadsBytes = 0;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
@@ -21,6 +21,8 @@
 #include <cmath>
 #include <memory>
 #include <QRect>
+#include <QThread>
+#include <QtConcurrent>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColor.h>
@@ -41,6 +43,51 @@
 #include <KoColorModelStandardIds.h>
 #include "kis_paintop_plugin_utils.h"
 
+namespace {
+
+/**
+ * The height of the stripes the big dabs are split into. It is equal
+ * to the height of the tiles of the paint devices.
+ */
+const int stripeHeight = 64;
+
+/**
+ * Smaller dabs are rendered in the stroke thread, since starting the
+ * concurrent jobs costs more than rendering them
+ */
+const int minStripedDabArea = 128 * 128;
+
+}
+
+struct KisColorSmudgeOp::DabRenderingInfo
+{
+    QRect srcDabRect;
+    bool useDullingMode = false;
+
+    /**
+     * The image projection, when the overlay mode is enabled
+     */
+    KisPaintDeviceSP projection;
+
+    /**
+     * The device the smudged pixels are taken from in the smearing mode
+     */
+    KisPaintDeviceSP smudgeSource;
+
+    /**
+     * The color the dab is filled with in the dulling mode
+     */
+    KoColor dullingFillColor;
+
+    /**
+     * The color mixed into the smudged pixels in the smearing mode
+     */
+    bool fillColorRate = false;
+    KoColor colorRateColor;
+
+    quint8 finalOpacity = OPACITY_OPAQUE_U8;
+};
+
 
 KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPainter* painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
@@ -121,6 +168,13 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
 
 KisColorSmudgeOp::~KisColorSmudgeOp()
 {
+    Q_FOREACH (const DabPainters &painters, m_stripePainters) {
+        delete painters.backgroundPainter;
+        delete painters.smudgePainter;
+        delete painters.colorRatePainter;
+        delete painters.finalPainter;
+    }
+
     qDeleteAll(m_hsvOptions);
     delete m_hsvTransform;
 }
@@ -247,15 +301,12 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
     const qreal fpOpacity = (qreal(painter()->opacity()) / 255.0) * m_opacityOption.getOpacityf(info);
 
+    DabRenderingInfo renderingInfo;
+    renderingInfo.srcDabRect = srcDabRect;
+    renderingInfo.useDullingMode = useDullingMode;
+
     if (m_image && m_overlayModeOption.isChecked()) {
-        m_image->blockUpdates();
-        m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
-        m_image->unblockUpdates();
-    }
-    else {
-        // IMPORTANT: Clear the temporary painting device to transparent black.
-        //            It will only clear the extents of the brush.
-        m_tempDev->clear(QRect(QPoint(), m_dstDabRect.size()));
+        renderingInfo.projection = m_image->projection();
     }
 
     // stored in the color space of the paintColor
@@ -265,7 +316,7 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
     if (!useDullingMode) {
         activeWrapper.readRect(srcDabRect);
-        m_smudgePainter->bitBlt(QPoint(), activeWrapper.preciseDevice(), srcDabRect);
+        renderingInfo.smudgeSource = activeWrapper.preciseDevice();
     } else {
         if (m_smudgeRadiusOption.isChecked()) {
             const qreal effectiveSize = 0.5 * (m_dstDabRect.width() + m_dstDabRect.height());
@@ -311,7 +362,8 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
                 color.convertTo(m_colorRatePainter->device()->colorSpace());
             }
 
-            m_colorRatePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
+            renderingInfo.fillColorRate = true;
+            renderingInfo.colorRateColor = color;
         } else {
             KIS_SAFE_ASSERT_RECOVER(*dullingFillColor.colorSpace() == *color.colorSpace()) {
                 color.convertTo(dullingFillColor.colorSpace());
@@ -327,38 +379,188 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
     if (useDullingMode) {
         KIS_SAFE_ASSERT_RECOVER_NOOP(*dullingFillColor.colorSpace() == *m_tempDev->colorSpace());
-        m_tempDev->fill(QRect(0, 0, m_dstDabRect.width(), m_dstDabRect.height()), dullingFillColor);
+        renderingInfo.dullingFillColor = dullingFillColor;
     }
 
     m_precisePainterWrapper.readRects(m_finalPainter->calculateAllMirroredRects(m_dstDabRect));
 
+    // set opacity calculated by the rate option
+    m_smudgeRateOption.apply(*m_finalPainter, info, 0.0, 1.0, fpOpacity);
+    renderingInfo.finalOpacity = m_finalPainter->opacity();
+
+    if (renderingInfo.projection) {
+        m_image->blockUpdates();
+    }
+
+    /**
+     * The consecutive dabs depend on each other, because every dab samples
+     * the result of the previous one, so the dabs are always rendered one
+     * by one. But the pixels of a single dab are independent, so the big
+     * dabs are split into stripes rendered concurrently.
+     */
+    const bool useStripes =
+        m_dstDabRect.height() > stripeHeight &&
+        m_dstDabRect.width() * m_dstDabRect.height() >= minStripedDabArea &&
+        QThread::idealThreadCount() > 1;
+
+    QVector<QRect> dirtyRects =
+        useStripes ?
+        renderDabInStripes(renderingInfo) :
+        renderDabSequentially(renderingInfo);
+
+    m_finalPainter->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+
+    if (renderingInfo.projection) {
+        m_image->unblockUpdates();
+    }
+
+    const QVector<QRect> mirroredRects = m_finalPainter->takeDirtyRegion();
+    m_precisePainterWrapper.writeRects(mirroredRects);
+    dirtyRects += mirroredRects;
+
+    painter()->addDirtyRects(dirtyRects);
+
+    return spacingInfo;
+}
+
+KisColorSmudgeOp::DabPainters KisColorSmudgeOp::stripePainters(int index)
+{
+    while (m_stripePainters.size() <= index) {
+        DabPainters painters;
+
+        painters.backgroundPainter = new KisPainter(m_tempDev);
+        painters.backgroundPainter->setCompositeOp(COMPOSITE_COPY);
+
+        painters.smudgePainter = new KisPainter(m_tempDev);
+
+        painters.colorRatePainter = new KisPainter(m_tempDev);
+        painters.colorRatePainter->setCompositeOp(m_colorRatePainter->compositeOp()->id());
+
+        painters.finalPainter = new KisPainter(m_precisePainterWrapper.preciseDevice());
+        painters.finalPainter->setCompositeOp(m_finalPainter->compositeOp()->id());
+        painters.finalPainter->setSelection(m_finalPainter->selection());
+        painters.finalPainter->setChannelFlags(m_finalPainter->channelFlags());
+
+        m_stripePainters.append(painters);
+    }
+
+    DabPainters painters = m_stripePainters[index];
+    painters.colorRatePainter->setOpacity(m_colorRatePainter->opacity());
+
+    return painters;
+}
+
+void KisColorSmudgeOp::prepareDabRect(const DabPainters &painters, const QRect &rc, const DabRenderingInfo &info)
+{
+    const QRect tempRect = rc.translated(-m_dstDabRect.topLeft());
+    const QRect srcRect = rc.translated(info.srcDabRect.topLeft() - m_dstDabRect.topLeft());
+
+    if (info.projection) {
+        painters.backgroundPainter->bitBlt(tempRect.topLeft(), info.projection, srcRect);
+    }
+    else {
+        // IMPORTANT: Clear the temporary painting device to transparent black.
+        //            It will only clear the extents of the brush.
+        m_tempDev->clear(tempRect);
+    }
+
+    if (!info.useDullingMode) {
+        painters.smudgePainter->bitBlt(tempRect.topLeft(), info.smudgeSource, srcRect);
+
+        if (info.fillColorRate) {
+            painters.colorRatePainter->fill(tempRect.x(), tempRect.y(), tempRect.width(), tempRect.height(), info.colorRateColor);
+        }
+    } else {
+        m_tempDev->fill(tempRect, info.dullingFillColor);
+    }
+}
+
+QVector<QRect> KisColorSmudgeOp::blendDabRect(const DabPainters &painters, const QRect &rc, const DabRenderingInfo &info)
+{
+    const QRect tempRect = rc.translated(-m_dstDabRect.topLeft());
+
     // if color is disabled (only smudge) and "overlay mode" is enabled
     // then first blit the region under the brush from the image projection
     // to the painting device to prevent a rapid build up of alpha value
     // if the color to be smudged is semi transparent.
-    if (m_image && m_overlayModeOption.isChecked() && !m_colorRateOption.isChecked()) {
-        m_finalPainter->setOpacity(OPACITY_OPAQUE_U8);
-        m_image->blockUpdates();
+    if (info.projection && !m_colorRateOption.isChecked()) {
+        painters.finalPainter->setOpacity(OPACITY_OPAQUE_U8);
         // TODO: check if this code is correct in mirrored mode! Technically, the
         //       painter renders the mirrored dab only, so we should also prepare
         //       the overlay for it in all the places.
-        m_finalPainter->bitBlt(m_dstDabRect.topLeft(), m_image->projection(), m_dstDabRect);
-        m_image->unblockUpdates();
+        painters.finalPainter->bitBlt(rc.topLeft(), info.projection, rc);
     }
 
-    // set opacity calculated by the rate option
-    m_smudgeRateOption.apply(*m_finalPainter, info, 0.0, 1.0, fpOpacity);
+    painters.finalPainter->setOpacity(info.finalOpacity);
 
     // then blit the temporary painting device on the canvas at the current brush position
     // the alpha mask (maskDab) will be used here to only blit the pixels that are in the area (shape) of the brush
-    m_finalPainter->bitBltWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_tempDev, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
-    m_finalPainter->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+    painters.finalPainter->bitBltWithFixedSelection(rc.x(), rc.y(),
+                                                    m_tempDev, m_maskDab,
+                                                    tempRect.x(), tempRect.y(),
+                                                    tempRect.x(), tempRect.y(),
+                                                    rc.width(), rc.height());
 
-    const QVector<QRect> dirtyRects = m_finalPainter->takeDirtyRegion();
+    const QVector<QRect> dirtyRects = painters.finalPainter->takeDirtyRegion();
     m_precisePainterWrapper.writeRects(dirtyRects);
-    painter()->addDirtyRects(dirtyRects);
 
-    return spacingInfo;
+    return dirtyRects;
+}
+
+QVector<QRect> KisColorSmudgeOp::renderDabSequentially(const DabRenderingInfo &info)
+{
+    DabPainters painters;
+    painters.backgroundPainter = m_backgroundPainter.data();
+    painters.smudgePainter = m_smudgePainter.data();
+    painters.colorRatePainter = m_colorRatePainter.data();
+    painters.finalPainter = m_finalPainter.data();
+
+    prepareDabRect(painters, m_dstDabRect, info);
+    return blendDabRect(painters, m_dstDabRect, info);
+}
+
+QVector<QRect> KisColorSmudgeOp::renderDabInStripes(const DabRenderingInfo &info)
+{
+    struct StripeJob {
+        QRect rect;
+        DabPainters painters;
+        QVector<QRect> dirtyRects;
+    };
+
+    /**
+     * The stripes are aligned to the tiles of m_tempDev, so that the
+     * concurrent jobs would never write into the same tile of it
+     */
+    QVector<StripeJob> jobs;
+    for (int y = 0; y < m_dstDabRect.height(); y += stripeHeight) {
+        StripeJob job;
+        job.rect = QRect(m_dstDabRect.x(), m_dstDabRect.y() + y,
+                         m_dstDabRect.width(), qMin(stripeHeight, m_dstDabRect.height() - y));
+        job.painters = stripePainters(jobs.size());
+        jobs.append(job);
+    }
+
+    QtConcurrent::blockingMap(jobs,
+        [this, &info] (StripeJob &job) {
+            prepareDabRect(job.painters, job.rect, info);
+        });
+
+    /**
+     * The source rect of the smudge usually overlaps the destination
+     * rect of the dab, so the blending may start only when all the
+     * stripes have sampled the canvas.
+     */
+    QtConcurrent::blockingMap(jobs,
+        [this, &info] (StripeJob &job) {
+            job.dirtyRects = blendDabRect(job.painters, job.rect, info);
+        });
+
+    QVector<QRect> dirtyRects;
+    Q_FOREACH (const StripeJob &job, jobs) {
+        dirtyRects += job.dirtyRects;
+    }
+
+    return dirtyRects;
 }
 
 KisSpacingInformation KisColorSmudgeOp::updateSpacingImpl(const KisPaintInformation &info) const
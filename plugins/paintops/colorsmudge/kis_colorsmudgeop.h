@@ -65,6 +65,31 @@ private:
 
     inline void getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y);
 
+    struct DabRenderingInfo;
+
+    /**
+     * The painters used for rendering a part of the dab. The stripes
+     * of big dabs are rendered concurrently, so each of them needs its
+     * own set of painters.
+     */
+    struct DabPainters {
+        KisPainter *backgroundPainter = 0;
+        KisPainter *smudgePainter = 0;
+        KisPainter *colorRatePainter = 0;
+        KisPainter *finalPainter = 0;
+    };
+
+    DabPainters stripePainters(int index);
+
+    // Samples the canvas and mixes the paint color into m_tempDev
+    void prepareDabRect(const DabPainters &painters, const QRect &rc, const DabRenderingInfo &info);
+
+    // Blends m_tempDev into the canvas and returns the changed rects
+    QVector<QRect> blendDabRect(const DabPainters &painters, const QRect &rc, const DabRenderingInfo &info);
+
+    QVector<QRect> renderDabSequentially(const DabRenderingInfo &info);
+    QVector<QRect> renderDabInStripes(const DabRenderingInfo &info);
+
 private:
     bool                      m_firstRun;
     KisImageWSP               m_image;
@@ -94,6 +119,7 @@ private:
     QRect                     m_dstDabRect;
     KisFixedPaintDeviceSP     m_maskDab;
     QPointF                   m_lastPaintPos;
+    QVector<DabPainters>      m_stripePainters;
 
     KoColorTransformation *m_hsvTransform {0};
     const KoCompositeOp *m_preciseColorRateCompositeOp {0};
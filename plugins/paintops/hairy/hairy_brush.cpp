@@ -25,7 +25,9 @@
 
 #include <QVariant>
 #include <QHash>
+#include <QThread>
 #include <QVector>
+#include <QtConcurrent>
 
 #include <kis_types.h>
 #include <kis_random_accessor_ng.h>
@@ -35,6 +37,47 @@
 
 #include <cmath>
 #include <ctime>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+/**
+ * The height of the bands the dab is split into. It is equal to the
+ * height of the tiles, so the bands rarely share tiles.
+ */
+const int bandHeight = 64;
+
+/**
+ * The lines with fewer bristles or deposits are painted in the calling
+ * thread, starting the concurrent jobs would cost more
+ */
+const int minBristlesPerJob = 256;
+const int minDepositsForBands = 4096;
+
+inline int bandIndex(int y)
+{
+    return y >= 0 ? y / bandHeight : -((-y - 1) / bandHeight) - 1;
+}
+
+}
+
+void HairyBrush::InkDeposits::append(const QPointF &pos, const quint8 *color, int pixelSize)
+{
+    x.append(pos.x());
+    y.append(pos.y());
+
+    const int offset = colors.size();
+    colors.resize(offset + pixelSize);
+    memcpy(colors.data() + offset, color, pixelSize);
+}
+
+void HairyBrush::InkDeposits::append(const InkDeposits &rhs)
+{
+    x += rhs.x;
+    y += rhs.y;
+    colors += rhs.colors;
+}
 
 
 HairyBrush::HairyBrush()
@@ -44,12 +87,12 @@ HairyBrush::HairyBrush()
     m_oldPressure = 1.0f;
 
     m_saturationId = -1;
-    m_transfo = 0;
+    m_numJobs = qMax(1, QThread::idealThreadCount());
 }
 
 HairyBrush::~HairyBrush()
 {
-    delete m_transfo;
+    qDeleteAll(m_transfos);
     qDeleteAll(m_bristles.begin(), m_bristles.end());
     m_bristles.clear();
 }
@@ -61,9 +104,16 @@ void HairyBrush::initAndCache()
     m_pixelSize = m_dab->colorSpace()->pixelSize();
 
     if (m_properties->useSaturation) {
-        m_transfo = m_dab->colorSpace()->createColorTransformation("hsv_adjustment", m_params);
-        if (m_transfo) {
-            m_saturationId = m_transfo->parameterId("s");
+        for (int i = 0; i < m_numJobs; i++) {
+            KoColorTransformation *transfo =
+                m_dab->colorSpace()->createColorTransformation("hsv_adjustment", m_params);
+            if (!transfo) break;
+
+            m_transfos.append(transfo);
+        }
+
+        if (!m_transfos.isEmpty()) {
+            m_saturationId = m_transfos.first()->parameterId("s");
         }
     }
 }
@@ -133,11 +183,6 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
     // this pressure controls shear and ink depletion
     qreal pressure = mousePressure * (pi2.pressure() * 2);
 
-    Bristle *bristle = 0;
-    KoColor bristleColor(dab->colorSpace());
-
-    m_dabAccessor = dab->createRandomAccessorNG();
-
     m_dab = dab;
 
     // initialization block
@@ -159,19 +204,36 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
 
     KisRandomSourceSP randomSource = pi2.randomSource();
 
+    /**
+     * The line is painted in three steps:
+     *
+     * 1) The bristles are transformed into their new positions. This
+     *    step consumes the random numbers, so it is done sequentially
+     *    to keep the strokes reproducible.
+     *
+     * 2) The bristles are moved along their paths and the ink they leave
+     *    is collected. Every bristle depends only on its own state, so the
+     *    bristles are split into concurrent jobs.
+     *
+     * 3) The deposits are painted into the dab. The result of painting
+     *    depends on the order of the deposits, so the dab is split into
+     *    horizontal bands, and every band paints its own deposits in the
+     *    original order. Therefore the result is exactly the same as if
+     *    all the deposits were painted one by one.
+     */
+
+    BristleSegments segments;
+
     qreal fx1, fy1, fx2, fy2;
     qreal randomX, randomY;
     qreal shear;
 
-    float inkDeplation = 0.0;
-    int inkDepletionSize = m_properties->inkDepletionCurve.size();
     int bristleCount = m_bristles.size();
-    int bristlePathSize;
     qreal threshold = 1.0 - pi2.pressure();
     for (int i = 0; i < bristleCount; i++) {
 
         if (!m_bristles.at(i)->enabled()) continue;
-        bristle = m_bristles[i];
+        Bristle *bristle = m_bristles[i];
 
         randomX = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
         randomY = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
@@ -200,17 +262,118 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
         bristle->setPrevX(fx2);
         bristle->setPrevY(fy2);
 
+        if (m_properties->threshold && (bristle->length() < threshold)) continue;
+
         // all coords relative to device position
-        fx1 += x1;
-        fy1 += y1;
+        segments.bristle.append(i);
+        segments.x1.append(fx1 + x1);
+        segments.y1.append(fy1 + y1);
+        segments.x2.append(fx2 + x2);
+        segments.y2.append(fy2 + y2);
+    }
 
-        fx2 += x2;
-        fy2 += y2;
+    int numJobs = qBound(1, segments.size() / minBristlesPerJob, m_numJobs);
+    if (!m_transfos.isEmpty()) {
+        numJobs = qMin(numJobs, m_transfos.size());
+    }
+
+    QVector<InkDeposits> jobDeposits(numJobs);
+    InkDeposits *jobDepositsPtr = jobDeposits.data();
+
+    if (numJobs > 1) {
+        QVector<int> jobs(numJobs);
+        std::iota(jobs.begin(), jobs.end(), 0);
+
+        QtConcurrent::blockingMap(jobs,
+            [this, &segments, jobDepositsPtr, numJobs, pressure] (int job) {
+                const int begin = segments.size() * job / numJobs;
+                const int end = segments.size() * (job + 1) / numJobs;
+
+                depositInk(segments, begin, end, pressure,
+                           m_transfos.value(job, 0), jobDepositsPtr + job);
+            });
+    } else {
+        depositInk(segments, 0, segments.size(), pressure,
+                   m_transfos.value(0, 0), jobDepositsPtr);
+    }
+
+    InkDeposits deposits;
+    Q_FOREACH (const InkDeposits &rhs, jobDeposits) {
+        deposits.append(rhs);
+    }
+
+    const int numDeposits = deposits.x.size();
+
+    if (numDeposits < minDepositsForBands || m_numJobs == 1) {
+        DabBand band;
+        band.top = std::numeric_limits<int>::min();
+        band.bottom = std::numeric_limits<int>::max();
+        band.deposits.resize(numDeposits);
+        std::iota(band.deposits.begin(), band.deposits.end(), 0);
+
+        paintBand(deposits, band);
+    } else {
+        int minBand = std::numeric_limits<int>::max();
+        int maxBand = std::numeric_limits<int>::min();
+
+        // the rows touched by the deposits, see addBristleInk()
+        auto depositRows = [this, &deposits] (int i) {
+            return m_properties->antialias ?
+                std::make_pair(int(deposits.y[i]), int(deposits.y[i]) + 1) :
+                std::make_pair(qRound(deposits.y[i]), qRound(deposits.y[i]));
+        };
+
+        for (int i = 0; i < numDeposits; i++) {
+            const std::pair<int, int> rows = depositRows(i);
+            minBand = qMin(minBand, bandIndex(rows.first));
+            maxBand = qMax(maxBand, bandIndex(rows.second));
+        }
+
+        QVector<DabBand> bands(maxBand - minBand + 1);
+        for (int i = 0; i < bands.size(); i++) {
+            bands[i].top = (minBand + i) * bandHeight;
+            bands[i].bottom = bands[i].top + bandHeight;
+        }
+
+        for (int i = 0; i < numDeposits; i++) {
+            const std::pair<int, int> rows = depositRows(i);
+            const int firstBand = bandIndex(rows.first);
+            const int lastBand = bandIndex(rows.second);
+
+            for (int band = firstBand; band <= lastBand; band++) {
+                bands[band - minBand].deposits.append(i);
+            }
+        }
+
+        QtConcurrent::blockingMap(bands,
+            [this, &deposits] (DabBand &band) {
+                if (!band.deposits.isEmpty()) {
+                    paintBand(deposits, band);
+                }
+            });
+    }
+
+    m_dab = 0;
+}
+
+void HairyBrush::depositInk(const BristleSegments &segments, int begin, int end, qreal pressure,
+                            KoColorTransformation *transfo, InkDeposits *deposits)
+{
+    Trajectory trajectory;
+    KoColor bristleColor(m_dab->colorSpace());
+
+    float inkDeplation = 0.0;
+    int inkDepletionSize = m_properties->inkDepletionCurve.size();
+    int bristlePathSize;
+
+    for (int j = begin; j < end; j++) {
+        Bristle *bristle = m_bristles.at(segments.bristle[j]);
 
-        if (m_properties->threshold && (bristle->length() < threshold)) continue;
         // paint between first and last dab
-        const QVector<QPointF> bristlePath = m_trajectory.getLinearTrajectory(QPointF(fx1, fy1), QPointF(fx2, fy2), 1.0);
-        bristlePathSize = m_trajectory.size();
+        const QVector<QPointF> bristlePath =
+            trajectory.getLinearTrajectory(QPointF(segments.x1[j], segments.y1[j]),
+                                           QPointF(segments.x2[j], segments.y2[j]), 1.0);
+        bristlePathSize = trajectory.size();
 
         // avoid overlapping bristle caps with antialias on
         if (m_properties->antialias) {
@@ -223,8 +386,8 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
             if (m_properties->inkDepletionEnabled) {
                 inkDeplation = fetchInkDepletion(bristle, inkDepletionSize);
 
-                if (m_properties->useSaturation && m_transfo != 0) {
-                    saturationDepletion(bristle, bristleColor, pressure, inkDeplation);
+                if (m_properties->useSaturation && transfo != 0) {
+                    saturationDepletion(transfo, bristle, bristleColor, pressure, inkDeplation);
                 }
 
                 if (m_properties->useOpacity) {
@@ -238,14 +401,26 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
                 }
             }
 
-            addBristleInk(bristle, bristlePath.at(i), bristleColor);
+            deposits->append(bristlePath.at(i), bristleColor.data(), m_pixelSize);
             bristle->setInkAmount(1.0 - inkDeplation);
             bristle->upIncrement();
         }
+    }
+}
 
+void HairyBrush::paintBand(const InkDeposits &deposits, DabBand &band)
+{
+    band.accessor = m_dab->createRandomAccessorNG();
+    band.color = m_color;
+
+    KoColor color(m_dab->colorSpace());
+
+    Q_FOREACH (int i, band.deposits) {
+        memcpy(color.data(), deposits.colors.constData() + i * m_pixelSize, m_pixelSize);
+        addBristleInk(band, QPointF(deposits.x[i], deposits.y[i]), color);
     }
-    m_dab = 0;
-    m_dabAccessor = 0;
+
+    band.accessor = 0;
 }
 
 
@@ -259,7 +434,7 @@ inline qreal HairyBrush::fetchInkDepletion(Bristle* bristle, int inkDepletionSiz
 }
 
 
-void HairyBrush::saturationDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation)
+void HairyBrush::saturationDepletion(KoColorTransformation *transfo, Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation)
 {
     qreal saturation;
     if (m_properties->useWeights) {
@@ -279,12 +454,12 @@ void HairyBrush::saturationDepletion(Bristle * bristle, KoColor &bristleColor, q
                          (1.0 - inkDeplation)) - 1.0;
 
     }
-    m_transfo->setParameter(m_transfo->parameterId("h"), 0.0);
-    m_transfo->setParameter(m_transfo->parameterId("v"), 0.0);
-    m_transfo->setParameter(m_saturationId, saturation);
-    m_transfo->setParameter(3, 1);//sets the type to
-    m_transfo->setParameter(4, false);//sets the colorize to none.
-    m_transfo->transform(bristleColor.data(), bristleColor.data() , 1);
+    transfo->setParameter(transfo->parameterId("h"), 0.0);
+    transfo->setParameter(transfo->parameterId("v"), 0.0);
+    transfo->setParameter(m_saturationId, saturation);
+    transfo->setParameter(3, 1);//sets the type to
+    transfo->setParameter(4, false);//sets the colorize to none.
+    transfo->transform(bristleColor.data(), bristleColor.data() , 1);
 }
 
 void HairyBrush::opacityDepletion(Bristle* bristle, KoColor& bristleColor, qreal pressure, qreal inkDeplation)
@@ -306,29 +481,28 @@ void HairyBrush::opacityDepletion(Bristle* bristle, KoColor& bristleColor, qreal
     bristleColor.setOpacity(opacity);
 }
 
-inline void HairyBrush::addBristleInk(Bristle *bristle,const QPointF &pos, const KoColor &color)
+inline void HairyBrush::addBristleInk(DabBand &band, const QPointF &pos, const KoColor &color)
 {
-    Q_UNUSED(bristle);
     if (m_properties->antialias) {
         if (m_properties->useCompositing) {
-            paintParticle(pos, color);
+            paintParticle(band, pos, color);
         } else {
-            paintParticle(pos, color, 1.0);
+            paintParticle(band, pos, color, 1.0);
         }
     }
     else {
         int ix = qRound(pos.x());
         int iy = qRound(pos.y());
         if (m_properties->useCompositing) {
-            plotPixel(ix, iy, color);
+            plotPixel(band, ix, iy, color);
         }
         else {
-            darkenPixel(ix, iy, color);
+            darkenPixel(band, ix, iy, color);
         }
     }
 }
 
-void HairyBrush::paintParticle(QPointF pos, const KoColor& color, qreal weight)
+void HairyBrush::paintParticle(DabBand &band, QPointF pos, const KoColor& color, qreal weight)
 {
     // opacity top left, right, bottom left, right
     quint8 opacity = color.opacityU8();
@@ -345,32 +519,37 @@ void HairyBrush::paintParticle(QPointF pos, const KoColor& color, qreal weight)
     quint8 bbr = qRound((fx)  * (fy)  * opacity);
 
     const KoColorSpace * cs = m_dab->colorSpace();
+    KisRandomAccessorSP accessor = band.accessor;
+
+    if (band.containsRow(ipy)) {
+        accessor->moveTo(ipx  , ipy);
+        btl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btl + cs->opacityU8(accessor->rawData()), OPACITY_OPAQUE_U8));
+        memcpy(accessor->rawData(), color.data(), cs->pixelSize());
+        cs->setOpacity(accessor->rawData(), btl, 1);
+
+        accessor->moveTo(ipx + 1, ipy);
+        btr =  quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btr + cs->opacityU8(accessor->rawData()), OPACITY_OPAQUE_U8));
+        memcpy(accessor->rawData(), color.data(), cs->pixelSize());
+        cs->setOpacity(accessor->rawData(), btr, 1);
+    }
 
-    m_dabAccessor->moveTo(ipx  , ipy);
-    btl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btl + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), btl, 1);
-
-    m_dabAccessor->moveTo(ipx + 1, ipy);
-    btr =  quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btr + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), btr, 1);
-
-    m_dabAccessor->moveTo(ipx, ipy + 1);
-    bbl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbl + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), bbl, 1);
-
-    m_dabAccessor->moveTo(ipx + 1, ipy + 1);
-    bbr = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbr + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), bbr, 1);
+    if (band.containsRow(ipy + 1)) {
+        accessor->moveTo(ipx, ipy + 1);
+        bbl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbl + cs->opacityU8(accessor->rawData()), OPACITY_OPAQUE_U8));
+        memcpy(accessor->rawData(), color.data(), cs->pixelSize());
+        cs->setOpacity(accessor->rawData(), bbl, 1);
+
+        accessor->moveTo(ipx + 1, ipy + 1);
+        bbr = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbr + cs->opacityU8(accessor->rawData()), OPACITY_OPAQUE_U8));
+        memcpy(accessor->rawData(), color.data(), cs->pixelSize());
+        cs->setOpacity(accessor->rawData(), bbr, 1);
+    }
 }
 
-void HairyBrush::paintParticle(QPointF pos, const KoColor& color)
+void HairyBrush::paintParticle(DabBand &band, QPointF pos, const KoColor& color)
 {
     // opacity top left, right, bottom left, right
-    memcpy(m_color.data(), color.data(), m_pixelSize);
+    memcpy(band.color.data(), color.data(), m_pixelSize);
     quint8 opacity = color.opacityU8();
 
     int ipx = int (pos.x());
@@ -383,31 +562,35 @@ void HairyBrush::paintParticle(QPointF pos, const KoColor& color)
     quint8 bbl = qRound((1.0 - fx) * (fy)  * opacity);
     quint8 bbr = qRound((fx)  * (fy)  * opacity);
 
-    m_color.setOpacity(btl);
-    plotPixel(ipx  , ipy, m_color);
+    band.color.setOpacity(btl);
+    plotPixel(band, ipx  , ipy, band.color);
 
-    m_color.setOpacity(btr);
-    plotPixel(ipx + 1  , ipy, m_color);
+    band.color.setOpacity(btr);
+    plotPixel(band, ipx + 1  , ipy, band.color);
 
-    m_color.setOpacity(bbl);
-    plotPixel(ipx  , ipy + 1, m_color);
+    band.color.setOpacity(bbl);
+    plotPixel(band, ipx  , ipy + 1, band.color);
 
-    m_color.setOpacity(bbr);
-    plotPixel(ipx + 1 , ipy + 1, m_color);
+    band.color.setOpacity(bbr);
+    plotPixel(band, ipx + 1 , ipy + 1, band.color);
 }
 
 
-inline void HairyBrush::plotPixel(int wx, int wy, const KoColor &color)
+inline void HairyBrush::plotPixel(DabBand &band, int wx, int wy, const KoColor &color)
 {
-    m_dabAccessor->moveTo(wx, wy);
-    m_compositeOp->composite(m_dabAccessor->rawData(), m_pixelSize, color.data() , m_pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
+    if (!band.containsRow(wy)) return;
+
+    band.accessor->moveTo(wx, wy);
+    m_compositeOp->composite(band.accessor->rawData(), m_pixelSize, color.data() , m_pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
 }
 
-inline void HairyBrush::darkenPixel(int wx, int wy, const KoColor &color)
+inline void HairyBrush::darkenPixel(DabBand &band, int wx, int wy, const KoColor &color)
 {
-    m_dabAccessor->moveTo(wx, wy);
-    if (m_dab->colorSpace()->opacityU8(m_dabAccessor->rawData()) < color.opacityU8()) {
-        memcpy(m_dabAccessor->rawData(), color.data(), m_pixelSize);
+    if (!band.containsRow(wy)) return;
+
+    band.accessor->moveTo(wx, wy);
+    if (m_dab->colorSpace()->opacityU8(band.accessor->rawData()) < color.opacityU8()) {
+        memcpy(band.accessor->rawData(), color.data(), m_pixelSize);
     }
 }
 
@@ -86,16 +86,66 @@ public:
     void fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density);
 
 private:
+    /**
+     * The ink left by the bristles in the current line, in the order
+     * it was deposited. Deposit i is painted at (x[i], y[i]) with the
+     * color stored at colors[i * pixelSize].
+     */
+    struct InkDeposits {
+        QVector<qreal> x;
+        QVector<qreal> y;
+        QVector<quint8> colors;
+
+        void append(const QPointF &pos, const quint8 *color, int pixelSize);
+        void append(const InkDeposits &rhs);
+    };
+
+    /**
+     * The end points of the paths of the bristles in the current line
+     */
+    struct BristleSegments {
+        QVector<int> bristle;
+        QVector<qreal> x1;
+        QVector<qreal> y1;
+        QVector<qreal> x2;
+        QVector<qreal> y2;
+
+        inline int size() const {
+            return bristle.size();
+        }
+    };
+
+    /**
+     * A horizontal band of the dab. The deposits are painted in bands
+     * concurrently, every band writes only into its own rows.
+     */
+    struct DabBand {
+        int top;
+        int bottom;
+        QVector<int> deposits;
+        KisRandomAccessorSP accessor;
+        KoColor color;
+
+        inline bool containsRow(int y) const {
+            return y >= top && y < bottom;
+        }
+    };
+
+    /// moves the bristles along the segments and collects the ink they leave
+    void depositInk(const BristleSegments &segments, int begin, int end, qreal pressure,
+                    KoColorTransformation *transfo, InkDeposits *deposits);
+    /// paints the deposits of the band into the dab
+    void paintBand(const InkDeposits &deposits, DabBand &band);
     /// paints single bristle
-    void addBristleInk(Bristle *bristle,const QPointF &pos, const KoColor &color);
+    void addBristleInk(DabBand &band, const QPointF &pos, const KoColor &color);
     /// composite single pixel to dab
-    void plotPixel(int wx, int wy, const KoColor &color);
+    void plotPixel(DabBand &band, int wx, int wy, const KoColor &color);
     /// check the opacity of dab pixel and if the opacity is less then color, it will copy color to dab
-    void darkenPixel(int wx, int wy, const KoColor &color);
+    void darkenPixel(DabBand &band, int wx, int wy, const KoColor &color);
     /// paint wu particle by copying the color and setup just the opacity, weight is complementary to opacity of the color
-    void paintParticle(QPointF pos, const KoColor& color, qreal weight);
+    void paintParticle(DabBand &band, QPointF pos, const KoColor& color, qreal weight);
     /// paint wu particle using composite operation
-    void paintParticle(QPointF pos, const KoColor& color);
+    void paintParticle(DabBand &band, QPointF pos, const KoColor& color);
     /// similar to sample input color in spray
     void colorifyBristles(KisPaintDeviceSP source, QPointF point);
 
@@ -104,7 +154,7 @@ private:
     double computeMousePressure(double distance);
 
     /// simulate running out of saturation
-    void saturationDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
+    void saturationDepletion(KoColorTransformation *transfo, Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
     /// simulate running out of ink through opacity decreasing
     void opacityDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
     /// fetch actual ink status according depletion curve
@@ -118,12 +168,9 @@ private:
     QVector<Bristle*> m_bristles;
     QTransform m_transform;
 
-    // used for interpolation the path of bristles
-    Trajectory m_trajectory;
     QHash<QString, QVariant> m_params;
     // temporary device
     KisPaintDeviceSP m_dab;
-    KisRandomAccessorSP m_dabAccessor;
     const KoCompositeOp * m_compositeOp;
     quint32 m_pixelSize;
 
@@ -134,7 +181,10 @@ private:
     KoColor m_color;
 
     int m_saturationId;
-    KoColorTransformation * m_transfo;
+
+    // the transformations are not thread-safe, so every job has its own one
+    QVector<KoColorTransformation*> m_transfos;
+    int m_numJobs;
 
     // internal counter counts the calls of paint, the counter is 1 when the first call occurs
     inline bool firstStroke() const {
@@ -0,0 +1,318 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "KisParticleBatch.h"
+
+#include <QHash>
+#include <QRect>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceConstants.h>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+/**
+ * The size of the blocks the particles are distributed over. It is equal
+ * to the size of the tiles, so the concurrent blocks never share tiles.
+ */
+const int blockSize = 64;
+
+/**
+ * Smaller batches are painted in the calling thread, starting the
+ * concurrent jobs would cost more
+ */
+const int minParticlesForThreading = 4096;
+
+inline int blockIndex(int x)
+{
+    return x >= 0 ? x / blockSize : -((-x - 1) / blockSize) - 1;
+}
+
+struct Block {
+    /**
+     * The union of the parts of the footprints lying in the block
+     */
+    QRect rect;
+
+    /**
+     * The indexes of the particles touching the block, in the order
+     * they were appended
+     */
+    QVector<int> particles;
+};
+
+}
+
+struct KisParticleBatch::Private
+{
+    Private(const KoColorSpace *_colorSpace, Mode _mode)
+        : colorSpace(_colorSpace),
+          mode(_mode),
+          pixelSize(_colorSpace->pixelSize())
+    {
+    }
+
+    const KoColorSpace *colorSpace;
+    const Mode mode;
+    const int pixelSize;
+    qreal weight = 1.0;
+
+    QVector<qreal> x;
+    QVector<qreal> y;
+    QVector<quint8> colors;
+
+    /**
+     * The opacities of the colors, used only in AccumulatedWuParticles mode
+     */
+    QVector<qreal> opacities;
+
+    /**
+     * The top-left pixels of the footprints and the coverages of the top-left,
+     * top-right, bottom-left and bottom-right pixels of the Wu particles
+     */
+    QVector<int> left;
+    QVector<int> top;
+    QVector<qreal> coverages[4];
+
+    int footprintSize() const {
+        return mode == Pixels ? 1 : 2;
+    }
+
+    void calculateFootprints();
+    QVector<Block> splitIntoBlocks() const;
+    void paintBlock(KisPaintDeviceSP device, const Block &block) const;
+};
+
+void KisParticleBatch::Private::calculateFootprints()
+{
+    const int numParticles = x.size();
+
+    left.resize(numParticles);
+    top.resize(numParticles);
+
+    const qreal *px = x.constData();
+    const qreal *py = y.constData();
+    int *pl = left.data();
+    int *pt = top.data();
+
+    if (mode == Pixels) {
+        for (int i = 0; i < numParticles; i++) {
+            pl[i] = qRound(px[i]);
+            pt[i] = qRound(py[i]);
+        }
+        return;
+    }
+
+    if (mode == WuParticles) {
+        for (int i = 0; i < numParticles; i++) {
+            pl[i] = int(px[i]);
+            pt[i] = int(py[i]);
+        }
+    } else {
+        for (int i = 0; i < numParticles; i++) {
+            pl[i] = std::floor(px[i]);
+            pt[i] = std::floor(py[i]);
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        coverages[k].resize(numParticles);
+    }
+
+    qreal *topLeft = coverages[0].data();
+    qreal *topRight = coverages[1].data();
+    qreal *bottomLeft = coverages[2].data();
+    qreal *bottomRight = coverages[3].data();
+
+    for (int i = 0; i < numParticles; i++) {
+        const qreal fx = px[i] - pl[i];
+        const qreal fy = py[i] - pt[i];
+
+        topLeft[i] = (1.0 - fx) * (1.0 - fy);
+        topRight[i] = fx * (1.0 - fy);
+        bottomLeft[i] = (1.0 - fx) * fy;
+        bottomRight[i] = fx * fy;
+    }
+
+    if (mode == AccumulatedWuParticles) {
+        const qreal *po = opacities.constData();
+
+        for (int k = 0; k < 4; k++) {
+            qreal *coverage = coverages[k].data();
+
+            for (int i = 0; i < numParticles; i++) {
+                coverage[i] = coverage[i] * po[i] * weight;
+            }
+        }
+    }
+}
+
+QVector<Block> KisParticleBatch::Private::splitIntoBlocks() const
+{
+    QVector<Block> blocks;
+    QHash<quint64, int> blockIds;
+
+    const int size = footprintSize();
+
+    for (int i = 0; i < left.size(); i++) {
+        const QRect footprint(left[i], top[i], size, size);
+
+        for (int by = blockIndex(footprint.top()); by <= blockIndex(footprint.bottom()); by++) {
+            for (int bx = blockIndex(footprint.left()); bx <= blockIndex(footprint.right()); bx++) {
+                const quint64 key = (quint64(quint32(by)) << 32) | quint32(bx);
+
+                auto it = blockIds.find(key);
+                if (it == blockIds.end()) {
+                    it = blockIds.insert(key, blocks.size());
+                    blocks.append(Block());
+                }
+
+                const QRect blockRect(bx * blockSize, by * blockSize, blockSize, blockSize);
+
+                Block &block = blocks[it.value()];
+                block.rect |= footprint & blockRect;
+                block.particles.append(i);
+            }
+        }
+    }
+
+    return blocks;
+}
+
+void KisParticleBatch::Private::paintBlock(KisPaintDeviceSP device, const Block &block) const
+{
+    const QRect &rc = block.rect;
+
+    QVector<quint8> buffer(rc.width() * rc.height() * pixelSize);
+    device->readBytes(buffer.data(), rc);
+
+    auto pixelAt = [&] (int px, int py) {
+        return buffer.data() + ((py - rc.y()) * rc.width() + px - rc.x()) * pixelSize;
+    };
+
+    if (mode == Pixels) {
+        Q_FOREACH (int i, block.particles) {
+            memcpy(pixelAt(left[i], top[i]), colors.constData() + i * pixelSize, pixelSize);
+        }
+    } else {
+        const int offsets[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+
+        Q_FOREACH (int i, block.particles) {
+            const quint8 *color = colors.constData() + i * pixelSize;
+
+            for (int k = 0; k < 4; k++) {
+                const int px = left[i] + offsets[k][0];
+                const int py = top[i] + offsets[k][1];
+
+                if (!rc.contains(px, py)) continue;
+
+                quint8 *dst = pixelAt(px, py);
+
+                if (mode == WuParticles) {
+                    memcpy(dst, color, pixelSize);
+                    colorSpace->setOpacity(dst, coverages[k][i], 1);
+                } else {
+                    const quint8 coverage = qRound(coverages[k][i]);
+                    const quint8 opacity =
+                        quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8,
+                                               coverage + colorSpace->opacityU8(dst),
+                                               OPACITY_OPAQUE_U8));
+
+                    memcpy(dst, color, pixelSize);
+                    colorSpace->setOpacity(dst, opacity, 1);
+                }
+            }
+        }
+    }
+
+    device->writeBytes(buffer.constData(), rc);
+}
+
+
+KisParticleBatch::KisParticleBatch(const KoColorSpace *colorSpace, Mode mode)
+    : m_d(new Private(colorSpace, mode))
+{
+}
+
+KisParticleBatch::~KisParticleBatch()
+{
+}
+
+void KisParticleBatch::setWeight(qreal weight)
+{
+    m_d->weight = weight;
+}
+
+void KisParticleBatch::append(qreal x, qreal y, const quint8 *color)
+{
+    m_d->x.append(x);
+    m_d->y.append(y);
+
+    const int offset = m_d->colors.size();
+    m_d->colors.resize(offset + m_d->pixelSize);
+    memcpy(m_d->colors.data() + offset, color, m_d->pixelSize);
+
+    if (m_d->mode == AccumulatedWuParticles) {
+        m_d->opacities.append(m_d->colorSpace->opacityU8(color));
+    }
+}
+
+int KisParticleBatch::size() const
+{
+    return m_d->x.size();
+}
+
+bool KisParticleBatch::isEmpty() const
+{
+    return m_d->x.isEmpty();
+}
+
+void KisParticleBatch::paint(KisPaintDeviceSP device)
+{
+    KIS_SAFE_ASSERT_RECOVER(device->pixelSize() == m_d->pixelSize) {
+        clear();
+        return;
+    }
+
+    if (isEmpty()) return;
+
+    m_d->calculateFootprints();
+    QVector<Block> blocks = m_d->splitIntoBlocks();
+
+    const Private *d = m_d.data();
+    auto paintBlock = [d, device] (Block &block) {
+        d->paintBlock(device, block);
+    };
+
+    if (blocks.size() > 1 &&
+        size() >= minParticlesForThreading &&
+        QThread::idealThreadCount() > 1) {
+
+        QtConcurrent::blockingMap(blocks, paintBlock);
+    } else {
+        std::for_each(blocks.begin(), blocks.end(), paintBlock);
+    }
+
+    clear();
+}
+
+void KisParticleBatch::clear()
+{
+    m_d->x.resize(0);
+    m_d->y.resize(0);
+    m_d->colors.resize(0);
+    m_d->opacities.resize(0);
+}
@@ -0,0 +1,89 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Krita Developers
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __KIS_PARTICLE_BATCH_H
+#define __KIS_PARTICLE_BATCH_H
+
+#include <QScopedPointer>
+
+#include "kis_types.h"
+#include "kritapaintop_export.h"
+
+class KoColorSpace;
+
+/**
+ * Collects the particles of a dab and paints them into a paint device
+ * at once, instead of moving a random accessor for every pixel of every
+ * particle.
+ *
+ * The particles are stored as arrays of coordinates and colors. When the
+ * batch is painted, the pixel footprints and coverages of all the particles
+ * are calculated in plain loops over the arrays, which the compiler
+ * vectorizes. Then the particles are distributed over the 64x64 blocks of
+ * the device their footprints touch. Every block is read into a buffer,
+ * gets its particles in the order they were appended and is written back
+ * with a single call. Big batches paint their blocks concurrently.
+ *
+ * The particles are painted in the same order as before, so the result is
+ * exactly the same as the one of painting them one by one.
+ */
+class PAINTOP_EXPORT KisParticleBatch
+{
+public:
+    enum Mode {
+        /**
+         * The pixel at the rounded position of the particle is overwritten
+         * with its color
+         */
+        Pixels,
+
+        /**
+         * The four pixels around the position, truncated towards zero, are
+         * overwritten with the color, whose opacity is set to the coverage
+         * of the pixel (the Wu particles of the Spray brush)
+         */
+        WuParticles,
+
+        /**
+         * The four pixels around the position, rounded down, are overwritten
+         * with the color, and the coverage of the pixel, multiplied by the
+         * opacity of the color and the weight, is added to the opacity of the
+         * pixel (the particles of the Particle brush)
+         */
+        AccumulatedWuParticles
+    };
+
+public:
+    KisParticleBatch(const KoColorSpace *colorSpace, Mode mode);
+    ~KisParticleBatch();
+
+    /**
+     * The weight of the coverage in AccumulatedWuParticles mode
+     */
+    void setWeight(qreal weight);
+
+    /**
+     * Adds a particle. \p color should be in the color space of the batch.
+     */
+    void append(qreal x, qreal y, const quint8 *color);
+
+    int size() const;
+    bool isEmpty() const;
+
+    /**
+     * Paints all the particles into \p device and removes them from
+     * the batch. The memory is kept for the next dab.
+     */
+    void paint(KisPaintDeviceSP device);
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PARTICLE_BATCH_H */
@@ -19,12 +19,10 @@
 #include "particle_brush.h"
 
 #include "kis_paint_device.h"
-#include "kis_random_accessor_ng.h"
 
-#include <KoColorSpace.h>
 #include <KoColor.h>
 
-#include <math.h>
+#include <KisParticleBatch.h>
 
 const qreal TIME = 0.000030;
 
@@ -40,61 +38,31 @@ ParticleBrush::~ParticleBrush()
 
 void ParticleBrush::initParticles()
 {
-    m_particlePos.resize(m_properties->particleCount);
-    m_particleNextPos.resize(m_properties->particleCount);
+    m_particleX.resize(m_properties->particleCount);
+    m_particleY.resize(m_properties->particleCount);
+    m_particleNextX.resize(m_properties->particleCount);
+    m_particleNextY.resize(m_properties->particleCount);
     m_accelaration.resize(m_properties->particleCount);
 }
 
 void ParticleBrush::setInitialPosition(const QPointF &pos)
 {
     for (int i = 0; i < m_properties->particleCount; i++) {
-        m_particlePos[i] = pos;
-        m_particleNextPos[i] = pos;
+        m_particleX[i] = pos.x();
+        m_particleY[i] = pos.y();
+        m_particleNextX[i] = pos.x();
+        m_particleNextY[i] = pos.y();
         m_accelaration[i] = (i + m_properties->iterations) * 0.5;
     }
 }
 
 
-void ParticleBrush::paintParticle(KisRandomAccessorSP accWrite, const KoColorSpace * cs, const QPointF &pos, const KoColor& color, qreal weight, bool respectOpacity)
-{
-    // opacity top left, right, bottom left, right
-    KoColor myColor(color);
-    quint8 opacity = respectOpacity ? myColor.opacityU8() : OPACITY_OPAQUE_U8;
-
-    int ipx = floor(pos.x());
-    int ipy = floor(pos.y());
-    qreal fx = pos.x() - ipx;
-    qreal fy = pos.y() - ipy;
-
-    quint8 btl = qRound((1.0 - fx) * (1.0 - fy) * opacity * weight);
-    quint8 btr = qRound((fx)  * (1.0 - fy) * opacity * weight);
-    quint8 bbl = qRound((1.0 - fx) * (fy)  * opacity * weight);
-    quint8 bbr = qRound((fx)  * (fy)  * opacity * weight);
-
-    accWrite->moveTo(ipx  , ipy);
-    myColor.setOpacity(quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btl + cs->opacityU8(accWrite->rawData()), OPACITY_OPAQUE_U8)));
-    memcpy(accWrite->rawData(), myColor.data(), cs->pixelSize());
-
-    accWrite->moveTo(ipx + 1, ipy);
-    myColor.setOpacity(quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btr + cs->opacityU8(accWrite->rawData()), OPACITY_OPAQUE_U8)));
-    memcpy(accWrite->rawData(), myColor.data(), cs->pixelSize());
-
-    accWrite->moveTo(ipx, ipy + 1);
-    myColor.setOpacity(quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbl + cs->opacityU8(accWrite->rawData()), OPACITY_OPAQUE_U8)));
-    memcpy(accWrite->rawData(), myColor.data(), cs->pixelSize());
-
-    accWrite->moveTo(ipx + 1, ipy + 1);
-    myColor.setOpacity(quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbr + cs->opacityU8(accWrite->rawData()), OPACITY_OPAQUE_U8)));
-    memcpy(accWrite->rawData(), myColor.data(), cs->pixelSize());
-}
-
-
-
-
 void ParticleBrush::draw(KisPaintDeviceSP dab, const KoColor& color, const QPointF &pos)
 {
-    KisRandomAccessorSP accessor = dab->createRandomAccessorNG();
-    const KoColorSpace * cs = dab->colorSpace();
+    if (!m_particleBatch) {
+        m_particleBatch.reset(new KisParticleBatch(dab->colorSpace(), KisParticleBatch::AccumulatedWuParticles));
+    }
+    m_particleBatch->setWeight(m_properties->weight);
 
     QRect boundingRect;
 
@@ -102,34 +70,47 @@ void ParticleBrush::draw(KisPaintDeviceSP dab, const KoColor& color, const QPoin
         boundingRect = dab->defaultBounds()->bounds();
     }
 
-    for (int i = 0; i < m_properties->iterations; i++) {
-        for (int j = 0; j < m_properties->particleCount; j++) {
-            /*
-                m_time = 0.01;
-                QPointF temp = m_position;
-                QPointF dist = m_position - m_oldPosition;
-                m_position = m_position + (dist + (m_acceleration*m_time*m_time));
-                m_oldPosition = temp;
-            */
-
-            /*
-                QPointF dist = info.pos() - m_position;
-                dist *= 0.3; // scale
-                dist *= 10; // force
-                m_oldPosition += dist;
-                m_oldPosition *= 0.989;
-                m_position = m_position + m_oldPosition * m_time * m_time;
-            */
-
-
-            QPointF dist = pos - m_particlePos[j];
-            dist.setX(dist.x() * m_properties->scale.x());
-            dist.setY(dist.y() * m_properties->scale.y());
-            dist = dist * m_accelaration[j];
-            m_particleNextPos[j] = m_particleNextPos[j] + dist;
-            m_particleNextPos[j] *= m_properties->gravity;
-            m_particlePos[j] = m_particlePos[j] + (m_particleNextPos[j] * TIME);
+    const int count = m_properties->particleCount;
+    const qreal scaleX = m_properties->scale.x();
+    const qreal scaleY = m_properties->scale.y();
+    const qreal gravity = m_properties->gravity;
+
+    qreal *particleX = m_particleX.data();
+    qreal *particleY = m_particleY.data();
+    qreal *nextX = m_particleNextX.data();
+    qreal *nextY = m_particleNextY.data();
+    const qreal *accelaration = m_accelaration.constData();
 
+    for (int i = 0; i < m_properties->iterations; i++) {
+        /*
+            m_time = 0.01;
+            QPointF temp = m_position;
+            QPointF dist = m_position - m_oldPosition;
+            m_position = m_position + (dist + (m_acceleration*m_time*m_time));
+            m_oldPosition = temp;
+        */
+
+        /*
+            QPointF dist = info.pos() - m_position;
+            dist *= 0.3; // scale
+            dist *= 10; // force
+            m_oldPosition += dist;
+            m_oldPosition *= 0.989;
+            m_position = m_position + m_oldPosition * m_time * m_time;
+        */
+
+        for (int j = 0; j < count; j++) {
+            const qreal distX = (pos.x() - particleX[j]) * scaleX * accelaration[j];
+            const qreal distY = (pos.y() - particleY[j]) * scaleY * accelaration[j];
+
+            nextX[j] = (nextX[j] + distX) * gravity;
+            nextY[j] = (nextY[j] + distY) * gravity;
+
+            particleX[j] = particleX[j] + nextX[j] * TIME;
+            particleY[j] = particleY[j] + nextY[j] * TIME;
+        }
+
+        for (int j = 0; j < count; j++) {
             /**
              * When the scale is negative the equation becomes
              * unstable, and the point coordinates grow to infinity,
@@ -144,20 +125,19 @@ void ParticleBrush::draw(KisPaintDeviceSP dab, const KoColor& color, const QPoin
             //  and then it will be passed to the lockless hashtable
             //  and then it will crash.
             // Hence better to catch infinity here and just not paint anything.
-            QPointF pointF = m_particlePos[j];
+            QPointF pointF(particleX[j], particleY[j]);
 
             const qint32 max = 2147483600;
             const qint32 min = -max;
             bool nearInfinity = pointF.x() < min || pointF.x () > max || pointF.y() < min || pointF.y() > max;
-            bool inside = boundingRect.contains(m_particlePos[j].toPoint());
+            bool inside = boundingRect.contains(pointF.toPoint());
 
             if (boundingRect.isEmpty() || (inside && !nearInfinity)) {
-                paintParticle(accessor, cs, m_particlePos[j], color, m_properties->weight, true);
+                m_particleBatch->append(pointF.x(), pointF.y(), color.data());
             }
 
         }//for j
     }//for i
-}
-
-
 
+    m_particleBatch->paint(dab);
+}
@@ -23,6 +23,7 @@
 #include "kis_paint_device.h"
 #include "kis_debug.h"
 #include <QPointF>
+#include <QScopedPointer>
 
 
 class KisParticleBrushProperties
@@ -35,9 +36,8 @@ public:
     QPointF scale;
 };
 
-class KisRandomAccessor;
-class KoColorSpace;
 class KoColor;
+class KisParticleBatch;
 
 class ParticleBrush
 {
@@ -55,14 +55,18 @@ public:
     }
 
 private:
-    /// paints wu particle, similar to spray version but you can turn on respecting opacity of the tool and add weight to opacity
-    /// also the particle respects opacity in the destination pixel buffer
-    void paintParticle(KisRandomAccessorSP writeAccessor, const KoColorSpace *cs,const QPointF &pos, const KoColor& color, qreal weight, bool respectOpacity);
-
-    QVector<QPointF> m_particlePos;
-    QVector<QPointF> m_particleNextPos;
+    /// the positions and the velocities of the particles, stored as separate
+    /// arrays, so the movement of all the particles is vectorized
+    QVector<qreal> m_particleX;
+    QVector<qreal> m_particleY;
+    QVector<qreal> m_particleNextX;
+    QVector<qreal> m_particleNextY;
     QVector<qreal> m_accelaration;
 
+    /// the particles are painted as wu particles, respecting the opacity of the
+    /// color and the opacity already present in the dab
+    QScopedPointer<KisParticleBatch> m_particleBatch;
+
     KisParticleBrushProperties * m_properties;
 };
 
@@ -35,6 +35,7 @@
 #include <kis_brush.h>
 
 class KisPaintInformation;
+class KisParticleBatch;
 
 class SprayBrush
 {
@@ -57,9 +58,9 @@ private:
     KoColor m_inkColor;
     qreal m_radius;
     quint32 m_particlesCount;
-    quint8 m_dabPixelSize;
 
     KisPainter * m_painter;
+    KisParticleBatch * m_particleBatch;
     KisPaintDeviceSP m_imageDevice;
     QImage m_brushQImage;
     QImage m_transformed;
@@ -77,8 +78,6 @@ private:
 private:
     /// rotation in radians according the settings (gauss distribution, uniform distribution or fixed angle)
     qreal rotationAngle(KisRandomSourceSP randomSource);
-    /// Paints Wu Particle
-    void paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor &color, qreal rx, qreal ry);
     void paintCircle(KisPainter * painter, qreal x, qreal y, qreal radius);
     void paintEllipse(KisPainter * painter, qreal x, qreal y, qreal a, qreal b, qreal angle);
     void paintRectangle(KisPainter * painter, qreal x, qreal y, qreal width, qreal height, qreal angle);